@@ -0,0 +1,494 @@
+#include "containers/btree_map.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#define BTREE_MAP_CACHE_LINE_SIZE 64
+// A node other than the root never has fewer keys than this, so two siblings
+// at the minimum always fit in one node when merged.
+#define BTREE_MAP_MIN_KEYS (BTREE_MAP_NODE_KEYS / 2)
+
+// NOTE: Separators in inner nodes follow the B+ tree rule: every key under
+// children[i] is less than keys[i], and every key under children[i + 1] is
+// not. Erase does not tidy separators, so they may name removed keys.
+typedef struct btree_node {
+    u32 count;
+    b8 is_leaf;
+    u64 keys[BTREE_MAP_NODE_KEYS];
+} btree_node;
+
+typedef struct btree_inner {
+    btree_node base;
+    btree_node *children[BTREE_MAP_NODE_KEYS + 1];
+} btree_inner;
+
+// Values follow the leaf, element_size apart.
+typedef struct btree_leaf {
+    btree_node base;
+    struct btree_leaf *next;
+} btree_leaf;
+
+static u64 btree_map_nodes_per_page(btree_map *map) {
+    u64 nodes = (BTREE_MAP_PAGE_SIZE - BTREE_MAP_CACHE_LINE_SIZE) /
+                map->node_size;
+    return nodes ? nodes : 1;
+}
+
+// The first cache line of a page links it to the next page.
+static u64 btree_map_page_size(btree_map *map) {
+    return BTREE_MAP_CACHE_LINE_SIZE +
+           map->node_size * btree_map_nodes_per_page(map);
+}
+
+static void *leaf_value(btree_map *map, btree_leaf *leaf, u32 index) {
+    return (u8 *)(leaf + 1) + map->element_size * index;
+}
+
+static btree_node *node_allocate(btree_map *map, b8 is_leaf) {
+    if (!map->free_nodes) {
+        u8 *page = kallocate_aligned(btree_map_page_size(map),
+                                     BTREE_MAP_CACHE_LINE_SIZE, MEMORY_TAG_BST);
+        if (!page) {
+            KERROR("btree_map - failed to allocate a page of nodes.");
+            return 0;
+        }
+        *(void **)page = map->pages;
+        map->pages = page;
+
+        // Push in reverse so nodes are handed out in address order.
+        for (u64 i = btree_map_nodes_per_page(map); i > 0; --i) {
+            void **node = (void **)(page + BTREE_MAP_CACHE_LINE_SIZE +
+                                    map->node_size * (i - 1));
+            *node = map->free_nodes;
+            map->free_nodes = node;
+        }
+    }
+
+    btree_node *node = map->free_nodes;
+    map->free_nodes = *(void **)node;
+    node->count = 0;
+    node->is_leaf = is_leaf;
+    if (is_leaf) {
+        ((btree_leaf *)node)->next = 0;
+    }
+    return node;
+}
+
+static void node_free(btree_map *map, btree_node *node) {
+    *(void **)node = map->free_nodes;
+    map->free_nodes = node;
+}
+
+// The child of an inner node whose range holds key.
+static u32 node_child_index(btree_node *node, u64 key) {
+    u32 i = 0;
+    while (i < node->count && node->keys[i] <= key) {
+        i++;
+    }
+    return i;
+}
+
+// The first key in a node not less than key, or count if there is none.
+static u32 node_lower_index(btree_node *node, u64 key) {
+    u32 i = 0;
+    while (i < node->count && node->keys[i] < key) {
+        i++;
+    }
+    return i;
+}
+
+static void leaf_shift_right(btree_map *map, btree_leaf *leaf, u32 index) {
+    for (u32 i = leaf->base.count; i > index; --i) {
+        leaf->base.keys[i] = leaf->base.keys[i - 1];
+        kcopy_memory(leaf_value(map, leaf, i), leaf_value(map, leaf, i - 1),
+                     map->element_size);
+    }
+}
+
+static void leaf_shift_left(btree_map *map, btree_leaf *leaf, u32 index) {
+    for (u32 i = index; i + 1 < leaf->base.count; ++i) {
+        leaf->base.keys[i] = leaf->base.keys[i + 1];
+        kcopy_memory(leaf_value(map, leaf, i), leaf_value(map, leaf, i + 1),
+                     map->element_size);
+    }
+}
+
+// Moves count entries from the front of source to the end of dest.
+static void leaf_append(btree_map *map, btree_leaf *dest, btree_leaf *source,
+                        u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        dest->base.keys[dest->base.count + i] = source->base.keys[i];
+    }
+    kcopy_memory(leaf_value(map, dest, dest->base.count),
+                 leaf_value(map, source, 0), map->element_size * count);
+    dest->base.count += count;
+}
+
+// Opens a gap at key index and child index + 1 of an inner node.
+static void inner_shift_right(btree_inner *inner, u32 index) {
+    for (u32 i = inner->base.count; i > index; --i) {
+        inner->base.keys[i] = inner->base.keys[i - 1];
+        inner->children[i + 1] = inner->children[i];
+    }
+}
+
+// Closes the gap left by key index and child index + 1 of an inner node.
+static void inner_remove(btree_inner *inner, u32 index) {
+    for (u32 i = index; i + 1 < inner->base.count; ++i) {
+        inner->base.keys[i] = inner->base.keys[i + 1];
+        inner->children[i + 1] = inner->children[i + 2];
+    }
+    inner->base.count--;
+}
+
+// Splits the full child at index in two, adding the new right half and its
+// separator to parent, which must not be full.
+static b8 split_child(btree_map *map, btree_inner *parent, u32 index) {
+    btree_node *child = parent->children[index];
+    btree_node *right = node_allocate(map, child->is_leaf);
+    if (!right) {
+        return false;
+    }
+
+    u64 separator;
+    if (child->is_leaf) {
+        btree_leaf *left_leaf = (btree_leaf *)child;
+        btree_leaf *right_leaf = (btree_leaf *)right;
+        u32 keep = (child->count + 1) / 2;
+        u32 moved = child->count - keep;
+        for (u32 i = 0; i < moved; ++i) {
+            right->keys[i] = child->keys[keep + i];
+        }
+        kcopy_memory(leaf_value(map, right_leaf, 0),
+                     leaf_value(map, left_leaf, keep),
+                     map->element_size * moved);
+        right->count = moved;
+        child->count = keep;
+        right_leaf->next = left_leaf->next;
+        left_leaf->next = right_leaf;
+        separator = right->keys[0];
+    } else {
+        btree_inner *left_inner = (btree_inner *)child;
+        btree_inner *right_inner = (btree_inner *)right;
+        // The middle key moves up rather than into either half.
+        u32 middle = child->count / 2;
+        u32 moved = child->count - middle - 1;
+        for (u32 i = 0; i < moved; ++i) {
+            right->keys[i] = child->keys[middle + 1 + i];
+            right_inner->children[i] = left_inner->children[middle + 1 + i];
+        }
+        right_inner->children[moved] = left_inner->children[child->count];
+        right->count = moved;
+        child->count = middle;
+        separator = child->keys[middle];
+    }
+
+    inner_shift_right(parent, index);
+    parent->base.keys[index] = separator;
+    parent->children[index + 1] = right;
+    parent->base.count++;
+    return true;
+}
+
+b8 btree_map_create(u64 element_size, btree_map *out_map) {
+    if (!out_map || element_size == 0) {
+        KERROR("btree_map_create - requires a valid out_map and a positive "
+               "element_size.");
+        return false;
+    }
+
+    kzero_memory(out_map, sizeof(btree_map));
+    out_map->element_size = element_size;
+
+    u64 leaf_size = sizeof(btree_leaf) + element_size * BTREE_MAP_NODE_KEYS;
+    u64 node_size =
+        leaf_size > sizeof(btree_inner) ? leaf_size : sizeof(btree_inner);
+    out_map->node_size = (node_size + BTREE_MAP_CACHE_LINE_SIZE - 1) &
+                         ~(u64)(BTREE_MAP_CACHE_LINE_SIZE - 1);
+
+    out_map->root = node_allocate(out_map, true);
+    if (!out_map->root) {
+        return false;
+    }
+    return true;
+}
+
+void btree_map_destroy(btree_map *map) {
+    if (!map) {
+        return;
+    }
+
+    u64 page_size = btree_map_page_size(map);
+    void *page = map->pages;
+    while (page) {
+        void *next = *(void **)page;
+        kfree_aligned(page, page_size, BTREE_MAP_CACHE_LINE_SIZE,
+                      MEMORY_TAG_BST);
+        page = next;
+    }
+    kzero_memory(map, sizeof(btree_map));
+}
+
+b8 btree_map_insert(btree_map *map, u64 key, const void *value) {
+    if (!map || !map->root || !value) {
+        KERROR("btree_map_insert - requires a valid map and value.");
+        return false;
+    }
+
+    // Splits happen on the way down, so every node entered has room for the
+    // separator of a child split below it.
+    btree_node *root = map->root;
+    if (root->count == BTREE_MAP_NODE_KEYS) {
+        btree_inner *new_root = (btree_inner *)node_allocate(map, false);
+        if (!new_root) {
+            return false;
+        }
+        new_root->children[0] = root;
+        if (!split_child(map, new_root, 0)) {
+            node_free(map, &new_root->base);
+            return false;
+        }
+        map->root = new_root;
+    }
+
+    btree_node *node = map->root;
+    while (!node->is_leaf) {
+        btree_inner *inner = (btree_inner *)node;
+        u32 index = node_child_index(node, key);
+        if (inner->children[index]->count == BTREE_MAP_NODE_KEYS) {
+            if (!split_child(map, inner, index)) {
+                return false;
+            }
+            if (key >= node->keys[index]) {
+                index++;
+            }
+        }
+        node = inner->children[index];
+    }
+
+    btree_leaf *leaf = (btree_leaf *)node;
+    u32 index = node_lower_index(node, key);
+    if (index < node->count && node->keys[index] == key) {
+        kcopy_memory(leaf_value(map, leaf, index), value, map->element_size);
+        return true;
+    }
+
+    leaf_shift_right(map, leaf, index);
+    node->keys[index] = key;
+    kcopy_memory(leaf_value(map, leaf, index), value, map->element_size);
+    node->count++;
+    map->count++;
+    return true;
+}
+
+// Makes sure the child at index has more than the minimum number of keys, by
+// taking one from a sibling or merging with it. Returns the index of the child
+// to descend into, which changes if it was merged into its left sibling.
+static u32 fix_child(btree_map *map, btree_inner *parent, u32 index) {
+    btree_node *child = parent->children[index];
+    btree_node *left = index > 0 ? parent->children[index - 1] : 0;
+    btree_node *right =
+        index < parent->base.count ? parent->children[index + 1] : 0;
+
+    if (left && left->count > BTREE_MAP_MIN_KEYS) {
+        if (child->is_leaf) {
+            btree_leaf *child_leaf = (btree_leaf *)child;
+            btree_leaf *left_leaf = (btree_leaf *)left;
+            leaf_shift_right(map, child_leaf, 0);
+            child->keys[0] = left->keys[left->count - 1];
+            kcopy_memory(leaf_value(map, child_leaf, 0),
+                         leaf_value(map, left_leaf, left->count - 1),
+                         map->element_size);
+            parent->base.keys[index - 1] = child->keys[0];
+        } else {
+            btree_inner *child_inner = (btree_inner *)child;
+            child_inner->children[child->count + 1] =
+                child_inner->children[child->count];
+            for (u32 i = child->count; i > 0; --i) {
+                child->keys[i] = child->keys[i - 1];
+                child_inner->children[i] = child_inner->children[i - 1];
+            }
+            child->keys[0] = parent->base.keys[index - 1];
+            child_inner->children[0] =
+                ((btree_inner *)left)->children[left->count];
+            parent->base.keys[index - 1] = left->keys[left->count - 1];
+        }
+        child->count++;
+        left->count--;
+        return index;
+    }
+
+    if (right && right->count > BTREE_MAP_MIN_KEYS) {
+        if (child->is_leaf) {
+            btree_leaf *right_leaf = (btree_leaf *)right;
+            leaf_append(map, (btree_leaf *)child, right_leaf, 1);
+            leaf_shift_left(map, right_leaf, 0);
+            right->count--;
+            parent->base.keys[index] = right->keys[0];
+        } else {
+            btree_inner *child_inner = (btree_inner *)child;
+            btree_inner *right_inner = (btree_inner *)right;
+            child->keys[child->count] = parent->base.keys[index];
+            child_inner->children[child->count + 1] = right_inner->children[0];
+            child->count++;
+            parent->base.keys[index] = right->keys[0];
+            for (u32 i = 0; i + 1 < right->count; ++i) {
+                right->keys[i] = right->keys[i + 1];
+                right_inner->children[i] = right_inner->children[i + 1];
+            }
+            right_inner->children[right->count - 1] =
+                right_inner->children[right->count];
+            right->count--;
+        }
+        return index;
+    }
+
+    // Both siblings are at the minimum; merge with one of them, always keeping
+    // the left node.
+    if (!right) {
+        index--;
+        right = child;
+        child = left;
+    }
+
+    if (child->is_leaf) {
+        btree_leaf *child_leaf = (btree_leaf *)child;
+        btree_leaf *right_leaf = (btree_leaf *)right;
+        leaf_append(map, child_leaf, right_leaf, right->count);
+        child_leaf->next = right_leaf->next;
+    } else {
+        btree_inner *child_inner = (btree_inner *)child;
+        btree_inner *right_inner = (btree_inner *)right;
+        child->keys[child->count] = parent->base.keys[index];
+        for (u32 i = 0; i < right->count; ++i) {
+            child->keys[child->count + 1 + i] = right->keys[i];
+            child_inner->children[child->count + 1 + i] =
+                right_inner->children[i];
+        }
+        child_inner->children[child->count + 1 + right->count] =
+            right_inner->children[right->count];
+        child->count += right->count + 1;
+    }
+
+    inner_remove(parent, index);
+    node_free(map, right);
+    return index;
+}
+
+b8 btree_map_erase(btree_map *map, u64 key) {
+    if (!map || !map->root) {
+        return false;
+    }
+
+    // Nodes are topped up on the way down, so removing from the leaf, or
+    // merging beneath a node, never leaves anything below the minimum.
+    btree_node *node = map->root;
+    while (!node->is_leaf) {
+        btree_inner *inner = (btree_inner *)node;
+        u32 index = node_child_index(node, key);
+        if (inner->children[index]->count <= BTREE_MAP_MIN_KEYS) {
+            index = fix_child(map, inner, index);
+        }
+        btree_node *child = inner->children[index];
+
+        // A merge can empty the root; its only child takes its place.
+        if (node == map->root && node->count == 0) {
+            map->root = child;
+            node_free(map, node);
+        }
+        node = child;
+    }
+
+    btree_leaf *leaf = (btree_leaf *)node;
+    u32 index = node_lower_index(node, key);
+    if (index == node->count || node->keys[index] != key) {
+        return false;
+    }
+
+    leaf_shift_left(map, leaf, index);
+    node->count--;
+    map->count--;
+    return true;
+}
+
+void *btree_map_get(btree_map *map, u64 key) {
+    if (!map || !map->root) {
+        return 0;
+    }
+
+    btree_node *node = map->root;
+    while (!node->is_leaf) {
+        node = ((btree_inner *)node)->children[node_child_index(node, key)];
+    }
+
+    u32 index = node_lower_index(node, key);
+    if (index == node->count || node->keys[index] != key) {
+        return 0;
+    }
+    return leaf_value(map, (btree_leaf *)node, index);
+}
+
+btree_map_iterator btree_map_begin(btree_map *map) {
+    btree_map_iterator iterator = {0};
+    if (!map || !map->root) {
+        return iterator;
+    }
+
+    btree_node *node = map->root;
+    while (!node->is_leaf) {
+        node = ((btree_inner *)node)->children[0];
+    }
+
+    iterator.leaf = node->count ? node : 0;
+    iterator.element_size = map->element_size;
+    return iterator;
+}
+
+btree_map_iterator btree_map_lower_bound(btree_map *map, u64 key) {
+    btree_map_iterator iterator = {0};
+    if (!map || !map->root) {
+        return iterator;
+    }
+
+    btree_node *node = map->root;
+    while (!node->is_leaf) {
+        node = ((btree_inner *)node)->children[node_child_index(node, key)];
+    }
+
+    iterator.element_size = map->element_size;
+    iterator.index = node_lower_index(node, key);
+    iterator.leaf = node;
+    if (iterator.index == node->count) {
+        // Every larger key is in a later leaf. Only an empty root leaf has no
+        // entries, and it has no next.
+        iterator.leaf = ((btree_leaf *)node)->next;
+        iterator.index = 0;
+    }
+    return iterator;
+}
+
+b8 btree_map_iterator_valid(const btree_map_iterator *iterator) {
+    return iterator && iterator->leaf;
+}
+
+void btree_map_iterator_next(btree_map_iterator *iterator) {
+    if (!btree_map_iterator_valid(iterator)) {
+        return;
+    }
+
+    btree_leaf *leaf = iterator->leaf;
+    iterator->index++;
+    if (iterator->index == leaf->base.count) {
+        iterator->leaf = leaf->next;
+        iterator->index = 0;
+    }
+}
+
+u64 btree_map_iterator_key(const btree_map_iterator *iterator) {
+    return ((btree_leaf *)iterator->leaf)->base.keys[iterator->index];
+}
+
+void *btree_map_iterator_value(const btree_map_iterator *iterator) {
+    return (u8 *)((btree_leaf *)iterator->leaf + 1) +
+           iterator->element_size * iterator->index;
+}
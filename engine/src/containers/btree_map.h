@@ -0,0 +1,150 @@
+/**
+ * @file btree_map.h
+ * @brief This file contains an ordered map from u64 keys to fixed-size values,
+ * built as a B+ tree with cache-line sized nodes.
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief The most keys a node holds. With the node header this fills two
+ * cache lines of keys, which are searched linearly.
+ */
+#define BTREE_MAP_NODE_KEYS 15
+
+/** @brief The size of each page of nodes taken from the memory system. */
+#define BTREE_MAP_PAGE_SIZE (16 * 1024)
+
+/**
+ * @brief Represents an ordered map. Members of this structure should not be
+ * modified outside the functions associated with it.
+ *
+ * Values live in the leaves, which are linked in key order for iteration;
+ * inner nodes only hold separator keys. Nodes are cache-line aligned and come
+ * from a pool of pages allocated with MEMORY_TAG_BST, with freed nodes kept on
+ * an intrusive free list. Insert and erase may move values between leaves, so
+ * value pointers are only valid until the map is next modified.
+ */
+typedef struct btree_map {
+    u64 element_size;
+    /** @brief The number of entries in the map. */
+    u64 count;
+    /** @brief The size of every node, inner or leaf, in bytes. */
+    u64 node_size;
+    /** @brief The root node, a leaf while the map is small. */
+    void *root;
+    /** @brief Nodes that are free to be reused. */
+    void *free_nodes;
+    /** @brief The pages nodes are carved from, linked through their first
+     * bytes. */
+    void *pages;
+} btree_map;
+
+/**
+ * @brief A position in a btree_map, used to walk entries in key order.
+ * Invalidated when the map is modified.
+ */
+typedef struct btree_map_iterator {
+    /** @brief The current leaf, or 0 once past the last entry. */
+    void *leaf;
+    /** @brief The entry within the leaf. */
+    u32 index;
+    u64 element_size;
+} btree_map_iterator;
+
+/**
+ * @brief Creates an empty map and stores it in out_map. Memory is allocated
+ * internally and released by btree_map_destroy.
+ *
+ * @param element_size The size of each value in bytes.
+ * @param out_map A pointer to hold the map.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 btree_map_create(u64 element_size, btree_map *out_map);
+
+/**
+ * @brief Destroys the provided map and frees its memory.
+ *
+ * @param map The map to be destroyed.
+ */
+KAPI void btree_map_destroy(btree_map *map);
+
+/**
+ * @brief Stores a copy of value under key, replacing any value already there.
+ *
+ * @param map The map to use.
+ * @param key The key of the entry.
+ * @param value A pointer to element_size bytes to copy in.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 btree_map_insert(btree_map *map, u64 key, const void *value);
+
+/**
+ * @brief Removes the entry with the given key.
+ *
+ * @param map The map to use.
+ * @param key The key of the entry.
+ * @return True if the entry existed and was removed; otherwise False.
+ */
+KAPI b8 btree_map_erase(btree_map *map, u64 key);
+
+/**
+ * @brief Gets the value stored under a key.
+ *
+ * @param map The map to use.
+ * @param key The key of the entry.
+ * @return A pointer to the value, or 0 if there is no such entry.
+ */
+KAPI void *btree_map_get(btree_map *map, u64 key);
+
+/**
+ * @brief Gets an iterator at the entry with the smallest key.
+ *
+ * @param map The map to use.
+ * @return The iterator. Not valid if the map is empty.
+ */
+KAPI btree_map_iterator btree_map_begin(btree_map *map);
+
+/**
+ * @brief Gets an iterator at the first entry whose key is not less than key.
+ *
+ * @param map The map to use.
+ * @param key The key to search for.
+ * @return The iterator. Not valid if every key is less than key.
+ */
+KAPI btree_map_iterator btree_map_lower_bound(btree_map *map, u64 key);
+
+/**
+ * @brief Indicates if an iterator is at an entry.
+ *
+ * @param iterator The iterator to check.
+ * @return True if the iterator is at an entry; False once past the last.
+ */
+KAPI b8 btree_map_iterator_valid(const btree_map_iterator *iterator);
+
+/**
+ * @brief Moves an iterator to the entry with the next larger key.
+ *
+ * @param iterator The iterator to move.
+ */
+KAPI void btree_map_iterator_next(btree_map_iterator *iterator);
+
+/**
+ * @brief Gets the key of the entry an iterator is at.
+ *
+ * @param iterator A valid iterator.
+ * @return The key.
+ */
+KAPI u64 btree_map_iterator_key(const btree_map_iterator *iterator);
+
+/**
+ * @brief Gets the value of the entry an iterator is at.
+ *
+ * @param iterator A valid iterator.
+ * @return A pointer to the value.
+ */
+KAPI void *btree_map_iterator_value(const btree_map_iterator *iterator);
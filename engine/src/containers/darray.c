@@ -2,23 +2,70 @@
 
 #include "core/kmemory.h"
 #include "core/logger.h"
-#include "core/utils.h"
+
+static darray_growth_policy growth_policy = {DARRAY_DEFAULT_GROWTH_PERCENT,
+                                             DARRAY_DEFAULT_MIN_CAPACITY};
+
+static u64 darray_block_size(u64 capacity, u64 stride) {
+    return DARRAY_FIELD_LENGTH * sizeof(u64) + capacity * stride;
+}
 
 void *_darray_create(u64 length, u64 stride) {
-    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
-    u64 array_size = length * stride;
-    u64 *new_array = kallocate(header_size + array_size, MEMORY_TAG_DARRAY);
-    kset_memory(new_array, 0, header_size + array_size);
+    // kallocate already hands back zeroed memory.
+    u64 *new_array =
+        kallocate(darray_block_size(length, stride), MEMORY_TAG_DARRAY);
     new_array[DARRAY_CAPACITY] = length;
     new_array[DARRAY_LENGTH] = 0;
     new_array[DARRAY_STRIDE] = stride;
-    return (void *)(new_array + DARRAY_FIELD_LENGTH);
+    return new_array + DARRAY_FIELD_LENGTH;
 }
+
+// Grows array to hold at least required elements, by the growth policy. The
+// block is extended in place when possible; otherwise it is moved, copying the
+// header and elements. New elements are not initialised. On failure the array
+// is returned unchanged, so callers must check the capacity before writing.
+static void *darray_grow(void *array, u64 required) {
+    u64 *header = (u64 *)array - DARRAY_FIELD_LENGTH;
+    u64 capacity = header[DARRAY_CAPACITY];
+    u64 stride = header[DARRAY_STRIDE];
+
+    u64 new_capacity = capacity * growth_policy.growth_percent / 100;
+    if (new_capacity <= capacity) {
+        new_capacity = capacity + 1;
+    }
+    if (new_capacity < growth_policy.min_capacity) {
+        new_capacity = growth_policy.min_capacity;
+    }
+    if (new_capacity < required) {
+        new_capacity = required;
+    }
+
+    u64 *new_header =
+        kreallocate(header, darray_block_size(capacity, stride),
+                    darray_block_size(new_capacity, stride), MEMORY_TAG_DARRAY);
+    if (!new_header) {
+        KERROR("darray_grow - failed to grow array to %llu elements.",
+               new_capacity);
+        return array;
+    }
+
+    new_header[DARRAY_CAPACITY] = new_capacity;
+    return new_header + DARRAY_FIELD_LENGTH;
+}
+
+void darray_set_growth_policy(darray_growth_policy policy) {
+    if (policy.growth_percent < 110) {
+        policy.growth_percent = 110;
+    }
+    growth_policy = policy;
+}
+
+darray_growth_policy darray_get_growth_policy() { return growth_policy; }
+
 void _darray_destroy(void *array) {
     u64 *header = (u64 *)array - DARRAY_FIELD_LENGTH;
-    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
     u64 total_size =
-        header_size + header[DARRAY_CAPACITY] * header[DARRAY_STRIDE];
+        darray_block_size(header[DARRAY_CAPACITY], header[DARRAY_STRIDE]);
     kfree(header, total_size, MEMORY_TAG_DARRAY);
 }
 
@@ -32,15 +79,7 @@ void _darray_field_set(void *array, u64 field, u64 value) {
 }
 
 void *_darray_resize(void *array) {
-    u64 length = darray_length(array);
-    u64 stride = darray_stride(array);
-    void *temp =
-        _darray_create(DARRAY_RESIZE_FACTOR * darray_capacity(array), stride);
-    kcopy_memory(temp, array, length * stride);
-
-    _darray_field_set(temp, DARRAY_LENGTH, length);
-    _darray_destroy(array);
-    return temp;
+    return darray_grow(array, darray_capacity(array) + 1);
 }
 
 void *_darray_push(void *array, const void *value_ptr) {
@@ -48,6 +87,11 @@ void *_darray_push(void *array, const void *value_ptr) {
     u64 stride = darray_stride(array);
     if (length >= darray_capacity(array)) {
         array = _darray_resize(array);
+        if (length >= darray_capacity(array)) {
+            KERROR("_darray_push - array is full and could not grow. The value "
+                   "was not pushed.");
+            return array;
+        }
     }
 
     u64 addr = (u64)array;
@@ -56,6 +100,24 @@ void *_darray_push(void *array, const void *value_ptr) {
     _darray_field_set(array, DARRAY_LENGTH, length + 1);
     return array;
 }
+void *_darray_push_n(void *array, const void *values, u64 count) {
+    u64 length = darray_length(array);
+    u64 stride = darray_stride(array);
+    if (length + count > darray_capacity(array)) {
+        array = darray_grow(array, length + count);
+        if (length + count > darray_capacity(array)) {
+            KERROR("_darray_push_n - array could not grow to %llu elements. "
+                   "No values were pushed.",
+                   length + count);
+            return array;
+        }
+    }
+
+    kcopy_memory((u8 *)array + length * stride, values, count * stride);
+    _darray_field_set(array, DARRAY_LENGTH, length + count);
+    return array;
+}
+
 void _darray_pop(void *array, void *dest) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
@@ -98,6 +160,11 @@ void *_darray_insert_at(void *array, u64 index, void *value_ptr) {
 
     if (length >= darray_capacity(array)) {
         array = _darray_resize(array);
+        if (length >= darray_capacity(array)) {
+            KERROR("_darray_insert_at - array is full and could not grow. The "
+                   "value was not inserted.");
+            return array;
+        }
     }
 
     u64 addr = (u64)array;
@@ -116,13 +183,10 @@ void *_darray_insert_at(void *array, u64 index, void *value_ptr) {
 void *_darray_reserve_on(void *array, u64 count_to_add) {
     u64 len = _darray_field_get(array, DARRAY_LENGTH);
     u64 capacity = _darray_field_get(array, DARRAY_CAPACITY);
-    u64 stride = _darray_field_get(array, DARRAY_STRIDE);
 
     if (len + count_to_add <= capacity) {
         return array;
     }
 
-    void *temp = _darray_create(next_pow2_u64(len + count_to_add), stride);
-    kcopy_memory(temp, array, len * stride);
-    return temp;
+    return darray_grow(array, len + count_to_add);
 }
@@ -8,6 +8,8 @@
  * u64 length
  * u64 stride
  * void *elements
+ *
+ * Elements past length are zeroed on create, but not after the array grows.
  */
 
 enum { DARRAY_CAPACITY, DARRAY_LENGTH, DARRAY_STRIDE, DARRAY_FIELD_LENGTH };
@@ -21,6 +23,7 @@ KAPI void _darray_field_set(void *array, u64 field, u64 value);
 KAPI void *_darray_resize(void *array);
 
 KAPI void *_darray_push(void *array, const void *value_ptr);
+KAPI void *_darray_push_n(void *array, const void *values, u64 count);
 KAPI void _darray_pop(void *array, void *dest);
 
 KAPI void *_darray_pop_at(void *array, u64 index, void *dest);
@@ -28,8 +31,31 @@ KAPI void *_darray_insert_at(void *array, u64 index, void *value_ptr);
 
 KAPI void *_darray_reserve_on(void *array, u64 count_to_add);
 
-#define DARRAY_DEFAULT_CAPACITY 1
-#define DARRAY_RESIZE_FACTOR 2
+/**
+ * @brief How arrays grow once full. Growth goes through kreallocate, so it
+ * happens in place when the allocator has room after the array.
+ */
+typedef struct darray_growth_policy {
+    /** @brief The new capacity as a percentage of the old. At least 110. */
+    u32 growth_percent;
+    /** @brief The smallest capacity an array grows to. */
+    u64 min_capacity;
+} darray_growth_policy;
+
+#define DARRAY_DEFAULT_GROWTH_PERCENT 200
+#define DARRAY_DEFAULT_MIN_CAPACITY 8
+#define DARRAY_DEFAULT_CAPACITY DARRAY_DEFAULT_MIN_CAPACITY
+
+/**
+ * @brief Sets the growth policy used by every array from now on. Not thread
+ * safe; set it at startup.
+ *
+ * @param policy The policy. growth_percent is clamped to at least 110.
+ */
+KAPI void darray_set_growth_policy(darray_growth_policy policy);
+
+/** @brief Gets the current growth policy. */
+KAPI darray_growth_policy darray_get_growth_policy();
 
 #define darray_create(type)                                                    \
     _darray_create(DARRAY_DEFAULT_CAPACITY, sizeof(type))
@@ -44,6 +70,10 @@ KAPI void *_darray_reserve_on(void *array, u64 count_to_add);
         array = _darray_push(array, &temp);                                    \
     }
 
+// Appends count elements copied from values, growing at most once.
+#define darray_push_n(array, values, count)                                    \
+    array = _darray_push_n(array, values, count);
+
 #define darray_pop(array, value_ptr) _darray_pop(array, value_ptr)
 
 #define darray_insert_at(array, index, value)                                  \
@@ -2,29 +2,207 @@
 #include "core/kmemory.h"
 #include "core/logger.h"
 
+// Every free range sits in two AVL trees: one ordered by offset, used to find
+// neighbours to merge with, and one ordered by size then offset, used for the
+// best-fit search.
+#define TREE_OFFSET 0
+#define TREE_SIZE 1
+
 typedef struct freelist_node {
-    u32 offset;
-    u32 size;
-    struct freelist_node *next;
+    u64 offset;
+    u64 size;
+    // [tree][0] is the left child, [tree][1] the right child.
+    struct freelist_node *children[2][2];
+    u8 heights[2];
 } freelist_node;
 
 typedef struct internal_state {
-    u32 total_size;
-    u32 max_entries;
+    u64 total_size;
+    u64 max_entries;
+    // Nodes past this index have never been handed out, so need no setup.
+    u64 unused_index;
+    u64 free_space;
+    // Returned nodes, linked through their left offset-tree child.
     freelist_node *free_node_head;
-    freelist_node *head;
+    freelist_node *roots[2];
     freelist_node *nodes;
 } internal_state;
 
 freelist_node *get_node(freelist *list);
 void return_node(freelist *list, freelist_node *node);
 
+static i32 tree_compare(u8 tree, freelist_node *a, freelist_node *b) {
+    if (tree == TREE_SIZE && a->size != b->size) {
+        return a->size < b->size ? -1 : 1;
+    }
+    if (a->offset != b->offset) {
+        return a->offset < b->offset ? -1 : 1;
+    }
+    return 0;
+}
+
+static u8 tree_height(u8 tree, freelist_node *node) {
+    return node ? node->heights[tree] : 0;
+}
+
+static i32 tree_balance_factor(u8 tree, freelist_node *node) {
+    return (i32)tree_height(tree, node->children[tree][1]) -
+           (i32)tree_height(tree, node->children[tree][0]);
+}
+
+static void tree_update_height(u8 tree, freelist_node *node) {
+    u8 left = tree_height(tree, node->children[tree][0]);
+    u8 right = tree_height(tree, node->children[tree][1]);
+    node->heights[tree] = (left > right ? left : right) + 1;
+}
+
+// Rotates the child on side up into node's place. Returns the new subtree root.
+static freelist_node *tree_rotate(u8 tree, freelist_node *node, u8 side) {
+    freelist_node *child = node->children[tree][side];
+    node->children[tree][side] = child->children[tree][!side];
+    child->children[tree][!side] = node;
+    tree_update_height(tree, node);
+    tree_update_height(tree, child);
+    return child;
+}
+
+static freelist_node *tree_balance(u8 tree, freelist_node *node) {
+    tree_update_height(tree, node);
+    i32 balance = tree_balance_factor(tree, node);
+    if (balance < -1 || balance > 1) {
+        u8 side = balance > 1;
+        freelist_node *child = node->children[tree][side];
+        i32 child_balance = tree_balance_factor(tree, child);
+        // Double rotation when the child leans the other way.
+        if ((side && child_balance < 0) || (!side && child_balance > 0)) {
+            node->children[tree][side] = tree_rotate(tree, child, !side);
+        }
+        return tree_rotate(tree, node, side);
+    }
+    return node;
+}
+
+static freelist_node *tree_insert(u8 tree, freelist_node *root,
+                                  freelist_node *node) {
+    if (!root) {
+        node->children[tree][0] = 0;
+        node->children[tree][1] = 0;
+        node->heights[tree] = 1;
+        return node;
+    }
+    u8 side = tree_compare(tree, node, root) > 0;
+    root->children[tree][side] =
+        tree_insert(tree, root->children[tree][side], node);
+    return tree_balance(tree, root);
+}
+
+static freelist_node *tree_remove_min(u8 tree, freelist_node *root,
+                                      freelist_node **out_min) {
+    if (!root->children[tree][0]) {
+        *out_min = root;
+        return root->children[tree][1];
+    }
+    root->children[tree][0] =
+        tree_remove_min(tree, root->children[tree][0], out_min);
+    return tree_balance(tree, root);
+}
+
+// NOTE: node must be in the tree, with the keys it was inserted with.
+static freelist_node *tree_remove(u8 tree, freelist_node *root,
+                                  freelist_node *node) {
+    i32 compare = tree_compare(tree, node, root);
+    if (compare != 0) {
+        u8 side = compare > 0;
+        root->children[tree][side] =
+            tree_remove(tree, root->children[tree][side], node);
+        return tree_balance(tree, root);
+    }
+
+    freelist_node *left = root->children[tree][0];
+    freelist_node *right = root->children[tree][1];
+    if (!right) {
+        return left;
+    }
+    freelist_node *min = 0;
+    right = tree_remove_min(tree, right, &min);
+    min->children[tree][0] = left;
+    min->children[tree][1] = right;
+    return tree_balance(tree, min);
+}
+
+static void range_insert(internal_state *state, freelist_node *node) {
+    for (u8 tree = 0; tree < 2; tree++) {
+        state->roots[tree] = tree_insert(tree, state->roots[tree], node);
+    }
+}
+
+static void range_remove(internal_state *state, freelist_node *node) {
+    for (u8 tree = 0; tree < 2; tree++) {
+        state->roots[tree] = tree_remove(tree, state->roots[tree], node);
+    }
+}
+
+// Changes a range that keeps its place in offset order, so only the size tree
+// needs updating.
+static void range_update(internal_state *state, freelist_node *node,
+                         u64 offset, u64 size) {
+    state->roots[TREE_SIZE] =
+        tree_remove(TREE_SIZE, state->roots[TREE_SIZE], node);
+    node->offset = offset;
+    node->size = size;
+    state->roots[TREE_SIZE] =
+        tree_insert(TREE_SIZE, state->roots[TREE_SIZE], node);
+}
+
+u64 freelist_default_capacity(u64 total_size) {
+    u64 max_entries = total_size / FREELIST_BYTES_PER_ENTRY;
+    if (max_entries < FREELIST_MIN_ENTRIES) {
+        return FREELIST_MIN_ENTRIES;
+    }
+    if (max_entries > FREELIST_DEFAULT_MAX_ENTRIES) {
+        return FREELIST_DEFAULT_MAX_ENTRIES;
+    }
+    return max_entries;
+}
+
+static u64 freelist_memory_requirement(u64 max_entries) {
+    return sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
+}
+
+// Empties both trees. Nodes are set up as they are first handed out.
+static void freelist_reset_empty(internal_state *state) {
+    state->roots[TREE_OFFSET] = 0;
+    state->roots[TREE_SIZE] = 0;
+    state->free_node_head = 0;
+    state->unused_index = 0;
+    state->free_space = 0;
+}
+
+// Leaves a single free range covering everything.
+static void freelist_reset(internal_state *state) {
+    freelist_reset_empty(state);
+
+    freelist_node *head = &state->nodes[state->unused_index++];
+    head->offset = 0;
+    head->size = state->total_size;
+    range_insert(state, head);
+    state->free_space = state->total_size;
+}
+
 void freelist_create(u64 total_size, u64 *memory_requirement, void *memory,
                      freelist *out_list) {
-    // Enough space to hold state and all nodes
-    u32 max_entries = (total_size / sizeof(void *));
-    *memory_requirement =
-        sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
+    freelist_create_with_capacity(total_size,
+                                  freelist_default_capacity(total_size),
+                                  memory_requirement, memory, out_list);
+}
+
+void freelist_create_with_capacity(u64 total_size, u64 max_entries,
+                                   u64 *memory_requirement, void *memory,
+                                   freelist *out_list) {
+    if (max_entries < 2) {
+        max_entries = 2;
+    }
+    *memory_requirement = freelist_memory_requirement(max_entries);
 
     if (!memory) {
         return;
@@ -37,32 +215,13 @@ void freelist_create(u64 total_size, u64 *memory_requirement, void *memory,
     }
 
     out_list->memory = memory;
-    kzero_memory(out_list->memory, *memory_requirement);
 
     // Setup state
     internal_state *state = (internal_state *)out_list->memory;
     state->nodes = (void *)(out_list->memory + sizeof(internal_state));
     state->max_entries = max_entries;
     state->total_size = total_size;
-
-    // Setup head node
-    state->head = &state->nodes[0];
-    state->head->offset = 0;
-    state->head->size = total_size;
-    state->head->next = 0;
-
-    state->free_node_head = &state->nodes[1];
-
-    // Invalidate other nodes
-    for (u32 i = 1; i < state->max_entries - 1; i++) {
-        state->nodes[i].offset = INVALID_ID;
-        state->nodes[i].size = INVALID_ID;
-        state->nodes[i].next = &state->nodes[i + 1];
-    }
-
-    state->nodes[state->max_entries - 1].offset = INVALID_ID;
-    state->nodes[state->max_entries - 1].size = INVALID_ID;
-    state->nodes[state->max_entries - 1].next = 0;
+    freelist_reset(state);
 }
 
 void freelist_destroy(freelist *list) {
@@ -71,10 +230,8 @@ void freelist_destroy(freelist *list) {
         return;
     }
 
-    internal_state *state = (internal_state *)list->memory;
-    u32 memory_size =
-        sizeof(internal_state) + sizeof(freelist_node) * state->max_entries;
-    kzero_memory(list->memory, memory_size);
+    // Nodes are only read through the state, so clearing it is enough.
+    kzero_memory(list->memory, sizeof(internal_state));
 }
 
 b8 freelist_allocate_block(freelist *list, u64 size, u64 *out_offset) {
@@ -89,37 +246,63 @@ b8 freelist_allocate_block(freelist *list, u64 size, u64 *out_offset) {
     }
 
     internal_state *state = (internal_state *)list->memory;
-    freelist_node *node = state->head;
-    freelist_node *previous = 0;
+
+    // Best fit: the smallest range that is large enough, lowest offset first.
+    freelist_node *best = 0;
+    freelist_node *node = state->roots[TREE_SIZE];
     while (node) {
-        if (node->size == size) {
-            *out_offset = node->offset;
-            freelist_node *node_to_return = 0;
-            if (previous) {
-                previous->next = node->next;
-                node_to_return = node;
-            } else {
-                node_to_return = state->head;
-                state->head = node->next;
-            }
-            return_node(list, node_to_return);
-            return true;
-        } else if (node->size > size) {
-            *out_offset = node->offset;
-            node->size -= size;
-            node->offset += size;
-            return true;
+        if (node->size >= size) {
+            best = node;
+            node = node->children[TREE_SIZE][0];
+        } else {
+            node = node->children[TREE_SIZE][1];
         }
+    }
+
+    if (!best) {
+        KWARN("freelist_allocate_block - no space was found to allocate block "
+              "of size: %lluB. Remaining space: %lluB.",
+              size, state->free_space);
+        return false;
+    }
+
+    *out_offset = best->offset;
+    state->free_space -= size;
+    if (best->size == size) {
+        range_remove(state, best);
+        return_node(list, best);
+    } else {
+        // Taking from the front keeps its place in offset order.
+        range_update(state, best, best->offset + size, best->size - size);
+    }
+    return true;
+}
+
+b8 freelist_allocate_block_at(freelist *list, u64 offset, u64 size) {
+    if (!list || !list->memory) {
+        KERROR("freelist_allocate_block_at - passed invalid freelist.");
+        return false;
+    }
+
+    internal_state *state = (internal_state *)list->memory;
 
-        previous = node;
-        node = node->next;
+    freelist_node *node = state->roots[TREE_OFFSET];
+    while (node && node->offset != offset) {
+        node = node->children[TREE_OFFSET][node->offset < offset];
     }
 
-    u64 free_space = freelist_free_space(list);
-    KWARN("freelist_allocate_block - no space was found to allocate block of "
-          "size: %uB. Remaining space: %lluB.",
-          size, free_space);
-    return false;
+    if (!node || node->size < size) {
+        return false;
+    }
+
+    state->free_space -= size;
+    if (node->size == size) {
+        range_remove(state, node);
+        return_node(list, node);
+    } else {
+        range_update(state, node, node->offset + size, node->size - size);
+    }
+    return true;
 }
 
 b8 freelist_free_block(freelist *list, u64 size, u64 offset) {
@@ -130,100 +313,76 @@ b8 freelist_free_block(freelist *list, u64 size, u64 offset) {
 
     internal_state *state = (internal_state *)list->memory;
 
-    if (offset > state->total_size || (offset + size) > state->total_size) {
+    if (offset > state->total_size || size > state->total_size - offset) {
         KERROR("freelist_free_block - passed invalid block.");
         return false;
     }
 
-    // Case 1: Completely full -> list is empty
-    if (state->head == 0) {
-        freelist_node *new_node = get_node(list);
-        new_node->offset = offset;
-        new_node->size = size;
-        state->head = new_node;
-        return true;
-    }
-
-    freelist_node *node = state->head;
+    // Find the free ranges either side of the block.
     freelist_node *previous = 0;
+    freelist_node *next = 0;
+    freelist_node *node = state->roots[TREE_OFFSET];
     while (node) {
-        // Case 2: There is a free node after the allocated space
-        if (node->offset > offset) {
-            // sanity check: see if the allocated space is at least as big as
-            // the block
-            if ((offset + size) > node->offset) {
-                KERROR("freelist_free_block - block size invalid.");
-                return false;
-            }
-
-            freelist_node *new_node;
-            if ((offset + size) == node->offset) {
-                // Case 2.1a: that free node is directly after the allocated
-                // space
-                node->offset -= size;
-                node->size += size;
-                new_node = node;
-            } else {
-                // Case 2.1b: that free node is not directly after the allocated
-                // space
-                // Certain scenarios a get will get called when not
-                // needed. Makes the logic a lot cleaner though
-                new_node = get_node(list);
-                new_node->offset = offset;
-                new_node->size = size;
-                new_node->next = node;
-            }
-
-            // Case 2.2a: This is the new head node
-            if (!previous) {
-                state->head = new_node;
-                return true;
-            }
-
-            // Case 2.2b: This is a middle insert
-            previous->next = new_node;
-
-            // Case 2.3: The previous chuck of memory is directly behind the
-            // allocated space
-            if ((previous->offset + previous->size) == new_node->offset) {
-                previous->size += new_node->size;
-                previous->next = new_node->next;
-
-                return_node(list, new_node);
-            }
-
-            return true;
-        } else if (node->offset == offset) {
-            // Case 0: You fucked up
+        if (node->offset == offset) {
             KERROR("freelist_free_block - block offset already in freelist.");
             return false;
         }
-
-        previous = node;
-        node = node->next;
+        if (node->offset < offset) {
+            previous = node;
+            node = node->children[TREE_OFFSET][1];
+        } else {
+            next = node;
+            node = node->children[TREE_OFFSET][0];
+        }
     }
 
-    // Case 3: Tail insert
-    // Case 0: You fucked up
-    if ((previous->offset + previous->size) > offset) {
+    if (previous && (previous->offset + previous->size) > offset) {
         KERROR("freelist_free_block - free block overlaps with allocation.");
         return false;
     }
+    if (next && (offset + size) > next->offset) {
+        KERROR("freelist_free_block - block size invalid.");
+        return false;
+    }
 
-    // Case 3a: Tail insert directly after a free space
-    if ((previous->offset + previous->size) == offset) {
-        previous->size += size;
-        return true;
+    b8 merge_previous =
+        previous && (previous->offset + previous->size) == offset;
+    b8 merge_next = next && (offset + size) == next->offset;
+
+    if (merge_previous && merge_next) {
+        // The block bridges two ranges; fold the second into the first.
+        u64 merged_size = previous->size + size + next->size;
+        range_remove(state, next);
+        return_node(list, next);
+        range_update(state, previous, previous->offset, merged_size);
+    } else if (merge_previous) {
+        range_update(state, previous, previous->offset, previous->size + size);
+    } else if (merge_next) {
+        range_update(state, next, offset, next->size + size);
+    } else {
+        freelist_node *new_node = get_node(list);
+        if (!new_node) {
+            return false;
+        }
+        new_node->offset = offset;
+        new_node->size = size;
+        range_insert(state, new_node);
     }
 
-    // Case 3b: Tail insert not directly after a free space
-    freelist_node *new_node = get_node(list);
-    new_node->offset = offset;
-    new_node->size = size;
-    previous->next = new_node;
+    state->free_space += size;
     return true;
 }
 
+// Frees every range of an old offset tree, in order, into the new list.
+static b8 freelist_copy_ranges(freelist *list, freelist_node *node) {
+    if (!node) {
+        return true;
+    }
+    return freelist_copy_ranges(list, node->children[TREE_OFFSET][0]) &&
+           freelist_free_block(list, node->size, node->offset) &&
+           freelist_copy_ranges(list, node->children[TREE_OFFSET][1]);
+}
+
 KAPI b8 freelist_resize(freelist *list, u64 *memory_requirement,
                         void *new_memory, u64 new_size, void **out_old_memory) {
     if (!list || !list->memory) {
@@ -243,9 +402,13 @@ KAPI b8 freelist_resize(freelist *list, u64 *memory_requirement,
         return false;
     }
 
-    u32 max_entries = (new_size / sizeof(void *));
-    *memory_requirement =
-        sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
+    // Never shrink the node pool; the old ranges plus the new space at the
+    // end may need all of it and one more.
+    u64 max_entries = freelist_default_capacity(new_size);
+    if (max_entries <= old_state->max_entries) {
+        max_entries = old_state->max_entries + 1;
+    }
+    *memory_requirement = freelist_memory_requirement(max_entries);
 
     if (!new_memory) {
         return true;
@@ -253,101 +416,43 @@ KAPI b8 freelist_resize(freelist *list, u64 *memory_requirement,
 
     *out_old_memory = list->memory;
 
-    u64 size_diff = new_size - old_state->total_size;
-
     list->memory = new_memory;
 
-    kzero_memory(list->memory, *memory_requirement);
-
     internal_state *state = (internal_state *)list->memory;
     state->total_size = new_size;
     state->nodes = (void *)((u64)list->memory + sizeof(internal_state));
     state->max_entries = max_entries;
+    freelist_reset_empty(state);
 
-    state->head = &state->nodes[0];
-    state->free_node_head = &state->nodes[1];
-
-    // Invalidate other nodes
-    for (u32 i = 1; i < state->max_entries - 1; i++) {
-        state->nodes[i].offset = INVALID_ID;
-        state->nodes[i].size = INVALID_ID;
-        state->nodes[i].next = &state->nodes[i + 1];
-    }
-
-    state->nodes[state->max_entries - 1].offset = INVALID_ID;
-    state->nodes[state->max_entries - 1].size = INVALID_ID;
-    state->nodes[state->max_entries - 1].next = 0;
-
-    // Copy over nodes
-    freelist_node *new_node = state->head;
-    freelist_node *old_node = old_state->head;
-
-    if (!old_node) {
-        // Case: entire old list was allocated
-        new_node->offset = old_state->total_size;
-        new_node->size = size_diff;
-        new_node->next = 0;
-    } else {
-        while (old_node) {
-            new_node->size = old_node->size;
-            new_node->offset = old_node->offset;
-            new_node->next = 0;
-
-            if (old_node->next) {
-                old_node = old_node->next;
-                new_node->next = get_node(list);
-                new_node = new_node->next;
-                continue;
-            }
-
-            if (old_node->offset + old_node->size == old_state->total_size) {
-                new_node->size += size_diff;
-            } else {
-                new_node->next = get_node(list);
-                new_node = new_node->next;
-                new_node->offset = old_state->total_size;
-                new_node->size = size_diff;
-                new_node->next = 0;
-            }
-            old_node = old_node->next;
-        }
+    // Start fully allocated, then free the old ranges and the new space.
+    if (!freelist_copy_ranges(list, old_state->roots[TREE_OFFSET])) {
+        return false;
     }
-
-    return true;
+    return freelist_free_block(list, new_size - old_state->total_size,
+                               old_state->total_size);
 }
 
 void freelist_clear(freelist *list) {
     internal_state *state = (internal_state *)list->memory;
-
-    // Setup head node
-    state->head = &state->nodes[0];
-    state->head->offset = 0;
-    state->head->size = state->total_size;
-    state->head->next = 0;
-
-    // Invalidate other nodes
-    for (u32 i = 1; i < state->max_entries - 1; i++) {
-        state->nodes[i].offset = INVALID_ID;
-        state->nodes[i].size = INVALID_ID;
-        state->nodes[i].next = &state->nodes[i + 1];
-    }
-
-    state->nodes[state->max_entries - 1].offset = INVALID_ID;
-    state->nodes[state->max_entries - 1].size = INVALID_ID;
-    state->nodes[state->max_entries - 1].next = 0;
+    freelist_reset(state);
 }
 
 u64 freelist_free_space(freelist *list) {
     internal_state *state = (internal_state *)list->memory;
-    u64 free_space = 0;
+    return state->free_space;
+}
 
-    freelist_node *node = state->head;
-    while (node) {
-        free_space += node->size;
-        node = node->next;
-    }
+u64 freelist_largest_free_block(freelist *list) {
+    internal_state *state = (internal_state *)list->memory;
 
-    return free_space;
+    freelist_node *node = state->roots[TREE_SIZE];
+    if (!node) {
+        return 0;
+    }
+    while (node->children[TREE_SIZE][1]) {
+        node = node->children[TREE_SIZE][1];
+    }
+    return node->size;
 }
 
 // NOTE: Internal function, shouldn't get a null pointer or invalid list
@@ -355,23 +460,26 @@ freelist_node *get_node(freelist *list) {
     internal_state *state = (internal_state *)list->memory;
 
     freelist_node *node = state->free_node_head;
-    if (!node) {
-        // Full
+    if (node) {
+        // Pop
+        state->free_node_head = node->children[TREE_OFFSET][0];
+    } else if (state->unused_index < state->max_entries) {
+        node = &state->nodes[state->unused_index++];
+    } else {
+        KERROR("freelist - out of nodes; all %llu free ranges are in use. "
+               "Create the freelist with a larger capacity.",
+               state->max_entries);
         return 0;
     }
 
-    // Pop
-    state->free_node_head = node->next;
-
-    node->next = 0;
     return node;
 }
 
 void return_node(freelist *list, freelist_node *node) {
     internal_state *state = (internal_state *)list->memory;
 
-    node->offset = INVALID_ID;
-    node->size = INVALID_ID;
-    node->next = state->free_node_head;
+    node->offset = INVALID_ID_U64;
+    node->size = INVALID_ID_U64;
+    node->children[TREE_OFFSET][0] = state->free_node_head;
     state->free_node_head = node;
 }
@@ -9,10 +9,23 @@
 
 #include "defines.h"
 
+/**
+ * @brief Bytes of managed memory per node in the default node pool. Each free
+ * range takes one node, so this is the smallest average range the default pool
+ * can track across the whole size.
+ */
+#define FREELIST_BYTES_PER_ENTRY 1024
+/** @brief Fewest nodes in the default node pool. */
+#define FREELIST_MIN_ENTRIES 32
+/** @brief Most nodes in the default node pool, whatever the size tracked. */
+#define FREELIST_DEFAULT_MAX_ENTRIES 65536
+
 /**
  * @typedef freelist
  * @brief A data structure to be used alongside an allocator for dynamic memory
- * allocation. Tracks free ranges of memory.
+ * allocation. Tracks free ranges of memory, indexed by size for best-fit
+ * allocation and by offset for merging neighbours on free, so both are
+ * O(log n) in the number of free ranges.
  */
 typedef struct freelist {
     /** @brief contains the internal state of the freelist */
@@ -22,7 +35,7 @@ typedef struct freelist {
 /**
  * @brief Creates a new freelist or gets the memory requirement for one. Call
  * twice; first passing 0 to memory to obtain the memory requirement, second to
- * pass the allocated block.
+ * pass the allocated block. Uses freelist_default_capacity nodes.
  *
  * @param total_size Size that the free list should track, in bytes.
  * @param memory_requirement A pointer to get the memory requirement for the
@@ -33,6 +46,31 @@ typedef struct freelist {
 KAPI void freelist_create(u64 total_size, u64 *memory_requirement, void *memory,
                           freelist *out_list);
 
+/**
+ * @brief Creates a new freelist with room for max_entries free ranges, or gets
+ * the memory requirement for one. Call twice, as with freelist_create. Frees
+ * that would need more ranges than this fail.
+ *
+ * @param total_size Size that the free list should track, in bytes.
+ * @param max_entries The most free ranges tracked at once. At least 2.
+ * @param memory_requirement A pointer to get the memory requirement for the
+ * free_list structure itself.
+ * @param memory 0, or a pre-allocated block of memory for the free-list to use.
+ * @param out_list A pointer to hold the free list.
+ */
+KAPI void freelist_create_with_capacity(u64 total_size, u64 max_entries,
+                                        u64 *memory_requirement, void *memory,
+                                        freelist *out_list);
+
+/**
+ * @brief Gets the number of free ranges freelist_create makes room for.
+ *
+ * @param total_size Size that the free list should track, in bytes.
+ * @return total_size / FREELIST_BYTES_PER_ENTRY, clamped to
+ * [FREELIST_MIN_ENTRIES, FREELIST_DEFAULT_MAX_ENTRIES].
+ */
+KAPI u64 freelist_default_capacity(u64 total_size);
+
 /**
  * @brief Destroys the provided freelist.
  *
@@ -41,7 +79,8 @@ KAPI void freelist_create(u64 total_size, u64 *memory_requirement, void *memory,
 KAPI void freelist_destroy(freelist *list);
 
 /**
- * @brief Attempts to find a allocate block of memory given the size.
+ * @brief Attempts to find a allocate block of memory given the size. Takes
+ * the front of the smallest free range that fits, lowest offset first.
  *
  * @param list The freelist struct.
  * @param size The size to allocate.
@@ -51,7 +90,21 @@ KAPI void freelist_destroy(freelist *list);
 KAPI b8 freelist_allocate_block(freelist *list, u64 size, u64 *out_offset);
 
 /**
- * @brief Attempts to find a free block of memory given the size.
+ * @brief Attempts to allocate size bytes from the front of the free range that
+ * starts exactly at offset. Used to grow an allocation in place into the free
+ * space that follows it.
+ *
+ * @param list The freelist struct.
+ * @param offset The offset the free range must start at.
+ * @param size The size to allocate.
+ * @return True if successful; False if no free range starts at offset or it
+ * is too small.
+ */
+KAPI b8 freelist_allocate_block_at(freelist *list, u64 offset, u64 size);
+
+/**
+ * @brief Attempts to find a free block of memory given the size. Fails if
+ * the block would start a new free range and every node is in use.
  *
  * @param list The freelist struct.
  * @param size The size to free.
@@ -63,7 +116,7 @@ KAPI b8 freelist_free_block(freelist *list, u64 size, u64 offset);
 /**
  * @brief Attempts to resize the provided freelist. Call twice, first to get the
  * new memory requirement, second to resize the freelist. Old memory must be
- * freed after calling resize.
+ * freed after calling resize. The node pool never shrinks.
  * NOTE: New size must be greater than the old size.
  *
  * @param list The freelist struct.
@@ -91,3 +144,11 @@ KAPI void freelist_clear(freelist *list);
  * @return The amount of free space.
  */
 KAPI u64 freelist_free_space(freelist *list);
+
+/**
+ * @brief Obtains the size of the largest free block within the freelist.
+ *
+ * @param list The freelist struct.
+ * @return The size of the largest free block.
+ */
+KAPI u64 freelist_largest_free_block(freelist *list);
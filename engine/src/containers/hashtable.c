@@ -1,29 +1,184 @@
 #include "containers/hashtable.h"
 
 #include "core/kmemory.h"
+#include "core/kstring.h"
 #include "core/logger.h"
+#include "core/utils.h"
 
-u64 hash_name(const char *name, u32 element_count) {
-    // A multiplier to use when generating hash, prime to avoid collisions.
-    static const u64 multiplier = 97;
+// NOTE: distance is the probe distance from the home slot plus one, so that a
+// zeroed slot reads as empty.
+typedef struct hashtable_slot {
+    u32 hash;
+    u32 distance;
+    char *key;
+} hashtable_slot;
+
+#define HASHTABLE_MIN_CAPACITY 8
+
+u32 hash_name(const char *name) {
+    // FNV-1a, folded down to 32 bits.
+    static const u64 offset_basis = 14695981039346656037ULL;
+    static const u64 prime = 1099511628211ULL;
 
     unsigned const char *us;
-    u64 hash = 0;
+    u64 hash = offset_basis;
 
     for (us = (unsigned const char *)name; *us; us++) {
-        hash = hash * multiplier + *us;
+        hash ^= *us;
+        hash *= prime;
+    }
+
+    return (u32)(hash ^ (hash >> 32));
+}
+
+static u64 hashtable_block_size(u32 capacity, u64 element_size) {
+    // Slots, values, then a single default value.
+    return (sizeof(hashtable_slot) + element_size) * capacity + element_size;
+}
+
+static hashtable_slot *hashtable_slots(hashtable *table) {
+    return (hashtable_slot *)table->memory;
+}
+
+static void *hashtable_value(hashtable *table, u32 index) {
+    return table->memory + (sizeof(hashtable_slot) * table->capacity) +
+           (table->element_size * index);
+}
+
+static void *hashtable_default(hashtable *table) {
+    return hashtable_value(table, table->capacity);
+}
+
+static i64 hashtable_find(hashtable *table, const char *name, u32 hash) {
+    hashtable_slot *slots = hashtable_slots(table);
+    u32 mask = table->capacity - 1;
+    u32 index = hash & mask;
+
+    for (u32 distance = 1;; distance++) {
+        hashtable_slot *slot = &slots[index];
+        // Robin Hood invariant: anything further along is closer to home than
+        // the key would be, so the key cannot be present.
+        if (slot->distance < distance) {
+            return -1;
+        }
+        if (slot->hash == hash && strings_equal(slot->key, name)) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+// Inserts a key known not to be present. Takes ownership of key.
+static void hashtable_insert(hashtable *table, u32 hash, char *key,
+                             const void *value) {
+    hashtable_slot *slots = hashtable_slots(table);
+    u32 mask = table->capacity - 1;
+    u32 index = hash & mask;
+    u32 distance = 1;
+
+    // Find where the new entry belongs: the first empty slot, or the first
+    // entry that is closer to its home than the new one would be.
+    while (slots[index].distance >= distance) {
+        index = (index + 1) & mask;
+        distance++;
     }
 
-    hash %= element_count;
+    // Shift the rest of the cluster along by one to make room.
+    u32 empty = index;
+    while (slots[empty].distance) {
+        empty = (empty + 1) & mask;
+    }
+    while (empty != index) {
+        u32 previous = (empty - 1) & mask;
+        slots[empty] = slots[previous];
+        slots[empty].distance++;
+        kcopy_memory(hashtable_value(table, empty),
+                     hashtable_value(table, previous), table->element_size);
+        empty = previous;
+    }
 
-    return hash;
+    slots[index].hash = hash;
+    slots[index].distance = distance;
+    slots[index].key = key;
+    kcopy_memory(hashtable_value(table, index), value, table->element_size);
+    table->count++;
 }
 
-void hashtable_create(u64 element_size, u32 element_count, void *memory,
-                      b8 is_pointer_type, hashtable *out_hashtable) {
-    if (!memory || !out_hashtable) {
-        KERROR("hashtable_create failed! Pointer to memory and out_hashtable "
-               "required.");
+static void hashtable_grow(hashtable *table) {
+    hashtable old = *table;
+
+    table->capacity = old.capacity * 2;
+    table->count = 0;
+    table->memory =
+        kallocate(hashtable_block_size(table->capacity, table->element_size),
+                  MEMORY_TAG_DICT);
+    kcopy_memory(hashtable_default(table), hashtable_default(&old),
+                 table->element_size);
+
+    hashtable_slot *old_slots = hashtable_slots(&old);
+    for (u32 i = 0; i < old.capacity; i++) {
+        if (old_slots[i].distance) {
+            hashtable_insert(table, old_slots[i].hash, old_slots[i].key,
+                             hashtable_value(&old, i));
+        }
+    }
+
+    kfree(old.memory, hashtable_block_size(old.capacity, old.element_size),
+          MEMORY_TAG_DICT);
+}
+
+static void hashtable_store(hashtable *table, const char *name,
+                            const void *value) {
+    u32 hash = hash_name(name);
+    i64 index = hashtable_find(table, name, hash);
+    if (index >= 0) {
+        kcopy_memory(hashtable_value(table, index), value, table->element_size);
+        return;
+    }
+
+    if ((u64)(table->count + 1) * 100 >
+        (u64)table->capacity * HASHTABLE_MAX_LOAD_PERCENT) {
+        hashtable_grow(table);
+    }
+
+    hashtable_insert(table, hash, string_duplicate(name), value);
+}
+
+static b8 hashtable_erase(hashtable *table, const char *name) {
+    u32 hash = hash_name(name);
+    i64 found = hashtable_find(table, name, hash);
+    if (found < 0) {
+        return false;
+    }
+
+    hashtable_slot *slots = hashtable_slots(table);
+    u32 mask = table->capacity - 1;
+    u32 index = found;
+
+    kfree(slots[index].key, string_length(slots[index].key) + 1,
+          MEMORY_TAG_STRING);
+
+    // Backward-shift deletion, no tombstones required.
+    u32 next = (index + 1) & mask;
+    while (slots[next].distance > 1) {
+        slots[index] = slots[next];
+        slots[index].distance--;
+        kcopy_memory(hashtable_value(table, index),
+                     hashtable_value(table, next), table->element_size);
+        index = next;
+        next = (next + 1) & mask;
+    }
+
+    kzero_memory(&slots[index], sizeof(hashtable_slot));
+    kzero_memory(hashtable_value(table, index), table->element_size);
+    table->count--;
+    return true;
+}
+
+void hashtable_create(u64 element_size, u32 element_count, b8 is_pointer_type,
+                      hashtable *out_hashtable) {
+    if (!out_hashtable) {
+        KERROR("hashtable_create failed! Pointer to out_hashtable required.");
         return;
     }
 
@@ -33,18 +188,38 @@ void hashtable_create(u64 element_size, u32 element_count, void *memory,
         return;
     }
 
-    // TODO: Might want to require an allocator and allocate this memory in this
-    // function.
-    out_hashtable->memory = memory;
-    out_hashtable->element_count = element_count;
+    u64 capacity =
+        next_pow2_u64(((u64)element_count * 100) / HASHTABLE_MAX_LOAD_PERCENT +
+                      1);
+    if (capacity < HASHTABLE_MIN_CAPACITY) {
+        capacity = HASHTABLE_MIN_CAPACITY;
+    }
+
     out_hashtable->element_size = element_size;
+    out_hashtable->element_count = element_count;
+    out_hashtable->capacity = (u32)capacity;
+    out_hashtable->count = 0;
     out_hashtable->is_pointer_type = is_pointer_type;
-    kzero_memory(out_hashtable->memory, element_size * element_count);
+    out_hashtable->has_default = false;
+    out_hashtable->memory = kallocate(
+        hashtable_block_size(out_hashtable->capacity, element_size),
+        MEMORY_TAG_DICT);
 }
 
 void hashtable_destroy(hashtable *table) {
     if (table) {
-        // TODO: If using allocator above, free memory here.
+        if (table->memory) {
+            hashtable_slot *slots = hashtable_slots(table);
+            for (u32 i = 0; i < table->capacity; i++) {
+                if (slots[i].distance) {
+                    kfree(slots[i].key, string_length(slots[i].key) + 1,
+                          MEMORY_TAG_STRING);
+                }
+            }
+            kfree(table->memory,
+                  hashtable_block_size(table->capacity, table->element_size),
+                  MEMORY_TAG_DICT);
+        }
         kzero_memory(table, sizeof(hashtable));
     }
 }
@@ -60,9 +235,7 @@ b8 hashtable_set(hashtable *table, const char *name, void *value) {
         return false;
     }
 
-    u64 hash = hash_name(name, table->element_count);
-    kcopy_memory(table->memory + (table->element_size * hash), value,
-                 table->element_size);
+    hashtable_store(table, name, value);
     return true;
 }
 
@@ -77,8 +250,13 @@ b8 hashtable_set_ptr(hashtable *table, const char *name, void **value) {
         return false;
     }
 
-    u64 hash = hash_name(name, table->element_count);
-    ((void **)table->memory)[hash] = value ? *value : 0;
+    if (!value || !*value) {
+        // Unsetting an entry that does not exist is not an error.
+        hashtable_erase(table, name);
+        return true;
+    }
+
+    hashtable_store(table, name, value);
     return true;
 }
 
@@ -93,10 +271,20 @@ b8 hashtable_get(hashtable *table, const char *name, void *out_value) {
         return false;
     }
 
-    u64 hash = hash_name(name, table->element_count);
-    kcopy_memory(out_value, table->memory + (table->element_size * hash),
-                 table->element_size);
-    return true;
+    i64 index = hashtable_find(table, name, hash_name(name));
+    if (index >= 0) {
+        kcopy_memory(out_value, hashtable_value(table, index),
+                     table->element_size);
+        return true;
+    }
+
+    if (table->has_default) {
+        kcopy_memory(out_value, hashtable_default(table), table->element_size);
+        return true;
+    }
+
+    kzero_memory(out_value, table->element_size);
+    return false;
 }
 
 b8 hashtable_get_ptr(hashtable *table, const char *name, void **out_value) {
@@ -111,11 +299,20 @@ b8 hashtable_get_ptr(hashtable *table, const char *name, void **out_value) {
         return false;
     }
 
-    u64 hash = hash_name(name, table->element_count);
-    *out_value = ((void **)table->memory)[hash];
+    i64 index = hashtable_find(table, name, hash_name(name));
+    *out_value = index >= 0 ? *(void **)hashtable_value(table, index) : 0;
     return *out_value != 0;
 }
 
+b8 hashtable_remove(hashtable *table, const char *name) {
+    if (!table || !name) {
+        KERROR("hashtable_remove requires table and name to exist.");
+        return false;
+    }
+
+    return hashtable_erase(table, name);
+}
+
 b8 hashtable_fill(hashtable *table, void *value) {
     if (!table || !value) {
         KERROR("hashtable_get requires table and value to exist.");
@@ -128,10 +325,8 @@ b8 hashtable_fill(hashtable *table, void *value) {
         return false;
     }
 
-    for (u32 i = 0; i < table->element_count; i++) {
-        kcopy_memory(table->memory + (table->element_size * i), value,
-                     table->element_size);
-    }
+    kcopy_memory(hashtable_default(table), value, table->element_size);
+    table->has_default = true;
 
     return true;
 }
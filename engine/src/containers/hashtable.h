@@ -6,34 +6,59 @@
  * @brief Represents a simple hashtable. Members of this structure should not be
  * modified outside the functions associated with it.
  *
+ * Open addressing with linear probing (Robin Hood ordering). Each slot stores
+ * the key's hash and a copy of the key, so colliding names resolve to
+ * separate entries. The table owns its memory and rehashes into a larger
+ * block once the load factor exceeds HASHTABLE_MAX_LOAD_PERCENT.
+ *
  * For non-pointer types, tables retains a copy of the value. For pointer types,
  * make sure to use the _ptr setter and getter. Table does not take ownership of
  * pointers or associated memory allocations, and should be managed externally.
  */
 typedef struct hashtable {
     u64 element_size;
+    /** @brief The number of elements the table was created to hold. */
     u32 element_count;
+    /** @brief The number of slots, always a power of 2. */
+    u32 capacity;
+    /** @brief The number of occupied slots. */
+    u32 count;
     b8 is_pointer_type;
+    /** @brief True once hashtable_fill has set a default value. */
+    b8 has_default;
+    /** @brief Slot metadata, followed by values, followed by the default. */
     void *memory;
 } hashtable;
 
+/** @brief The load factor, in percent, at which the table grows. */
+#define HASHTABLE_MAX_LOAD_PERCENT 75
+
+/**
+ * @brief Hashes a name with FNV-1a, folded down to 32 bits. The hash the table
+ * uses for its keys.
+ *
+ * @param name The null-terminated name to hash.
+ * @return The hash.
+ */
+KAPI u32 hash_name(const char *name);
+
 /**
- * @brief Creates a hashtable and stores it in out_hashtable.
+ * @brief Creates a hashtable and stores it in out_hashtable. Memory is
+ * allocated internally and released by hashtable_destroy.
  *
  * @param element_size The size of each element in bytes.
- * @param element_count The maximum number of elements, cannot be resized.
- * @param memory A block of memory to be used. Should be equal to element_size *
- * element_count.
+ * @param element_count The expected number of elements. Used to size the table
+ * up front; the table grows when it fills past its load factor.
  * @param is_pointer_type Indicates if this hashtable will hold pointer types.
  * @param out_hashtable A pointer to a hashtable in which to hold the relevant
  * data.
  */
-KAPI void hashtable_create(u64 element_size, u32 element_count, void *memory,
+KAPI void hashtable_create(u64 element_size, u32 element_count,
                            b8 is_pointer_type, hashtable *out_hashtable);
 
 /**
- * @brief Destroys the provided hashtable. Does not release memory for pointer
- * types.
+ * @brief Destroys the provided hashtable and frees its memory. Does not release
+ * memory for pointer types.
  *
  * @param table A pointer to the table to be destroyed.
  */
@@ -63,13 +88,16 @@ KAPI b8 hashtable_set(hashtable *table, const char *name, void *value);
 KAPI b8 hashtable_set_ptr(hashtable *table, const char *name, void **value);
 
 /**
- * @brief Obtains a copy of data present in the hashtable.
+ * @brief Obtains a copy of data present in the hashtable. If the entry does not
+ * exist, the default value set by hashtable_fill is copied instead.
  * Only use for tables which were *NOT* created with is_pointer_type = true;
  *
  * @param table A pointer to the table. Required.
  * @param name The name of the entry to be retrieved. Required.
  * @param out_value A pointer to store the retrieved value. Required.
- * @return True; False if a null pointer is passed.
+ * @return True if the entry (or a default) was found; False if a null pointer
+ * is passed or the entry does not exist and no default is set, in which case
+ * out_value is zeroed.
  */
 KAPI b8 hashtable_get(hashtable *table, const char *name, void *out_value);
 
@@ -85,9 +113,19 @@ KAPI b8 hashtable_get(hashtable *table, const char *name, void *out_value);
 KAPI b8 hashtable_get_ptr(hashtable *table, const char *name, void **out_value);
 
 /**
- * @brief Fills all entries with the given value. Useful when non-existent
- * 'names' should retrieve a default value. Should *NOT* be used with tables
- * which were created with is_pointer_type = true;
+ * @brief Removes an entry from the hashtable, releasing its stored key.
+ *
+ * @param table A pointer to the table. Required.
+ * @param name The name of the entry to be removed. Required.
+ * @return True if the entry existed and was removed; otherwise False.
+ */
+KAPI b8 hashtable_remove(hashtable *table, const char *name);
+
+/**
+ * @brief Sets the value returned by hashtable_get for names that have no
+ * entry. Useful when non-existent 'names' should retrieve a default value.
+ * Should *NOT* be used with tables which were created with is_pointer_type =
+ * true;
  *
  * @param table A pointer to the table to be filled. Required.
  * @param value The value to be filled with. Required.
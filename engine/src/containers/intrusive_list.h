@@ -0,0 +1,236 @@
+/**
+ * @file intrusive_list.h
+ * @brief This file contains an intrusive doubly linked list, whose nodes are
+ * embedded in the structures they link.
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief The links embedded in a structure to put it in an intrusive_list. A
+ * node is in at most one list at a time; unlinked nodes have both links 0.
+ */
+typedef struct intrusive_list_node {
+    struct intrusive_list_node *prev;
+    struct intrusive_list_node *next;
+} intrusive_list_node;
+
+/**
+ * @brief An intrusive doubly linked list. The list owns no memory: it links
+ * nodes embedded in the caller's structures, so walking it touches only those
+ * structures, and every operation other than clearing is O(1).
+ *
+ * The list is circular through root, which acts as both the node before the
+ * head and the node after the tail, so linking never checks for empty ends.
+ * A list must not be copied by value once it holds nodes.
+ */
+typedef struct intrusive_list {
+    intrusive_list_node root;
+    /** @brief The number of nodes in the list. */
+    u64 length;
+} intrusive_list;
+
+/**
+ * @brief Gets the structure a node is embedded in.
+ *
+ * @param node A pointer to the node.
+ * @param type The type of the structure.
+ * @param member The name of the node member within the structure.
+ */
+#define intrusive_list_entry(node, type, member)                               \
+    ((type *)((u8 *)(node) - __builtin_offsetof(type, member)))
+
+/**
+ * @brief Walks every node of a list from head to tail. The current node must
+ * not be removed while walking; use intrusive_list_next beforehand instead.
+ *
+ * @param list A pointer to the list.
+ * @param node The name of the intrusive_list_node pointer to declare.
+ */
+#define intrusive_list_for_each(list, node)                                    \
+    for (intrusive_list_node *node = (list)->root.next; node != &(list)->root; \
+         node = node->next)
+
+/**
+ * @brief Makes a list empty. Must be called before the list is used. Nodes
+ * already in it are not unlinked.
+ *
+ * @param list The list to initialize.
+ */
+KINLINE void intrusive_list_init(intrusive_list *list) {
+    list->root.prev = &list->root;
+    list->root.next = &list->root;
+    list->length = 0;
+}
+
+/** @brief Indicates if a list holds no nodes. */
+KINLINE b8 intrusive_list_empty(const intrusive_list *list) {
+    return list->root.next == &list->root;
+}
+
+/** @brief Indicates if a node is currently in a list. */
+KINLINE b8 intrusive_list_linked(const intrusive_list_node *node) {
+    return node->next != 0;
+}
+
+/** @brief Gets the first node of a list, or 0 if it is empty. */
+KINLINE intrusive_list_node *intrusive_list_head(intrusive_list *list) {
+    return intrusive_list_empty(list) ? 0 : list->root.next;
+}
+
+/** @brief Gets the last node of a list, or 0 if it is empty. */
+KINLINE intrusive_list_node *intrusive_list_tail(intrusive_list *list) {
+    return intrusive_list_empty(list) ? 0 : list->root.prev;
+}
+
+/** @brief Gets the node after node in list, or 0 if node is the tail. */
+KINLINE intrusive_list_node *intrusive_list_next(intrusive_list *list,
+                                                 intrusive_list_node *node) {
+    return node->next == &list->root ? 0 : node->next;
+}
+
+/** @brief Gets the node before node in list, or 0 if node is the head. */
+KINLINE intrusive_list_node *intrusive_list_prev(intrusive_list *list,
+                                                 intrusive_list_node *node) {
+    return node->prev == &list->root ? 0 : node->prev;
+}
+
+/**
+ * @brief Links an unlinked node into a list after position, which is either a
+ * node in the list or the list's root.
+ *
+ * @param list The list to insert into.
+ * @param position The node to insert after.
+ * @param node The node to insert.
+ */
+KINLINE void intrusive_list_insert_after(intrusive_list *list,
+                                         intrusive_list_node *position,
+                                         intrusive_list_node *node) {
+    node->prev = position;
+    node->next = position->next;
+    position->next->prev = node;
+    position->next = node;
+    list->length++;
+}
+
+/**
+ * @brief Links an unlinked node into a list before position, which is either
+ * a node in the list or the list's root.
+ *
+ * @param list The list to insert into.
+ * @param position The node to insert before.
+ * @param node The node to insert.
+ */
+KINLINE void intrusive_list_insert_before(intrusive_list *list,
+                                          intrusive_list_node *position,
+                                          intrusive_list_node *node) {
+    intrusive_list_insert_after(list, position->prev, node);
+}
+
+/** @brief Links an unlinked node in as the head of a list. */
+KINLINE void intrusive_list_push_head(intrusive_list *list,
+                                      intrusive_list_node *node) {
+    intrusive_list_insert_after(list, &list->root, node);
+}
+
+/** @brief Links an unlinked node in as the tail of a list. */
+KINLINE void intrusive_list_push_tail(intrusive_list *list,
+                                      intrusive_list_node *node) {
+    intrusive_list_insert_after(list, list->root.prev, node);
+}
+
+/**
+ * @brief Unlinks a node from the list it is in.
+ *
+ * @param list The list holding the node.
+ * @param node The node to remove.
+ */
+KINLINE void intrusive_list_remove(intrusive_list *list,
+                                   intrusive_list_node *node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = 0;
+    node->next = 0;
+    list->length--;
+}
+
+/** @brief Unlinks and returns the head of a list, or 0 if it is empty. */
+KINLINE intrusive_list_node *intrusive_list_pop_head(intrusive_list *list) {
+    intrusive_list_node *node = intrusive_list_head(list);
+    if (node) {
+        intrusive_list_remove(list, node);
+    }
+    return node;
+}
+
+/** @brief Unlinks and returns the tail of a list, or 0 if it is empty. */
+KINLINE intrusive_list_node *intrusive_list_pop_tail(intrusive_list *list) {
+    intrusive_list_node *node = intrusive_list_tail(list);
+    if (node) {
+        intrusive_list_remove(list, node);
+    }
+    return node;
+}
+
+/**
+ * @brief Moves a node already in a list to its head, as an LRU cache does
+ * when an entry is used.
+ *
+ * @param list The list holding the node.
+ * @param node The node to move.
+ */
+KINLINE void intrusive_list_move_to_head(intrusive_list *list,
+                                         intrusive_list_node *node) {
+    intrusive_list_remove(list, node);
+    intrusive_list_push_head(list, node);
+}
+
+/** @brief Moves a node already in a list to its tail. */
+KINLINE void intrusive_list_move_to_tail(intrusive_list *list,
+                                         intrusive_list_node *node) {
+    intrusive_list_remove(list, node);
+    intrusive_list_push_tail(list, node);
+}
+
+/**
+ * @brief Moves every node of source to the tail of list in O(1), leaving
+ * source empty.
+ *
+ * @param list The list to append to.
+ * @param source The list whose nodes are moved.
+ */
+KINLINE void intrusive_list_splice_tail(intrusive_list *list,
+                                        intrusive_list *source) {
+    if (intrusive_list_empty(source)) {
+        return;
+    }
+
+    intrusive_list_node *first = source->root.next;
+    intrusive_list_node *last = source->root.prev;
+    first->prev = list->root.prev;
+    list->root.prev->next = first;
+    last->next = &list->root;
+    list->root.prev = last;
+    list->length += source->length;
+    intrusive_list_init(source);
+}
+
+/**
+ * @brief Unlinks every node of a list in O(n), leaving each with 0 links.
+ *
+ * @param list The list to clear.
+ */
+KINLINE void intrusive_list_clear(intrusive_list *list) {
+    intrusive_list_node *node = list->root.next;
+    while (node != &list->root) {
+        intrusive_list_node *next = node->next;
+        node->prev = 0;
+        node->next = 0;
+        node = next;
+    }
+    intrusive_list_init(list);
+}
@@ -0,0 +1,233 @@
+#include "containers/pool_list.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// NOTE: Free nodes have prev set to this, so removing an index twice is
+// caught. Their next links the free list.
+#define POOL_LIST_FREE_NODE (INVALID_ID - 1)
+
+// Links and value share a node, padded so every node stays 8-byte aligned.
+static u64 pool_list_stride(u64 element_size) {
+    return (sizeof(pool_list_links) + element_size + 7) & ~(u64)7;
+}
+
+static b8 pool_list_node_linked(pool_list *list, u32 node) {
+    return node < list->capacity &&
+           pool_list_node_links(list, node)->prev != POOL_LIST_FREE_NODE;
+}
+
+void pool_list_create(u64 element_size, u32 capacity, u64 *memory_requirement,
+                      void *memory, pool_list *out_list) {
+    if (!memory_requirement) {
+        KERROR("pool_list_create - requires a valid pointer to "
+               "memory_requirement.");
+        return;
+    }
+
+    if (capacity == 0 || capacity >= POOL_LIST_FREE_NODE ||
+        element_size == 0) {
+        KERROR("pool_list_create - capacity and element_size must be "
+               "positive, and capacity less than INVALID_ID - 1.");
+        return;
+    }
+
+    *memory_requirement = pool_list_stride(element_size) * capacity;
+
+    if (!memory) {
+        return;
+    }
+
+    if (!out_list) {
+        KERROR("pool_list_create - requires a valid pointer to out_list.");
+        return;
+    }
+
+    out_list->element_size = element_size;
+    out_list->stride = pool_list_stride(element_size);
+    out_list->capacity = capacity;
+    out_list->memory = memory;
+    pool_list_reset(out_list);
+}
+
+void pool_list_destroy(pool_list *list) {
+    if (!list) {
+        return;
+    }
+
+    kzero_memory(list, sizeof(pool_list));
+}
+
+void pool_list_reset(pool_list *list) {
+    if (!list || !list->memory) {
+        return;
+    }
+
+    // Thread every node onto the free list in order, so a list pushed from
+    // empty fills the pool front to back.
+    for (u32 i = 0; i < list->capacity; ++i) {
+        pool_list_links *links = pool_list_node_links(list, i);
+        links->prev = POOL_LIST_FREE_NODE;
+        links->next = i + 1;
+    }
+    pool_list_node_links(list, list->capacity - 1)->next = INVALID_ID;
+    list->free_head = 0;
+    list->head = INVALID_ID;
+    list->tail = INVALID_ID;
+    list->length = 0;
+}
+
+// Takes a node off the free list and fills its value. Links are left to the
+// caller.
+static u32 pool_list_take_node(pool_list *list, const void *value) {
+    u32 node = list->free_head;
+    if (node == INVALID_ID) {
+        return INVALID_ID;
+    }
+
+    list->free_head = pool_list_node_links(list, node)->next;
+    if (value) {
+        kcopy_memory(pool_list_get(list, node), value, list->element_size);
+    } else {
+        kzero_memory(pool_list_get(list, node), list->element_size);
+    }
+    return node;
+}
+
+// Links node between prev and next, either of which may be INVALID_ID for the
+// ends of the list.
+static void pool_list_link(pool_list *list, u32 node, u32 prev, u32 next) {
+    pool_list_links *links = pool_list_node_links(list, node);
+    links->prev = prev;
+    links->next = next;
+
+    if (prev == INVALID_ID) {
+        list->head = node;
+    } else {
+        pool_list_node_links(list, prev)->next = node;
+    }
+    if (next == INVALID_ID) {
+        list->tail = node;
+    } else {
+        pool_list_node_links(list, next)->prev = node;
+    }
+    list->length++;
+}
+
+static void pool_list_unlink(pool_list *list, u32 node) {
+    pool_list_links *links = pool_list_node_links(list, node);
+
+    if (links->prev == INVALID_ID) {
+        list->head = links->next;
+    } else {
+        pool_list_node_links(list, links->prev)->next = links->next;
+    }
+    if (links->next == INVALID_ID) {
+        list->tail = links->prev;
+    } else {
+        pool_list_node_links(list, links->next)->prev = links->prev;
+    }
+    list->length--;
+}
+
+u32 pool_list_push_head(pool_list *list, const void *value) {
+    if (!list || !list->memory) {
+        KERROR("pool_list_push_head - requires a valid list.");
+        return INVALID_ID;
+    }
+
+    u32 node = pool_list_take_node(list, value);
+    if (node != INVALID_ID) {
+        pool_list_link(list, node, INVALID_ID, list->head);
+    }
+    return node;
+}
+
+u32 pool_list_push_tail(pool_list *list, const void *value) {
+    if (!list || !list->memory) {
+        KERROR("pool_list_push_tail - requires a valid list.");
+        return INVALID_ID;
+    }
+
+    u32 node = pool_list_take_node(list, value);
+    if (node != INVALID_ID) {
+        pool_list_link(list, node, list->tail, INVALID_ID);
+    }
+    return node;
+}
+
+u32 pool_list_insert_after(pool_list *list, u32 position, const void *value) {
+    if (!list || !list->memory || !pool_list_node_linked(list, position)) {
+        KERROR("pool_list_insert_after - requires a valid list and a position "
+               "in it.");
+        return INVALID_ID;
+    }
+
+    u32 node = pool_list_take_node(list, value);
+    if (node != INVALID_ID) {
+        pool_list_link(list, node, position,
+                       pool_list_node_links(list, position)->next);
+    }
+    return node;
+}
+
+b8 pool_list_remove(pool_list *list, u32 node) {
+    if (!list || !list->memory || !pool_list_node_linked(list, node)) {
+        return false;
+    }
+
+    pool_list_unlink(list, node);
+    pool_list_links *links = pool_list_node_links(list, node);
+    links->prev = POOL_LIST_FREE_NODE;
+    links->next = list->free_head;
+    list->free_head = node;
+    return true;
+}
+
+b8 pool_list_pop_head(pool_list *list, void *out_value) {
+    if (!list || list->head == INVALID_ID) {
+        return false;
+    }
+
+    if (out_value) {
+        kcopy_memory(out_value, pool_list_get(list, list->head),
+                     list->element_size);
+    }
+    return pool_list_remove(list, list->head);
+}
+
+b8 pool_list_pop_tail(pool_list *list, void *out_value) {
+    if (!list || list->tail == INVALID_ID) {
+        return false;
+    }
+
+    if (out_value) {
+        kcopy_memory(out_value, pool_list_get(list, list->tail),
+                     list->element_size);
+    }
+    return pool_list_remove(list, list->tail);
+}
+
+b8 pool_list_move_to_head(pool_list *list, u32 node) {
+    if (!list || !list->memory || !pool_list_node_linked(list, node)) {
+        return false;
+    }
+
+    if (list->head != node) {
+        pool_list_unlink(list, node);
+        pool_list_link(list, node, INVALID_ID, list->head);
+    }
+    return true;
+}
+
+b8 pool_list_move_to_tail(pool_list *list, u32 node) {
+    if (!list || !list->memory || !pool_list_node_linked(list, node)) {
+        return false;
+    }
+
+    if (list->tail != node) {
+        pool_list_unlink(list, node);
+        pool_list_link(list, node, list->tail, INVALID_ID);
+    }
+    return true;
+}
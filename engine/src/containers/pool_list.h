@@ -0,0 +1,175 @@
+/**
+ * @file pool_list.h
+ * @brief This file contains a doubly linked list whose nodes live in one
+ * contiguous pool and link to each other by index.
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief The links at the start of every pool_list node, followed by the
+ * node's value. INVALID_ID marks the end of the list in either direction.
+ */
+typedef struct pool_list_links {
+    u32 prev;
+    u32 next;
+} pool_list_links;
+
+/**
+ * @brief A fixed capacity doubly linked list of fixed-size values. Members of
+ * this structure should not be modified outside the functions associated with
+ * it.
+ *
+ * Each node holds its links and its value inline, and all nodes sit in one
+ * block, so walking the list does a single load per node and a list built in
+ * order walks memory in order. Nodes are named by u32 index; free nodes are
+ * kept on a list threaded through the pool. Values never move, so indices
+ * and value pointers stay valid until the node is removed.
+ */
+typedef struct pool_list {
+    u64 element_size;
+    /** @brief The size of a node, links and value, in bytes. */
+    u64 stride;
+    /** @brief The number of nodes in the pool. */
+    u32 capacity;
+    /** @brief The number of nodes in the list. */
+    u32 length;
+    /** @brief The first node, or INVALID_ID if the list is empty. */
+    u32 head;
+    /** @brief The last node, or INVALID_ID if the list is empty. */
+    u32 tail;
+    /** @brief The first free node, or INVALID_ID if the pool is full. */
+    u32 free_head;
+    /** @brief The pool of nodes. */
+    void *memory;
+} pool_list;
+
+/**
+ * @brief Creates a pool_list or gets the memory requirement for one. Call
+ * twice; first passing 0 to memory to obtain the memory requirement, second to
+ * pass the allocated block.
+ *
+ * @param element_size The size of each value in bytes.
+ * @param capacity The number of nodes. Must be less than INVALID_ID - 1.
+ * @param memory_requirement A pointer to get the memory requirement.
+ * @param memory 0, or a pre-allocated block of memory for the list to use.
+ * @param out_list A pointer to hold the list.
+ */
+KAPI void pool_list_create(u64 element_size, u32 capacity,
+                           u64 *memory_requirement, void *memory,
+                           pool_list *out_list);
+
+/**
+ * @brief Destroys the provided list. The memory block is owned by the caller
+ * and should be freed afterwards.
+ *
+ * @param list The list to be destroyed.
+ */
+KAPI void pool_list_destroy(pool_list *list);
+
+/**
+ * @brief Empties the list, returning every node to the pool.
+ *
+ * @param list The list to reset.
+ */
+KAPI void pool_list_reset(pool_list *list);
+
+/**
+ * @brief Takes a node from the pool and links it in as the head of the list.
+ *
+ * @param list The list to use.
+ * @param value A pointer to element_size bytes to copy in, or 0 to zero the
+ * value.
+ * @return The index of the new node, or INVALID_ID if the pool is full.
+ */
+KAPI u32 pool_list_push_head(pool_list *list, const void *value);
+
+/**
+ * @brief Takes a node from the pool and links it in as the tail of the list.
+ * See pool_list_push_head.
+ */
+KAPI u32 pool_list_push_tail(pool_list *list, const void *value);
+
+/**
+ * @brief Takes a node from the pool and links it in after position. See
+ * pool_list_push_head.
+ *
+ * @param position The index of a node in the list.
+ */
+KAPI u32 pool_list_insert_after(pool_list *list, u32 position,
+                                const void *value);
+
+/**
+ * @brief Unlinks a node and returns it to the pool.
+ *
+ * @param list The list to use.
+ * @param node The index of the node.
+ * @return True if the node was in the list; otherwise False.
+ */
+KAPI b8 pool_list_remove(pool_list *list, u32 node);
+
+/**
+ * @brief Removes the head of the list.
+ *
+ * @param list The list to use.
+ * @param out_value 0, or a pointer to receive a copy of the removed value.
+ * @return True if the list held a node; otherwise False.
+ */
+KAPI b8 pool_list_pop_head(pool_list *list, void *out_value);
+
+/** @brief Removes the tail of the list. See pool_list_pop_head. */
+KAPI b8 pool_list_pop_tail(pool_list *list, void *out_value);
+
+/**
+ * @brief Moves a node in the list to its head, as an LRU cache does when an
+ * entry is used.
+ *
+ * @param list The list to use.
+ * @param node The index of the node.
+ * @return True if the node was in the list; otherwise False.
+ */
+KAPI b8 pool_list_move_to_head(pool_list *list, u32 node);
+
+/** @brief Moves a node in the list to its tail. See pool_list_move_to_head. */
+KAPI b8 pool_list_move_to_tail(pool_list *list, u32 node);
+
+/** @brief Gets the links of a node. */
+KINLINE pool_list_links *pool_list_node_links(const pool_list *list,
+                                             u32 node) {
+    return (pool_list_links *)((u8 *)list->memory + list->stride * node);
+}
+
+/**
+ * @brief Gets the value of a node. Does not check the index; the node must be
+ * in the list.
+ *
+ * @param list The list to use.
+ * @param node The index of the node.
+ * @return A pointer to the value.
+ */
+KINLINE void *pool_list_get(const pool_list *list, u32 node) {
+    return pool_list_node_links(list, node) + 1;
+}
+
+/** @brief Gets the first node, or INVALID_ID if the list is empty. */
+KINLINE u32 pool_list_head(const pool_list *list) { return list->head; }
+
+/** @brief Gets the last node, or INVALID_ID if the list is empty. */
+KINLINE u32 pool_list_tail(const pool_list *list) { return list->tail; }
+
+/** @brief Gets the node after node, or INVALID_ID if node is the tail. */
+KINLINE u32 pool_list_next(const pool_list *list, u32 node) {
+    return pool_list_node_links(list, node)->next;
+}
+
+/** @brief Gets the node before node, or INVALID_ID if node is the head. */
+KINLINE u32 pool_list_prev(const pool_list *list, u32 node) {
+    return pool_list_node_links(list, node)->prev;
+}
+
+/** @brief Gets the number of nodes in the list. */
+KINLINE u32 pool_list_length(const pool_list *list) { return list->length; }
@@ -0,0 +1,253 @@
+#include "containers/ring_queue.h"
+
+#include "core/katomic.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// head and tail count every element ever dequeued and enqueued; they are
+// masked down to a slot index and never wrap in practice. Each sits on its own
+// cache line together with the side's cached copy of the other index, so the
+// SPSC producer only reads head when the queue looks full, and the consumer
+// only reads tail when it looks empty.
+typedef struct ring_queue_state {
+    u64 head;
+    u64 cached_tail;
+    u8 head_padding[RING_QUEUE_CACHE_LINE_SIZE - sizeof(u64) * 2];
+    u64 tail;
+    u64 cached_head;
+    u8 tail_padding[RING_QUEUE_CACHE_LINE_SIZE - sizeof(u64) * 2];
+} ring_queue_state;
+
+// Slots follow the state. MPMC slots start with a sequence number: equal to
+// the position when the slot is free for the producer of that position, and
+// position + 1 once it holds a value for the consumer.
+typedef struct ring_queue_cell {
+    u64 sequence;
+} ring_queue_cell;
+
+static u64 ring_queue_stride(ring_queue_type type, u64 element_size) {
+    u64 stride = (element_size + 7) & ~(u64)7;
+    if (type == RING_QUEUE_TYPE_MPMC) {
+        stride += sizeof(ring_queue_cell);
+    }
+    return stride;
+}
+
+static u64 ring_queue_block_size(ring_queue *queue) {
+    return sizeof(ring_queue_state) +
+           ring_queue_stride(queue->type, queue->element_size) *
+               queue->capacity;
+}
+
+static void *ring_queue_slot(ring_queue *queue, u64 position) {
+    u64 stride = ring_queue_stride(queue->type, queue->element_size);
+    return queue->state + sizeof(ring_queue_state) +
+           stride * (position & (queue->capacity - 1));
+}
+
+b8 ring_queue_create(ring_queue_type type, u64 element_size, u64 capacity,
+                     ring_queue *out_queue) {
+    if (!out_queue || element_size == 0 || capacity == 0) {
+        KERROR("ring_queue_create - requires a valid out_queue, and positive "
+               "element_size and capacity.");
+        return false;
+    }
+
+    u64 rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+
+    out_queue->type = type;
+    out_queue->element_size = element_size;
+    out_queue->capacity = rounded;
+
+    u64 block_size = ring_queue_block_size(out_queue);
+    out_queue->state = kallocate_aligned(
+        block_size, RING_QUEUE_CACHE_LINE_SIZE, MEMORY_TAG_RING_QUEUE);
+    if (!out_queue->state) {
+        KERROR("ring_queue_create - failed to allocate %llu bytes.",
+               block_size);
+        return false;
+    }
+
+    if (type == RING_QUEUE_TYPE_MPMC) {
+        for (u64 i = 0; i < rounded; ++i) {
+            ring_queue_cell *cell = ring_queue_slot(out_queue, i);
+            cell->sequence = i;
+        }
+    }
+
+    return true;
+}
+
+void ring_queue_destroy(ring_queue *queue) {
+    if (!queue || !queue->state) {
+        return;
+    }
+
+    kfree_aligned(queue->state, ring_queue_block_size(queue),
+                  RING_QUEUE_CACHE_LINE_SIZE, MEMORY_TAG_RING_QUEUE);
+    kzero_memory(queue, sizeof(ring_queue));
+}
+
+static b8 ring_queue_enqueue_single(ring_queue *queue, const void *value) {
+    ring_queue_state *state = queue->state;
+    if (state->tail - state->head == queue->capacity) {
+        return false;
+    }
+
+    kcopy_memory(ring_queue_slot(queue, state->tail), value,
+                 queue->element_size);
+    state->tail++;
+    return true;
+}
+
+static b8 ring_queue_dequeue_single(ring_queue *queue, void *out_value) {
+    ring_queue_state *state = queue->state;
+    if (state->head == state->tail) {
+        return false;
+    }
+
+    kcopy_memory(out_value, ring_queue_slot(queue, state->head),
+                 queue->element_size);
+    state->head++;
+    return true;
+}
+
+static b8 ring_queue_enqueue_spsc(ring_queue *queue, const void *value) {
+    ring_queue_state *state = queue->state;
+    // Only this thread writes tail.
+    u64 tail = katomic_load(&state->tail, KATOMIC_RELAXED);
+    if (tail - state->cached_head == queue->capacity) {
+        state->cached_head = katomic_load(&state->head, KATOMIC_ACQUIRE);
+        if (tail - state->cached_head == queue->capacity) {
+            return false;
+        }
+    }
+
+    kcopy_memory(ring_queue_slot(queue, tail), value, queue->element_size);
+    katomic_store(&state->tail, tail + 1, KATOMIC_RELEASE);
+    return true;
+}
+
+static b8 ring_queue_dequeue_spsc(ring_queue *queue, void *out_value) {
+    ring_queue_state *state = queue->state;
+    // Only this thread writes head.
+    u64 head = katomic_load(&state->head, KATOMIC_RELAXED);
+    if (head == state->cached_tail) {
+        state->cached_tail = katomic_load(&state->tail, KATOMIC_ACQUIRE);
+        if (head == state->cached_tail) {
+            return false;
+        }
+    }
+
+    kcopy_memory(out_value, ring_queue_slot(queue, head), queue->element_size);
+    katomic_store(&state->head, head + 1, KATOMIC_RELEASE);
+    return true;
+}
+
+static b8 ring_queue_enqueue_mpmc(ring_queue *queue, const void *value) {
+    ring_queue_state *state = queue->state;
+    u64 position = katomic_load(&state->tail, KATOMIC_RELAXED);
+    ring_queue_cell *cell;
+    for (;;) {
+        cell = ring_queue_slot(queue, position);
+        u64 sequence = katomic_load(&cell->sequence, KATOMIC_ACQUIRE);
+        i64 difference = (i64)(sequence - position);
+        if (difference == 0) {
+            // The slot is free for this position; claim it. On failure,
+            // position is reloaded with the current tail.
+            if (katomic_compare_exchange_weak(&state->tail, &position,
+                                              position + 1, KATOMIC_RELAXED,
+                                              KATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The slot still holds the value from a lap ago.
+            return false;
+        } else {
+            position = katomic_load(&state->tail, KATOMIC_RELAXED);
+        }
+    }
+
+    kcopy_memory(cell + 1, value, queue->element_size);
+    katomic_store(&cell->sequence, position + 1, KATOMIC_RELEASE);
+    return true;
+}
+
+static b8 ring_queue_dequeue_mpmc(ring_queue *queue, void *out_value) {
+    ring_queue_state *state = queue->state;
+    u64 position = katomic_load(&state->head, KATOMIC_RELAXED);
+    ring_queue_cell *cell;
+    for (;;) {
+        cell = ring_queue_slot(queue, position);
+        u64 sequence = katomic_load(&cell->sequence, KATOMIC_ACQUIRE);
+        i64 difference = (i64)(sequence - (position + 1));
+        if (difference == 0) {
+            if (katomic_compare_exchange_weak(&state->head, &position,
+                                              position + 1, KATOMIC_RELAXED,
+                                              KATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // Nothing has been written to this position yet.
+            return false;
+        } else {
+            position = katomic_load(&state->head, KATOMIC_RELAXED);
+        }
+    }
+
+    kcopy_memory(out_value, cell + 1, queue->element_size);
+    // Free the slot for the producer one lap ahead.
+    katomic_store(&cell->sequence, position + queue->capacity,
+                  KATOMIC_RELEASE);
+    return true;
+}
+
+b8 ring_queue_enqueue(ring_queue *queue, const void *value) {
+    if (!queue || !queue->state || !value) {
+        KERROR("ring_queue_enqueue - requires a valid queue and value.");
+        return false;
+    }
+
+    switch (queue->type) {
+    case RING_QUEUE_TYPE_SINGLE_THREADED:
+        return ring_queue_enqueue_single(queue, value);
+    case RING_QUEUE_TYPE_SPSC:
+        return ring_queue_enqueue_spsc(queue, value);
+    case RING_QUEUE_TYPE_MPMC:
+        return ring_queue_enqueue_mpmc(queue, value);
+    }
+    return false;
+}
+
+b8 ring_queue_dequeue(ring_queue *queue, void *out_value) {
+    if (!queue || !queue->state || !out_value) {
+        KERROR("ring_queue_dequeue - requires a valid queue and out_value.");
+        return false;
+    }
+
+    switch (queue->type) {
+    case RING_QUEUE_TYPE_SINGLE_THREADED:
+        return ring_queue_dequeue_single(queue, out_value);
+    case RING_QUEUE_TYPE_SPSC:
+        return ring_queue_dequeue_spsc(queue, out_value);
+    case RING_QUEUE_TYPE_MPMC:
+        return ring_queue_dequeue_mpmc(queue, out_value);
+    }
+    return false;
+}
+
+u64 ring_queue_count(ring_queue *queue) {
+    if (!queue || !queue->state) {
+        return 0;
+    }
+
+    ring_queue_state *state = queue->state;
+    // Read head first, so a concurrent dequeue cannot push it past tail.
+    u64 head = katomic_load(&state->head, KATOMIC_ACQUIRE);
+    u64 tail = katomic_load(&state->tail, KATOMIC_ACQUIRE);
+    u64 count = tail - head;
+    return count > queue->capacity ? queue->capacity : count;
+}
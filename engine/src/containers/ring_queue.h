@@ -0,0 +1,98 @@
+/**
+ * @file ring_queue.h
+ * @brief This file contains a fixed-capacity ring buffer queue, with
+ * single-threaded, single-producer/single-consumer and
+ * multi-producer/multi-consumer variants.
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The size the head and tail indices are padded out to. */
+#define RING_QUEUE_CACHE_LINE_SIZE 64
+
+/**
+ * @brief The threading guarantees a ring queue is created with.
+ */
+typedef enum ring_queue_type {
+    /** @brief Used from one thread only. No atomics. */
+    RING_QUEUE_TYPE_SINGLE_THREADED,
+    /**
+     * @brief Lock-free, for exactly one thread enqueuing and one thread
+     * dequeuing at a time.
+     */
+    RING_QUEUE_TYPE_SPSC,
+    /**
+     * @brief Lock-free, for any number of threads enqueuing and dequeuing.
+     * Each slot carries a sequence number that hands it between producers and
+     * consumers (Vyukov's bounded MPMC queue).
+     */
+    RING_QUEUE_TYPE_MPMC
+} ring_queue_type;
+
+/**
+ * @brief Represents a fixed-capacity FIFO queue of fixed-size elements.
+ * Members of this structure should not be modified outside the functions
+ * associated with it.
+ *
+ * Elements are copied in and out. The head and tail indices live on their own
+ * cache lines so producers and consumers do not contend on the same line.
+ */
+typedef struct ring_queue {
+    ring_queue_type type;
+    u64 element_size;
+    /** @brief The number of slots, always a power of 2. */
+    u64 capacity;
+    /** @brief The internal state, allocated with MEMORY_TAG_RING_QUEUE. */
+    void *state;
+} ring_queue;
+
+/**
+ * @brief Creates a ring queue and stores it in out_queue. Memory is allocated
+ * internally and released by ring_queue_destroy.
+ *
+ * @param type The threading guarantees the queue needs.
+ * @param element_size The size of each element in bytes.
+ * @param capacity The most elements held at once. Rounded up to a power of 2.
+ * @param out_queue A pointer to hold the queue.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 ring_queue_create(ring_queue_type type, u64 element_size, u64 capacity,
+                          ring_queue *out_queue);
+
+/**
+ * @brief Destroys the provided queue. No thread may be using it.
+ *
+ * @param queue The queue to be destroyed.
+ */
+KAPI void ring_queue_destroy(ring_queue *queue);
+
+/**
+ * @brief Copies a value onto the back of the queue.
+ *
+ * @param queue The queue to use.
+ * @param value A pointer to element_size bytes to copy in.
+ * @return True if successful; False if the queue is full.
+ */
+KAPI b8 ring_queue_enqueue(ring_queue *queue, const void *value);
+
+/**
+ * @brief Copies the value at the front of the queue out and removes it.
+ *
+ * @param queue The queue to use.
+ * @param out_value A pointer to element_size bytes to copy into.
+ * @return True if successful; False if the queue is empty.
+ */
+KAPI b8 ring_queue_dequeue(ring_queue *queue, void *out_value);
+
+/**
+ * @brief Gets the number of elements in the queue. Only a snapshot while
+ * other threads are using the queue.
+ *
+ * @param queue The queue to use.
+ * @return The number of elements.
+ */
+KAPI u64 ring_queue_count(ring_queue *queue);
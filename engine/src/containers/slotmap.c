@@ -0,0 +1,181 @@
+#include "containers/slotmap.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// NOTE: An odd generation marks an occupied slot, so filling and emptying a
+// slot each bump it once. link is the slot's position in the dense indices
+// while occupied, and the next empty slot while empty.
+typedef struct slotmap_slot {
+    u32 generation;
+    u32 link;
+} slotmap_slot;
+
+// Values come first so they keep the alignment of the block; the slot
+// metadata after them is padded to 8 bytes.
+static u64 slotmap_values_size(u64 element_size, u32 capacity) {
+    return (element_size * capacity + 7) & ~(u64)7;
+}
+
+static void *slotmap_value(slotmap *map, u32 index) {
+    return map->memory + map->element_size * index;
+}
+
+static slotmap_slot *slotmap_slots(slotmap *map) {
+    return map->memory +
+           slotmap_values_size(map->element_size, map->capacity);
+}
+
+static u32 *slotmap_dense(slotmap *map) {
+    return (u32 *)(slotmap_slots(map) + map->capacity);
+}
+
+static b8 slotmap_slot_occupied(slotmap_slot *slot) {
+    return slot->generation & 1;
+}
+
+void slotmap_create(u64 element_size, u32 capacity, u64 *memory_requirement,
+                    void *memory, slotmap *out_map) {
+    if (!memory_requirement) {
+        KERROR("slotmap_create - requires a valid pointer to "
+               "memory_requirement.");
+        return;
+    }
+
+    if (capacity == 0 || capacity == INVALID_ID || element_size == 0) {
+        KERROR("slotmap_create - capacity and element_size must be positive, "
+               "and capacity less than INVALID_ID.");
+        return;
+    }
+
+    *memory_requirement = slotmap_values_size(element_size, capacity) +
+                          (sizeof(slotmap_slot) + sizeof(u32)) * capacity;
+
+    if (!memory) {
+        return;
+    }
+
+    if (!out_map) {
+        KERROR("slotmap_create - requires a valid pointer to out_map.");
+        return;
+    }
+
+    out_map->element_size = element_size;
+    out_map->capacity = capacity;
+    out_map->count = 0;
+    out_map->memory = memory;
+
+    // Thread every slot onto the free list in order, so the first inserts
+    // fill the lowest slots.
+    slotmap_slot *slots = slotmap_slots(out_map);
+    for (u32 i = 0; i < capacity; ++i) {
+        slots[i].generation = 0;
+        slots[i].link = i + 1;
+    }
+    slots[capacity - 1].link = INVALID_ID;
+    out_map->free_head = 0;
+}
+
+void slotmap_destroy(slotmap *map) {
+    if (!map) {
+        return;
+    }
+
+    kzero_memory(map, sizeof(slotmap));
+}
+
+void *slotmap_insert(slotmap *map, slotmap_handle *out_handle) {
+    if (!map || !map->memory || !out_handle) {
+        KERROR("slotmap_insert - requires a valid map and out_handle.");
+        return 0;
+    }
+
+    if (map->free_head == INVALID_ID) {
+        *out_handle = SLOTMAP_INVALID_HANDLE;
+        return 0;
+    }
+
+    u32 index = map->free_head;
+    slotmap_slot *slot = &slotmap_slots(map)[index];
+    map->free_head = slot->link;
+
+    slot->generation++;
+    slot->link = map->count;
+    slotmap_dense(map)[map->count] = index;
+    map->count++;
+
+    *out_handle = ((u64)slot->generation << 32) | index;
+
+    void *value = slotmap_value(map, index);
+    kzero_memory(value, map->element_size);
+    return value;
+}
+
+b8 slotmap_remove(slotmap *map, slotmap_handle handle) {
+    if (!slotmap_get(map, handle)) {
+        return false;
+    }
+
+    u32 index = slotmap_handle_index(handle);
+    slotmap_slot *slots = slotmap_slots(map);
+    slotmap_slot *slot = &slots[index];
+
+    // Fill the hole in the dense indices with the last entry.
+    u32 *dense = slotmap_dense(map);
+    u32 last = dense[map->count - 1];
+    dense[slot->link] = last;
+    slots[last].link = slot->link;
+    map->count--;
+
+    slot->generation++;
+    slot->link = map->free_head;
+    map->free_head = index;
+    return true;
+}
+
+void *slotmap_get(slotmap *map, slotmap_handle handle) {
+    if (!map || !map->memory || handle == SLOTMAP_INVALID_HANDLE) {
+        return 0;
+    }
+
+    u32 index = slotmap_handle_index(handle);
+    if (index >= map->capacity) {
+        return 0;
+    }
+
+    slotmap_slot *slot = &slotmap_slots(map)[index];
+    if (!slotmap_slot_occupied(slot) ||
+        slot->generation != slotmap_handle_generation(handle)) {
+        return 0;
+    }
+
+    return slotmap_value(map, index);
+}
+
+void *slotmap_get_at(slotmap *map, u32 index) {
+    if (!map || !map->memory || index >= map->capacity) {
+        return 0;
+    }
+
+    if (!slotmap_slot_occupied(&slotmap_slots(map)[index])) {
+        return 0;
+    }
+
+    return slotmap_value(map, index);
+}
+
+slotmap_handle slotmap_handle_at(slotmap *map, u32 index) {
+    if (!slotmap_get_at(map, index)) {
+        return SLOTMAP_INVALID_HANDLE;
+    }
+
+    return ((u64)slotmap_slots(map)[index].generation << 32) | index;
+}
+
+const u32 *slotmap_dense_indices(slotmap *map) {
+    if (!map || !map->memory) {
+        return 0;
+    }
+
+    return slotmap_dense(map);
+}
@@ -0,0 +1,127 @@
+/**
+ * @file slotmap.h
+ * @brief This file contains a generational slot map, used to hand out stable
+ * handles to engine resources.
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A handle to a value in a slotmap. The low 32 bits hold the slot
+ * index, the high 32 bits the generation of the slot when it was filled.
+ */
+typedef u64 slotmap_handle;
+
+/** @brief A handle that never refers to a value. */
+#define SLOTMAP_INVALID_HANDLE INVALID_ID_U64
+
+/** @brief Gets the slot index of a handle. */
+#define slotmap_handle_index(handle) ((u32)(handle))
+/** @brief Gets the generation of a handle. */
+#define slotmap_handle_generation(handle) ((u32)((handle) >> 32))
+
+/**
+ * @brief A fixed capacity container of values addressed by generational
+ * handles. Members of this structure should not be modified outside the
+ * functions associated with it.
+ *
+ * Insert, remove and lookup are O(1): free slots are kept on a list threaded
+ * through the slots themselves, and each slot carries a generation that is
+ * bumped when it is filled or emptied, so stale handles are rejected. Values
+ * never move, so pointers to them stay valid until they are removed. A dense
+ * array of occupied slot indices allows iterating live values in O(count).
+ */
+typedef struct slotmap {
+    u64 element_size;
+    /** @brief The number of slots. */
+    u32 capacity;
+    /** @brief The number of occupied slots. */
+    u32 count;
+    /** @brief The first empty slot, or INVALID_ID if there is none. */
+    u32 free_head;
+    /** @brief Values, followed by slot metadata, then the dense indices. */
+    void *memory;
+} slotmap;
+
+/**
+ * @brief Creates a slotmap or gets the memory requirement for one. Call twice;
+ * first passing 0 to memory to obtain the memory requirement, second to pass
+ * the allocated block.
+ *
+ * @param element_size The size of each value in bytes.
+ * @param capacity The number of slots. Must be less than INVALID_ID.
+ * @param memory_requirement A pointer to get the memory requirement.
+ * @param memory 0, or a pre-allocated block of memory for the slotmap to use.
+ * @param out_map A pointer to hold the slotmap.
+ */
+KAPI void slotmap_create(u64 element_size, u32 capacity,
+                         u64 *memory_requirement, void *memory,
+                         slotmap *out_map);
+
+/**
+ * @brief Destroys the provided slotmap. The memory block is owned by the
+ * caller and should be freed afterwards.
+ *
+ * @param map The slotmap to be destroyed.
+ */
+KAPI void slotmap_destroy(slotmap *map);
+
+/**
+ * @brief Fills a free slot with a zeroed value.
+ *
+ * @param map The slotmap to use.
+ * @param out_handle A pointer to hold the handle of the new value.
+ * @return A pointer to the new value, or 0 if every slot is occupied.
+ */
+KAPI void *slotmap_insert(slotmap *map, slotmap_handle *out_handle);
+
+/**
+ * @brief Empties the slot the handle refers to. Moves the last entry of the
+ * dense indices into the removed one's place.
+ *
+ * @param map The slotmap to use.
+ * @param handle The handle of the value to remove.
+ * @return True if the handle was live; otherwise False.
+ */
+KAPI b8 slotmap_remove(slotmap *map, slotmap_handle handle);
+
+/**
+ * @brief Gets the value a handle refers to.
+ *
+ * @param map The slotmap to use.
+ * @param handle The handle of the value.
+ * @return A pointer to the value, or 0 if the handle is stale or invalid.
+ */
+KAPI void *slotmap_get(slotmap *map, slotmap_handle handle);
+
+/**
+ * @brief Gets the value in a slot, ignoring generations.
+ *
+ * @param map The slotmap to use.
+ * @param index The slot index.
+ * @return A pointer to the value, or 0 if the slot is empty.
+ */
+KAPI void *slotmap_get_at(slotmap *map, u32 index);
+
+/**
+ * @brief Gets the current handle of an occupied slot.
+ *
+ * @param map The slotmap to use.
+ * @param index The slot index.
+ * @return The handle, or SLOTMAP_INVALID_HANDLE if the slot is empty.
+ */
+KAPI slotmap_handle slotmap_handle_at(slotmap *map, u32 index);
+
+/**
+ * @brief Gets the indices of occupied slots, packed into map->count entries.
+ * Inserts append to the end, removes swap the last entry into the removed
+ * one's place, so iterate backwards when removing during iteration.
+ *
+ * @param map The slotmap to use.
+ * @return A pointer to the dense slot indices.
+ */
+KAPI const u32 *slotmap_dense_indices(slotmap *map);
@@ -0,0 +1,135 @@
+#include "containers/soa.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// Each column is followed by one spare line, so columns whose size is a
+// large power of 2 do not all start on the same cache set and alias when a
+// loop walks several of them together.
+static u64 soa_column_size(u64 element_size, u64 capacity) {
+    return ((element_size * capacity + SOA_COLUMN_ALIGNMENT - 1) &
+            ~(u64)(SOA_COLUMN_ALIGNMENT - 1)) +
+           SOA_COLUMN_ALIGNMENT;
+}
+
+// Allocates one block for every column and points the columns into it.
+static b8 soa_allocate(soa_header *header, void **columns,
+                       const u64 *column_sizes, u32 column_count,
+                       u64 capacity) {
+    u64 block_size = 0;
+    for (u32 i = 0; i < column_count; ++i) {
+        block_size += soa_column_size(column_sizes[i], capacity);
+    }
+
+    u8 *block = kallocate_aligned(block_size, SOA_COLUMN_ALIGNMENT,
+                                  MEMORY_TAG_ARRAY);
+    if (!block) {
+        KERROR("soa - failed to allocate %llu bytes for %llu rows.", block_size,
+               capacity);
+        return false;
+    }
+
+    u64 offset = 0;
+    for (u32 i = 0; i < column_count; ++i) {
+        columns[i] = block + offset;
+        offset += soa_column_size(column_sizes[i], capacity);
+    }
+
+    header->block = block;
+    header->block_size = block_size;
+    header->capacity = capacity;
+    return true;
+}
+
+b8 _soa_create(soa_header *header, void **columns, const u64 *column_sizes,
+               u32 column_count, u64 capacity) {
+    if (!header || !columns || !column_sizes || column_count == 0) {
+        KERROR("soa_create - requires a valid container and at least one "
+               "column.");
+        return false;
+    }
+
+    kzero_memory(header, sizeof(soa_header));
+    kzero_memory(columns, sizeof(void *) * column_count);
+    if (capacity < SOA_MIN_CAPACITY) {
+        capacity = SOA_MIN_CAPACITY;
+    }
+    return soa_allocate(header, columns, column_sizes, column_count, capacity);
+}
+
+void _soa_destroy(soa_header *header, void **columns, u32 column_count) {
+    if (!header || !header->block) {
+        return;
+    }
+
+    kfree_aligned(header->block, header->block_size, SOA_COLUMN_ALIGNMENT,
+                  MEMORY_TAG_ARRAY);
+    kzero_memory(header, sizeof(soa_header));
+    kzero_memory(columns, sizeof(void *) * column_count);
+}
+
+b8 _soa_reserve(soa_header *header, void **columns, const u64 *column_sizes,
+                u32 column_count, u64 capacity) {
+    if (!header || !header->block) {
+        KERROR("soa_reserve - requires a created container.");
+        return false;
+    }
+    if (capacity <= header->capacity) {
+        return true;
+    }
+
+    soa_header old = *header;
+    void *old_columns[column_count];
+    kcopy_memory(old_columns, columns, sizeof(void *) * column_count);
+
+    if (!soa_allocate(header, columns, column_sizes, column_count,
+                      capacity)) {
+        *header = old;
+        kcopy_memory(columns, old_columns, sizeof(void *) * column_count);
+        return false;
+    }
+
+    for (u32 i = 0; i < column_count; ++i) {
+        kcopy_memory(columns[i], old_columns[i], column_sizes[i] * old.count);
+    }
+    kfree_aligned(old.block, old.block_size, SOA_COLUMN_ALIGNMENT,
+                  MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u64 _soa_push(soa_header *header, void **columns, const u64 *column_sizes,
+              u32 column_count) {
+    if (header->count == header->capacity &&
+        !_soa_reserve(header, columns, column_sizes, column_count,
+                      header->capacity * 2)) {
+        return INVALID_ID_U64;
+    }
+
+    u64 index = header->count;
+    for (u32 i = 0; i < column_count; ++i) {
+        kzero_memory((u8 *)columns[i] + column_sizes[i] * index,
+                     column_sizes[i]);
+    }
+    header->count++;
+    return index;
+}
+
+b8 _soa_swap_remove(soa_header *header, void **columns,
+                    const u64 *column_sizes, u32 column_count, u64 index) {
+    if (!header || index >= header->count) {
+        KERROR("soa_swap_remove - index %llu is outside the container.",
+               index);
+        return false;
+    }
+
+    u64 last = header->count - 1;
+    if (index != last) {
+        for (u32 i = 0; i < column_count; ++i) {
+            u8 *column = columns[i];
+            kcopy_memory(column + column_sizes[i] * index,
+                         column + column_sizes[i] * last, column_sizes[i]);
+        }
+    }
+    header->count--;
+    return true;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file soa.h
+ * @brief This file contains a structure-of-arrays container, generated by
+ * macro from a column list declared once.
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The alignment of the block and of every column within it. */
+#define SOA_COLUMN_ALIGNMENT 64
+
+/** @brief The smallest capacity a container grows to. */
+#define SOA_MIN_CAPACITY 16
+
+/**
+ * @brief The bookkeeping shared by every generated container. Members of this
+ * structure should not be modified outside the functions associated with it.
+ */
+typedef struct soa_header {
+    /** @brief The number of rows in use. */
+    u64 count;
+    /** @brief The number of rows the columns have room for. */
+    u64 capacity;
+    /** @brief The size of the block holding every column, in bytes. */
+    u64 block_size;
+    /** @brief The block holding every column, allocated with
+     * MEMORY_TAG_ARRAY. */
+    void *block;
+} soa_header;
+
+/**
+ * @brief Creates the columns of a container. Used by the functions
+ * SOA_DEFINE generates; call those instead.
+ *
+ * @param header The container's header.
+ * @param columns The container's column pointers, column_count of them.
+ * @param column_sizes The element size of each column.
+ * @param column_count The number of columns.
+ * @param capacity The number of rows to make room for.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 _soa_create(soa_header *header, void **columns,
+                    const u64 *column_sizes, u32 column_count, u64 capacity);
+
+/** @brief Frees the columns of a container. See _soa_create. */
+KAPI void _soa_destroy(soa_header *header, void **columns, u32 column_count);
+
+/**
+ * @brief Makes room for at least capacity rows, moving every column into one
+ * new block. See _soa_create.
+ */
+KAPI b8 _soa_reserve(soa_header *header, void **columns,
+                     const u64 *column_sizes, u32 column_count, u64 capacity);
+
+/**
+ * @brief Appends a zeroed row to every column, growing them if needed. See
+ * _soa_create.
+ *
+ * @return The index of the new row, or INVALID_ID_U64 if growing failed.
+ */
+KAPI u64 _soa_push(soa_header *header, void **columns,
+                   const u64 *column_sizes, u32 column_count);
+
+/**
+ * @brief Removes a row by moving the last row into its place in every column.
+ * See _soa_create.
+ *
+ * @return True if index was in range; otherwise False.
+ */
+KAPI b8 _soa_swap_remove(soa_header *header, void **columns,
+                         const u64 *column_sizes, u32 column_count,
+                         u64 index);
+
+// Column list helpers, applied to each X(type, name) entry of a column list.
+#define _SOA_FIELD(type, name) type *name;
+#define _SOA_SIZE(type, name) sizeof(type),
+#define _SOA_COUNT(type, name) +1
+
+/**
+ * @brief Generates a structure-of-arrays container type and its functions.
+ * Columns are declared once, as a macro taking X and expanding X(type, name)
+ * for each column:
+ *
+ *     #define TRANSFORM_COLUMNS(X) X(vec3, position) X(mat4, model)
+ *     SOA_DEFINE(transform_soa, TRANSFORM_COLUMNS)
+ *
+ * This declares a struct transform_soa with a header and one pointer per
+ * column, transform_soa.position and transform_soa.model, each holding
+ * header.count elements. All columns live in one block, each starting on a
+ * SOA_COLUMN_ALIGNMENT boundary, so loops over a column see contiguous,
+ * aligned data. Column pointers change when the container grows.
+ *
+ * Functions generated, with name being the container name:
+ * - b8 name_create(name *soa, u64 capacity)
+ * - void name_destroy(name *soa)
+ * - b8 name_reserve(name *soa, u64 capacity)
+ * - u64 name_push(name *soa): appends a zeroed row and returns its index, or
+ *   INVALID_ID_U64 if growing failed. Fill the row through the columns.
+ * - b8 name_swap_remove(name *soa, u64 index)
+ * - u64 name_count(name *soa)
+ *
+ * @param name The name of the container type.
+ * @param COLUMNS The column list macro.
+ */
+#define SOA_DEFINE(name, COLUMNS)                                              \
+    typedef struct name {                                                      \
+        soa_header header;                                                     \
+        COLUMNS(_SOA_FIELD)                                                    \
+    } name;                                                                    \
+                                                                               \
+    /* The column pointers follow the header with no padding, so they can be   \
+     * handled as an array. */                                                 \
+    STATIC_ASSERT(sizeof(name) ==                                              \
+                      sizeof(soa_header) +                                     \
+                          sizeof(void *) * (0 COLUMNS(_SOA_COUNT)),            \
+                  "Expected " #name " columns to follow its header.");         \
+                                                                               \
+    static const u64 name##_column_sizes[] = {COLUMNS(_SOA_SIZE)};             \
+                                                                               \
+    KINLINE void **name##_columns(name *soa) {                                 \
+        return (void **)((u8 *)soa + sizeof(soa_header));                      \
+    }                                                                          \
+                                                                               \
+    KINLINE b8 name##_create(name *soa, u64 capacity) {                        \
+        return _soa_create(&soa->header, name##_columns(soa),                  \
+                           name##_column_sizes, 0 COLUMNS(_SOA_COUNT),         \
+                           capacity);                                          \
+    }                                                                          \
+                                                                               \
+    KINLINE void name##_destroy(name *soa) {                                   \
+        _soa_destroy(&soa->header, name##_columns(soa),                        \
+                     0 COLUMNS(_SOA_COUNT));                                   \
+    }                                                                          \
+                                                                               \
+    KINLINE b8 name##_reserve(name *soa, u64 capacity) {                       \
+        return _soa_reserve(&soa->header, name##_columns(soa),                 \
+                            name##_column_sizes, 0 COLUMNS(_SOA_COUNT),        \
+                            capacity);                                         \
+    }                                                                          \
+                                                                               \
+    KINLINE u64 name##_push(name *soa) {                                       \
+        return _soa_push(&soa->header, name##_columns(soa),                    \
+                         name##_column_sizes, 0 COLUMNS(_SOA_COUNT));          \
+    }                                                                          \
+                                                                               \
+    KINLINE b8 name##_swap_remove(name *soa, u64 index) {                      \
+        return _soa_swap_remove(&soa->header, name##_columns(soa),             \
+                                name##_column_sizes, 0 COLUMNS(_SOA_COUNT),    \
+                                index);                                        \
+    }                                                                          \
+                                                                               \
+    KINLINE u64 name##_count(name *soa) { return soa->header.count; }
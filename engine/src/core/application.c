@@ -6,8 +6,11 @@
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "core/logger.h"
+#include "core/job_system.h"
+#include "core/string_intern.h"
 #include "defines.h"
 #include "game_types.h"
+#include "memory/frame_allocator.h"
 #include "memory/linear_allocator.h"
 #include "platform/platform.h"
 #include "renderer/renderer_frontend.h"
@@ -32,10 +35,14 @@ typedef struct application_state {
     clock clock;
     f64 last_time;
 
-    u64 systems_allocator_memory_requirement;
-    void *systems_allocator_memory;
     linear_allocator systems_allocator;
 
+    // Scratch memory for transient per-frame data, one buffer per frame in
+    // flight.
+    u64 frame_allocator_memory_requirement;
+    void *frame_allocator_memory;
+    frame_allocator frame_allocator;
+
     u64 logging_system_memory_requirement;
     void *logging_system_state;
 
@@ -45,6 +52,12 @@ typedef struct application_state {
     u64 event_system_memory_requirement;
     void *event_system_state;
 
+    u64 string_intern_system_memory_requirement;
+    void *string_intern_system_state;
+
+    u64 job_system_memory_requirement;
+    void *job_system_state;
+
     u64 resource_system_memory_requirement;
     void *resource_system_state;
 
@@ -97,7 +110,7 @@ b8 event_on_debug_event(u16 code, void *sender, void *listener_inst,
     }
 
     // Release the old texture
-    texture_system_release(old_name);
+    texture_system_release(string_intern(old_name));
 
     return true;
 }
@@ -111,32 +124,31 @@ KAPI b8 application_create(game *game_inst) {
     // memory
     memory_system_configuration memory_system_config = {};
     memory_system_config.total_alloc_count = GIBIBYTES(1);
+    memory_system_config.allocator_strategy = DYNAMIC_ALLOCATOR_STRATEGY_TLSF;
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; i++) {
+        memory_system_config.budgets[i] =
+            game_inst->app_config.memory_budgets[i];
+    }
     if (!memory_system_initialize(memory_system_config)) {
         KERROR("Failed to initialize memory system, shutting down.");
         return false;
     }
 
-    // TODO: handle alignment in dynamic allocator
-    void *raw_game_state_block =
-        kallocate(game_inst->state_memory_requirement + 63, MEMORY_TAG_GAME);
-    game_inst->state = (void *)(((u64)raw_game_state_block + 63) & ~63);
+    game_inst->state = kallocate_aligned(game_inst->state_memory_requirement,
+                                         64, MEMORY_TAG_GAME);
 
     game_inst->application_state =
         kallocate(sizeof(application_state), MEMORY_TAG_APPLICATION);
     app_state = game_inst->application_state;
     app_state->game_inst = game_inst;
 
-    u64 systems_allocator_total_size = 64 * 1024 * 1024; // 64 mb
-    linear_allocator_create(systems_allocator_total_size,
-                            &app_state->systems_allocator_memory_requirement, 0,
-                            &app_state->systems_allocator);
-    app_state->systems_allocator_memory =
-        kallocate(app_state->systems_allocator_memory_requirement,
-                  MEMORY_TAG_LINEAR_ALLOCATOR);
-    linear_allocator_create(systems_allocator_total_size,
-                            &app_state->systems_allocator_memory_requirement,
-                            app_state->systems_allocator_memory,
-                            &app_state->systems_allocator);
+    // Reserved up front, committed as systems claim their state.
+    u64 systems_allocator_total_size = 256 * 1024 * 1024; // 256 mb
+    if (!linear_allocator_create_virtual(systems_allocator_total_size, 0,
+                                         &app_state->systems_allocator)) {
+        KFATAL("Failed to reserve memory for the systems allocator.");
+        return false;
+    }
 
     // Initialize subsystems
     // logging
@@ -191,6 +203,42 @@ KAPI b8 application_create(game *game_inst) {
         return false;
     }
 
+    // Initialize string interning, before any system that names resources
+    string_intern_config string_intern_config;
+    // Room for every texture, material and geometry name, with spare.
+    string_intern_config.max_string_count = 128 * 1024;
+    string_intern_initialize(
+        &app_state->string_intern_system_memory_requirement, 0,
+        string_intern_config);
+    app_state->string_intern_system_state = linear_allocator_allocate(
+        &app_state->systems_allocator,
+        app_state->string_intern_system_memory_requirement, 64);
+    if (!string_intern_initialize(
+            &app_state->string_intern_system_memory_requirement,
+            app_state->string_intern_system_state, string_intern_config)) {
+        KFATAL("Failed to initialize string intern system, shutting down.");
+        return false;
+    }
+
+    // Initialize the job system, with a worker per remaining hardware thread
+    job_system_config job_system_config;
+    job_system_config.worker_count = JOB_SYSTEM_WORKER_COUNT_AUTO;
+    job_system_config.max_queued_jobs = 1024;
+    job_system_config.pin_workers = false;
+    job_system_config.fiber_count = 128;
+    job_system_config.fiber_stack_size = 64 * 1024;
+    job_system_initialize(&app_state->job_system_memory_requirement, 0,
+                          job_system_config);
+    app_state->job_system_state = linear_allocator_allocate(
+        &app_state->systems_allocator,
+        app_state->job_system_memory_requirement, PLATFORM_CACHE_LINE_SIZE);
+    if (!job_system_initialize(&app_state->job_system_memory_requirement,
+                               app_state->job_system_state,
+                               job_system_config)) {
+        KFATAL("Failed to initialize job system, shutting down.");
+        return false;
+    }
+
     // Initialize resource system
     resource_system_config resource_system_config;
     resource_system_config.asset_base_path = "./assets";
@@ -220,6 +268,25 @@ KAPI b8 application_create(game *game_inst) {
         return false;
     }
 
+    // Initialize frame allocator
+    u64 frame_allocator_frame_size = 8 * 1024 * 1024; // 8 mb
+    u8 frame_allocator_frame_count = renderer_max_frames_in_flight();
+    frame_allocator_create(frame_allocator_frame_size,
+                           frame_allocator_frame_count,
+                           &app_state->frame_allocator_memory_requirement, 0,
+                           0);
+    app_state->frame_allocator_memory = linear_allocator_allocate(
+        &app_state->systems_allocator,
+        app_state->frame_allocator_memory_requirement, 64);
+    if (!frame_allocator_create(frame_allocator_frame_size,
+                                frame_allocator_frame_count,
+                                &app_state->frame_allocator_memory_requirement,
+                                app_state->frame_allocator_memory,
+                                &app_state->frame_allocator)) {
+        KFATAL("Failed to initialize frame allocator, shutting down.");
+        return false;
+    }
+
     // Initialize texture system
     texture_system_config texture_system_config;
     texture_system_config.max_texture_count = 65536;
@@ -350,6 +417,16 @@ KAPI b8 application_run() {
         }
 
         if (!app_state->is_suspended) {
+            // Frame memory is reused only once the GPU is done with the
+            // frame that last used it.
+            u8 frame_index = 0;
+            if (!renderer_wait_for_frame(&frame_index)) {
+                KFATAL("Waiting for the renderer failed, shutting down");
+                break;
+            }
+            frame_allocator_begin_frame(&app_state->frame_allocator,
+                                        frame_index);
+
             // Update clock and get delta time
             clock_update(&app_state->clock);
             f64 current_time = app_state->clock.elapsed;
@@ -373,18 +450,21 @@ KAPI b8 application_run() {
             packet.delta_time = delta;
 
             // TODO: temp
-            geometry_render_data test_render;
-            test_render.geometry = app_state->test_world_geometry;
-            test_render.model = mat4_identity();
+            // Draw lists live in frame memory until the frame retires.
+            geometry_render_data *test_render = frame_allocator_allocate(
+                &app_state->frame_allocator, sizeof(geometry_render_data), 16);
+            test_render->geometry = app_state->test_world_geometry;
+            test_render->model = mat4_identity();
 
             packet.geometry_count = 1;
-            packet.geometries = &test_render;
+            packet.geometries = test_render;
 
-            geometry_render_data test_ui_render;
-            test_ui_render.geometry = app_state->test_ui_geometry;
-            test_ui_render.model = mat4_translation((vec3){{0, 0, 0}});
+            geometry_render_data *test_ui_render = frame_allocator_allocate(
+                &app_state->frame_allocator, sizeof(geometry_render_data), 16);
+            test_ui_render->geometry = app_state->test_ui_geometry;
+            test_ui_render->model = mat4_translation((vec3){{0, 0, 0}});
             packet.ui_geometry_count = 1;
-            packet.ui_geometries = &test_ui_render;
+            packet.ui_geometries = test_ui_render;
 
             renderer_draw_frame(&packet);
 
@@ -405,6 +485,9 @@ KAPI b8 application_run() {
             }
 
             frame_count++;
+            memory_system_end_frame();
+            // Pay down fragmentation a little every frame.
+            memory_system_compact(MEBIBYTES(1));
 
             input_update(delta);
 
@@ -414,6 +497,12 @@ KAPI b8 application_run() {
     }
 
     KDEBUG("Frame count: %d, running time: %f", frame_count, running_time);
+    frame_allocator_stats frame_stats;
+    frame_allocator_get_stats(&app_state->frame_allocator, &frame_stats);
+    KDEBUG("Frame allocator high-water mark: %llu of %lluB per frame, %llu "
+           "failed allocations.",
+           frame_stats.high_water, frame_stats.capacity,
+           frame_stats.failed_count);
     app_state->is_running = false;
 
     KINFO("after temp watch close");
@@ -432,16 +521,17 @@ KAPI b8 application_run() {
     texture_system_shutdown(app_state->texture_system_state);
     renderer_shutdown(app_state->renderer_system_state);
     resource_system_shutdown(app_state->resource_system_state);
+    job_system_shutdown(app_state->job_system_state);
+    string_intern_shutdown(app_state->string_intern_system_state);
     event_shutdown(app_state->event_system_state);
 
-    kfree(app_state->game_inst->state,
-          app_state->game_inst->state_memory_requirement + 63, MEMORY_TAG_GAME);
+    kfree_aligned(app_state->game_inst->state,
+                  app_state->game_inst->state_memory_requirement, 64,
+                  MEMORY_TAG_GAME);
 
-    // Destroy and free linear allocator
+    // Destroy linear allocator, releasing its reserved range
+    frame_allocator_destroy(&app_state->frame_allocator);
     linear_allocator_destroy(&app_state->systems_allocator);
-    kfree(app_state->systems_allocator_memory,
-          app_state->systems_allocator_memory_requirement,
-          MEMORY_TAG_LINEAR_ALLOCATOR);
 
     platform_shutdown(&app_state->platform);
     memory_system_shutdown();
@@ -449,6 +539,11 @@ KAPI b8 application_run() {
     return true;
 }
 
+void *application_frame_allocate(u64 size, u64 alignment) {
+    return frame_allocator_allocate(&app_state->frame_allocator, size,
+                                    alignment);
+}
+
 void application_get_framebuffer_size(u32 *width, u32 *height) {
     *width = app_state->width;
     *height = app_state->height;
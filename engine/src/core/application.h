@@ -2,6 +2,8 @@
 
 #include "defines.h"
 
+#include "core/kmemory.h"
+
 typedef struct game game;
 
 // Application Configuration
@@ -20,10 +22,17 @@ typedef struct application_config {
 
     // The application title, if applicable
     char *name;
+
+    // Per-tag memory ceilings, indexed by memory_tag. Zeroed means none.
+    memory_tag_budget memory_budgets[MEMORY_TAG_MAX_TAGS];
 } application_config;
 
 KAPI b8 application_create(game *game_inst);
 
 KAPI b8 application_run();
 
+// Allocates transient memory that stays valid for as many frames as the
+// renderer keeps in flight. Not zeroed; never freed individually.
+KAPI void *application_frame_allocate(u64 size, u64 alignment);
+
 void application_get_framebuffer_size(u32 *width, u32 *height);
@@ -46,7 +46,7 @@ b8 event_initialize(u64 *memory_requirement, void *state) {
 void event_shutdown(void *state) {
     for (u16 i = 0; i < MAX_MESSAGE_CODES; i++) {
         if (state_ptr->registered[i].events == 0) {
-            break;
+            continue;
         }
 
         darray_destroy(state_ptr->registered[i].events);
@@ -112,7 +112,8 @@ b8 event_unregister(u16 code, void *listener, PFN_on_event on_event) {
 }
 
 b8 event_fire(u16 code, void *sender, event_context context) {
-    if (state_ptr->initialized == false) {
+    // The memory system can fire before the event system is up.
+    if (!state_ptr || state_ptr->initialized == false) {
         return false;
     }
 
@@ -111,6 +111,14 @@ typedef enum system_event_code {
      */
     EVENT_CODE_RESIZED = 0x08,
 
+    // A memory tag went over its soft budget. Fired on the main thread from
+    // memory_system_end_frame; listeners should free what they can.
+    /* Context usage:
+     * memory_tag tag = data.data.u32[0];
+     * u64 bytes_in_use = data.data.u64[1];
+     */
+    EVENT_CODE_MEMORY_PRESSURE = 0x09,
+
     // Debug codes
     EVENT_CODE_DEBUG0 = 0x10,
     EVENT_CODE_DEBUG1 = 0x11,
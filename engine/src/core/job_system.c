@@ -0,0 +1,679 @@
+#include "core/job_system.h"
+
+#include "core/kfiber.h"
+#include "core/katomic.h"
+#include "core/kmemory.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kthread.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+// A worker that finds nothing to run this many times in a row goes to sleep.
+#define JOB_IDLE_SPIN_COUNT 64
+
+// A queued job. Stealing threads may read a slot while its owner overwrites
+// it, in which case their claim on the slot fails and the copy is discarded,
+// so fields are accessed atomically.
+typedef struct job_slot {
+    pfn_job_entry entry;
+    void *params;
+    job_counter *counter;
+} job_slot;
+
+// A Chase-Lev work-stealing deque. The owning thread pushes and pops at
+// bottom; other threads steal from top. Each index sits on its own cache
+// line, so steals do not slow the owner down.
+typedef struct job_deque {
+    i64 top;
+    u8 top_padding[PLATFORM_CACHE_LINE_SIZE - sizeof(i64)];
+    i64 bottom;
+    u8 bottom_padding[PLATFORM_CACHE_LINE_SIZE - sizeof(i64)];
+} job_deque;
+
+// A fiber jobs run on, so they can wait by switching away. A fiber runs job,
+// switches back to the scheduler of the thread running it, and is then either
+// kept for the next job or, if it set wait_counter, parked until that counter
+// reaches zero and resumed on whichever thread finds it first.
+typedef struct job_fiber {
+    kfiber fiber;
+    job_slot job;
+    job_counter *wait_counter;
+    // The thread running the fiber; set each time it is switched to.
+    u32 thread;
+    // Links the free or waiting list.
+    u32 next;
+} job_fiber;
+
+typedef struct job_thread {
+    job_deque deques[JOB_PRIORITY_COUNT];
+    // Only touched by the owning thread.
+    kthread thread;
+    // The thread's own context, which fibers switch back to.
+    kfiber scheduler;
+    u32 random;
+    // A fiber kept for the next job, or INVALID_ID.
+    u32 idle_fiber;
+    // The fiber the thread is running, or INVALID_ID on its own stack.
+    u32 current_fiber;
+    u8 padding[PLATFORM_CACHE_LINE_SIZE - sizeof(kthread) - sizeof(kfiber) -
+               sizeof(u32) * 3];
+} job_thread;
+
+STATIC_ASSERT(sizeof(job_thread) % PLATFORM_CACHE_LINE_SIZE == 0,
+              "Expected job_thread to fill whole cache lines.");
+
+typedef struct job_system_state {
+    job_system_config config;
+    u32 thread_count;
+    /** @brief The slots in each deque, a power of 2. */
+    u32 queue_capacity;
+    job_thread *threads;
+    // Indexed by thread, then priority, then position.
+    job_slot *slots;
+    job_fiber *fibers;
+    ksemaphore wake;
+    // Guards the free and waiting fiber lists.
+    kmutex fiber_lock;
+    u32 free_fibers;
+    u32 waiting_fibers;
+    // The length of the waiting list, read without the lock.
+    u32 waiting_count;
+    // Written by every thread.
+    b8 running;
+    u32 sleeping;
+    // Threads outside the system inside job_counter_add. Shutdown waits for
+    // them, since the waiter they release may be the one shutting down.
+    u32 counter_updates;
+} job_system_state;
+
+static job_system_state *state_ptr = 0;
+
+static KTHREAD_LOCAL u32 thread_index = INVALID_ID;
+
+static u64 job_round_to_line(u64 size) {
+    return (size + PLATFORM_CACHE_LINE_SIZE - 1) &
+           ~(u64)(PLATFORM_CACHE_LINE_SIZE - 1);
+}
+
+static job_slot *job_deque_slots(u32 thread, job_priority priority) {
+    return state_ptr->slots +
+           ((u64)thread * JOB_PRIORITY_COUNT + priority) *
+               state_ptr->queue_capacity;
+}
+
+static b8 job_deque_push(u32 thread, job_priority priority,
+                         const job *job_to_push, job_counter *counter) {
+    job_deque *deque = &state_ptr->threads[thread].deques[priority];
+    i64 bottom = katomic_load(&deque->bottom, KATOMIC_RELAXED);
+    i64 top = katomic_load(&deque->top, KATOMIC_ACQUIRE);
+    if (bottom - top >= (i64)state_ptr->queue_capacity) {
+        return false;
+    }
+
+    job_slot *slot = &job_deque_slots(thread, priority)
+                          [bottom & (state_ptr->queue_capacity - 1)];
+    katomic_store(&slot->entry, job_to_push->entry, KATOMIC_RELAXED);
+    katomic_store(&slot->params, job_to_push->params, KATOMIC_RELAXED);
+    katomic_store(&slot->counter, counter, KATOMIC_RELAXED);
+    // Publish the slot with the new bottom.
+    katomic_store(&deque->bottom, bottom + 1, KATOMIC_RELEASE);
+    return true;
+}
+
+static b8 job_deque_pop(u32 thread, job_priority priority, job_slot *out) {
+    job_deque *deque = &state_ptr->threads[thread].deques[priority];
+    i64 bottom = katomic_load(&deque->bottom, KATOMIC_RELAXED) - 1;
+    katomic_store(&deque->bottom, bottom, KATOMIC_RELAXED);
+    // Thieves must see the lowered bottom before top is read, or both could
+    // take the last job.
+    katomic_thread_fence(KATOMIC_SEQ_CST);
+    i64 top = katomic_load(&deque->top, KATOMIC_RELAXED);
+    if (top > bottom) {
+        katomic_store(&deque->bottom, bottom + 1, KATOMIC_RELAXED);
+        return false;
+    }
+
+    *out = job_deque_slots(thread, priority)
+        [bottom & (state_ptr->queue_capacity - 1)];
+    if (top != bottom) {
+        return true;
+    }
+
+    // The last job; race thieves for it through top.
+    b8 taken = katomic_compare_exchange_strong(&deque->top, &top, top + 1,
+                                               KATOMIC_SEQ_CST,
+                                               KATOMIC_RELAXED);
+    katomic_store(&deque->bottom, bottom + 1, KATOMIC_RELAXED);
+    return taken;
+}
+
+static b8 job_deque_steal(u32 thread, job_priority priority, job_slot *out) {
+    job_deque *deque = &state_ptr->threads[thread].deques[priority];
+    i64 top = katomic_load(&deque->top, KATOMIC_ACQUIRE);
+    katomic_thread_fence(KATOMIC_SEQ_CST);
+    i64 bottom = katomic_load(&deque->bottom, KATOMIC_ACQUIRE);
+    if (top >= bottom) {
+        return false;
+    }
+
+    job_slot *slot = &job_deque_slots(thread, priority)
+                          [top & (state_ptr->queue_capacity - 1)];
+    job_slot copy;
+    copy.entry = katomic_load(&slot->entry, KATOMIC_RELAXED);
+    copy.params = katomic_load(&slot->params, KATOMIC_RELAXED);
+    copy.counter = katomic_load(&slot->counter, KATOMIC_RELAXED);
+    if (!katomic_compare_exchange_strong(&deque->top, &top, top + 1,
+                                         KATOMIC_SEQ_CST, KATOMIC_RELAXED)) {
+        return false;
+    }
+
+    *out = copy;
+    return true;
+}
+
+// Wakes up to count sleeping workers.
+static void job_wake(u32 count) {
+    // Order the pushes before the read of sleeping; see job_worker_main.
+    katomic_thread_fence(KATOMIC_SEQ_CST);
+    u32 sleeping = katomic_load(&state_ptr->sleeping, KATOMIC_RELAXED);
+    u32 woken;
+    do {
+        if (sleeping == 0) {
+            return;
+        }
+        woken = sleeping < count ? sleeping : count;
+    } while (!katomic_compare_exchange_weak(&state_ptr->sleeping, &sleeping,
+                                            sleeping - woken, KATOMIC_RELAXED,
+                                            KATOMIC_RELAXED));
+    ksemaphore_signal(&state_ptr->wake, woken);
+}
+
+// Called once a counter drops to zero. A fiber parked on it only resumes when
+// a worker looks, so make sure one is awake to.
+static void job_counter_reached_zero() {
+    // job_run still runs jobs inline when there is no job system.
+    if (!state_ptr) {
+        return;
+    }
+    // Order the decrement before the read of waiting_count. job_fiber_park
+    // orders its increment before the parking thread's next look at the
+    // counter, so either that look sees zero or this sees the fiber.
+    katomic_thread_fence(KATOMIC_SEQ_CST);
+    if (katomic_load(&state_ptr->waiting_count, KATOMIC_RELAXED) > 0) {
+        job_wake(1);
+    }
+}
+
+static void job_execute(const job_slot *slot) {
+    slot->entry(slot->params);
+    if (slot->counter) {
+        // Release the job's writes to whoever waits on the counter.
+        if (katomic_fetch_sub(&slot->counter->value, 1, KATOMIC_RELEASE) ==
+            1) {
+            job_counter_reached_zero();
+        }
+    }
+}
+
+// Finds a job, highest priority first: from the thread's own deque, then by
+// stealing from the others, starting at a random one so thieves spread out.
+static b8 job_find(u32 thread, job_slot *out) {
+    job_thread *self = &state_ptr->threads[thread];
+    u32 count = state_ptr->thread_count;
+    for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+        if (job_deque_pop(thread, p, out)) {
+            return true;
+        }
+
+        if (count > 1) {
+            // xorshift32
+            self->random ^= self->random << 13;
+            self->random ^= self->random >> 17;
+            self->random ^= self->random << 5;
+            u32 start = self->random % count;
+            for (u32 i = 0; i < count; ++i) {
+                u32 victim = (start + i) % count;
+                if (victim != thread && job_deque_steal(victim, p, out)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+static u32 job_fiber_take_free() {
+    kmutex_lock(&state_ptr->fiber_lock);
+    u32 index = state_ptr->free_fibers;
+    if (index != INVALID_ID) {
+        state_ptr->free_fibers = state_ptr->fibers[index].next;
+    }
+    kmutex_unlock(&state_ptr->fiber_lock);
+    return index;
+}
+
+static void job_fiber_release(u32 index) {
+    kmutex_lock(&state_ptr->fiber_lock);
+    state_ptr->fibers[index].next = state_ptr->free_fibers;
+    state_ptr->free_fibers = index;
+    kmutex_unlock(&state_ptr->fiber_lock);
+}
+
+static void job_fiber_park(u32 index) {
+    kmutex_lock(&state_ptr->fiber_lock);
+    state_ptr->fibers[index].next = state_ptr->waiting_fibers;
+    state_ptr->waiting_fibers = index;
+    katomic_fetch_add(&state_ptr->waiting_count, 1, KATOMIC_RELAXED);
+    kmutex_unlock(&state_ptr->fiber_lock);
+    // This thread stays awake and looks for ready fibers next; order the
+    // increment before that look. See job_counter_reached_zero.
+    katomic_thread_fence(KATOMIC_SEQ_CST);
+}
+
+// Takes a parked fiber whose counter has reached zero, or returns INVALID_ID.
+static u32 job_fiber_take_ready() {
+    if (katomic_load(&state_ptr->waiting_count, KATOMIC_RELAXED) == 0) {
+        return INVALID_ID;
+    }
+
+    kmutex_lock(&state_ptr->fiber_lock);
+    u32 *link = &state_ptr->waiting_fibers;
+    while (*link != INVALID_ID) {
+        u32 index = *link;
+        job_fiber *fiber = &state_ptr->fibers[index];
+        if (katomic_load(&fiber->wait_counter->value, KATOMIC_ACQUIRE) <= 0) {
+            *link = fiber->next;
+            katomic_fetch_sub(&state_ptr->waiting_count, 1, KATOMIC_RELAXED);
+            kmutex_unlock(&state_ptr->fiber_lock);
+            return index;
+        }
+        link = &fiber->next;
+    }
+    kmutex_unlock(&state_ptr->fiber_lock);
+    return INVALID_ID;
+}
+
+static void job_fiber_main(void *params) {
+    job_fiber *fiber = &state_ptr->fibers[(u32)(u64)params];
+    for (;;) {
+        job_execute(&fiber->job);
+        kfiber_switch(&fiber->fiber,
+                      &state_ptr->threads[fiber->thread].scheduler);
+    }
+}
+
+// Switches to a fiber, new or resumed, until it finishes its job or waits.
+static void job_fiber_run(u32 thread, u32 index) {
+    job_thread *self = &state_ptr->threads[thread];
+    job_fiber *fiber = &state_ptr->fibers[index];
+    fiber->thread = thread;
+    fiber->wait_counter = 0;
+    self->current_fiber = index;
+    kfiber_switch(&self->scheduler, &fiber->fiber);
+    self->current_fiber = INVALID_ID;
+
+    // Only now is the fiber off its stack, so it is safe to park.
+    if (fiber->wait_counter) {
+        job_fiber_park(index);
+    } else if (self->idle_fiber == INVALID_ID) {
+        self->idle_fiber = index;
+    } else {
+        job_fiber_release(index);
+    }
+}
+
+// Runs a job on a fiber when there is one to spare, or on the thread's own
+// stack, where waiting inside it falls back to running other jobs.
+static void job_dispatch(u32 thread, const job_slot *slot) {
+    if (!state_ptr->fibers) {
+        job_execute(slot);
+        return;
+    }
+
+    job_thread *self = &state_ptr->threads[thread];
+    u32 index = self->idle_fiber;
+    if (index != INVALID_ID) {
+        self->idle_fiber = INVALID_ID;
+    } else {
+        index = job_fiber_take_free();
+        if (index == INVALID_ID) {
+            job_execute(slot);
+            return;
+        }
+    }
+
+    state_ptr->fibers[index].job = *slot;
+    job_fiber_run(thread, index);
+}
+
+static b8 job_find_and_execute(u32 thread) {
+    if (state_ptr->fibers) {
+        // Finish started jobs before starting new ones.
+        u32 ready = job_fiber_take_ready();
+        if (ready != INVALID_ID) {
+            job_fiber_run(thread, ready);
+            return true;
+        }
+    }
+
+    job_slot slot;
+    if (!job_find(thread, &slot)) {
+        return false;
+    }
+
+    job_dispatch(thread, &slot);
+    return true;
+}
+
+static u32 job_worker_main(void *params) {
+    thread_index = (u32)(u64)params;
+    job_thread *self = &state_ptr->threads[thread_index];
+    if (state_ptr->fibers && !kfiber_convert_thread(&self->scheduler)) {
+        KERROR("job_worker_main - worker %u failed to convert to a fiber.",
+               thread_index);
+        memory_system_flush_thread_cache();
+        return 1;
+    }
+
+    u32 idle = 0;
+    while (katomic_load(&state_ptr->running, KATOMIC_ACQUIRE)) {
+        if (job_find_and_execute(thread_index)) {
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < JOB_IDLE_SPIN_COUNT) {
+            kthread_yield();
+            continue;
+        }
+
+        // Announce sleep, then look once more: job_run and
+        // job_counter_reached_zero publish their work before reading
+        // sleeping, so either that look sees the work or they see this
+        // thread asleep and wake it.
+        idle = 0;
+        katomic_fetch_add(&state_ptr->sleeping, 1, KATOMIC_SEQ_CST);
+        katomic_thread_fence(KATOMIC_SEQ_CST);
+        u32 ready = state_ptr->fibers ? job_fiber_take_ready() : INVALID_ID;
+        job_slot slot;
+        if (ready != INVALID_ID || job_find(thread_index, &slot)) {
+            // Withdraw unless a waker already counted this thread; its
+            // signal then only causes one spurious wake up.
+            u32 sleeping =
+                katomic_load(&state_ptr->sleeping, KATOMIC_RELAXED);
+            while (sleeping > 0 &&
+                   !katomic_compare_exchange_weak(&state_ptr->sleeping,
+                                                  &sleeping, sleeping - 1,
+                                                  KATOMIC_RELAXED,
+                                                  KATOMIC_RELAXED)) {
+            }
+            if (ready != INVALID_ID) {
+                job_fiber_run(thread_index, ready);
+            } else {
+                job_dispatch(thread_index, &slot);
+            }
+            continue;
+        }
+        if (!katomic_load(&state_ptr->running, KATOMIC_ACQUIRE)) {
+            break;
+        }
+        ksemaphore_wait(&state_ptr->wake);
+    }
+
+    if (state_ptr->fibers) {
+        kfiber_revert_thread(&self->scheduler);
+    }
+    // Blocks cached by this thread can't be reused once it exits.
+    memory_system_flush_thread_cache();
+    return 0;
+}
+
+// Creates the fibers and converts the calling thread, so it can switch to
+// them.
+static b8 job_fibers_create(job_fiber *fibers) {
+    if (!kfiber_convert_thread(&state_ptr->threads[0].scheduler)) {
+        KFATAL("job_system_initialize - failed to convert the thread to a "
+               "fiber.");
+        return false;
+    }
+
+    state_ptr->fibers = fibers;
+    for (u32 i = 0; i < state_ptr->config.fiber_count; ++i) {
+        if (!kfiber_create(state_ptr->config.fiber_stack_size, job_fiber_main,
+                           (void *)(u64)i, &fibers[i].fiber)) {
+            KFATAL("job_system_initialize - failed to create fiber %u.", i);
+            return false;
+        }
+        fibers[i].next = i + 1;
+    }
+    fibers[state_ptr->config.fiber_count - 1].next = INVALID_ID;
+    state_ptr->free_fibers = 0;
+    return true;
+}
+
+b8 job_system_initialize(u64 *memory_requirement, void *state,
+                         job_system_config config) {
+    if (config.max_queued_jobs == 0) {
+        KFATAL("job_system_initialize - config.max_queued_jobs must be "
+               "positive.");
+        return false;
+    }
+
+    u32 processor_count = platform_get_processor_count();
+    if (platform_get_cache_line_size() > PLATFORM_CACHE_LINE_SIZE) {
+        KWARN("job_system_initialize - cache lines are %u bytes, more than "
+              "the %u the queues are padded to; threads may contend.",
+              platform_get_cache_line_size(), PLATFORM_CACHE_LINE_SIZE);
+    }
+    u32 worker_count = config.worker_count;
+    if (worker_count == JOB_SYSTEM_WORKER_COUNT_AUTO) {
+        worker_count = processor_count - 1;
+    }
+    u32 thread_count = worker_count + 1;
+    u32 queue_capacity = 1;
+    while (queue_capacity < config.max_queued_jobs) {
+        queue_capacity <<= 1;
+    }
+
+    // The state, followed by the threads, the deque slots, then the fibers.
+    // Fiber stacks are allocated by the platform.
+    u64 struct_requirement = job_round_to_line(sizeof(job_system_state));
+    u64 threads_requirement = sizeof(job_thread) * thread_count;
+    u64 slots_requirement = sizeof(job_slot) * thread_count *
+                            JOB_PRIORITY_COUNT * queue_capacity;
+    u64 fibers_requirement = sizeof(job_fiber) * config.fiber_count;
+    *memory_requirement = struct_requirement + threads_requirement +
+                          slots_requirement + fibers_requirement;
+
+    if (!state) {
+        return true;
+    }
+
+    if ((u64)state % PLATFORM_CACHE_LINE_SIZE != 0) {
+        KFATAL("job_system_initialize - state must be aligned to %u bytes.",
+               PLATFORM_CACHE_LINE_SIZE);
+        return false;
+    }
+
+    state_ptr = state;
+    kzero_memory(state_ptr, *memory_requirement);
+    state_ptr->config = config;
+    state_ptr->thread_count = thread_count;
+    state_ptr->queue_capacity = queue_capacity;
+    state_ptr->threads = state + struct_requirement;
+    state_ptr->slots = state + struct_requirement + threads_requirement;
+    state_ptr->running = true;
+    for (u32 i = 0; i < thread_count; ++i) {
+        job_thread *thread = &state_ptr->threads[i];
+        thread->random = 0x9E3779B9u * (i + 1);
+        thread->idle_fiber = INVALID_ID;
+        thread->current_fiber = INVALID_ID;
+    }
+
+    if (!ksemaphore_create(0, &state_ptr->wake) ||
+        !kmutex_create(&state_ptr->fiber_lock)) {
+        KFATAL("job_system_initialize - failed to create semaphore or "
+               "mutex.");
+        ksemaphore_destroy(&state_ptr->wake);
+        kmutex_destroy(&state_ptr->fiber_lock);
+        state_ptr = 0;
+        return false;
+    }
+
+    state_ptr->free_fibers = INVALID_ID;
+    state_ptr->waiting_fibers = INVALID_ID;
+    if (config.fiber_count > 0) {
+        if (!job_fibers_create(state + struct_requirement +
+                               threads_requirement + slots_requirement)) {
+            // No workers have started yet.
+            state_ptr->thread_count = 1;
+            job_system_shutdown(state);
+            return false;
+        }
+    }
+
+    thread_index = 0;
+    for (u32 i = 1; i < thread_count; ++i) {
+        job_thread *thread = &state_ptr->threads[i];
+        if (!kthread_create(job_worker_main, (void *)(u64)i, false,
+                            &thread->thread)) {
+            KFATAL("job_system_initialize - failed to start worker %u.", i);
+            state_ptr->thread_count = i;
+            job_system_shutdown(state);
+            return false;
+        }
+        if (config.pin_workers) {
+            kthread_set_affinity(&thread->thread, i % processor_count);
+        }
+    }
+
+    KINFO("Job system started with %u worker threads and %u fibers.",
+          worker_count, config.fiber_count);
+    return true;
+}
+
+void job_system_shutdown(void *state) {
+    if (!state_ptr) {
+        return;
+    }
+
+    katomic_store(&state_ptr->running, false, KATOMIC_RELEASE);
+    // Enough for every worker, asleep or about to be.
+    ksemaphore_signal(&state_ptr->wake, state_ptr->thread_count);
+    for (u32 i = 1; i < state_ptr->thread_count; ++i) {
+        kthread_wait(&state_ptr->threads[i].thread);
+    }
+    while (katomic_load(&state_ptr->counter_updates, KATOMIC_ACQUIRE) > 0) {
+        kthread_yield();
+    }
+
+    if (state_ptr->fibers) {
+        // Fibers still parked are dropped with their jobs.
+        for (u32 i = 0; i < state_ptr->config.fiber_count; ++i) {
+            kfiber_destroy(&state_ptr->fibers[i].fiber);
+        }
+        kfiber_revert_thread(&state_ptr->threads[0].scheduler);
+    }
+
+    kmutex_destroy(&state_ptr->fiber_lock);
+    ksemaphore_destroy(&state_ptr->wake);
+    thread_index = INVALID_ID;
+    state_ptr = 0;
+}
+
+void job_run(const job *jobs, u32 count, job_priority priority,
+             job_counter *counter) {
+    if (!jobs || priority >= JOB_PRIORITY_COUNT) {
+        KERROR("job_run - requires valid jobs and priority.");
+        return;
+    }
+
+    if (counter) {
+        katomic_fetch_add(&counter->value, count, KATOMIC_RELAXED);
+    }
+
+    u32 thread = thread_index;
+    if (!state_ptr || thread == INVALID_ID) {
+        if (state_ptr) {
+            KERROR("job_run - called from a thread outside the job system. "
+                   "Running the jobs at once.");
+        }
+        for (u32 i = 0; i < count; ++i) {
+            job_slot slot = {jobs[i].entry, jobs[i].params, counter};
+            job_execute(&slot);
+        }
+        return;
+    }
+
+    u32 queued = 0;
+    for (u32 i = 0; i < count; ++i) {
+        if (job_deque_push(thread, priority, &jobs[i], counter)) {
+            queued++;
+        } else {
+            // The deque is full; doing the work here keeps it bounded.
+            job_slot slot = {jobs[i].entry, jobs[i].params, counter};
+            job_execute(&slot);
+        }
+    }
+
+    if (queued > 0) {
+        job_wake(queued);
+    }
+}
+
+void job_wait(job_counter *counter) {
+    if (!counter) {
+        return;
+    }
+
+    u32 thread = thread_index;
+    if (state_ptr && thread != INVALID_ID) {
+        u32 index = state_ptr->threads[thread].current_fiber;
+        if (index != INVALID_ID) {
+            // On a fiber: park it, and let this thread run something else.
+            // It returns here once the counter reaches zero, possibly on
+            // another thread, so nothing read before the switch is reused.
+            if (katomic_load(&counter->value, KATOMIC_ACQUIRE) > 0) {
+                job_fiber *fiber = &state_ptr->fibers[index];
+                fiber->wait_counter = counter;
+                kfiber_switch(&fiber->fiber,
+                              &state_ptr->threads[thread].scheduler);
+            }
+            return;
+        }
+    }
+
+    while (katomic_load(&counter->value, KATOMIC_ACQUIRE) > 0) {
+        if (!state_ptr || thread == INVALID_ID ||
+            !job_find_and_execute(thread)) {
+            kthread_yield();
+        }
+    }
+}
+
+void job_counter_add(job_counter *counter, i64 amount) {
+    if (!counter) {
+        return;
+    }
+    // Register before touching the counter: once it reaches zero, its waiter
+    // can go on to shut the system down while this thread still wakes a
+    // worker.
+    job_system_state *state = state_ptr;
+    if (state) {
+        katomic_fetch_add(&state->counter_updates, 1, KATOMIC_RELAXED);
+    }
+    i64 previous = katomic_fetch_add(&counter->value, amount, KATOMIC_RELEASE);
+    if (state) {
+        if (previous > 0 && previous + amount <= 0) {
+            job_counter_reached_zero();
+        }
+        katomic_fetch_sub(&state->counter_updates, 1, KATOMIC_RELEASE);
+    }
+}
+
+u32 job_system_thread_count() {
+    return state_ptr ? state_ptr->thread_count : 0;
+}
+
+u32 job_system_thread_index() { return thread_index; }
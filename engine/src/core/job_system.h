@@ -0,0 +1,133 @@
+/**
+ * @file job_system.h
+ * @brief This file contains the job system, which runs small units of work on
+ * a worker thread per hardware thread, balanced by work stealing.
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The function a job runs. */
+typedef void (*pfn_job_entry)(void *params);
+
+/** @brief The order in which queued jobs are picked up. */
+typedef enum job_priority {
+    /** @brief Picked up before any other queued job. */
+    JOB_PRIORITY_HIGH,
+    JOB_PRIORITY_NORMAL,
+    /** @brief Picked up only when nothing else is queued. */
+    JOB_PRIORITY_LOW,
+    JOB_PRIORITY_COUNT
+} job_priority;
+
+/**
+ * @brief Counts unfinished jobs, for fork-join. Zero it, pass it to job_run
+ * along with a batch of jobs, then job_wait on it. One counter may be passed
+ * to several job_run calls. Must outlive the jobs that reference it.
+ */
+typedef struct job_counter {
+    i64 value;
+} job_counter;
+
+/** @brief A job to run. */
+typedef struct job {
+    /** @brief The function to run. */
+    pfn_job_entry entry;
+    /** @brief Passed to entry. Must stay valid until the job finishes. */
+    void *params;
+} job;
+
+/** @brief Requests one worker per hardware thread besides the calling one. */
+#define JOB_SYSTEM_WORKER_COUNT_AUTO INVALID_ID
+
+typedef struct job_system_config {
+    /** @brief The number of worker threads, which may be 0, or
+     * JOB_SYSTEM_WORKER_COUNT_AUTO. */
+    u32 worker_count;
+    /** @brief The most jobs each thread can hold queued at each priority.
+     * Rounded up to a power of 2. A job that does not fit runs at once. */
+    u32 max_queued_jobs;
+    /** @brief Pins each worker to its own logical processor. */
+    b8 pin_workers;
+    /** @brief The number of fibers jobs run on, or 0 to run jobs on the
+     * thread stacks. With fibers, a job that waits is parked and its thread
+     * runs other jobs; the job later resumes on any thread. A job that starts
+     * while every fiber is parked runs on the thread stack. */
+    u32 fiber_count;
+    /** @brief The stack size of each fiber, in bytes. */
+    u64 fiber_stack_size;
+} job_system_config;
+
+/**
+ * @brief Initializes the job system and starts its workers. Call twice; first
+ * passing 0 to state to obtain the memory requirement, second to pass the
+ * allocated block, aligned to 64 bytes. The calling thread joins the system
+ * as thread 0 and must be the one to shut it down.
+ *
+ * @param memory_requirement A pointer to get the memory requirement.
+ * @param state 0, or a pre-allocated block of memory for the system state.
+ * @param config The configuration for the system.
+ * @return True if successful; otherwise False.
+ */
+b8 job_system_initialize(u64 *memory_requirement, void *state,
+                         job_system_config config);
+
+/**
+ * @brief Stops the workers once they finish their current job. Jobs still
+ * queued are dropped.
+ *
+ * @param state The system state.
+ */
+void job_system_shutdown(void *state);
+
+/**
+ * @brief Queues jobs on the calling thread, where idle threads can steal
+ * them. Must be called from a thread of the job system: the one that
+ * initialized it, or a job. Before the system is initialized, jobs run at
+ * once on the calling thread. Jobs of one priority run in no set order.
+ *
+ * @param jobs The jobs to run.
+ * @param count The number of jobs.
+ * @param priority The priority to queue them at.
+ * @param counter 0, or a counter to increase by count now and decrease as
+ * each job finishes.
+ */
+KAPI void job_run(const job *jobs, u32 count, job_priority priority,
+                  job_counter *counter);
+
+/**
+ * @brief Waits until counter reaches zero without leaving a core idle. From a
+ * job running on a fiber, the fiber is parked and its thread moves on to
+ * other jobs; the job may resume on another thread. Otherwise, queued jobs
+ * are run on the calling thread while waiting. Must be called from a thread
+ * of the job system.
+ *
+ * @param counter The counter to wait on.
+ */
+KAPI void job_wait(job_counter *counter);
+
+/**
+ * @brief Adjusts a counter from outside a job, so jobs can wait on other work:
+ * add 1 when an I/O request starts, for example, and -1 from whichever thread
+ * completes it.
+ *
+ * @param counter The counter to adjust.
+ * @param amount The amount to add.
+ */
+KAPI void job_counter_add(job_counter *counter, i64 amount);
+
+/**
+ * @brief Gets the number of threads running jobs, including the thread that
+ * initialized the system.
+ */
+KAPI u32 job_system_thread_count();
+
+/**
+ * @brief Gets the index of the calling thread in the job system: 0 for the
+ * thread that initialized it, 1 and up for workers, or INVALID_ID for other
+ * threads.
+ */
+KAPI u32 job_system_thread_index();
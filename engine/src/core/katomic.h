@@ -0,0 +1,87 @@
+/**
+ * @file katomic.h
+ * @brief Contains atomic operations on plain integer and pointer variables,
+ * with the memory orders of the C11 memory model. They map onto the GCC and
+ * Clang builtins, so the variables need no _Atomic qualifier. The engine
+ * builds with Clang on every platform, Windows included, so there is no MSVC
+ * mapping.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+#if !defined(__GNUC__) && !defined(__clang__)
+#error "katomic.h requires GCC or Clang atomic builtins."
+#endif
+
+/** @brief No ordering; only the operation itself is atomic. */
+#define KATOMIC_RELAXED __ATOMIC_RELAXED
+/** @brief Later reads and writes stay after this load. */
+#define KATOMIC_ACQUIRE __ATOMIC_ACQUIRE
+/** @brief Earlier reads and writes stay before this store. */
+#define KATOMIC_RELEASE __ATOMIC_RELEASE
+/** @brief Both acquire and release, for read-modify-write operations. */
+#define KATOMIC_ACQ_REL __ATOMIC_ACQ_REL
+/** @brief Acquire and release, plus one total order over all such
+ * operations. */
+#define KATOMIC_SEQ_CST __ATOMIC_SEQ_CST
+
+/** @brief Atomically reads *ptr. */
+#define katomic_load(ptr, order) __atomic_load_n(ptr, order)
+
+/** @brief Atomically writes value to *ptr. */
+#define katomic_store(ptr, value, order) __atomic_store_n(ptr, value, order)
+
+/** @brief Atomically writes value to *ptr and returns the previous value. */
+#define katomic_exchange(ptr, value, order)                                    \
+    __atomic_exchange_n(ptr, value, order)
+
+/**
+ * @brief Writes desired to *ptr if it holds *expected. On failure, *expected
+ * receives the current value. May fail spuriously, so call it in a loop.
+ * @return True if the value was written; otherwise False.
+ */
+#define katomic_compare_exchange_weak(ptr, expected, desired, success_order,   \
+                                      failure_order)                           \
+    __atomic_compare_exchange_n(ptr, expected, desired, true, success_order,   \
+                                failure_order)
+
+/** @brief Like katomic_compare_exchange_weak, but never fails spuriously. */
+#define katomic_compare_exchange_strong(ptr, expected, desired,                \
+                                        success_order, failure_order)          \
+    __atomic_compare_exchange_n(ptr, expected, desired, false, success_order,  \
+                                failure_order)
+
+/** @brief Atomically adds value to *ptr and returns the previous value. */
+#define katomic_fetch_add(ptr, value, order)                                   \
+    __atomic_fetch_add(ptr, value, order)
+
+/** @brief Atomically subtracts value from *ptr and returns the previous
+ * value. */
+#define katomic_fetch_sub(ptr, value, order)                                   \
+    __atomic_fetch_sub(ptr, value, order)
+
+/** @brief Atomically ANDs value into *ptr and returns the previous value. */
+#define katomic_fetch_and(ptr, value, order)                                   \
+    __atomic_fetch_and(ptr, value, order)
+
+/** @brief Atomically ORs value into *ptr and returns the previous value. */
+#define katomic_fetch_or(ptr, value, order) __atomic_fetch_or(ptr, value, order)
+
+/** @brief Orders memory operations around it without an atomic operation. */
+#define katomic_thread_fence(order) __atomic_thread_fence(order)
+
+/**
+ * @brief Tells the processor the thread is spinning on a value another thread
+ * will change, so it can save power and give way to a sibling hyperthread.
+ */
+KINLINE void katomic_spin_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
@@ -0,0 +1,64 @@
+/**
+ * @file kcondition.h
+ * @brief Contains a thin, platform-agnostic wrapper around a native condition
+ * variable. Implemented per platform in the platform layer.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+struct kmutex;
+
+/**
+ * @brief Represents a condition variable, which threads wait on with a kmutex
+ * held until another thread changes what the mutex guards and signals it.
+ */
+typedef struct kcondition {
+    /** @brief The platform condition variable. */
+    void *internal_data;
+} kcondition;
+
+/**
+ * @brief Creates a condition variable.
+ *
+ * @param out_condition A pointer to hold the condition variable. Required.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kcondition_create(kcondition *out_condition);
+
+/**
+ * @brief Destroys a condition variable. No thread may be waiting on it.
+ *
+ * @param condition A pointer to the condition variable.
+ */
+KAPI void kcondition_destroy(kcondition *condition);
+
+/**
+ * @brief Unlocks mutex and blocks until the condition variable is signalled,
+ * then locks mutex again before returning. May return spuriously, so call it
+ * in a loop that rechecks what is being waited for.
+ *
+ * @param condition A pointer to the condition variable.
+ * @param mutex A pointer to a mutex held by the calling thread.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kcondition_wait(kcondition *condition, struct kmutex *mutex);
+
+/**
+ * @brief Wakes one thread waiting on the condition variable, if any.
+ *
+ * @param condition A pointer to the condition variable.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kcondition_signal(kcondition *condition);
+
+/**
+ * @brief Wakes every thread waiting on the condition variable.
+ *
+ * @param condition A pointer to the condition variable.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kcondition_broadcast(kcondition *condition);
@@ -0,0 +1,74 @@
+/**
+ * @file kfiber.h
+ * @brief Contains a thin, platform-agnostic wrapper around user-mode fibers:
+ * stacks that threads switch between cooperatively. Implemented per platform
+ * in the platform layer.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief The function a fiber starts executing. It must never return; it
+ * ends by switching to another fiber for the last time.
+ */
+typedef void (*pfn_fiber_start)(void *);
+
+/**
+ * @brief Represents a fiber, or a thread converted so it can switch to
+ * fibers. A fiber may be resumed on any thread, but only one at a time.
+ */
+typedef struct kfiber {
+    /** @brief The platform fiber. */
+    void *internal_data;
+} kfiber;
+
+/**
+ * @brief Creates a fiber with its own stack. It starts executing when first
+ * switched to.
+ *
+ * @param stack_size The size of the stack in bytes. Rounded up to whole pages,
+ * plus a guard page where the platform supports one.
+ * @param start_function_ptr The function the fiber starts executing.
+ * @param params Passed to start_function_ptr.
+ * @param out_fiber A pointer to hold the fiber. Required.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kfiber_create(u64 stack_size, pfn_fiber_start start_function_ptr,
+                      void *params, kfiber *out_fiber);
+
+/**
+ * @brief Destroys a fiber and frees its stack. Must not be running.
+ *
+ * @param fiber A pointer to the fiber.
+ */
+KAPI void kfiber_destroy(kfiber *fiber);
+
+/**
+ * @brief Converts the calling thread into a fiber, so it can switch to other
+ * fibers and be switched back to.
+ *
+ * @param out_fiber A pointer to hold the thread's fiber. Required.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kfiber_convert_thread(kfiber *out_fiber);
+
+/**
+ * @brief Undoes kfiber_convert_thread. Must be called on the same thread,
+ * while it runs its own fiber.
+ *
+ * @param fiber A pointer to the thread's fiber.
+ */
+KAPI void kfiber_revert_thread(kfiber *fiber);
+
+/**
+ * @brief Saves the running fiber into from and continues running to. Returns
+ * when something switches back to from, possibly on another thread.
+ *
+ * @param from The fiber the calling thread is running.
+ * @param to The fiber to run.
+ */
+KAPI void kfiber_switch(kfiber *from, kfiber *to);
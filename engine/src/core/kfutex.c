@@ -0,0 +1,61 @@
+#include "core/kfutex.h"
+
+#include "core/katomic.h"
+#include "platform/platform.h"
+
+// Waiters move an unset event to waiting before they sleep, so setting it
+// only calls into the platform when a thread may be asleep.
+#define KFUTEX_EVENT_UNSET 0
+#define KFUTEX_EVENT_SET 1
+#define KFUTEX_EVENT_WAITING 2
+
+void kfutex_event_set(kfutex_event *event) {
+    u32 previous =
+        katomic_exchange(&event->state, KFUTEX_EVENT_SET, KATOMIC_RELEASE);
+    if (previous == KFUTEX_EVENT_WAITING) {
+        kfutex_wake(&event->state, INVALID_ID);
+    }
+}
+
+void kfutex_event_reset(kfutex_event *event) {
+    // An event with waiters is already unset; leave it marked as waiting.
+    u32 expected = KFUTEX_EVENT_SET;
+    katomic_compare_exchange_strong(&event->state, &expected,
+                                    KFUTEX_EVENT_UNSET, KATOMIC_RELAXED,
+                                    KATOMIC_RELAXED);
+}
+
+b8 kfutex_event_is_set(kfutex_event *event) {
+    return katomic_load(&event->state, KATOMIC_ACQUIRE) == KFUTEX_EVENT_SET;
+}
+
+b8 kfutex_event_wait(kfutex_event *event, u32 timeout_ms) {
+    f64 deadline = 0;
+    if (timeout_ms != KFUTEX_WAIT_FOREVER) {
+        deadline = platform_get_absolute_time() + timeout_ms / 1000.0;
+    }
+
+    for (;;) {
+        u32 state = katomic_load(&event->state, KATOMIC_ACQUIRE);
+        if (state == KFUTEX_EVENT_SET) {
+            return true;
+        }
+        if (state == KFUTEX_EVENT_UNSET &&
+            !katomic_compare_exchange_weak(&event->state, &state,
+                                           KFUTEX_EVENT_WAITING,
+                                           KATOMIC_RELAXED, KATOMIC_RELAXED)) {
+            continue;
+        }
+
+        u32 wait_ms = KFUTEX_WAIT_FOREVER;
+        if (timeout_ms != KFUTEX_WAIT_FOREVER) {
+            f64 remaining = deadline - platform_get_absolute_time();
+            if (remaining <= 0) {
+                return false;
+            }
+            // Round up, so a short remainder does not become a busy loop.
+            wait_ms = (u32)(remaining * 1000.0) + 1;
+        }
+        kfutex_wait(&event->state, KFUTEX_EVENT_WAITING, wait_ms);
+    }
+}
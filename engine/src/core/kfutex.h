@@ -0,0 +1,78 @@
+/**
+ * @file kfutex.h
+ * @brief Contains waiting on the value of a 32-bit word, the primitive
+ * behind lightweight locks and events, and an event built on it. The wait
+ * and wake are implemented per platform in the platform layer.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief Passed as a timeout to wait with no time limit. */
+#define KFUTEX_WAIT_FOREVER INVALID_ID
+
+/**
+ * @brief Blocks while *address holds expected, until woken by kfutex_wake or
+ * the timeout passes. The check and the sleep are one atomic step, so a wake
+ * that follows a change of *address is never missed. May return spuriously.
+ *
+ * @param address The word to wait on. Must be 4-byte aligned.
+ * @param expected The value to sleep while *address holds.
+ * @param timeout_ms The longest time to wait, or KFUTEX_WAIT_FOREVER.
+ * @return False if the timeout passed; otherwise True.
+ */
+KAPI b8 kfutex_wait(u32 *address, u32 expected, u32 timeout_ms);
+
+/**
+ * @brief Wakes up to count threads waiting on address.
+ *
+ * @param address The word waited on.
+ * @param count The most threads to wake, or INVALID_ID for all of them.
+ */
+KAPI void kfutex_wake(u32 *address, u32 count);
+
+/**
+ * @brief A manual-reset event the size of a u32, needing no creation or
+ * destruction: zero it to start unset. Setting or resetting it costs one
+ * atomic operation, plus a system call only when threads are waiting.
+ */
+typedef struct kfutex_event {
+    /** @brief Unset, set, or unset with threads waiting. */
+    u32 state;
+} kfutex_event;
+
+/**
+ * @brief Sets the event, waking every thread waiting on it. It stays set
+ * until reset.
+ *
+ * @param event A pointer to the event.
+ */
+KAPI void kfutex_event_set(kfutex_event *event);
+
+/**
+ * @brief Unsets the event, so later waits block.
+ *
+ * @param event A pointer to the event.
+ */
+KAPI void kfutex_event_reset(kfutex_event *event);
+
+/**
+ * @brief Checks whether the event is set, without waiting.
+ *
+ * @param event A pointer to the event.
+ * @return True if set; otherwise False.
+ */
+KAPI b8 kfutex_event_is_set(kfutex_event *event);
+
+/**
+ * @brief Blocks until the event is set or the timeout passes. Writes made
+ * before kfutex_event_set are visible once this returns True.
+ *
+ * @param event A pointer to the event.
+ * @param timeout_ms The longest time to wait, or KFUTEX_WAIT_FOREVER.
+ * @return True if the event was set; False if the timeout passed.
+ */
+KAPI b8 kfutex_event_wait(kfutex_event *event, u32 timeout_ms);
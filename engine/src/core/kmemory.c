@@ -1,16 +1,57 @@
 #include "kmemory.h"
 
+#include "core/asserts.h"
+#include "core/event.h"
+#include "core/katomic.h"
+#include "core/kmutex.h"
 #include "core/kstring.h"
 #include "core/logger.h"
+#include "memory/allocation_tracker.h"
 #include "memory/dynamic_allocator.h"
+#include "memory/handle_allocator.h"
+#include "memory/slab_allocator.h"
 #include "platform/platform.h"
 
 #include <stdio.h>
 
-struct memory_stats {
+// The call-site macros from kmemory.h would rename the definitions below.
+#undef kallocate
+#undef kallocate_uninit
+#undef kallocate_aligned
+#undef kreallocate
+
+// Stats are sharded so threads mostly update their own cache lines. Shards are
+// only ever added to (frees may subtract on another shard, wrapping), and the
+// totals are the sum over all shards.
+#define MEMORY_STATS_SHARD_COUNT 16
+
+typedef struct memory_stats_shard {
     u64 total_allocated;
+    u64 alloc_count;
+    // Bytes cleared by kallocate and kzero_memory.
+    u64 bytes_zeroed;
     u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
-};
+    u8 padding[64 - ((3 + MEMORY_TAG_MAX_TAGS) * sizeof(u64)) % 64];
+} memory_stats_shard;
+
+// Blocks each thread keeps per slab size class before touching the lock.
+#define MEMORY_MAGAZINE_SIZE 32
+// Blocks moved between a magazine and the slab allocator per lock.
+#define MEMORY_MAGAZINE_BATCH (MEMORY_MAGAZINE_SIZE / 2)
+
+typedef struct memory_thread_cache {
+    // Matches the memory system generation the cache was filled from.
+    u64 generation;
+    u32 shard;
+    u32 counts[SLAB_ALLOCATOR_CLASS_COUNT];
+    void *blocks[SLAB_ALLOCATOR_CLASS_COUNT][MEMORY_MAGAZINE_SIZE];
+} memory_thread_cache;
+
+#define MEMORY_ATOMIC_ADD(ptr, value)                                          \
+    katomic_fetch_add(ptr, value, KATOMIC_RELAXED)
+#define MEMORY_ATOMIC_SUB(ptr, value)                                          \
+    katomic_fetch_sub(ptr, value, KATOMIC_RELAXED)
+#define MEMORY_ATOMIC_LOAD(ptr) katomic_load(ptr, KATOMIC_RELAXED)
 
 static const char *memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "UNKNOWN          ", "ARRAY            ", "LINEAR ALLOCATOR ",
@@ -23,38 +64,196 @@ static const char *memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
 typedef struct memory_system_state {
     memory_system_configuration config;
     b8 initialized;
-    struct memory_stats stats;
-    u64 alloc_count;
+    memory_stats_shard stats[MEMORY_STATS_SHARD_COUNT];
     u64 allocator_memory_requirement;
     dynamic_allocator allocator;
-    void *allocator_block;
+    // Reserved address space holding the dynamic allocator. Only the first
+    // arena_committed bytes are backed.
+    void *arena;
+    u64 arena_reserved;
+    u64 arena_committed;
+    // Bytes of the allocator's memory requirement that are not pool.
+    u64 arena_overhead;
+    u64 pool_size;
+    // Small blocks are served from size-class slabs carved out of allocator.
+    u64 slab_allocator_memory_requirement;
+    slab_allocator slab_allocator;
+    void *slab_allocator_block;
+    // Relocatable blocks, also carved out of allocator.
+    u64 handle_allocator_memory_requirement;
+    handle_allocator handle_allocator;
+    void *handle_allocator_block;
+    // Guards allocator and slab_allocator. Small blocks mostly come from the
+    // per-thread magazines without taking it.
+    kmutex lock;
+    u64 generation;
+    u32 next_shard;
+    // Frees rejected by the header check or, with KMEMORY_VERIFY_FREES, freed
+    // with a size, alignment or tag that differs from the allocation.
+    u64 free_mismatch_count;
+    // Bytes zeroed total at the end of the previous frame, and during it.
+    u64 frame_zeroed_baseline;
+    u64 frame_zeroed_bytes;
+    // Canaries found overwritten when their block was freed.
+    u64 overrun_count;
+    // Small blocks taken by thread caches and not yet given back to the slab,
+    // in use or cached. Changed under lock.
+    u64 cached_blocks;
+    // Copied from config so they can be changed at runtime. Pressure is set
+    // while a tag is over its soft limit, so the event fires once per crossing.
+    // Allocating threads only latch it; the event goes out at the end of the
+    // frame, from the main thread.
+    memory_tag_budget budgets[MEMORY_TAG_MAX_TAGS];
+    u8 pressure[MEMORY_TAG_MAX_TAGS];
+#if KMEMORY_TRACK_ALLOCATIONS
+    // Call-site stats. Has its own lock since small blocks skip the main one.
+    allocation_tracker tracker;
+    void *tracker_block;
+    kmutex tracker_lock;
+#endif
 } memory_system_state;
 
 static memory_system_state *state_ptr;
+static u64 memory_generation = 0;
+static KTHREAD_LOCAL memory_thread_cache thread_cache;
+
+// The dynamic allocator lives in reserved address space, committed in these
+// units as it grows.
+#define MEMORY_COMMIT_GRANULARITY PLATFORM_HUGE_PAGE_SIZE
+// How much of the pool is committed at startup when the strategy can grow.
+#define MEMORY_INITIAL_COMMIT_SIZE (4 * MEMORY_COMMIT_GRANULARITY)
+
+// Handles the memory system can have live at once.
+#define MEMORY_MAX_HANDLE_COUNT 65536
+// Distinct call sites the allocation tracker can tell apart.
+#define MEMORY_TRACKER_MAX_SITES 4096
+
+static u64 memory_round_up(u64 value, u64 granularity) {
+    return ((value + granularity - 1) / granularity) * granularity;
+}
 
 b8 memory_system_initialize(memory_system_configuration config) {
     u64 alloc_memory_requirement = 0;
-    dynamic_allocator_create(config.total_alloc_count,
-                             &alloc_memory_requirement, 0, 0);
-    u64 total_memory_size =
-        sizeof(memory_system_state) + alloc_memory_requirement;
+    if (!dynamic_allocator_create_with_strategy(
+            config.allocator_strategy, config.total_alloc_count,
+            &alloc_memory_requirement, 0, 0)) {
+        KFATAL("Memory system allocator strategy is invalid. Cannot continue.");
+        return false;
+    }
+    u64 slab_memory_requirement = 0;
+    slab_allocator_create(0, &slab_memory_requirement, 0, 0);
+    u64 handle_memory_requirement = 0;
+    handle_allocator_create(0, MEMORY_MAX_HANDLE_COUNT,
+                            &handle_memory_requirement, 0, 0);
+    u64 tracker_memory_requirement = 0;
+#if KMEMORY_TRACK_ALLOCATIONS
+    allocation_tracker_create(MEMORY_TRACKER_MAX_SITES,
+                              &tracker_memory_requirement, 0, 0);
+#endif
+    u64 state_memory_size = sizeof(memory_system_state) +
+                            slab_memory_requirement +
+                            handle_memory_requirement +
+                            tracker_memory_requirement;
 
-    void *memory_block = platform_allocate(total_memory_size, false);
+    void *memory_block = platform_allocate(state_memory_size, false);
     if (!memory_block) {
         KFATAL("Couldn't allocate memory for Memory System. Cannot continue.");
         return false;
     }
 
     state_ptr = (memory_system_state *)memory_block;
-    state_ptr->allocator_memory_requirement = alloc_memory_requirement;
-
-    state_ptr->allocator_block =
+    platform_zero_memory(state_ptr, sizeof(memory_system_state));
+    state_ptr->config = config;
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; i++) {
+        state_ptr->budgets[i] = config.budgets[i];
+    }
+#if !KMEMORY_GUARD_ALLOCATIONS
+    if (config.guard_allocations) {
+        KWARN("Memory guard allocations requested, but not built in. Ignored.");
+        state_ptr->config.guard_allocations = false;
+    }
+#endif
+    state_ptr->slab_allocator_memory_requirement = slab_memory_requirement;
+    state_ptr->slab_allocator_block =
         (void *)((u64)state_ptr + sizeof(memory_system_state));
-    dynamic_allocator_create(config.total_alloc_count,
-                             &state_ptr->allocator_memory_requirement,
-                             state_ptr->allocator_block, &state_ptr->allocator);
+    state_ptr->handle_allocator_memory_requirement = handle_memory_requirement;
+    state_ptr->handle_allocator_block =
+        state_ptr->slab_allocator_block + slab_memory_requirement;
+#if KMEMORY_TRACK_ALLOCATIONS
+    state_ptr->tracker_block =
+        state_ptr->handle_allocator_block + handle_memory_requirement;
+    allocation_tracker_create(MEMORY_TRACKER_MAX_SITES,
+                              &tracker_memory_requirement,
+                              state_ptr->tracker_block, &state_ptr->tracker);
+    kmutex_create(&state_ptr->tracker_lock);
+#endif
+
+    // Reserve address space for the whole pool, but only commit what the
+    // allocator needs now. TLSF can grow in place; the freelist cannot, so it
+    // is committed in full.
+    state_ptr->arena_reserved =
+        memory_round_up(alloc_memory_requirement, MEMORY_COMMIT_GRANULARITY);
+    state_ptr->arena = platform_memory_reserve(state_ptr->arena_reserved);
+    if (!state_ptr->arena) {
+        KFATAL("Couldn't reserve memory for Memory System. Cannot continue.");
+        platform_free(state_ptr, false);
+        state_ptr = 0;
+        return false;
+    }
 
-    state_ptr->alloc_count = 0;
+    u64 pool_size = config.total_alloc_count;
+    if (config.allocator_strategy == DYNAMIC_ALLOCATOR_STRATEGY_TLSF &&
+        pool_size > MEMORY_INITIAL_COMMIT_SIZE) {
+        pool_size = MEMORY_INITIAL_COMMIT_SIZE;
+    }
+    u64 pool_requirement = 0;
+    dynamic_allocator_create_with_strategy(config.allocator_strategy,
+                                           pool_size, &pool_requirement, 0, 0);
+    state_ptr->arena_overhead = pool_requirement - pool_size;
+    state_ptr->arena_committed =
+        memory_round_up(pool_requirement, MEMORY_COMMIT_GRANULARITY);
+    if (state_ptr->arena_committed > state_ptr->arena_reserved) {
+        state_ptr->arena_committed = state_ptr->arena_reserved;
+    }
+    if (!platform_memory_commit(state_ptr->arena, state_ptr->arena_committed,
+                                true)) {
+        KFATAL("Couldn't commit memory for Memory System. Cannot continue.");
+        platform_memory_release(state_ptr->arena, state_ptr->arena_reserved);
+        platform_free(state_ptr, false);
+        state_ptr = 0;
+        return false;
+    }
+
+    // Use everything the rounding committed.
+    pool_size = state_ptr->arena_committed - state_ptr->arena_overhead;
+    if (pool_size > config.total_alloc_count) {
+        pool_size = config.total_alloc_count;
+    }
+    state_ptr->pool_size = pool_size;
+
+    dynamic_allocator_create_with_strategy(
+        config.allocator_strategy, pool_size,
+        &state_ptr->allocator_memory_requirement, state_ptr->arena,
+        &state_ptr->allocator);
+    slab_allocator_create(&state_ptr->allocator,
+                          &state_ptr->slab_allocator_memory_requirement,
+                          state_ptr->slab_allocator_block,
+                          &state_ptr->slab_allocator);
+    handle_allocator_create(&state_ptr->allocator, MEMORY_MAX_HANDLE_COUNT,
+                            &state_ptr->handle_allocator_memory_requirement,
+                            state_ptr->handle_allocator_block,
+                            &state_ptr->handle_allocator);
+
+    if (!kmutex_create(&state_ptr->lock)) {
+        KFATAL("Couldn't create the Memory System lock. Cannot continue.");
+        platform_memory_release(state_ptr->arena, state_ptr->arena_reserved);
+        platform_free(state_ptr, false);
+        state_ptr = 0;
+        return false;
+    }
+
+    // Invalidates magazines left over from a previous initialization.
+    state_ptr->generation = ++memory_generation;
     state_ptr->initialized = true;
 
     return true;
@@ -66,37 +265,588 @@ void memory_system_shutdown() {
         return;
     }
 
+#if KMEMORY_TRACK_ALLOCATIONS
+    allocation_tracker_destroy(&state_ptr->tracker);
+    kmutex_destroy(&state_ptr->tracker_lock);
+#endif
+    handle_allocator_destroy(&state_ptr->handle_allocator);
+    slab_allocator_destroy(&state_ptr->slab_allocator);
     dynamic_allocator_destroy(&state_ptr->allocator);
-    u64 total_memory_size =
-        sizeof(memory_system_state) + state_ptr->allocator_memory_requirement;
-    platform_free(state_ptr, total_memory_size);
+    kmutex_destroy(&state_ptr->lock);
+    platform_memory_release(state_ptr->arena, state_ptr->arena_reserved);
+    platform_free(state_ptr, false);
     state_ptr = 0;
 }
 
+// Commits more of the arena and grows the pool by at least size bytes. Must
+// be called with the lock held.
+static b8 memory_grow(u64 size) {
+    u64 max_size = state_ptr->config.total_alloc_count;
+    if (state_ptr->config.allocator_strategy !=
+            DYNAMIC_ALLOCATOR_STRATEGY_TLSF ||
+        state_ptr->pool_size >= max_size) {
+        return false;
+    }
+
+    // Leave room for block headers, and never grow by less than a commit.
+    u64 target = state_ptr->pool_size + size + 256;
+    u64 committed = memory_round_up(target + state_ptr->arena_overhead,
+                                    MEMORY_COMMIT_GRANULARITY);
+    if (committed > state_ptr->arena_reserved) {
+        committed = state_ptr->arena_reserved;
+    }
+    u64 new_pool_size = committed - state_ptr->arena_overhead;
+    if (new_pool_size > max_size) {
+        new_pool_size = max_size;
+    }
+    if (new_pool_size <= state_ptr->pool_size) {
+        return false;
+    }
+
+    if (!platform_memory_commit(state_ptr->arena + state_ptr->arena_committed,
+                                committed - state_ptr->arena_committed, true)) {
+        return false;
+    }
+    state_ptr->arena_committed = committed;
+
+    if (!dynamic_allocator_grow(&state_ptr->allocator, new_pool_size)) {
+        return false;
+    }
+    state_ptr->pool_size = new_pool_size;
+    return true;
+}
+
+// Makes sure the pool has at least size bytes free before allocating from it,
+// so growth does not depend on a failed allocation. Lock must be held.
+static void memory_reserve_space(u64 size) {
+    // Only TLSF can grow, and only it tracks free space in O(1).
+    if (state_ptr->config.allocator_strategy ==
+            DYNAMIC_ALLOCATOR_STRATEGY_TLSF &&
+        dynamic_allocator_free_space(&state_ptr->allocator) < size + 256) {
+        memory_grow(size);
+    }
+}
+
+// Sits directly before every block handed out by kallocate and
+// kallocate_aligned, so frees do not need the size.
+typedef struct memory_header {
+    u64 size;
+    // Bytes from the underlying allocation to the block.
+    u16 offset;
+    // Requested alignment, or 0 for kallocate.
+    u16 alignment;
+    u16 tag;
+    u16 magic;
+#if KMEMORY_TRACK_ALLOCATIONS
+    // Tracker site the block was allocated from. Padded to keep blocks 16
+    // byte aligned.
+    u32 site;
+    u32 reserved;
+    u64 padding;
+#endif
+} memory_header;
+
+#if KMEMORY_TRACK_ALLOCATIONS
+STATIC_ASSERT(sizeof(memory_header) == 32,
+              "memory_header expected to be 32 bytes.");
+#else
+STATIC_ASSERT(sizeof(memory_header) == 16,
+              "memory_header expected to be 16 bytes.");
+#endif
+
+#define MEMORY_HEADER_MAGIC 0xA10C
+#define MEMORY_HEADER_FREED 0xF4EE
+
+static u64 memory_effective_alignment(u16 alignment) {
+    // The header itself needs 8 byte alignment.
+    return alignment < 8 ? 8 : alignment;
+}
+
+static u64 memory_underlying_size(u64 size, u16 alignment) {
+    if (!alignment) {
+        return size + sizeof(memory_header);
+    }
+    return size + memory_effective_alignment(alignment) - 1 +
+           sizeof(memory_header);
+}
+
+static memory_thread_cache *memory_thread_cache_get() {
+    memory_thread_cache *cache = &thread_cache;
+    if (cache->generation != state_ptr->generation) {
+        // Anything cached belonged to a previous memory system; drop it.
+        platform_zero_memory(cache->counts, sizeof(cache->counts));
+        cache->generation = state_ptr->generation;
+        cache->shard = MEMORY_ATOMIC_ADD(&state_ptr->next_shard, 1) %
+                       MEMORY_STATS_SHARD_COUNT;
+    }
+    return cache;
+}
+
+static void *memory_cache_allocate(memory_thread_cache *cache, u64 size) {
+    u32 index = slab_allocator_class_index(size);
+    if (!cache->counts[index]) {
+        u64 class_size = slab_allocator_class_size(index);
+        kmutex_lock(&state_ptr->lock);
+        memory_reserve_space(SLAB_ALLOCATOR_PAGE_SIZE);
+        for (u32 i = 0; i < MEMORY_MAGAZINE_BATCH; i++) {
+            void *block =
+                slab_allocator_allocate(&state_ptr->slab_allocator, class_size);
+            if (!block) {
+                break;
+            }
+            cache->blocks[index][cache->counts[index]++] = block;
+        }
+        state_ptr->cached_blocks += cache->counts[index];
+        kmutex_unlock(&state_ptr->lock);
+
+        if (!cache->counts[index]) {
+            return 0;
+        }
+    }
+    return cache->blocks[index][--cache->counts[index]];
+}
+
+static void memory_cache_free(memory_thread_cache *cache, void *block,
+                              u64 size) {
+    u32 index = slab_allocator_class_index(size);
+    if (cache->counts[index] == MEMORY_MAGAZINE_SIZE) {
+        u64 class_size = slab_allocator_class_size(index);
+        kmutex_lock(&state_ptr->lock);
+        for (u32 i = 0; i < MEMORY_MAGAZINE_BATCH; i++) {
+            slab_allocator_free(&state_ptr->slab_allocator,
+                                cache->blocks[index][--cache->counts[index]],
+                                class_size);
+        }
+        state_ptr->cached_blocks -= MEMORY_MAGAZINE_BATCH;
+        kmutex_unlock(&state_ptr->lock);
+    }
+    cache->blocks[index][cache->counts[index]++] = block;
+}
+
+#if KMEMORY_GUARD_ALLOCATIONS
+// Blocks on their own pages, between two inaccessible guard pages.
+#define MEMORY_HEADER_GUARDED 0xA10D
+// Blocks followed by a canary that is checked when they are freed.
+#define MEMORY_HEADER_CANARY 0xA10E
+#define MEMORY_CANARY_SIZE 16
+#define MEMORY_CANARY_BYTE 0xFD
+// Blocks needing more than this get guard pages; smaller ones a canary.
+#define MEMORY_GUARD_PAGE_MIN_SIZE SLAB_ALLOCATOR_MAX_SIZE
+
+// Guard-mode blocks, guarded or canaried, are placed at least 16 byte aligned
+// whatever was asked for. The normal path makes no such promise: the freelist
+// strategy hands out blocks at any offset.
+static u16 memory_guard_alignment(u16 alignment) {
+    return alignment > 16 ? alignment : 16;
+}
+
+static u64 memory_guard_data_size(u64 size, u16 alignment) {
+    return memory_round_up(
+        memory_underlying_size(size, memory_guard_alignment(alignment)),
+        platform_memory_page_size());
+}
+
+// Places the block so it ends as close to the trailing guard page as its
+// alignment allows. The bytes between are filled with the canary.
+static u64 memory_guard_allocate(u64 size, u16 alignment) {
+    u64 page = platform_memory_page_size();
+    u64 data_size = memory_guard_data_size(size, alignment);
+    void *base = platform_memory_reserve(data_size + page * 2);
+    if (!base) {
+        return 0;
+    }
+    if (!platform_memory_commit(base + page, data_size, false)) {
+        platform_memory_release(base, data_size + page * 2);
+        return 0;
+    }
+
+    u64 end = (u64)base + page + data_size;
+    u64 block = (end - size) & ~((u64)memory_guard_alignment(alignment) - 1);
+    platform_set_memory((void *)(block + size), MEMORY_CANARY_BYTE,
+                        end - (block + size));
+    return block;
+}
+
+static void memory_guard_free(void *block, u64 size, u16 alignment) {
+    u64 page = platform_memory_page_size();
+    u64 data_size = memory_guard_data_size(size, alignment);
+    // The block ends within a page of the trailing guard page.
+    u64 end = memory_round_up((u64)block + size, page);
+    platform_memory_release((void *)(end - data_size - page),
+                            data_size + page * 2);
+}
+
+// Bytes after the block that hold the canary.
+static u64 memory_canary_size(void *block, memory_header *header) {
+    if (header->magic == MEMORY_HEADER_CANARY) {
+        return MEMORY_CANARY_SIZE;
+    }
+    if (header->magic == MEMORY_HEADER_GUARDED) {
+        u64 page = platform_memory_page_size();
+        u64 end = (u64)block + header->size;
+        return memory_round_up(end, page) - end;
+    }
+    return 0;
+}
+
+static void memory_check_canary(void *block, memory_header *header) {
+    u64 canary_size = memory_canary_size(block, header);
+    u8 *canary = block + header->size;
+    for (u64 i = 0; i < canary_size; i++) {
+        if (canary[i] != MEMORY_CANARY_BYTE) {
+            KERROR("Memory overrun - block %p (size %llu, tag %u) was written "
+                   "%llu bytes past its end.",
+                   block, header->size, header->tag, i + 1);
+            if (state_ptr) {
+                MEMORY_ATOMIC_ADD(&state_ptr->overrun_count, 1);
+            }
+            return;
+        }
+    }
+}
+#endif
+
+// The alignment a block is placed at, which guard mode may raise above what
+// was asked for. Derived from the header on free, so it must not change
+// between allocating and freeing a block.
+static u16 memory_placement_alignment(u16 magic, u16 alignment) {
+#if KMEMORY_GUARD_ALLOCATIONS
+    if (magic == MEMORY_HEADER_GUARDED || magic == MEMORY_HEADER_CANARY) {
+        return memory_guard_alignment(alignment);
+    }
+#endif
+    return alignment;
+}
+
+static u64 memory_tag_usage(memory_tag tag) {
+    u64 tagged = 0;
+    for (u32 i = 0; i < MEMORY_STATS_SHARD_COUNT; i++) {
+        tagged +=
+            MEMORY_ATOMIC_LOAD(&state_ptr->stats[i].tagged_allocations[tag]);
+    }
+    return tagged;
+}
+
+static void memory_usage_format(char *buffer, u64 buffer_size);
+
+// Stops the program if size more under tag would cross its hard limit. Callers
+// don't check kallocate for null, so refusing the block would only move the
+// crash somewhere less obvious. Checked against the current total, so threads
+// allocating at the same time can overshoot by what they have in flight.
+static void memory_budget_enforce(memory_tag tag, u64 size) {
+    u64 hard_limit = state_ptr->budgets[tag].hard_limit;
+    if (!hard_limit) {
+        return;
+    }
+    u64 usage = memory_tag_usage(tag);
+    if (usage + size <= hard_limit) {
+        return;
+    }
+
+    char report[8000];
+    memory_usage_format(report, sizeof(report));
+    KFATAL("Memory budget - allocating %lluB under tag %s would reach %lluB, "
+           "over its hard limit of %lluB.\n%s",
+           size, memory_tag_strings[tag], usage + size, hard_limit, report);
+    KASSERT_MSG(false, "Memory budget hard limit exceeded.");
+}
+
+// Pressure states. Latched by whichever thread crossed the soft limit, then
+// dispatched by memory_system_end_frame.
+#define MEMORY_PRESSURE_NONE 0
+#define MEMORY_PRESSURE_LATCHED 1
+#define MEMORY_PRESSURE_DISPATCHED 2
+
+// Runs inside the allocator on any thread, so it must not call out: listeners
+// free memory and touch systems that are not thread safe.
+static void memory_budget_check_pressure(memory_tag tag) {
+    u64 soft_limit = state_ptr->budgets[tag].soft_limit;
+    if (!soft_limit || MEMORY_ATOMIC_LOAD(&state_ptr->pressure[tag])) {
+        return;
+    }
+    if (memory_tag_usage(tag) <= soft_limit) {
+        return;
+    }
+    u8 expected = MEMORY_PRESSURE_NONE;
+    katomic_compare_exchange_strong(&state_ptr->pressure[tag], &expected,
+                                    MEMORY_PRESSURE_LATCHED, KATOMIC_RELAXED,
+                                    KATOMIC_RELAXED);
+}
+
+// Fires EVENT_CODE_MEMORY_PRESSURE for each tag latched since the last call.
+static void memory_budget_dispatch_pressure() {
+    for (u32 tag = 0; tag < MEMORY_TAG_MAX_TAGS; tag++) {
+        u8 expected = MEMORY_PRESSURE_LATCHED;
+        if (!katomic_compare_exchange_strong(
+                &state_ptr->pressure[tag], &expected,
+                MEMORY_PRESSURE_DISPATCHED, KATOMIC_RELAXED,
+                KATOMIC_RELAXED)) {
+            continue;
+        }
+
+        u64 usage = memory_tag_usage(tag);
+        KWARN("Memory budget - tag %s is at %lluB, over its soft limit of "
+              "%lluB.",
+              memory_tag_strings[tag], usage,
+              state_ptr->budgets[tag].soft_limit);
+        event_context context;
+        context.data.u32[0] = tag;
+        context.data.u64[1] = usage;
+        event_fire(EVENT_CODE_MEMORY_PRESSURE, 0, context);
+    }
+}
+
+static void memory_budget_release_pressure(memory_tag tag) {
+    if (!MEMORY_ATOMIC_LOAD(&state_ptr->pressure[tag])) {
+        return;
+    }
+    u64 soft_limit = state_ptr->budgets[tag].soft_limit;
+    if (!soft_limit || memory_tag_usage(tag) <= soft_limit) {
+        katomic_store(&state_ptr->pressure[tag], MEMORY_PRESSURE_NONE,
+                      KATOMIC_RELAXED);
+    }
+}
+
+static void *memory_allocate(u64 size, u16 alignment, memory_tag tag,
+                             b8 zero, const char *file, u32 line) {
+    u16 magic = MEMORY_HEADER_MAGIC;
+    u64 request_size = size;
+#if KMEMORY_GUARD_ALLOCATIONS
+    if (state_ptr && state_ptr->config.guard_allocations) {
+        // Alignments past a page can't end against the guard page.
+        if (memory_underlying_size(size, alignment) >
+                MEMORY_GUARD_PAGE_MIN_SIZE &&
+            alignment <= platform_memory_page_size()) {
+            magic = MEMORY_HEADER_GUARDED;
+        } else {
+            magic = MEMORY_HEADER_CANARY;
+            request_size += MEMORY_CANARY_SIZE;
+        }
+    }
+#endif
+    u16 placement = memory_placement_alignment(magic, alignment);
+    u64 total_size = memory_underlying_size(request_size, placement);
+
+    u64 block = 0;
+    u64 offset = 0;
+    memory_thread_cache *cache = state_ptr ? memory_thread_cache_get() : 0;
+#if KMEMORY_GUARD_ALLOCATIONS
+    if (magic == MEMORY_HEADER_GUARDED) {
+        block = memory_guard_allocate(size, alignment);
+        if (!block) {
+            return 0;
+        }
+    }
+#endif
+
+    if (!block) {
+        void *raw;
+        if (!cache) {
+            raw = platform_allocate(total_size, false);
+        } else if (total_size <= SLAB_ALLOCATOR_MAX_SIZE) {
+            raw = memory_cache_allocate(cache, total_size);
+        } else {
+            kmutex_lock(&state_ptr->lock);
+            memory_reserve_space(total_size);
+            raw = dynamic_allocator_allocate(&state_ptr->allocator, total_size);
+            if (!raw && memory_grow(total_size)) {
+                // Free space was too fragmented; try again in the new space.
+                raw = dynamic_allocator_allocate(&state_ptr->allocator,
+                                                 total_size);
+            }
+            kmutex_unlock(&state_ptr->lock);
+        }
+
+        if (!raw) {
+            return 0;
+        }
+
+        block = (u64)raw + sizeof(memory_header);
+        if (placement) {
+            u64 effective = memory_effective_alignment(placement);
+            block = (block + effective - 1) & ~(effective - 1);
+        }
+        offset = block - (u64)raw;
+    }
+
+    memory_header *header = (memory_header *)(block - sizeof(memory_header));
+    header->size = size;
+    header->offset = (u16)offset;
+    header->alignment = alignment;
+    header->tag = (u16)tag;
+    header->magic = magic;
+
+#if KMEMORY_GUARD_ALLOCATIONS
+    if (magic == MEMORY_HEADER_CANARY) {
+        platform_set_memory((void *)(block + size), MEMORY_CANARY_BYTE,
+                            MEMORY_CANARY_SIZE);
+    }
+#endif
+
+#if KMEMORY_TRACK_ALLOCATIONS
+    header->site = ALLOCATION_TRACKER_OVERFLOW_SITE;
+    if (cache) {
+        kmutex_lock(&state_ptr->tracker_lock);
+        header->site = allocation_tracker_record_allocation(
+            &state_ptr->tracker, file, line, size);
+        kmutex_unlock(&state_ptr->tracker_lock);
+    }
+#endif
+
+    if (cache) {
+        memory_stats_shard *stats = &state_ptr->stats[cache->shard];
+        MEMORY_ATOMIC_ADD(&stats->total_allocated, size);
+        MEMORY_ATOMIC_ADD(&stats->tagged_allocations[tag], size);
+        MEMORY_ATOMIC_ADD(&stats->alloc_count, 1);
+        if (zero) {
+            MEMORY_ATOMIC_ADD(&stats->bytes_zeroed, size);
+        }
+        memory_budget_check_pressure(tag);
+    }
+
+    if (zero) {
+        platform_zero_memory((void *)block, size);
+    }
+    return (void *)block;
+}
+
+static b8 memory_header_valid(memory_header *header) {
+#if KMEMORY_GUARD_ALLOCATIONS
+    return header->magic == MEMORY_HEADER_MAGIC ||
+           header->magic == MEMORY_HEADER_GUARDED ||
+           header->magic == MEMORY_HEADER_CANARY;
+#else
+    return header->magic == MEMORY_HEADER_MAGIC;
+#endif
+}
+
+static memory_header *memory_get_header(void *block, const char *caller) {
+    memory_header *header = (memory_header *)(block - sizeof(memory_header));
+    if (!memory_header_valid(header)) {
+        if (header->magic == MEMORY_HEADER_FREED) {
+            KERROR("%s - block %p has already been freed.", caller, block);
+        } else {
+            KERROR("%s - block %p was not allocated by the memory system.",
+                   caller, block);
+        }
+        if (state_ptr) {
+            MEMORY_ATOMIC_ADD(&state_ptr->free_mismatch_count, 1);
+        }
+        return 0;
+    }
+    return header;
+}
+
+static void memory_release(void *block, memory_header *header) {
+    void *raw = block - header->offset;
+    u64 request_size = header->size;
+    b8 guarded = false;
+#if KMEMORY_GUARD_ALLOCATIONS
+    memory_check_canary(block, header);
+    guarded = header->magic == MEMORY_HEADER_GUARDED;
+    if (header->magic == MEMORY_HEADER_CANARY) {
+        request_size += MEMORY_CANARY_SIZE;
+    }
+#endif
+    u64 total_size = memory_underlying_size(
+        request_size, memory_placement_alignment(header->magic,
+                                                 header->alignment));
+    header->magic = MEMORY_HEADER_FREED;
+
+    if (!guarded &&
+        (!state_ptr ||
+         !dynamic_allocator_owns_block(&state_ptr->allocator, raw))) {
+        // The piece of memory could have been created before initialisation
+        platform_free(raw, false);
+        return;
+    }
+
+    memory_thread_cache *cache = memory_thread_cache_get();
+    memory_stats_shard *stats = &state_ptr->stats[cache->shard];
+    MEMORY_ATOMIC_SUB(&stats->total_allocated, header->size);
+    MEMORY_ATOMIC_SUB(&stats->tagged_allocations[header->tag], header->size);
+    memory_budget_release_pressure(header->tag);
+
+#if KMEMORY_TRACK_ALLOCATIONS
+    kmutex_lock(&state_ptr->tracker_lock);
+    allocation_tracker_record_free(&state_ptr->tracker, header->site,
+                                   header->size);
+    kmutex_unlock(&state_ptr->tracker_lock);
+#endif
+
+#if KMEMORY_GUARD_ALLOCATIONS
+    if (guarded) {
+        memory_guard_free(block, header->size, header->alignment);
+        return;
+    }
+#endif
+
+    if (total_size <= SLAB_ALLOCATOR_MAX_SIZE) {
+        memory_cache_free(cache, raw, total_size);
+    } else {
+        kmutex_lock(&state_ptr->lock);
+        dynamic_allocator_free(&state_ptr->allocator, raw, total_size);
+        kmutex_unlock(&state_ptr->lock);
+    }
+}
+
+#if KMEMORY_VERIFY_FREES
+static void memory_verify(const char *caller, void *block,
+                          memory_header *header, u64 size, u16 alignment,
+                          memory_tag tag) {
+    if (header->size == size && header->alignment == alignment &&
+        header->tag == tag) {
+        return;
+    }
+
+    KERROR("%s - block %p was allocated with size %llu, alignment %u, tag %u "
+           "but freed with size %llu, alignment %u, tag %u.",
+           caller, block, header->size, header->alignment, header->tag, size,
+           alignment, tag);
+    if (state_ptr) {
+        MEMORY_ATOMIC_ADD(&state_ptr->free_mismatch_count, 1);
+    }
+}
+#endif
+
 KAPI void *kallocate(u64 size, memory_tag tag) {
+    return kallocate_at(size, tag, 0, 0);
+}
+
+KAPI void *kallocate_at(u64 size, memory_tag tag, const char *file,
+                        u32 line) {
     if (tag == MEMORY_TAG_UNKNOWN) {
         KWARN("kallocate called using MEMORY_TAG_UNKNOWN. Please re-class this "
               "allocation.");
     }
 
-    // TODO: Memory alignment
-    void *block;
     if (!state_ptr) {
         KWARN("kallocate called before memory system initialized.");
-        block = platform_allocate(size, false);
     } else {
-        state_ptr->stats.total_allocated += size;
-        state_ptr->stats.tagged_allocations[tag] += size;
-        state_ptr->alloc_count++;
+        memory_budget_enforce(tag, size);
+    }
 
-        block = dynamic_allocator_allocate(&state_ptr->allocator, size);
+    return memory_allocate(size, 0, tag, true, file, line);
+}
+
+KAPI void *kallocate_uninit(u64 size, memory_tag tag) {
+    return kallocate_uninit_at(size, tag, 0, 0);
+}
+
+KAPI void *kallocate_uninit_at(u64 size, memory_tag tag, const char *file,
+                               u32 line) {
+    if (tag == MEMORY_TAG_UNKNOWN) {
+        KWARN("kallocate_uninit called using MEMORY_TAG_UNKNOWN. Please "
+              "re-class this allocation.");
     }
 
-    if (block) {
-        platform_zero_memory(block, size);
+    if (!state_ptr) {
+        KWARN("kallocate_uninit called before memory system initialized.");
+    } else {
+        memory_budget_enforce(tag, size);
     }
 
-    return block;
+    return memory_allocate(size, 0, tag, false, file, line);
 }
 
 KAPI void kfree(void *block, u64 size, memory_tag tag) {
@@ -105,24 +855,183 @@ KAPI void kfree(void *block, u64 size, memory_tag tag) {
               "allocation.");
     }
 
-    // TODO: Memory alignment
+    if (!block) {
+        return;
+    }
+
+    memory_header *header = memory_get_header(block, "kfree");
+    if (!header) {
+        return;
+    }
+
+#if KMEMORY_VERIFY_FREES
+    memory_verify("kfree", block, header, size, 0, tag);
+#endif
+
+    memory_release(block, header);
+}
+
+KAPI void kfree_unsized(void *block) {
+    if (!block) {
+        return;
+    }
+
+    memory_header *header = memory_get_header(block, "kfree_unsized");
+    if (header) {
+        memory_release(block, header);
+    }
+}
+
+KAPI void *kallocate_aligned(u64 size, u16 alignment, memory_tag tag) {
+    return kallocate_aligned_at(size, alignment, tag, 0, 0);
+}
+
+KAPI void *kallocate_aligned_at(u64 size, u16 alignment, memory_tag tag,
+                                const char *file, u32 line) {
+    if (tag == MEMORY_TAG_UNKNOWN) {
+        KWARN("kallocate_aligned called using MEMORY_TAG_UNKNOWN. Please "
+              "re-class this allocation.");
+    }
+
+    if (!alignment || (alignment & (alignment - 1))) {
+        KERROR("kallocate_aligned - alignment %u is not a power of 2.",
+               alignment);
+        return 0;
+    }
+
     if (!state_ptr) {
-        KWARN("kallocate called before memory system initialized.");
-        platform_free(block, false);
+        KWARN("kallocate_aligned called before memory system initialized.");
     } else {
-        state_ptr->stats.total_allocated -= size;
-        state_ptr->stats.tagged_allocations[tag] -= size;
-
-        b8 result = dynamic_allocator_free(&state_ptr->allocator, block, size);
-        if (!result) {
-            // Handle dynamic allocator failing gracefully
-            // The piece of memory could have been created before initialisation
-            platform_free(block, false);
-        }
+        memory_budget_enforce(tag, size);
+    }
+
+    return memory_allocate(size, alignment, tag, true, file, line);
+}
+
+KAPI void kfree_aligned(void *block, u64 size, u16 alignment, memory_tag tag) {
+    if (tag == MEMORY_TAG_UNKNOWN) {
+        KWARN("kfree_aligned called using MEMORY_TAG_UNKNOWN. Please re-class "
+              "this allocation.");
+    }
+
+    if (!block) {
+        return;
+    }
+
+    memory_header *header = memory_get_header(block, "kfree_aligned");
+    if (!header) {
+        return;
+    }
+
+#if KMEMORY_VERIFY_FREES
+    memory_verify("kfree_aligned", block, header, size, alignment, tag);
+#endif
+
+    memory_release(block, header);
+}
+
+// Grows a block from the dynamic allocator without moving it.
+static b8 memory_try_extend(void *block, memory_header *header, u64 new_size,
+                            const char *file, u32 line) {
+    if (!state_ptr || header->magic != MEMORY_HEADER_MAGIC ||
+        new_size <= header->size) {
+        return false;
+    }
+
+    void *raw = block - header->offset;
+    u64 old_total = memory_underlying_size(header->size, header->alignment);
+    u64 new_total = memory_underlying_size(new_size, header->alignment);
+    // Slab blocks have a fixed size class.
+    if (old_total <= SLAB_ALLOCATOR_MAX_SIZE ||
+        !dynamic_allocator_owns_block(&state_ptr->allocator, raw)) {
+        return false;
+    }
+
+    u64 added = new_size - header->size;
+    kmutex_lock(&state_ptr->lock);
+    b8 extended = dynamic_allocator_try_extend(&state_ptr->allocator, raw,
+                                               old_total, new_total);
+    kmutex_unlock(&state_ptr->lock);
+    if (!extended) {
+        return false;
+    }
+
+#if KMEMORY_TRACK_ALLOCATIONS
+    // Counted as a free of the old block and an allocation at the caller.
+    kmutex_lock(&state_ptr->tracker_lock);
+    allocation_tracker_record_free(&state_ptr->tracker, header->site,
+                                   header->size);
+    header->site = allocation_tracker_record_allocation(&state_ptr->tracker,
+                                                        file, line, new_size);
+    kmutex_unlock(&state_ptr->tracker_lock);
+#endif
+
+    memory_stats_shard *stats =
+        &state_ptr->stats[memory_thread_cache_get()->shard];
+    MEMORY_ATOMIC_ADD(&stats->total_allocated, added);
+    MEMORY_ATOMIC_ADD(&stats->tagged_allocations[header->tag], added);
+    header->size = new_size;
+    memory_budget_check_pressure(header->tag);
+    return true;
+}
+
+KAPI void *kreallocate(void *block, u64 old_size, u64 new_size,
+                       memory_tag tag) {
+    return kreallocate_at(block, old_size, new_size, tag, 0, 0);
+}
+
+KAPI void *kreallocate_at(void *block, u64 old_size, u64 new_size,
+                          memory_tag tag, const char *file, u32 line) {
+    if (!block) {
+        return kallocate_uninit_at(new_size, tag, file, line);
     }
+
+    memory_header *header = memory_get_header(block, "kreallocate");
+    if (!header) {
+        return 0;
+    }
+
+#if KMEMORY_VERIFY_FREES
+    memory_verify("kreallocate", block, header, old_size, header->alignment,
+                  tag);
+#endif
+
+    // Only the added bytes count against the budget; a moved block is not
+    // checked again while the old one is still counted.
+    if (state_ptr && new_size > header->size) {
+        memory_budget_enforce(header->tag, new_size - header->size);
+    }
+
+    if (memory_try_extend(block, header, new_size, file, line)) {
+        return block;
+    }
+
+    void *moved =
+        memory_allocate(new_size, header->alignment, tag, false, file, line);
+    if (!moved) {
+        return 0;
+    }
+    u64 keep = header->size < new_size ? header->size : new_size;
+    platform_copy_memory(moved, block, keep);
+    memory_release(block, header);
+    return moved;
+}
+
+KAPI u64 kallocation_size(void *block) {
+    if (!block) {
+        return 0;
+    }
+
+    memory_header *header = memory_get_header(block, "kallocation_size");
+    return header ? header->size : 0;
 }
 
 KAPI void *kzero_memory(void *block, u64 size) {
+    if (state_ptr) {
+        memory_stats_shard *stats =
+            &state_ptr->stats[memory_thread_cache_get()->shard];
+        MEMORY_ATOMIC_ADD(&stats->bytes_zeroed, size);
+    }
     return platform_zero_memory(block, size);
 }
 KAPI void *kcopy_memory(void *dest, const void *source, u64 size) {
@@ -132,38 +1041,82 @@ KAPI void *kset_memory(void *dest, i32 value, u64 size) {
     return platform_set_memory(dest, value, size);
 }
 
-KAPI char *get_memory_usage_str() {
+static void memory_format_size(u64 bytes, f32 *out_amount, char *out_unit) {
     const u64 gib = 1024 * 1024 * 1024;
     const u64 mib = 1024 * 1024;
     const u64 kib = 1024;
 
-    char buffer[8000] = "System memory use (tagged):\n";
-    u64 offset = string_length(buffer);
+    out_unit[0] = 'X';
+    out_unit[1] = 'i';
+    out_unit[2] = 'B';
+    out_unit[3] = 0;
+    if (bytes >= gib) {
+        out_unit[0] = 'G';
+        *out_amount = bytes / (f32)gib;
+    } else if (bytes >= mib) {
+        out_unit[0] = 'M';
+        *out_amount = bytes / (f32)mib;
+    } else if (bytes >= kib) {
+        out_unit[0] = 'K';
+        *out_amount = bytes / (f32)kib;
+    } else {
+        out_unit[0] = 'B';
+        out_unit[1] = 0;
+        *out_amount = bytes;
+    }
+}
+
+// Writes the usage report into buffer without allocating, so it can also be
+// logged from inside the allocation path.
+static void memory_usage_format(char *buffer, u64 buffer_size) {
+    const u64 mib = 1024 * 1024;
+
+    u64 offset = snprintf(buffer, buffer_size, "System memory use (tagged):\n");
 
     for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; i++) {
-        char unit[4] = "XiB";
+        char unit[4];
         f32 amount = 1.0f;
+        memory_format_size(memory_tag_usage(i), &amount, unit);
+        offset += snprintf(buffer + offset, buffer_size - offset,
+                           "  %s: %.2f%s", memory_tag_strings[i], amount, unit);
 
-        if (state_ptr->stats.tagged_allocations[i] >= gib) {
-            unit[0] = 'G';
-            amount = state_ptr->stats.tagged_allocations[i] / (f32)gib;
-        } else if (state_ptr->stats.tagged_allocations[i] >= mib) {
-            unit[0] = 'M';
-            amount = state_ptr->stats.tagged_allocations[i] / (f32)mib;
-        } else if (state_ptr->stats.tagged_allocations[i] >= kib) {
-            unit[0] = 'K';
-            amount = state_ptr->stats.tagged_allocations[i] / (f32)kib;
-        } else {
-            unit[0] = 'B';
-            unit[1] = 0;
-            amount = state_ptr->stats.tagged_allocations[i];
+        memory_tag_budget *budget = &state_ptr->budgets[i];
+        if (budget->soft_limit || budget->hard_limit) {
+            char soft_unit[4];
+            char hard_unit[4];
+            f32 soft = 0;
+            f32 hard = 0;
+            memory_format_size(budget->soft_limit, &soft, soft_unit);
+            memory_format_size(budget->hard_limit, &hard, hard_unit);
+            offset += snprintf(buffer + offset, buffer_size - offset,
+                               " (soft %.2f%s, hard %.2f%s)", soft, soft_unit,
+                               hard, hard_unit);
         }
-
-        i32 length = snprintf(buffer + offset, 8000, "  %s: %.2f%s\n",
-                              memory_tag_strings[i], amount, unit);
-        offset += length;
+        offset += snprintf(buffer + offset, buffer_size - offset, "\n");
     }
 
+    u64 zeroed = state_ptr->frame_zeroed_bytes;
+    offset += snprintf(buffer + offset, buffer_size - offset,
+                       "Bytes zeroed last frame: %llu\n", zeroed);
+    offset += snprintf(buffer + offset, buffer_size - offset,
+                       "Committed: %.2fMiB of %.2fMiB reserved\n",
+                       state_ptr->arena_committed / (f32)mib,
+                       state_ptr->arena_reserved / (f32)mib);
+
+    kmutex_lock(&state_ptr->lock);
+    u64 free_space = dynamic_allocator_free_space(&state_ptr->allocator);
+    u64 largest = dynamic_allocator_largest_free_block(&state_ptr->allocator);
+    kmutex_unlock(&state_ptr->lock);
+    snprintf(buffer + offset, buffer_size - offset,
+             "Largest free block: %.2fMiB of %.2fMiB free (%.1f%% "
+             "contiguous)\n",
+             largest / (f32)mib, free_space / (f32)mib,
+             free_space ? largest * 100.0f / free_space : 100.0f);
+}
+
+KAPI char *get_memory_usage_str() {
+    char buffer[8000];
+    memory_usage_format(buffer, sizeof(buffer));
     char *out_string = string_duplicate(buffer);
     return out_string;
 }
@@ -172,5 +1125,233 @@ u64 get_memory_alloc_count() {
     if (!state_ptr) {
         return 0;
     }
-    return state_ptr->alloc_count;
+
+    u64 alloc_count = 0;
+    for (u32 i = 0; i < MEMORY_STATS_SHARD_COUNT; i++) {
+        alloc_count += MEMORY_ATOMIC_LOAD(&state_ptr->stats[i].alloc_count);
+    }
+    return alloc_count;
+}
+
+u64 get_memory_free_mismatch_count() {
+    if (!state_ptr) {
+        return 0;
+    }
+    return MEMORY_ATOMIC_LOAD(&state_ptr->free_mismatch_count);
+}
+
+void memory_system_flush_thread_cache() {
+    if (!state_ptr) {
+        return;
+    }
+
+    memory_thread_cache *cache = memory_thread_cache_get();
+    kmutex_lock(&state_ptr->lock);
+    for (u32 i = 0; i < SLAB_ALLOCATOR_CLASS_COUNT; i++) {
+        u64 class_size = slab_allocator_class_size(i);
+        state_ptr->cached_blocks -= cache->counts[i];
+        while (cache->counts[i]) {
+            slab_allocator_free(&state_ptr->slab_allocator,
+                                cache->blocks[i][--cache->counts[i]],
+                                class_size);
+        }
+    }
+    kmutex_unlock(&state_ptr->lock);
+}
+
+static u64 memory_bytes_zeroed_total() {
+    u64 bytes_zeroed = 0;
+    for (u32 i = 0; i < MEMORY_STATS_SHARD_COUNT; i++) {
+        bytes_zeroed += MEMORY_ATOMIC_LOAD(&state_ptr->stats[i].bytes_zeroed);
+    }
+    return bytes_zeroed;
+}
+
+void memory_system_end_frame() {
+    if (!state_ptr) {
+        return;
+    }
+
+    u64 total = memory_bytes_zeroed_total();
+    state_ptr->frame_zeroed_bytes = total - state_ptr->frame_zeroed_baseline;
+    state_ptr->frame_zeroed_baseline = total;
+
+    memory_budget_dispatch_pressure();
+
+#if KMEMORY_TRACK_ALLOCATIONS
+    kmutex_lock(&state_ptr->tracker_lock);
+    allocation_tracker_end_frame(&state_ptr->tracker);
+    kmutex_unlock(&state_ptr->tracker_lock);
+#endif
+}
+
+u64 get_memory_zeroed_bytes_last_frame() {
+    if (!state_ptr) {
+        return 0;
+    }
+    return state_ptr->frame_zeroed_bytes;
+}
+
+u64 get_memory_committed_bytes() {
+    if (!state_ptr) {
+        return 0;
+    }
+    return state_ptr->arena_committed;
+}
+
+f32 get_memory_free_contiguity() {
+    if (!state_ptr) {
+        return 1.0f;
+    }
+
+    kmutex_lock(&state_ptr->lock);
+    u64 free_space = dynamic_allocator_free_space(&state_ptr->allocator);
+    u64 largest = dynamic_allocator_largest_free_block(&state_ptr->allocator);
+    kmutex_unlock(&state_ptr->lock);
+    return free_space ? (f32)largest / free_space : 1.0f;
+}
+
+u32 kallocate_handle(u64 size, memory_tag tag) {
+    if (!state_ptr) {
+        KERROR("kallocate_handle called before memory system initialized.");
+        return INVALID_ID;
+    }
+
+    memory_budget_enforce(tag, size);
+
+    kmutex_lock(&state_ptr->lock);
+    memory_reserve_space(size + HANDLE_ALLOCATOR_ALIGNMENT * 2);
+    u32 handle = handle_allocator_allocate(&state_ptr->handle_allocator, size);
+    kmutex_unlock(&state_ptr->lock);
+
+    if (handle != INVALID_ID) {
+        memory_stats_shard *stats =
+            &state_ptr->stats[memory_thread_cache_get()->shard];
+        MEMORY_ATOMIC_ADD(&stats->total_allocated, size);
+        MEMORY_ATOMIC_ADD(&stats->tagged_allocations[tag], size);
+        MEMORY_ATOMIC_ADD(&stats->alloc_count, 1);
+        memory_budget_check_pressure(tag);
+    }
+    return handle;
+}
+
+void kfree_handle(u32 handle, memory_tag tag) {
+    if (!state_ptr) {
+        return;
+    }
+
+    kmutex_lock(&state_ptr->lock);
+    u64 size = handle_allocator_size(&state_ptr->handle_allocator, handle);
+    b8 freed = handle_allocator_free(&state_ptr->handle_allocator, handle);
+    kmutex_unlock(&state_ptr->lock);
+
+    if (!freed) {
+        MEMORY_ATOMIC_ADD(&state_ptr->free_mismatch_count, 1);
+        return;
+    }
+    memory_stats_shard *stats =
+        &state_ptr->stats[memory_thread_cache_get()->shard];
+    MEMORY_ATOMIC_SUB(&stats->total_allocated, size);
+    MEMORY_ATOMIC_SUB(&stats->tagged_allocations[tag], size);
+    memory_budget_release_pressure(tag);
+}
+
+void *khandle_get(u32 handle) {
+    if (!state_ptr) {
+        return 0;
+    }
+
+    kmutex_lock(&state_ptr->lock);
+    void *block = handle_allocator_get(&state_ptr->handle_allocator, handle);
+    kmutex_unlock(&state_ptr->lock);
+    return block;
+}
+
+u64 memory_system_compact(u64 max_bytes) {
+    if (!state_ptr) {
+        return 0;
+    }
+
+    kmutex_lock(&state_ptr->lock);
+    u64 moved =
+        handle_allocator_compact(&state_ptr->handle_allocator, max_bytes);
+    kmutex_unlock(&state_ptr->lock);
+    return moved;
+}
+
+char *get_memory_allocation_report(allocation_tracker_sort sort,
+                                   u32 top_count) {
+#if KMEMORY_TRACK_ALLOCATIONS
+    if (state_ptr) {
+        // The buffer is allocated before taking the lock, since allocating
+        // takes it too.
+        u64 buffer_size = 2048 + (u64)top_count * 256;
+        char *buffer = kallocate_uninit(buffer_size, MEMORY_TAG_STRING);
+        kmutex_lock(&state_ptr->tracker_lock);
+        allocation_tracker_report(&state_ptr->tracker, sort, top_count, buffer,
+                                  buffer_size);
+        kmutex_unlock(&state_ptr->tracker_lock);
+
+        char *out_string = string_duplicate(buffer);
+        kfree(buffer, buffer_size, MEMORY_TAG_STRING);
+        return out_string;
+    }
+#endif
+    return string_duplicate("Allocation tracking is disabled. Build with "
+                            "KMEMORY_TRACK_ALLOCATIONS=1 to enable it.\n");
+}
+
+char *get_memory_allocation_json() {
+#if KMEMORY_TRACK_ALLOCATIONS
+    if (state_ptr) {
+        // Sites can be added between sizing and writing; leave room.
+        kmutex_lock(&state_ptr->tracker_lock);
+        u64 buffer_size = allocation_tracker_json_size(&state_ptr->tracker);
+        kmutex_unlock(&state_ptr->tracker_lock);
+        buffer_size += buffer_size / 2;
+
+        char *buffer = kallocate_uninit(buffer_size, MEMORY_TAG_STRING);
+        kmutex_lock(&state_ptr->tracker_lock);
+        allocation_tracker_json(&state_ptr->tracker, buffer, buffer_size);
+        kmutex_unlock(&state_ptr->tracker_lock);
+
+        char *out_string = string_duplicate(buffer);
+        kfree(buffer, buffer_size, MEMORY_TAG_STRING);
+        return out_string;
+    }
+#endif
+    return string_duplicate("{}");
+}
+
+u64 get_memory_cached_block_count() {
+    if (!state_ptr) {
+        return 0;
+    }
+    kmutex_lock(&state_ptr->lock);
+    u64 count = state_ptr->cached_blocks;
+    kmutex_unlock(&state_ptr->lock);
+    return count;
+}
+
+u64 get_memory_overrun_count() {
+    if (!state_ptr) {
+        return 0;
+    }
+    return MEMORY_ATOMIC_LOAD(&state_ptr->overrun_count);
+}
+
+void memory_system_set_tag_budget(memory_tag tag, memory_tag_budget budget) {
+    if (!state_ptr || tag >= MEMORY_TAG_MAX_TAGS) {
+        return;
+    }
+    state_ptr->budgets[tag] = budget;
+    memory_budget_release_pressure(tag);
+    memory_budget_check_pressure(tag);
+}
+
+u64 get_memory_tag_usage(memory_tag tag) {
+    if (!state_ptr || tag >= MEMORY_TAG_MAX_TAGS) {
+        return 0;
+    }
+    return memory_tag_usage(tag);
 }
@@ -2,9 +2,44 @@
 
 #include "defines.h"
 
-typedef struct memory_system_configuration {
-    u64 total_alloc_count;
-} memory_system_configuration;
+#include "memory/allocation_tracker.h"
+#include "memory/dynamic_allocator.h"
+
+/**
+ * @brief When set, kfree and kfree_aligned check the size, alignment and tag
+ * passed in against the block header and log any mismatch. Enabled in debug
+ * builds.
+ */
+#ifndef KMEMORY_VERIFY_FREES
+#if defined(_DEBUG)
+#define KMEMORY_VERIFY_FREES 1
+#else
+#define KMEMORY_VERIFY_FREES 0
+#endif
+#endif
+
+/**
+ * @brief When set, memory_system_configuration.guard_allocations is honoured.
+ * Enabled in debug builds; release builds compile the guard paths out.
+ */
+#ifndef KMEMORY_GUARD_ALLOCATIONS
+#if defined(_DEBUG)
+#define KMEMORY_GUARD_ALLOCATIONS 1
+#else
+#define KMEMORY_GUARD_ALLOCATIONS 0
+#endif
+#endif
+
+/**
+ * @brief When set, every allocation records its call site, and
+ * get_memory_allocation_report and get_memory_allocation_json report per-site
+ * live blocks and per-frame churn. kallocate, kallocate_uninit and
+ * kallocate_aligned become macros passing __FILE__ and __LINE__. Off by
+ * default; blocks carry a larger header while enabled.
+ */
+#ifndef KMEMORY_TRACK_ALLOCATIONS
+#define KMEMORY_TRACK_ALLOCATIONS 0
+#endif
 
 typedef enum memory_tag {
     MEMORY_TAG_UNKNOWN,
@@ -29,11 +64,93 @@ typedef enum memory_tag {
     MEMORY_TAG_MAX_TAGS
 } memory_tag;
 
+/**
+ * @brief A ceiling on the bytes live under one memory tag. 0 disables a limit.
+ */
+typedef struct memory_tag_budget {
+    /** @brief Crossing this fires EVENT_CODE_MEMORY_PRESSURE at the end of the
+     * frame, once until usage drops back to it. */
+    u64 soft_limit;
+    /** @brief An allocation that would cross this logs a usage report and
+     * stops the program. */
+    u64 hard_limit;
+} memory_tag_budget;
+
+typedef struct memory_system_configuration {
+    /** @brief The most the memory system can hand out. Address space for it
+     * is reserved up front, but with DYNAMIC_ALLOCATOR_STRATEGY_TLSF memory is
+     * only committed as it is used. */
+    u64 total_alloc_count;
+    /** @brief The strategy used by the backing dynamic allocator. */
+    dynamic_allocator_strategy allocator_strategy;
+    /** @brief Debug aid. Large blocks get their own pages, ending against an
+     * inaccessible guard page so overruns fault where they happen. Small
+     * blocks get a canary that is checked when they are freed. Ignored unless
+     * built with KMEMORY_GUARD_ALLOCATIONS. */
+    b8 guard_allocations;
+    /** @brief Per-tag budgets, indexed by memory_tag. Zeroed means none. */
+    memory_tag_budget budgets[MEMORY_TAG_MAX_TAGS];
+} memory_system_configuration;
+
+
 b8 memory_system_initialize(memory_system_configuration config);
 void memory_system_shutdown();
 
+// kallocate and kfree are safe to call from any thread. Small blocks are
+// cached per thread; a thread that is about to exit should hand its cache
+// back so other threads can reuse the blocks.
+KAPI void memory_system_flush_thread_cache();
+
+// Closes the per-frame memory counters and fires the pressure events latched
+// during the frame. Called once per frame by the application loop, on the main
+// thread.
+KAPI void memory_system_end_frame();
+
 KAPI void *kallocate(u64 size, memory_tag tag);
+// Like kallocate, but the block is not zeroed. Use when the caller overwrites
+// all of it anyway.
+KAPI void *kallocate_uninit(u64 size, memory_tag tag);
 KAPI void kfree(void *block, u64 size, memory_tag tag);
+KAPI void *kallocate_aligned(u64 size, u16 alignment, memory_tag tag);
+KAPI void kfree_aligned(void *block, u64 size, u16 alignment, memory_tag tag);
+// Resizes a block from kallocate, kallocate_uninit or kallocate_aligned,
+// keeping its contents up to the smaller size. Grows in place when the
+// allocator has free space right after the block; otherwise moves it. Bytes
+// past old_size are not initialised. Returns the block, which may have moved,
+// or 0 on failure, leaving the old block as it was.
+KAPI void *kreallocate(void *block, u64 old_size, u64 new_size,
+                       memory_tag tag);
+// The same, recording the caller's file and line when tracking is enabled.
+KAPI void *kallocate_at(u64 size, memory_tag tag, const char *file, u32 line);
+KAPI void *kallocate_uninit_at(u64 size, memory_tag tag, const char *file,
+                               u32 line);
+KAPI void *kallocate_aligned_at(u64 size, u16 alignment, memory_tag tag,
+                                const char *file, u32 line);
+KAPI void *kreallocate_at(void *block, u64 old_size, u64 new_size,
+                          memory_tag tag, const char *file, u32 line);
+
+#if KMEMORY_TRACK_ALLOCATIONS
+#define kallocate(size, tag) kallocate_at(size, tag, __FILE__, __LINE__)
+#define kallocate_uninit(size, tag)                                            \
+    kallocate_uninit_at(size, tag, __FILE__, __LINE__)
+#define kallocate_aligned(size, alignment, tag)                                \
+    kallocate_aligned_at(size, alignment, tag, __FILE__, __LINE__)
+#define kreallocate(block, old_size, new_size, tag)                            \
+    kreallocate_at(block, old_size, new_size, tag, __FILE__, __LINE__)
+#endif
+// Every block carries a header with its size and tag, so it can be freed
+// without them.
+KAPI void kfree_unsized(void *block);
+KAPI u64 kallocation_size(void *block);
+// Relocatable blocks, reached through a handle instead of a pointer, so
+// memory_system_compact can move them. Pointers from khandle_get are only
+// valid until the next compaction; resolve again each frame.
+KAPI u32 kallocate_handle(u64 size, memory_tag tag);
+KAPI void kfree_handle(u32 handle, memory_tag tag);
+KAPI void *khandle_get(u32 handle);
+// Moves up to max_bytes of handle blocks into lower free space. Returns the
+// bytes moved. Called once per frame by the application loop.
+KAPI u64 memory_system_compact(u64 max_bytes);
 KAPI void *kzero_memory(void *block, u64 size);
 KAPI void *kcopy_memory(void *dest, const void *source, u64 size);
 KAPI void *kset_memory(void *dest, i32 value, u64 size);
@@ -41,3 +158,37 @@ KAPI void *kset_memory(void *dest, i32 value, u64 size);
 KAPI char *get_memory_usage_str();
 
 KAPI u64 get_memory_alloc_count();
+
+KAPI u64 get_memory_free_mismatch_count();
+
+// Small blocks thread caches have taken from the slab and not given back, in
+// use or cached. Cached ones only return when their thread calls
+// memory_system_flush_thread_cache.
+KAPI u64 get_memory_cached_block_count();
+
+// Blocks found written past their end when freed, with guard_allocations.
+KAPI u64 get_memory_overrun_count();
+
+// Bytes zeroed by kallocate and kzero_memory during the last complete frame.
+KAPI u64 get_memory_zeroed_bytes_last_frame();
+
+// Top call sites and the size histogram, as text or a JSON snapshot. Only
+// filled in when built with KMEMORY_TRACK_ALLOCATIONS. The caller frees the
+// string.
+KAPI char *get_memory_allocation_report(allocation_tracker_sort sort,
+                                        u32 top_count);
+KAPI char *get_memory_allocation_json();
+
+// Replaces the budget of one tag. Takes effect for the next allocation.
+KAPI void memory_system_set_tag_budget(memory_tag tag,
+                                       memory_tag_budget budget);
+
+// Bytes currently live under tag.
+KAPI u64 get_memory_tag_usage(memory_tag tag);
+
+// Bytes of the reserved allocator arena currently backed by memory.
+KAPI u64 get_memory_committed_bytes();
+
+// Largest free block over total free space in the dynamic allocator. 1 means
+// all free space is contiguous; lower means more fragmented.
+KAPI f32 get_memory_free_contiguity();
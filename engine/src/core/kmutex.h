@@ -0,0 +1,51 @@
+/**
+ * @file kmutex.h
+ * @brief Contains a thin, platform-agnostic wrapper around a native mutex.
+ * Implemented per platform in the platform layer.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Represents a mutex. Not recursive.
+ */
+typedef struct kmutex {
+    /** @brief The platform mutex. */
+    void *internal_data;
+} kmutex;
+
+/**
+ * @brief Creates a mutex. The platform mutex is allocated with
+ * platform_allocate, so this can be used by the memory system itself.
+ *
+ * @param out_mutex A pointer to hold the mutex. Required.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kmutex_create(kmutex *out_mutex);
+
+/**
+ * @brief Destroys a mutex. Must not be held.
+ *
+ * @param mutex A pointer to the mutex.
+ */
+KAPI void kmutex_destroy(kmutex *mutex);
+
+/**
+ * @brief Locks the mutex, blocking until it is available.
+ *
+ * @param mutex A pointer to the mutex.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kmutex_lock(kmutex *mutex);
+
+/**
+ * @brief Unlocks a mutex held by the calling thread.
+ *
+ * @param mutex A pointer to the mutex.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kmutex_unlock(kmutex *mutex);
@@ -0,0 +1,54 @@
+/**
+ * @file ksemaphore.h
+ * @brief Contains a thin, platform-agnostic wrapper around a native counting
+ * semaphore. Implemented per platform in the platform layer.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Represents a counting semaphore.
+ */
+typedef struct ksemaphore {
+    /** @brief The platform semaphore. */
+    void *internal_data;
+} ksemaphore;
+
+/**
+ * @brief Creates a semaphore.
+ *
+ * @param initial_count The count the semaphore starts with.
+ * @param out_semaphore A pointer to hold the semaphore. Required.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 ksemaphore_create(u32 initial_count, ksemaphore *out_semaphore);
+
+/**
+ * @brief Destroys a semaphore. No thread may be waiting on it.
+ *
+ * @param semaphore A pointer to the semaphore.
+ */
+KAPI void ksemaphore_destroy(ksemaphore *semaphore);
+
+/**
+ * @brief Increases the count of a semaphore, waking up to count waiting
+ * threads.
+ *
+ * @param semaphore A pointer to the semaphore.
+ * @param count The amount to increase the count by.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 ksemaphore_signal(ksemaphore *semaphore, u32 count);
+
+/**
+ * @brief Blocks until the count of a semaphore is positive, then decreases it
+ * by one.
+ *
+ * @param semaphore A pointer to the semaphore.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 ksemaphore_wait(ksemaphore *semaphore);
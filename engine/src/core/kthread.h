@@ -0,0 +1,75 @@
+/**
+ * @file kthread.h
+ * @brief Contains a thin, platform-agnostic wrapper around native threads.
+ * Implemented per platform in the platform layer.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief The function a thread starts executing. The return value is the
+ * thread's exit code.
+ */
+typedef u32 (*pfn_thread_start)(void *);
+
+/**
+ * @brief Represents a native thread.
+ */
+typedef struct kthread {
+    /** @brief The platform handle of the thread. */
+    void *internal_data;
+    /** @brief The platform id of the thread. */
+    u64 thread_id;
+} kthread;
+
+/**
+ * @brief Creates and starts a new thread.
+ *
+ * @param start_function_ptr The function the thread starts executing.
+ * @param params Passed to start_function_ptr. Must outlive the thread.
+ * @param auto_detach If true, the thread cleans up after itself when it
+ * finishes and cannot be waited on.
+ * @param out_thread A pointer to hold the thread. Required.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kthread_create(pfn_thread_start start_function_ptr, void *params,
+                       b8 auto_detach, kthread *out_thread);
+
+/**
+ * @brief Releases the platform handle of a thread. Does not stop the thread.
+ *
+ * @param thread A pointer to the thread.
+ */
+KAPI void kthread_destroy(kthread *thread);
+
+/**
+ * @brief Blocks until the thread finishes, then destroys it.
+ *
+ * @param thread A pointer to the thread.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kthread_wait(kthread *thread);
+
+/**
+ * @brief Gets the platform id of the calling thread.
+ */
+KAPI u64 kthread_current_id();
+
+/**
+ * @brief Gives up the rest of the calling thread's time slice.
+ */
+KAPI void kthread_yield();
+
+/**
+ * @brief Restricts a thread to run on a single logical processor.
+ *
+ * @param thread A pointer to a thread that has not been detached.
+ * @param processor_index The logical processor, less than
+ * platform_get_processor_count().
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 kthread_set_affinity(kthread *thread, u32 processor_index);
@@ -0,0 +1,231 @@
+#include "core/string_intern.h"
+
+#include "containers/hashtable.h"
+#include "core/katomic.h"
+#include "core/kmemory.h"
+#include "core/kmutex.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+
+typedef struct string_intern_entry {
+    const char *str;
+    u32 hash;
+    u32 length;
+} string_intern_entry;
+
+// Strings are packed into blocks, which are only freed on shutdown so interned
+// pointers stay valid.
+typedef struct string_intern_block {
+    struct string_intern_block *next;
+    u64 size;
+} string_intern_block;
+
+typedef struct string_intern_state {
+    string_intern_config config;
+    // Written under lock, read without it once an entry is published.
+    u32 count;
+    /** @brief The number of table slots, a power of 2 at least twice
+     * max_string_count so probes stay short. */
+    u32 table_capacity;
+    // Open addressing with linear probing; empty slots hold INVALID_ID.
+    string_id *table;
+    // Indexed by ID.
+    string_intern_entry *entries;
+    string_intern_block *blocks;
+    u64 block_used;
+    kmutex lock;
+} string_intern_state;
+
+static string_intern_state *state_ptr = 0;
+
+static u32 string_intern_table_capacity(u32 max_string_count) {
+    u32 capacity = 8;
+    while (capacity < (u64)max_string_count * 2) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+// Copies a string into the current block, starting a new one if it is full.
+static const char *string_intern_store(const char *str, u64 length) {
+    string_intern_block *block = state_ptr->blocks;
+    if (!block || state_ptr->block_used + length + 1 > block->size) {
+        u64 size = sizeof(string_intern_block) + length + 1;
+        if (size < STRING_INTERN_BLOCK_SIZE) {
+            size = STRING_INTERN_BLOCK_SIZE;
+        }
+        block = kallocate_uninit(size, MEMORY_TAG_STRING);
+        if (!block) {
+            return 0;
+        }
+        block->next = state_ptr->blocks;
+        block->size = size;
+        state_ptr->blocks = block;
+        state_ptr->block_used = sizeof(string_intern_block);
+    }
+
+    char *copy = (char *)block + state_ptr->block_used;
+    kcopy_memory(copy, str, length + 1);
+    state_ptr->block_used += length + 1;
+    return copy;
+}
+
+// Finds the table slot holding str, or the empty slot it would go in.
+static u32 string_intern_probe(const char *str, u32 hash) {
+    u32 mask = state_ptr->table_capacity - 1;
+    u32 index = hash & mask;
+    for (;;) {
+        string_id id = state_ptr->table[index];
+        if (id == INVALID_ID) {
+            return index;
+        }
+        string_intern_entry *entry = &state_ptr->entries[id];
+        if (entry->hash == hash && strings_equal(entry->str, str)) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+b8 string_intern_initialize(u64 *memory_requirement, void *state,
+                            string_intern_config config) {
+    if (config.max_string_count < 2 || config.max_string_count == INVALID_ID) {
+        KFATAL("string_intern_initialize - config.max_string_count must be at "
+               "least 2 and less than INVALID_ID.");
+        return false;
+    }
+
+    // The state, followed by the table, followed by the entries.
+    u32 table_capacity = string_intern_table_capacity(config.max_string_count);
+    u64 struct_requirement = sizeof(string_intern_state);
+    u64 table_requirement = sizeof(string_id) * table_capacity;
+    u64 entries_requirement =
+        sizeof(string_intern_entry) * config.max_string_count;
+    *memory_requirement =
+        struct_requirement + table_requirement + entries_requirement;
+
+    if (!state) {
+        return true;
+    }
+
+    state_ptr = state;
+    kzero_memory(state_ptr, struct_requirement);
+    state_ptr->config = config;
+    state_ptr->table_capacity = table_capacity;
+    state_ptr->table = state + struct_requirement;
+    state_ptr->entries = state + struct_requirement + table_requirement;
+    kset_memory(state_ptr->table, 0xFF, table_requirement);
+
+    if (!kmutex_create(&state_ptr->lock)) {
+        KFATAL("string_intern_initialize - failed to create mutex.");
+        state_ptr = 0;
+        return false;
+    }
+
+    // ID 0 is always the empty string.
+    if (string_intern("") != STRING_ID_EMPTY) {
+        KFATAL("string_intern_initialize - failed to intern the empty string.");
+        return false;
+    }
+
+    return true;
+}
+
+void string_intern_shutdown(void *state) {
+    if (!state_ptr) {
+        return;
+    }
+
+    string_intern_block *block = state_ptr->blocks;
+    while (block) {
+        string_intern_block *next = block->next;
+        kfree(block, block->size, MEMORY_TAG_STRING);
+        block = next;
+    }
+
+    kmutex_destroy(&state_ptr->lock);
+    state_ptr = 0;
+}
+
+string_id string_intern(const char *str) {
+    if (!state_ptr) {
+        KERROR("string_intern - called before the system was initialized.");
+        return INVALID_ID;
+    }
+    if (!str) {
+        str = "";
+    }
+
+    u32 hash = hash_name(str);
+    kmutex_lock(&state_ptr->lock);
+    u32 index = string_intern_probe(str, hash);
+    string_id id = state_ptr->table[index];
+    if (id != INVALID_ID) {
+        kmutex_unlock(&state_ptr->lock);
+        return id;
+    }
+
+    if (state_ptr->count == state_ptr->config.max_string_count) {
+        kmutex_unlock(&state_ptr->lock);
+        KERROR("string_intern - cannot hold more than %u strings. Adjust "
+               "configuration to allow more.",
+               state_ptr->config.max_string_count);
+        return INVALID_ID;
+    }
+
+    u64 length = string_length(str);
+    const char *copy = string_intern_store(str, length);
+    if (!copy) {
+        kmutex_unlock(&state_ptr->lock);
+        KERROR("string_intern - failed to allocate storage for '%s'.", str);
+        return INVALID_ID;
+    }
+
+    id = state_ptr->count;
+    string_intern_entry *entry = &state_ptr->entries[id];
+    entry->str = copy;
+    entry->hash = hash;
+    entry->length = (u32)length;
+    state_ptr->table[index] = id;
+    // Publish the entry to lock-free readers.
+    katomic_store(&state_ptr->count, id + 1, KATOMIC_RELEASE);
+    kmutex_unlock(&state_ptr->lock);
+    return id;
+}
+
+string_id string_intern_find(const char *str) {
+    if (!state_ptr || !str) {
+        return INVALID_ID;
+    }
+
+    u32 hash = hash_name(str);
+    kmutex_lock(&state_ptr->lock);
+    string_id id = state_ptr->table[string_intern_probe(str, hash)];
+    kmutex_unlock(&state_ptr->lock);
+    return id;
+}
+
+static string_intern_entry *string_intern_entry_get(string_id id) {
+    if (!state_ptr ||
+        id >= katomic_load(&state_ptr->count, KATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    return &state_ptr->entries[id];
+}
+
+const char *string_intern_get(string_id id) {
+    string_intern_entry *entry = string_intern_entry_get(id);
+    return entry ? entry->str : "";
+}
+
+u32 string_intern_hash(string_id id) {
+    string_intern_entry *entry = string_intern_entry_get(id);
+    return entry ? entry->hash : 0;
+}
+
+u32 string_intern_count() {
+    if (!state_ptr) {
+        return 0;
+    }
+    return katomic_load(&state_ptr->count, KATOMIC_ACQUIRE);
+}
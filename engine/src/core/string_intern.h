@@ -0,0 +1,91 @@
+/**
+ * @file string_intern.h
+ * @brief This file contains the string intern system, which maps names to
+ * stable 32-bit IDs so they can be stored and compared as integers.
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief The ID of an interned string. Equal strings always get the same ID,
+ * for as long as the system runs, so comparing IDs compares the strings.
+ */
+typedef u32 string_id;
+
+/** @brief The ID of the empty string, so zeroed structures hold no name. */
+#define STRING_ID_EMPTY 0
+
+/** @brief The size of each block interned strings are copied into. */
+#define STRING_INTERN_BLOCK_SIZE (64 * 1024)
+
+typedef struct string_intern_config {
+    /** @brief The most distinct strings that can be interned, including the
+     * empty string. */
+    u32 max_string_count;
+} string_intern_config;
+
+/**
+ * @brief Initializes the string intern system. Call twice; first passing 0 to
+ * state to obtain the memory requirement, second to pass the allocated block.
+ * Interned strings are copied into blocks allocated with MEMORY_TAG_STRING.
+ *
+ * @param memory_requirement A pointer to get the memory requirement.
+ * @param state 0, or a pre-allocated block of memory for the system state.
+ * @param config The configuration for the system.
+ * @return True if successful; otherwise False.
+ */
+b8 string_intern_initialize(u64 *memory_requirement, void *state,
+                            string_intern_config config);
+
+/**
+ * @brief Shuts the string intern system down, freeing every interned string.
+ * IDs and strings obtained from it are no longer valid.
+ *
+ * @param state The system state.
+ */
+void string_intern_shutdown(void *state);
+
+/**
+ * @brief Gets the ID of a string, interning a copy of it first if it has not
+ * been seen before. Case sensitive. Thread safe.
+ *
+ * @param str The string to intern. A null pointer is treated as empty.
+ * @return The ID, or INVALID_ID if the system is full or not initialized.
+ */
+KAPI string_id string_intern(const char *str);
+
+/**
+ * @brief Gets the ID of a string without interning it. Thread safe.
+ *
+ * @param str The string to look up.
+ * @return The ID, or INVALID_ID if the string has not been interned.
+ */
+KAPI string_id string_intern_find(const char *str);
+
+/**
+ * @brief Gets the interned copy of the string an ID refers to.
+ *
+ * @param id The ID of the string.
+ * @return The string, or an empty string if the ID is not valid.
+ */
+KAPI const char *string_intern_get(string_id id);
+
+/**
+ * @brief Gets the hash computed for a string when it was interned, so it does
+ * not need hashing again.
+ *
+ * @param id The ID of the string.
+ * @return The hash, or 0 if the ID is not valid.
+ */
+KAPI u32 string_intern_hash(string_id id);
+
+/**
+ * @brief Gets the number of interned strings, including the empty string.
+ *
+ * @return The number of strings.
+ */
+KAPI u32 string_intern_count();
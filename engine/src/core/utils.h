@@ -41,6 +41,22 @@ KINLINE u64 kclz_u64(u64 x) {
 #endif
 }
 
+KINLINE u64 kctz_u64(u64 x) {
+    if (x == 0) {
+        return 64;
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    u64 count = 0;
+    while (!(x & 1)) {
+        count++;
+        x >>= 1;
+    }
+    return count;
+#endif
+}
+
 KINLINE u64 next_pow2_u64(u64 x) {
     if (x <= 1) {
         return 1;
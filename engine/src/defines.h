@@ -49,6 +49,8 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
  * pointing to anything.
  */
 #define INVALID_ID 4294967295U
+/** @brief The 64 bit equivalent of INVALID_ID. */
+#define INVALID_ID_U64 18446744073709551615UL
 
 // Platform detection
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
@@ -107,6 +109,9 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
 #define KNOINLINE
 #endif
 
+// Thread local storage
+#define KTHREAD_LOCAL _Thread_local
+
 #define GIBIBYTES(amount) amount * 1024 * 1024 * 1024
 #define MEBIBYTES(amount) amount * 1024 * 1024
 #define KIBIBYTES(amount) amount * 1024
@@ -12,7 +12,7 @@ extern b8 create_game(game *out_game);
  */
 int main(void) {
     // Request the game instance from the application
-    game game_inst;
+    game game_inst = {};
     if (!create_game(&game_inst)) {
         KFATAL("Could not create game!");
         return -1;
@@ -0,0 +1,422 @@
+#include "memory/allocation_tracker.h"
+
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "core/utils.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+typedef struct internal_state {
+    u32 max_sites;
+    u32 site_count;
+    // Power of two, at least twice max_sites, so probes stay short.
+    u32 slot_count;
+    // Site indices by hash, INVALID_ID where empty.
+    u32 *slots;
+    allocation_site_stats *sites;
+    // Per-site counters for the frame in progress.
+    u64 *current_allocations;
+    u64 *current_frees;
+    u64 histogram[ALLOCATION_TRACKER_HISTOGRAM_BUCKETS];
+    u64 frame_count;
+} internal_state;
+
+static u32 site_hash(const char *file, u32 line) {
+    u32 hash = 2166136261u;
+    for (const char *c = file; *c; c++) {
+        hash = (hash ^ (u8)*c) * 16777619u;
+    }
+    return (hash ^ line) * 16777619u;
+}
+
+static void site_reset(allocation_site_stats *site, const char *file,
+                       u32 line) {
+    // Runs inside the memory system, so stays off kzero_memory and its
+    // zeroed byte counter.
+    allocation_site_stats empty = {0};
+    *site = empty;
+    site->file = file;
+    site->line = line;
+}
+
+// Finds or adds the site, falling back to the overflow site when full.
+static u32 site_find(internal_state *state, const char *file, u32 line) {
+    u32 mask = state->slot_count - 1;
+    for (u32 slot = site_hash(file, line) & mask;;
+         slot = (slot + 1) & mask) {
+        u32 index = state->slots[slot];
+        if (index == INVALID_ID) {
+            if (state->site_count == state->max_sites) {
+                return ALLOCATION_TRACKER_OVERFLOW_SITE;
+            }
+            index = state->site_count++;
+            site_reset(&state->sites[index], file, line);
+            state->slots[slot] = index;
+            return index;
+        }
+
+        // The same file can have distinct __FILE__ literals per translation
+        // unit, so fall back to comparing the text.
+        allocation_site_stats *site = &state->sites[index];
+        if (site->line == line &&
+            (site->file == file || strings_equal(site->file, file))) {
+            return index;
+        }
+    }
+}
+
+static u32 histogram_bucket(u64 size) {
+    if (!size) {
+        return 0;
+    }
+    u32 bucket = 63 - (u32)kclz_u64(size);
+    return bucket < ALLOCATION_TRACKER_HISTOGRAM_BUCKETS
+               ? bucket
+               : ALLOCATION_TRACKER_HISTOGRAM_BUCKETS - 1;
+}
+
+static u64 site_sort_key(allocation_site_stats *site,
+                         allocation_tracker_sort sort) {
+    switch (sort) {
+    case ALLOCATION_TRACKER_SORT_LIVE_BYTES:
+        return site->live_bytes;
+    case ALLOCATION_TRACKER_SORT_TOTAL_COUNT:
+        return site->total_count;
+    case ALLOCATION_TRACKER_SORT_FRAME_CHURN:
+    default:
+        return site->frame_allocations + site->frame_frees;
+    }
+}
+
+// Appends formatted text, keeping the buffer terminated when it runs out.
+static void append(char *buffer, u64 buffer_size, u64 *offset,
+                   const char *format, ...) {
+    if (*offset + 1 >= buffer_size) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    i32 written =
+        vsnprintf(buffer + *offset, buffer_size - *offset, format, args);
+    va_end(args);
+
+    if (written > 0) {
+        *offset += (u64)written;
+        if (*offset >= buffer_size) {
+            *offset = buffer_size - 1;
+        }
+    }
+}
+
+b8 allocation_tracker_create(u32 max_sites, u64 *memory_requirement,
+                             void *memory, allocation_tracker *out_tracker) {
+    if (!memory_requirement) {
+        KERROR("allocation_tracker_create - memory_requirement not passed "
+               "through.");
+        return false;
+    }
+
+    // One extra for the overflow site.
+    max_sites += 1;
+    u32 slot_count = (u32)next_pow2_u64((u64)max_sites * 2);
+    *memory_requirement = sizeof(internal_state) + sizeof(u32) * slot_count +
+                          sizeof(allocation_site_stats) * max_sites +
+                          sizeof(u64) * max_sites * 2;
+
+    if (!memory) {
+        return true;
+    }
+
+    if (!out_tracker) {
+        KERROR("allocation_tracker_create - Requires out_tracker.");
+        return false;
+    }
+
+    out_tracker->memory = memory;
+
+    internal_state *state = (internal_state *)memory;
+    kzero_memory(memory, *memory_requirement);
+    state->max_sites = max_sites;
+    state->slot_count = slot_count;
+    state->slots = memory + sizeof(internal_state);
+    state->sites = (void *)(state->slots + slot_count);
+    state->current_allocations = (void *)(state->sites + max_sites);
+    state->current_frees = state->current_allocations + max_sites;
+
+    for (u32 i = 0; i < slot_count; i++) {
+        state->slots[i] = INVALID_ID;
+    }
+
+    // The overflow site is never found by hash.
+    site_reset(&state->sites[ALLOCATION_TRACKER_OVERFLOW_SITE], "<other>", 0);
+    state->site_count = 1;
+
+    return true;
+}
+
+void allocation_tracker_destroy(allocation_tracker *tracker) {
+    if (!tracker || !tracker->memory) {
+        KERROR("allocation_tracker_destroy - Passed in null tracker.");
+        return;
+    }
+
+    tracker->memory = 0;
+}
+
+u32 allocation_tracker_record_allocation(allocation_tracker *tracker,
+                                         const char *file, u32 line,
+                                         u64 size) {
+    internal_state *state = (internal_state *)tracker->memory;
+    u32 index = file ? site_find(state, file, line)
+                     : ALLOCATION_TRACKER_OVERFLOW_SITE;
+
+    allocation_site_stats *site = &state->sites[index];
+    site->live_count++;
+    site->live_bytes += size;
+    if (site->live_bytes > site->peak_live_bytes) {
+        site->peak_live_bytes = site->live_bytes;
+    }
+    site->total_count++;
+    site->total_bytes += size;
+    state->current_allocations[index]++;
+    state->histogram[histogram_bucket(size)]++;
+    return index;
+}
+
+void allocation_tracker_record_free(allocation_tracker *tracker, u32 site,
+                                    u64 size) {
+    internal_state *state = (internal_state *)tracker->memory;
+    if (site >= state->site_count) {
+        site = ALLOCATION_TRACKER_OVERFLOW_SITE;
+    }
+
+    allocation_site_stats *stats = &state->sites[site];
+    stats->live_count--;
+    stats->live_bytes -= size;
+    state->current_frees[site]++;
+}
+
+void allocation_tracker_end_frame(allocation_tracker *tracker) {
+    if (!tracker || !tracker->memory) {
+        return;
+    }
+
+    internal_state *state = (internal_state *)tracker->memory;
+    for (u32 i = 0; i < state->site_count; i++) {
+        state->sites[i].frame_allocations = state->current_allocations[i];
+        state->sites[i].frame_frees = state->current_frees[i];
+        state->current_allocations[i] = 0;
+        state->current_frees[i] = 0;
+    }
+    state->frame_count++;
+}
+
+u32 allocation_tracker_site_count(allocation_tracker *tracker) {
+    if (!tracker || !tracker->memory) {
+        return 0;
+    }
+
+    return ((internal_state *)tracker->memory)->site_count;
+}
+
+b8 allocation_tracker_get_site(allocation_tracker *tracker, u32 site,
+                               allocation_site_stats *out_stats) {
+    if (!tracker || !tracker->memory || !out_stats) {
+        KERROR("allocation_tracker_get_site - Requires tracker and "
+               "out_stats.");
+        return false;
+    }
+
+    internal_state *state = (internal_state *)tracker->memory;
+    if (site >= state->site_count) {
+        return false;
+    }
+
+    *out_stats = state->sites[site];
+    return true;
+}
+
+void allocation_tracker_get_histogram(allocation_tracker *tracker,
+                                      u64 *out_buckets) {
+    if (!tracker || !tracker->memory || !out_buckets) {
+        KERROR("allocation_tracker_get_histogram - Requires tracker and "
+               "out_buckets.");
+        return;
+    }
+
+    internal_state *state = (internal_state *)tracker->memory;
+    kcopy_memory(out_buckets, state->histogram, sizeof(state->histogram));
+}
+
+u32 allocation_tracker_top_sites(allocation_tracker *tracker,
+                                 allocation_tracker_sort sort, u32 max_count,
+                                 u32 *out_sites) {
+    if (!tracker || !tracker->memory || !out_sites) {
+        KERROR("allocation_tracker_top_sites - Requires tracker and "
+               "out_sites.");
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)tracker->memory;
+
+    // Insertion into a short sorted list; max_count is small.
+    u32 count = 0;
+    for (u32 i = 0; i < state->site_count; i++) {
+        u64 key = site_sort_key(&state->sites[i], sort);
+        if (!key) {
+            continue;
+        }
+
+        u32 position = count;
+        while (position > 0 &&
+               site_sort_key(&state->sites[out_sites[position - 1]], sort) <
+                   key) {
+            position--;
+        }
+        if (position >= max_count) {
+            continue;
+        }
+
+        u32 last = count < max_count ? count : max_count - 1;
+        for (u32 j = last; j > position; j--) {
+            out_sites[j] = out_sites[j - 1];
+        }
+        out_sites[position] = i;
+        if (count < max_count) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+u64 allocation_tracker_report(allocation_tracker *tracker,
+                              allocation_tracker_sort sort, u32 top_count,
+                              char *buffer, u64 buffer_size) {
+    if (!tracker || !tracker->memory || !buffer || !buffer_size) {
+        KERROR("allocation_tracker_report - Requires tracker and buffer.");
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)tracker->memory;
+    static const char *sort_names[] = {"frame churn", "live bytes",
+                                       "total allocations"};
+
+    u64 frame_allocations = 0;
+    u64 frame_frees = 0;
+    u64 live_count = 0;
+    u64 live_bytes = 0;
+    for (u32 i = 0; i < state->site_count; i++) {
+        frame_allocations += state->sites[i].frame_allocations;
+        frame_frees += state->sites[i].frame_frees;
+        live_count += state->sites[i].live_count;
+        live_bytes += state->sites[i].live_bytes;
+    }
+
+    u64 offset = 0;
+    buffer[0] = 0;
+    append(buffer, buffer_size, &offset,
+           "Allocations last frame: %llu, frees: %llu. Live: %llu blocks, "
+           "%lluB across %u sites.\n",
+           frame_allocations, frame_frees, live_count, live_bytes,
+           state->site_count);
+
+    u32 top[64];
+    if (top_count > 64) {
+        top_count = 64;
+    }
+    u32 count = allocation_tracker_top_sites(tracker, sort, top_count, top);
+    append(buffer, buffer_size, &offset, "Top %u sites by %s:\n", count,
+           sort_names[sort]);
+    for (u32 i = 0; i < count; i++) {
+        allocation_site_stats *site = &state->sites[top[i]];
+        append(buffer, buffer_size, &offset,
+               "  %s:%u  frame: +%llu/-%llu  live: %llu (%lluB, peak %lluB)  "
+               "total: %llu (%lluB)\n",
+               site->file, site->line, site->frame_allocations,
+               site->frame_frees, site->live_count, site->live_bytes,
+               site->peak_live_bytes, site->total_count, site->total_bytes);
+    }
+
+    append(buffer, buffer_size, &offset, "Size histogram:\n");
+    for (u32 i = 0; i < ALLOCATION_TRACKER_HISTOGRAM_BUCKETS; i++) {
+        if (state->histogram[i]) {
+            append(buffer, buffer_size, &offset, "  %12lluB+: %llu\n",
+                   1ULL << i, state->histogram[i]);
+        }
+    }
+
+    return offset;
+}
+
+// Writes a JSON string, escaping quotes, backslashes and control characters.
+static void append_json_string(char *buffer, u64 buffer_size, u64 *offset,
+                               const char *text) {
+    append(buffer, buffer_size, offset, "\"");
+    for (const char *c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            append(buffer, buffer_size, offset, "\\%c", *c);
+        } else if ((u8)*c < 0x20) {
+            append(buffer, buffer_size, offset, "\\u%04x", (u8)*c);
+        } else {
+            append(buffer, buffer_size, offset, "%c", *c);
+        }
+    }
+    append(buffer, buffer_size, offset, "\"");
+}
+
+u64 allocation_tracker_json(allocation_tracker *tracker, char *buffer,
+                            u64 buffer_size) {
+    if (!tracker || !tracker->memory || !buffer || !buffer_size) {
+        KERROR("allocation_tracker_json - Requires tracker and buffer.");
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)tracker->memory;
+
+    u64 offset = 0;
+    buffer[0] = 0;
+    append(buffer, buffer_size, &offset, "{\"frame\":%llu,\"histogram\":[",
+           state->frame_count);
+    for (u32 i = 0; i < ALLOCATION_TRACKER_HISTOGRAM_BUCKETS; i++) {
+        append(buffer, buffer_size, &offset, i ? ",%llu" : "%llu",
+               state->histogram[i]);
+    }
+    append(buffer, buffer_size, &offset, "],\"sites\":[");
+
+    for (u32 i = 0; i < state->site_count; i++) {
+        allocation_site_stats *site = &state->sites[i];
+        append(buffer, buffer_size, &offset, i ? ",{\"file\":" : "{\"file\":");
+        append_json_string(buffer, buffer_size, &offset, site->file);
+        append(buffer, buffer_size, &offset,
+               ",\"line\":%u,\"live_count\":%llu,\"live_bytes\":%llu,"
+               "\"peak_live_bytes\":%llu,\"total_count\":%llu,"
+               "\"total_bytes\":%llu,\"frame_allocations\":%llu,"
+               "\"frame_frees\":%llu}",
+               site->line, site->live_count, site->live_bytes,
+               site->peak_live_bytes, site->total_count, site->total_bytes,
+               site->frame_allocations, site->frame_frees);
+    }
+    append(buffer, buffer_size, &offset, "]}");
+
+    return offset;
+}
+
+u64 allocation_tracker_json_size(allocation_tracker *tracker) {
+    if (!tracker || !tracker->memory) {
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)tracker->memory;
+
+    // Histogram and framing, then each site's numbers (at most 20 digits
+    // each) and its file, which may double when escaped.
+    u64 size = 64 + ALLOCATION_TRACKER_HISTOGRAM_BUCKETS * 21;
+    for (u32 i = 0; i < state->site_count; i++) {
+        size += 320 + string_length(state->sites[i].file) * 6;
+    }
+    return size;
+}
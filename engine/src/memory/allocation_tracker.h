@@ -0,0 +1,194 @@
+/**
+ * @file allocation_tracker.h
+ * @brief Contains an allocation call-site tracker. Records live blocks,
+ * totals and per-frame churn for every file/line that allocates, plus a size
+ * histogram, and formats them as a sorted report or a JSON snapshot.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief Number of size histogram buckets. Bucket i counts sizes in
+ * [2^i, 2^(i+1)); the last bucket also holds everything larger. */
+#define ALLOCATION_TRACKER_HISTOGRAM_BUCKETS 32
+
+/** @brief The site index allocations are counted under once the site table
+ * is full. */
+#define ALLOCATION_TRACKER_OVERFLOW_SITE 0
+
+/**
+ * @brief The allocation tracker struct. Sites are found through a hash of
+ * their file and line, and keep a stable index for their lifetime so callers
+ * can store it with the block and report the free against the same site.
+ */
+typedef struct allocation_tracker {
+    /** @brief The internal state, followed by the site tables. */
+    void *memory;
+} allocation_tracker;
+
+/** @brief What the top-N report is sorted by, largest first. */
+typedef enum allocation_tracker_sort {
+    /** @brief Allocations plus frees during the last complete frame. */
+    ALLOCATION_TRACKER_SORT_FRAME_CHURN,
+    /** @brief Bytes currently allocated. */
+    ALLOCATION_TRACKER_SORT_LIVE_BYTES,
+    /** @brief Allocations since the tracker was created. */
+    ALLOCATION_TRACKER_SORT_TOTAL_COUNT,
+} allocation_tracker_sort;
+
+/** @brief Numbers for a single allocation site. */
+typedef struct allocation_site_stats {
+    /** @brief The file the allocation was made from. */
+    const char *file;
+    /** @brief The line the allocation was made from. */
+    u32 line;
+    /** @brief Blocks from the site not yet freed. */
+    u64 live_count;
+    /** @brief Bytes from the site not yet freed. */
+    u64 live_bytes;
+    /** @brief The most live_bytes has been. */
+    u64 peak_live_bytes;
+    /** @brief Allocations since the tracker was created. */
+    u64 total_count;
+    /** @brief Bytes allocated since the tracker was created. */
+    u64 total_bytes;
+    /** @brief Allocations during the last complete frame. */
+    u64 frame_allocations;
+    /** @brief Frees during the last complete frame. */
+    u64 frame_frees;
+} allocation_site_stats;
+
+/**
+ * @brief Creates an allocation tracker. Should be called twice; once to get
+ * the memory requirement, twice to create the struct. The memory should not
+ * come from the tracked allocator.
+ *
+ * @param max_sites The most distinct call sites to track. Sites past this are
+ * counted together under ALLOCATION_TRACKER_OVERFLOW_SITE.
+ * @param memory_requirement A pointer to the amount of memory needed.
+ * @param memory A pointer to the memory for the tracker, or 0.
+ * @param out_tracker A pointer to hold the tracker.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 allocation_tracker_create(u32 max_sites, u64 *memory_requirement,
+                                  void *memory,
+                                  allocation_tracker *out_tracker);
+
+/**
+ * @brief Destroys an allocation tracker. Does not free the memory block.
+ *
+ * @param tracker A pointer to the tracker to destroy.
+ */
+KAPI void allocation_tracker_destroy(allocation_tracker *tracker);
+
+/**
+ * @brief Records an allocation.
+ *
+ * @param tracker A pointer to the tracker struct.
+ * @param file The file of the call site. Must outlive the tracker, e.g. a
+ * __FILE__ literal.
+ * @param line The line of the call site.
+ * @param size The size allocated.
+ * @return The site index to pass to allocation_tracker_record_free.
+ */
+KAPI u32 allocation_tracker_record_allocation(allocation_tracker *tracker,
+                                              const char *file, u32 line,
+                                              u64 size);
+
+/**
+ * @brief Records a free against the site that made the allocation.
+ *
+ * @param tracker A pointer to the tracker struct.
+ * @param site The index returned when the block was allocated.
+ * @param size The size of the block.
+ */
+KAPI void allocation_tracker_record_free(allocation_tracker *tracker, u32 site,
+                                         u64 size);
+
+/**
+ * @brief Closes the per-frame counters. Call once per frame.
+ *
+ * @param tracker A pointer to the tracker struct.
+ */
+KAPI void allocation_tracker_end_frame(allocation_tracker *tracker);
+
+/**
+ * @brief Gets the number of sites in use, including the overflow site.
+ *
+ * @param tracker A pointer to the tracker struct.
+ */
+KAPI u32 allocation_tracker_site_count(allocation_tracker *tracker);
+
+/**
+ * @brief Gets the numbers for a site.
+ *
+ * @param tracker A pointer to the tracker struct.
+ * @param site The site index, less than allocation_tracker_site_count.
+ * @param out_stats A pointer to hold the numbers.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 allocation_tracker_get_site(allocation_tracker *tracker, u32 site,
+                                    allocation_site_stats *out_stats);
+
+/**
+ * @brief Gets the size histogram of every allocation since creation.
+ *
+ * @param tracker A pointer to the tracker struct.
+ * @param out_buckets An array of ALLOCATION_TRACKER_HISTOGRAM_BUCKETS counts.
+ */
+KAPI void allocation_tracker_get_histogram(allocation_tracker *tracker,
+                                           u64 *out_buckets);
+
+/**
+ * @brief Gets the indices of the top sites by sort, largest first. Sites with
+ * nothing to report for the sort are left out.
+ *
+ * @param tracker A pointer to the tracker struct.
+ * @param sort What to sort by.
+ * @param max_count The most sites to return.
+ * @param out_sites An array of at least max_count indices.
+ * @return The number of sites written.
+ */
+KAPI u32 allocation_tracker_top_sites(allocation_tracker *tracker,
+                                      allocation_tracker_sort sort,
+                                      u32 max_count, u32 *out_sites);
+
+/**
+ * @brief Writes a human readable report of the top sites, the last frame's
+ * totals and the size histogram. Output is cut short, but still terminated,
+ * if the buffer is too small.
+ *
+ * @param tracker A pointer to the tracker struct.
+ * @param sort What to sort the sites by.
+ * @param top_count The most sites to list.
+ * @param buffer The buffer to write to.
+ * @param buffer_size The size of buffer.
+ * @return The number of characters written, excluding the terminator.
+ */
+KAPI u64 allocation_tracker_report(allocation_tracker *tracker,
+                                   allocation_tracker_sort sort,
+                                   u32 top_count, char *buffer,
+                                   u64 buffer_size);
+
+/**
+ * @brief Writes every site, the frame totals and the histogram as a JSON
+ * object. Output is cut short, but still terminated, if the buffer is too
+ * small; use allocation_tracker_json_size to size it.
+ *
+ * @param tracker A pointer to the tracker struct.
+ * @param buffer The buffer to write to.
+ * @param buffer_size The size of buffer.
+ * @return The number of characters written, excluding the terminator.
+ */
+KAPI u64 allocation_tracker_json(allocation_tracker *tracker, char *buffer,
+                                 u64 buffer_size);
+
+/**
+ * @brief Gets a buffer size large enough for allocation_tracker_json.
+ *
+ * @param tracker A pointer to the tracker struct.
+ */
+KAPI u64 allocation_tracker_json_size(allocation_tracker *tracker);
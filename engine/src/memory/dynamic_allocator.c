@@ -2,24 +2,52 @@
 #include "containers/freelist.h"
 #include "core/kmemory.h"
 #include "core/logger.h"
-
-// TODO: support memory alignment
+#include "memory/tlsf_allocator.h"
 
 typedef struct internal_state {
+    dynamic_allocator_strategy strategy;
+    u64 total_size;
     freelist freelist;
+    tlsf_allocator tlsf;
     void *memory;
+    // Size of the memory range handed out from, used for ownership checks.
+    u64 memory_size;
 } internal_state;
 
 b8 dynamic_allocator_create(u64 total_size, u64 *memory_requirement,
                             void *memory, dynamic_allocator *out_allocator) {
+    return dynamic_allocator_create_with_strategy(
+        DYNAMIC_ALLOCATOR_STRATEGY_FREELIST, total_size, memory_requirement,
+        memory, out_allocator);
+}
+
+b8 dynamic_allocator_create_with_strategy(dynamic_allocator_strategy strategy,
+                                          u64 total_size,
+                                          u64 *memory_requirement, void *memory,
+                                          dynamic_allocator *out_allocator) {
     // Get memory requirement:
     // dynamic allocator -> internal_state
-    // freelist -> internal_state
-    // memory pool
-    u64 freelist_memory_requirement = 0;
-    freelist_create(total_size, &freelist_memory_requirement, 0, 0);
-    *memory_requirement =
-        sizeof(internal_state) + freelist_memory_requirement + total_size;
+    // freelist -> internal_state, memory pool
+    // tlsf -> tlsf state and memory pool
+    u64 strategy_memory_requirement = 0;
+    switch (strategy) {
+    case DYNAMIC_ALLOCATOR_STRATEGY_FREELIST:
+        freelist_create(total_size, &strategy_memory_requirement, 0, 0);
+        *memory_requirement =
+            sizeof(internal_state) + strategy_memory_requirement + total_size;
+        break;
+    case DYNAMIC_ALLOCATOR_STRATEGY_TLSF:
+        if (!tlsf_allocator_create(total_size, &strategy_memory_requirement, 0,
+                                   0)) {
+            return false;
+        }
+        *memory_requirement =
+            sizeof(internal_state) + strategy_memory_requirement;
+        break;
+    default:
+        KERROR("dynamic_allocator_create - Unknown strategy %u.", strategy);
+        return false;
+    }
 
     if (!memory) {
         return true;
@@ -33,13 +61,48 @@ b8 dynamic_allocator_create(u64 total_size, u64 *memory_requirement,
     out_allocator->memory = memory;
 
     internal_state *state = (internal_state *)out_allocator->memory;
+    state->strategy = strategy;
+    state->total_size = total_size;
+    void *strategy_memory = (void *)(out_allocator->memory +
+                                     sizeof(internal_state));
+
+    if (strategy == DYNAMIC_ALLOCATOR_STRATEGY_TLSF) {
+        // The pool lives inside the tlsf allocator's own block.
+        state->memory = strategy_memory;
+        state->memory_size = strategy_memory_requirement;
+        return tlsf_allocator_create(total_size, &strategy_memory_requirement,
+                                     strategy_memory, &state->tlsf);
+    }
+
     // Setup freelist
-    freelist_create(total_size, &freelist_memory_requirement,
-                    (void *)(out_allocator->memory + sizeof(internal_state)),
+    freelist_create(total_size, &strategy_memory_requirement, strategy_memory,
                     &state->freelist);
     // Initialise the rest of the memory
-    state->memory = (void *)(out_allocator->memory + sizeof(internal_state) +
-                             freelist_memory_requirement);
+    state->memory = (void *)(strategy_memory + strategy_memory_requirement);
+    state->memory_size = total_size;
+    return true;
+}
+
+b8 dynamic_allocator_grow(dynamic_allocator *allocator, u64 new_total_size) {
+    if (!allocator || !allocator->memory) {
+        KERROR("dynamic_allocator_grow - Passed in null allocator.");
+        return false;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    if (state->strategy != DYNAMIC_ALLOCATOR_STRATEGY_TLSF) {
+        KERROR("dynamic_allocator_grow - Only the TLSF strategy can grow.");
+        return false;
+    }
+
+    if (!tlsf_allocator_grow(&state->tlsf, new_total_size)) {
+        return false;
+    }
+
+    u64 memory_size = 0;
+    tlsf_allocator_create(new_total_size, &memory_size, 0, 0);
+    state->total_size = new_total_size;
+    state->memory_size = memory_size;
     return true;
 }
 
@@ -51,7 +114,11 @@ b8 dynamic_allocator_destroy(dynamic_allocator *allocator) {
 
     // Zero out structs, destroy freelist
     internal_state *state = (internal_state *)allocator->memory;
-    freelist_destroy(&state->freelist);
+    if (state->strategy == DYNAMIC_ALLOCATOR_STRATEGY_TLSF) {
+        tlsf_allocator_destroy(&state->tlsf);
+    } else {
+        freelist_destroy(&state->freelist);
+    }
     state->memory = 0;
     allocator->memory = 0;
     return true;
@@ -65,6 +132,10 @@ void *dynamic_allocator_allocate(dynamic_allocator *allocator, u64 size) {
 
     internal_state *state = (internal_state *)allocator->memory;
 
+    if (state->strategy == DYNAMIC_ALLOCATOR_STRATEGY_TLSF) {
+        return tlsf_allocator_allocate(&state->tlsf, size);
+    }
+
     u64 offset = 0;
 
     if (!freelist_allocate_block(&state->freelist, size, &offset)) {
@@ -86,7 +157,11 @@ b8 dynamic_allocator_free(dynamic_allocator *allocator, void *block, u64 size) {
 
     internal_state *state = (internal_state *)allocator->memory;
 
-    u32 offset = (u32)(block - state->memory);
+    if (state->strategy == DYNAMIC_ALLOCATOR_STRATEGY_TLSF) {
+        return tlsf_allocator_free(&state->tlsf, block);
+    }
+
+    u64 offset = (u64)(block - state->memory);
 
     if (!freelist_free_block(&state->freelist, size, offset)) {
         KERROR("dynamic_allocator_free - cannot free block.");
@@ -96,6 +171,39 @@ b8 dynamic_allocator_free(dynamic_allocator *allocator, void *block, u64 size) {
     return true;
 }
 
+b8 dynamic_allocator_try_extend(dynamic_allocator *allocator, void *block,
+                                u64 old_size, u64 new_size) {
+    if (!allocator || !block || new_size < old_size) {
+        KERROR("dynamic_allocator_try_extend - Requires a valid allocator and "
+               "block, and new_size of at least old_size.");
+        return false;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+
+    if (state->strategy == DYNAMIC_ALLOCATOR_STRATEGY_TLSF) {
+        return tlsf_allocator_try_extend(&state->tlsf, block, new_size);
+    }
+
+    if (new_size == old_size) {
+        return true;
+    }
+
+    u64 offset = (u64)(block - state->memory);
+    return freelist_allocate_block_at(&state->freelist, offset + old_size,
+                                      new_size - old_size);
+}
+
+b8 dynamic_allocator_owns_block(dynamic_allocator *allocator, void *block) {
+    if (!allocator || !allocator->memory) {
+        return false;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    return (u64)block >= (u64)state->memory &&
+           (u64)block < (u64)state->memory + state->memory_size;
+}
+
 u64 dynamic_allocator_free_space(dynamic_allocator *allocator) {
     if (!allocator) {
         KERROR("dynamic_allocator_free_space - Passed in null allocator.");
@@ -103,5 +211,22 @@ u64 dynamic_allocator_free_space(dynamic_allocator *allocator) {
     }
 
     internal_state *state = (internal_state *)allocator->memory;
+    if (state->strategy == DYNAMIC_ALLOCATOR_STRATEGY_TLSF) {
+        return tlsf_allocator_free_space(&state->tlsf);
+    }
     return freelist_free_space(&state->freelist);
 }
+
+u64 dynamic_allocator_largest_free_block(dynamic_allocator *allocator) {
+    if (!allocator) {
+        KERROR("dynamic_allocator_largest_free_block - Passed in null "
+               "allocator.");
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    if (state->strategy == DYNAMIC_ALLOCATOR_STRATEGY_TLSF) {
+        return tlsf_allocator_largest_free_block(&state->tlsf);
+    }
+    return freelist_largest_free_block(&state->freelist);
+}
@@ -9,6 +9,18 @@
 
 #include "defines.h"
 
+/**
+ * @brief The strategy a dynamic allocator uses to track free space.
+ */
+typedef enum dynamic_allocator_strategy {
+    /** @brief A sorted freelist. First fit, O(n) in the number of free
+     * ranges. */
+    DYNAMIC_ALLOCATOR_STRATEGY_FREELIST = 0,
+    /** @brief Two-level segregated fit. O(1) allocate and free with a small
+     * header per block. */
+    DYNAMIC_ALLOCATOR_STRATEGY_TLSF
+} dynamic_allocator_strategy;
+
 /**
  * @brief The dynamic allocator struct.
  */
@@ -33,6 +45,37 @@ KAPI b8 dynamic_allocator_create(u64 total_size, u64 *memory_requirement,
                                  void *memory,
                                  dynamic_allocator *out_allocator);
 
+/**
+ * @brief Creates a dynamic allocator using the given strategy. Should be
+ * called twice; once to get the memory requirement, twice to create the struct.
+ * dynamic_allocator_create uses DYNAMIC_ALLOCATOR_STRATEGY_FREELIST.
+ *
+ * @param strategy The strategy used to track free space.
+ * @param total_size The total_size in bytes that the allocator should hold.
+ * This does not contain state of allocator.
+ * @param memory_requirement A pointer to the amount of memory needed for the
+ * struct.
+ * @param memory A pointer to the memory for the allocator.
+ * @param out_allocator A pointer to hold the allocator.
+ * @return True if successful; other False.
+ */
+KAPI b8 dynamic_allocator_create_with_strategy(
+    dynamic_allocator_strategy strategy, u64 total_size,
+    u64 *memory_requirement, void *memory, dynamic_allocator *out_allocator);
+
+/**
+ * @brief Grows a dynamic allocator in place. Only supported by
+ * DYNAMIC_ALLOCATOR_STRATEGY_TLSF. The memory following the allocator's
+ * current memory requirement must be usable up to the memory requirement for
+ * new_total_size.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param new_total_size The new total size in bytes.
+ * @return True if successful; other False.
+ */
+KAPI b8 dynamic_allocator_grow(dynamic_allocator *allocator,
+                               u64 new_total_size);
+
 /**
  * @brief Destroys a dynamic allocator.
  *
@@ -61,9 +104,41 @@ KAPI void *dynamic_allocator_allocate(dynamic_allocator *allocator, u64 size);
 KAPI b8 dynamic_allocator_free(dynamic_allocator *allocator, void *block,
                                u64 size);
 
+/**
+ * @brief Attempts to grow a block in place, into free space directly after it.
+ * Nothing is copied, and the block's contents are kept.
+ *
+ * @param allocator The allocator struct.
+ * @param block The block to grow.
+ * @param old_size The size the block was allocated with.
+ * @param new_size The new size of the block. Must be at least old_size.
+ * @return True if the block now holds new_size bytes; otherwise False, and the
+ * block is unchanged.
+ */
+KAPI b8 dynamic_allocator_try_extend(dynamic_allocator *allocator, void *block,
+                                     u64 old_size, u64 new_size);
+
+/**
+ * @brief Checks whether a block lies within the memory managed by the
+ * allocator.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param block The block to check.
+ * @return True if the block is inside the allocator's range; otherwise False.
+ */
+KAPI b8 dynamic_allocator_owns_block(dynamic_allocator *allocator, void *block);
+
 /**
  * @brief Gets the amount of free space left in the provided dynamic allocator.
  *
  * @param allocator A pointer to the allocator struct.
  */
 KAPI u64 dynamic_allocator_free_space(dynamic_allocator *allocator);
+
+/**
+ * @brief Gets the size of the largest block that could currently be
+ * allocated from the provided dynamic allocator.
+ *
+ * @param allocator A pointer to the allocator struct.
+ */
+KAPI u64 dynamic_allocator_largest_free_block(dynamic_allocator *allocator);
@@ -0,0 +1,139 @@
+#include "memory/frame_allocator.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "memory/linear_allocator.h"
+
+typedef struct internal_state {
+    u64 frame_size;
+    u8 frame_count;
+    u8 current;
+    linear_allocator frames[FRAME_ALLOCATOR_MAX_FRAMES];
+    u64 last_frame_used;
+    u64 high_water;
+    u64 failed_count;
+} internal_state;
+
+b8 frame_allocator_create(u64 frame_size, u8 frame_count,
+                          u64 *memory_requirement, void *memory,
+                          frame_allocator *out_allocator) {
+    if (!memory_requirement) {
+        KERROR("frame_allocator_create - memory_requirement not passed "
+               "through.");
+        return false;
+    }
+
+    if (!frame_size || !frame_count ||
+        frame_count > FRAME_ALLOCATOR_MAX_FRAMES) {
+        KERROR("frame_allocator_create - frame_size must be non-zero and "
+               "frame_count between 1 and %u. Got %u.",
+               FRAME_ALLOCATOR_MAX_FRAMES, frame_count);
+        return false;
+    }
+
+    u64 frame_requirement = 0;
+    linear_allocator_create(frame_size, &frame_requirement, 0, 0);
+    *memory_requirement =
+        sizeof(internal_state) + frame_requirement * frame_count;
+
+    if (!memory) {
+        return true;
+    }
+
+    if (!out_allocator) {
+        KERROR("frame_allocator_create - Requires out_allocator.");
+        return false;
+    }
+
+    out_allocator->memory = memory;
+
+    internal_state *state = (internal_state *)memory;
+    kzero_memory(state, sizeof(internal_state));
+    state->frame_size = frame_size;
+    state->frame_count = frame_count;
+
+    void *frame_memory = memory + sizeof(internal_state);
+    for (u8 i = 0; i < frame_count; i++) {
+        linear_allocator_create(frame_size, &frame_requirement, frame_memory,
+                                &state->frames[i]);
+        frame_memory += frame_requirement;
+    }
+
+    return true;
+}
+
+void frame_allocator_destroy(frame_allocator *allocator) {
+    if (!allocator || !allocator->memory) {
+        KERROR("frame_allocator_destroy - Passed in null allocator.");
+        return;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    for (u8 i = 0; i < state->frame_count; i++) {
+        linear_allocator_destroy(&state->frames[i]);
+    }
+    allocator->memory = 0;
+}
+
+void frame_allocator_begin_frame(frame_allocator *allocator, u8 frame_index) {
+    if (!allocator || !allocator->memory) {
+        KERROR("frame_allocator_begin_frame - Passed in null allocator.");
+        return;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+
+    // A linear buffer only grows within a frame, so what it used is the
+    // frame's high-water mark.
+    u64 used = linear_allocator_allocated(&state->frames[state->current]);
+    state->last_frame_used = used;
+    if (used > state->high_water) {
+        state->high_water = used;
+    }
+
+    // The index comes from the renderer, so a skipped frame reuses its slot
+    // rather than drifting out of step with the fences.
+    if (frame_index >= state->frame_count) {
+        KERROR("frame_allocator_begin_frame - frame_index %u is out of range "
+               "for %u frames.",
+               frame_index, state->frame_count);
+        frame_index %= state->frame_count;
+    }
+    state->current = frame_index;
+    linear_allocator_reset(&state->frames[state->current]);
+}
+
+void *frame_allocator_allocate(frame_allocator *allocator, u64 size,
+                               u64 alignment) {
+    if (!allocator || !allocator->memory) {
+        KERROR("frame_allocator_allocate - Passed in null allocator.");
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    void *block = linear_allocator_allocate(&state->frames[state->current],
+                                            size, alignment);
+    if (!block) {
+        state->failed_count++;
+    }
+    return block;
+}
+
+void frame_allocator_get_stats(frame_allocator *allocator,
+                               frame_allocator_stats *out_stats) {
+    if (!allocator || !allocator->memory || !out_stats) {
+        KERROR("frame_allocator_get_stats - Requires allocator and "
+               "out_stats.");
+        return;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    out_stats->capacity = state->frame_size;
+    out_stats->used =
+        linear_allocator_allocated(&state->frames[state->current]);
+    out_stats->last_frame_used = state->last_frame_used;
+    out_stats->high_water = out_stats->used > state->high_water
+                                ? out_stats->used
+                                : state->high_water;
+    out_stats->failed_count = state->failed_count;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file frame_allocator.h
+ * @brief Contains a per-frame scratch allocator. Transient data lives in one
+ * of several linear buffers, reset as the frame that used it comes around
+ * again.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief The most buffers a frame allocator can rotate through. */
+#define FRAME_ALLOCATOR_MAX_FRAMES 4
+
+/**
+ * @brief The frame allocator struct. Holds one linear buffer per frame in
+ * flight. Allocation is a pointer bump in the current buffer. Beginning a
+ * frame switches to the buffer of the renderer's frame slot and resets it,
+ * so data stays valid until the GPU has finished with that slot.
+ */
+typedef struct frame_allocator {
+    /** @brief The internal state, followed by the buffers. */
+    void *memory;
+} frame_allocator;
+
+/** @brief Usage numbers for a frame allocator. */
+typedef struct frame_allocator_stats {
+    /** @brief The size of each buffer. */
+    u64 capacity;
+    /** @brief Bytes used so far in the current frame. */
+    u64 used;
+    /** @brief Bytes used by the last completed frame. */
+    u64 last_frame_used;
+    /** @brief The most bytes any frame has used. */
+    u64 high_water;
+    /** @brief Allocations that did not fit in their frame's buffer. */
+    u64 failed_count;
+} frame_allocator_stats;
+
+/**
+ * @brief Creates a frame allocator. Should be called twice; once to get the
+ * memory requirement, twice to create the struct.
+ *
+ * @param frame_size The size of each frame's buffer.
+ * @param frame_count The number of buffers, usually the renderer's maximum
+ * frames in flight. At most FRAME_ALLOCATOR_MAX_FRAMES.
+ * @param memory_requirement A pointer to the amount of memory needed.
+ * @param memory A pointer to the memory for the allocator, or 0.
+ * @param out_allocator A pointer to hold the allocator.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 frame_allocator_create(u64 frame_size, u8 frame_count,
+                               u64 *memory_requirement, void *memory,
+                               frame_allocator *out_allocator);
+
+/**
+ * @brief Destroys a frame allocator. Does not free the memory block.
+ *
+ * @param allocator A pointer to the allocator to destroy.
+ */
+KAPI void frame_allocator_destroy(frame_allocator *allocator);
+
+/**
+ * @brief Starts a new frame. Switches to the buffer for frame_index and resets
+ * it, which invalidates everything allocated the last time that slot was
+ * used. Call only once the renderer has waited for that slot, as
+ * renderer_wait_for_frame does, so the GPU no longer reads the old data.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param frame_index The renderer's frame slot, less than frame_count.
+ */
+KAPI void frame_allocator_begin_frame(frame_allocator *allocator,
+                                      u8 frame_index);
+
+/**
+ * @brief Allocates from the current frame's buffer. The memory is not zeroed.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param size The size to allocate.
+ * @param alignment What to align on, has to be a power of 2.
+ * @return The block of memory if successful; otherwise Null.
+ */
+KAPI void *frame_allocator_allocate(frame_allocator *allocator, u64 size,
+                                    u64 alignment);
+
+/**
+ * @brief Gets the usage numbers of a frame allocator.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param out_stats A pointer to hold the stats.
+ */
+KAPI void frame_allocator_get_stats(frame_allocator *allocator,
+                                    frame_allocator_stats *out_stats);
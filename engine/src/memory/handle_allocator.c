@@ -0,0 +1,258 @@
+#include "memory/handle_allocator.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#define HANDLE_INDEX_MASK ((1U << HANDLE_ALLOCATOR_INDEX_BITS) - 1)
+// Bounds the table scan of one compaction step when little can move.
+#define HANDLE_COMPACT_MAX_VISITS 1024
+// The generation that would make a handle equal INVALID_ID is skipped.
+#define HANDLE_GENERATION_MAX ((1U << (32 - HANDLE_ALLOCATOR_INDEX_BITS)) - 1)
+
+typedef struct handle_entry {
+    // Null while the entry is free.
+    void *block;
+    // The allocation block was aligned within, freed with handle_raw_size.
+    void *raw;
+    u64 size;
+    u32 generation;
+    // Next free entry while the entry is free.
+    u32 next_free;
+} handle_entry;
+
+typedef struct internal_state {
+    dynamic_allocator *backing;
+    u32 max_handle_count;
+    u32 free_head;
+    // Where the next compaction step resumes.
+    u32 compact_cursor;
+    handle_entry *entries;
+} internal_state;
+
+// Blocks are aligned here rather than by a header in the backing allocator,
+// so nothing outside the table describes them.
+static u64 handle_raw_size(u64 size) {
+    return size + HANDLE_ALLOCATOR_ALIGNMENT - 1;
+}
+
+static void *handle_align(void *raw) {
+    return (void *)(((u64)raw + HANDLE_ALLOCATOR_ALIGNMENT - 1) &
+                    ~(u64)(HANDLE_ALLOCATOR_ALIGNMENT - 1));
+}
+
+static void handle_release(internal_state *state, handle_entry *entry) {
+    dynamic_allocator_free(state->backing, entry->raw,
+                           handle_raw_size(entry->size));
+}
+
+static u32 handle_make(u32 index, u32 generation) {
+    return (generation << HANDLE_ALLOCATOR_INDEX_BITS) | index;
+}
+
+static handle_entry *handle_lookup(internal_state *state, u32 handle) {
+    u32 index = handle & HANDLE_INDEX_MASK;
+    if (handle == INVALID_ID || index >= state->max_handle_count) {
+        return 0;
+    }
+
+    handle_entry *entry = &state->entries[index];
+    if (!entry->block ||
+        entry->generation != handle >> HANDLE_ALLOCATOR_INDEX_BITS) {
+        return 0;
+    }
+    return entry;
+}
+
+b8 handle_allocator_create(dynamic_allocator *backing, u32 max_handle_count,
+                           u64 *memory_requirement, void *memory,
+                           handle_allocator *out_allocator) {
+    if (!memory_requirement) {
+        KERROR("handle_allocator_create - memory_requirement not passed "
+               "through.");
+        return false;
+    }
+
+    if (!max_handle_count || max_handle_count > HANDLE_ALLOCATOR_MAX_HANDLES) {
+        KERROR("handle_allocator_create - max_handle_count must be between 1 "
+               "and %u. Got %u.",
+               HANDLE_ALLOCATOR_MAX_HANDLES, max_handle_count);
+        return false;
+    }
+
+    *memory_requirement =
+        sizeof(internal_state) + sizeof(handle_entry) * max_handle_count;
+
+    if (!memory) {
+        return true;
+    }
+
+    if (!backing || !out_allocator) {
+        KERROR("handle_allocator_create - requires backing and out_allocator.");
+        return false;
+    }
+
+    out_allocator->memory = memory;
+
+    internal_state *state = (internal_state *)memory;
+    state->backing = backing;
+    state->max_handle_count = max_handle_count;
+    state->free_head = 0;
+    state->compact_cursor = 0;
+    state->entries = (handle_entry *)(memory + sizeof(internal_state));
+
+    for (u32 i = 0; i < max_handle_count; i++) {
+        state->entries[i].block = 0;
+        state->entries[i].raw = 0;
+        state->entries[i].size = 0;
+        state->entries[i].generation = 0;
+        state->entries[i].next_free = i + 1 < max_handle_count ? i + 1
+                                                               : INVALID_ID;
+    }
+
+    return true;
+}
+
+void handle_allocator_destroy(handle_allocator *allocator) {
+    if (!allocator || !allocator->memory) {
+        KERROR("handle_allocator_destroy - Passed in null allocator.");
+        return;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    for (u32 i = 0; i < state->max_handle_count; i++) {
+        if (state->entries[i].block) {
+            handle_release(state, &state->entries[i]);
+        }
+    }
+    allocator->memory = 0;
+}
+
+u32 handle_allocator_allocate(handle_allocator *allocator, u64 size) {
+    if (!allocator || !allocator->memory || !size) {
+        KERROR("handle_allocator_allocate - Requires a valid allocator and a "
+               "non-zero size.");
+        return INVALID_ID;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    if (state->free_head == INVALID_ID) {
+        KERROR("handle_allocator_allocate - All %u handles are in use.",
+               state->max_handle_count);
+        return INVALID_ID;
+    }
+
+    void *raw =
+        dynamic_allocator_allocate(state->backing, handle_raw_size(size));
+    if (!raw) {
+        return INVALID_ID;
+    }
+    void *block = handle_align(raw);
+    kzero_memory(block, size);
+
+    u32 index = state->free_head;
+    handle_entry *entry = &state->entries[index];
+    state->free_head = entry->next_free;
+    entry->block = block;
+    entry->raw = raw;
+    entry->size = size;
+    entry->next_free = INVALID_ID;
+    return handle_make(index, entry->generation);
+}
+
+b8 handle_allocator_free(handle_allocator *allocator, u32 handle) {
+    if (!allocator || !allocator->memory) {
+        KERROR("handle_allocator_free - Passed in null allocator.");
+        return false;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    handle_entry *entry = handle_lookup(state, handle);
+    if (!entry) {
+        KERROR("handle_allocator_free - Handle %u is not live.", handle);
+        return false;
+    }
+
+    handle_release(state, entry);
+    entry->block = 0;
+    entry->raw = 0;
+    entry->size = 0;
+    // Older copies of the handle stop matching.
+    entry->generation = (entry->generation + 1) % HANDLE_GENERATION_MAX;
+    entry->next_free = state->free_head;
+    state->free_head = handle & HANDLE_INDEX_MASK;
+    return true;
+}
+
+void *handle_allocator_get(handle_allocator *allocator, u32 handle) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+
+    handle_entry *entry =
+        handle_lookup((internal_state *)allocator->memory, handle);
+    return entry ? entry->block : 0;
+}
+
+u64 handle_allocator_size(handle_allocator *allocator, u32 handle) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+
+    handle_entry *entry =
+        handle_lookup((internal_state *)allocator->memory, handle);
+    return entry ? entry->size : 0;
+}
+
+u64 handle_allocator_compact(handle_allocator *allocator, u64 max_bytes) {
+    if (!allocator || !allocator->memory) {
+        KERROR("handle_allocator_compact - Passed in null allocator.");
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+
+    // Blocks that cannot fit anywhere are skipped rather than attempted, so a
+    // full backing allocator does not log a failure per block. The margin
+    // covers the alignment padding and size-class rounding in the backing.
+    u64 largest = dynamic_allocator_largest_free_block(state->backing);
+
+    u32 max_visits = state->max_handle_count < HANDLE_COMPACT_MAX_VISITS
+                         ? state->max_handle_count
+                         : HANDLE_COMPACT_MAX_VISITS;
+    u64 moved = 0;
+    for (u32 visited = 0; visited < max_visits && moved < max_bytes;
+         visited++) {
+        handle_entry *entry = &state->entries[state->compact_cursor];
+        state->compact_cursor =
+            (state->compact_cursor + 1) % state->max_handle_count;
+
+        if (!entry->block || moved + entry->size > max_bytes) {
+            continue;
+        }
+        u64 needed = entry->size + HANDLE_ALLOCATOR_ALIGNMENT * 2;
+        if (needed + needed / 8 > largest) {
+            continue;
+        }
+
+        u64 raw_size = handle_raw_size(entry->size);
+        void *raw = dynamic_allocator_allocate(state->backing, raw_size);
+        if (!raw) {
+            break;
+        }
+        if (raw > entry->raw) {
+            // The backing allocator found nothing lower; leave it be.
+            dynamic_allocator_free(state->backing, raw, raw_size);
+            continue;
+        }
+
+        void *target = handle_align(raw);
+        kcopy_memory(target, entry->block, entry->size);
+        handle_release(state, entry);
+        entry->block = target;
+        entry->raw = raw;
+        moved += entry->size;
+        largest = dynamic_allocator_largest_free_block(state->backing);
+    }
+
+    return moved;
+}
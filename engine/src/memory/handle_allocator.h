@@ -0,0 +1,107 @@
+/**
+ * @file handle_allocator.h
+ * @brief Contains a handle-based allocator. Blocks are reached through
+ * generation-checked handles, so they can be moved to undo fragmentation in
+ * the backing dynamic allocator.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+#include "memory/dynamic_allocator.h"
+
+/** @brief Bits of a handle holding the table index. The rest hold the
+ * generation. */
+#define HANDLE_ALLOCATOR_INDEX_BITS 20
+/** @brief The most handles a single allocator can have live. */
+#define HANDLE_ALLOCATOR_MAX_HANDLES ((1U << HANDLE_ALLOCATOR_INDEX_BITS) - 1)
+/** @brief Alignment of every block. */
+#define HANDLE_ALLOCATOR_ALIGNMENT 16
+
+/**
+ * @brief The handle allocator struct. Each handle is a 32-bit table index and
+ * generation; the table entry holds where the block currently lives. Stale
+ * handles are rejected once the entry has been freed or reused.
+ */
+typedef struct handle_allocator {
+    /** @brief The internal state, followed by the handle table. */
+    void *memory;
+} handle_allocator;
+
+/**
+ * @brief Creates a handle allocator. Should be called twice; once to get the
+ * memory requirement, twice to create the struct.
+ *
+ * @param backing The dynamic allocator blocks are taken from. Must outlive the
+ * handle allocator.
+ * @param max_handle_count The most handles live at once. At most
+ * HANDLE_ALLOCATOR_MAX_HANDLES.
+ * @param memory_requirement A pointer to the amount of memory needed.
+ * @param memory A pointer to the memory for the allocator, or 0.
+ * @param out_allocator A pointer to hold the allocator.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 handle_allocator_create(dynamic_allocator *backing,
+                                u32 max_handle_count, u64 *memory_requirement,
+                                void *memory, handle_allocator *out_allocator);
+
+/**
+ * @brief Destroys a handle allocator, returning every live block to the
+ * backing allocator. Does not free the memory block.
+ *
+ * @param allocator A pointer to the allocator to destroy.
+ */
+KAPI void handle_allocator_destroy(handle_allocator *allocator);
+
+/**
+ * @brief Allocates a zeroed block and returns a handle to it.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param size The size to allocate.
+ * @return The handle if successful; otherwise INVALID_ID.
+ */
+KAPI u32 handle_allocator_allocate(handle_allocator *allocator, u64 size);
+
+/**
+ * @brief Frees the block behind a handle. The handle, and any copies of it,
+ * become invalid.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param handle The handle to free.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 handle_allocator_free(handle_allocator *allocator, u32 handle);
+
+/**
+ * @brief Gets where the block behind a handle currently lives. The pointer is
+ * only valid until the next call to handle_allocator_compact.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param handle The handle to resolve.
+ * @return The block if the handle is live; otherwise Null.
+ */
+KAPI void *handle_allocator_get(handle_allocator *allocator, u32 handle);
+
+/**
+ * @brief Gets the size a handle was allocated with.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param handle The handle.
+ * @return The size if the handle is live; otherwise 0.
+ */
+KAPI u64 handle_allocator_size(handle_allocator *allocator, u32 handle);
+
+/**
+ * @brief Runs one incremental compaction step. Blocks are visited in turn,
+ * continuing where the previous step stopped, and each is moved if the
+ * backing allocator can place it at a lower address. Moving stops once
+ * max_bytes have been copied; blocks larger than max_bytes never move.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param max_bytes The most bytes to copy in this step.
+ * @return The number of bytes moved.
+ */
+KAPI u64 handle_allocator_compact(handle_allocator *allocator, u64 max_bytes);
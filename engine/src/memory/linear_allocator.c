@@ -2,13 +2,43 @@
 
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "platform/platform.h"
 
 typedef struct internal_state {
     u64 total_size;
     u64 allocated;
     void *memory;
+    // Set for allocators that own a reserved virtual range. The state sits at
+    // the start of the range, followed by memory.
+    b8 is_virtual;
+    b8 huge_pages;
+    u64 committed;
+    u64 commit_granularity;
+    u64 reserved;
 } internal_state;
 
+static u64 round_up(u64 value, u64 granularity) {
+    return ((value + granularity - 1) / granularity) * granularity;
+}
+
+// Commits enough of a virtual allocator's range to hold required bytes of
+// memory.
+static b8 linear_allocator_commit(internal_state *state, u64 required) {
+    u64 end = round_up(sizeof(internal_state) + required,
+                       state->commit_granularity);
+    if (end > state->reserved) {
+        end = state->reserved;
+    }
+
+    u64 committed_end = sizeof(internal_state) + state->committed;
+    if (!platform_memory_commit((void *)state + committed_end,
+                                end - committed_end, state->huge_pages)) {
+        return false;
+    }
+    state->committed = end - sizeof(internal_state);
+    return true;
+}
+
 void linear_allocator_create(u64 total_size, u64 *memory_requirement,
                              void *memory, linear_allocator *out_allocator) {
     if (!memory_requirement) {
@@ -26,9 +56,59 @@ void linear_allocator_create(u64 total_size, u64 *memory_requirement,
     out_allocator->memory = memory;
 
     internal_state *state = (internal_state *)out_allocator->memory;
+    kzero_memory(state, sizeof(internal_state));
     state->total_size = total_size;
     state->allocated = 0;
     state->memory = (void *)(out_allocator->memory + sizeof(internal_state));
+    state->committed = total_size;
+}
+
+b8 linear_allocator_create_virtual(u64 reserve_size, u64 commit_granularity,
+                                   linear_allocator *out_allocator) {
+    if (!out_allocator || !reserve_size) {
+        KERROR("linear_allocator_create_virtual - Requires out_allocator and "
+               "a non-zero reserve_size.");
+        return false;
+    }
+
+    u64 page_size = platform_memory_page_size();
+    u64 granularity = round_up(commit_granularity ? commit_granularity : 1,
+                               page_size);
+    u64 reserved =
+        round_up(sizeof(internal_state) + reserve_size, granularity);
+
+    void *base = platform_memory_reserve(reserved);
+    if (!base) {
+        return false;
+    }
+
+    b8 huge_pages = (granularity % PLATFORM_HUGE_PAGE_SIZE) == 0;
+    if (!platform_memory_commit(base, granularity, huge_pages)) {
+        platform_memory_release(base, reserved);
+        return false;
+    }
+
+    internal_state *state = (internal_state *)base;
+    state->total_size = reserve_size;
+    state->allocated = 0;
+    state->memory = base + sizeof(internal_state);
+    state->is_virtual = true;
+    state->huge_pages = huge_pages;
+    state->committed = granularity - sizeof(internal_state);
+    state->commit_granularity = granularity;
+    state->reserved = reserved;
+
+    out_allocator->memory = base;
+    return true;
+}
+
+u64 linear_allocator_committed(linear_allocator *allocator) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    return state->committed;
 }
 
 void linear_allocator_destroy(linear_allocator *allocator) {
@@ -37,6 +117,12 @@ void linear_allocator_destroy(linear_allocator *allocator) {
     }
 
     internal_state *state = (internal_state *)allocator->memory;
+    if (state->is_virtual) {
+        platform_memory_release(allocator->memory, state->reserved);
+        allocator->memory = 0;
+        return;
+    }
+
     state->total_size = 0;
     state->allocated = 0;
     state->memory = 0;
@@ -75,6 +161,14 @@ void *linear_allocator_allocate(linear_allocator *allocator, u64 size,
         return 0;
     }
 
+    if (state->allocated + total_size > state->committed &&
+        !linear_allocator_commit(state, state->allocated + total_size)) {
+        KERROR("linear_allocator_allocate - Failed to commit memory for "
+               "%lluB.",
+               total_size);
+        return 0;
+    }
+
     state->allocated += total_size;
     return (void *)aligned_address;
 }
@@ -88,5 +182,38 @@ void linear_allocator_free_all(linear_allocator *allocator) {
 
     internal_state *state = (internal_state *)allocator->memory;
     state->allocated = 0;
+
+    if (state->is_virtual) {
+        // Hand everything past the first commit back; it reads as zero when
+        // committed again.
+        u64 first = state->commit_granularity - sizeof(internal_state);
+        if (state->committed > first) {
+            platform_memory_decommit(state->memory + first,
+                                     state->committed - first);
+            state->committed = first;
+        }
+        kzero_memory(state->memory, first);
+        return;
+    }
+
     kzero_memory(state->memory, state->total_size);
 }
+
+void linear_allocator_reset(linear_allocator *allocator) {
+    if (!allocator || !allocator->memory) {
+        KERROR("linear_allocator_reset - Provided allocator not initialized");
+        return;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    state->allocated = 0;
+}
+
+u64 linear_allocator_allocated(linear_allocator *allocator) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    return state->allocated;
+}
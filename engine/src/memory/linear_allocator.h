@@ -26,9 +26,33 @@ KAPI void linear_allocator_create(u64 total_size, u64 *memory_requirement,
                                   void *memory,
                                   linear_allocator *out_allocator);
 
+/**
+ * @brief Creates a linear_allocator that owns a reserved range of address
+ * space. Memory is committed in commit_granularity steps as allocations reach
+ * it, so reserve_size can be far larger than what is ever used.
+ *
+ * @param reserve_size The most the allocator can hand out.
+ * @param commit_granularity Bytes committed at a time, rounded up to the page
+ * size. 0 commits a page at a time. Multiples of PLATFORM_HUGE_PAGE_SIZE ask
+ * for huge pages.
+ * @param out_allocator A pointer to the allocator.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 linear_allocator_create_virtual(u64 reserve_size,
+                                        u64 commit_granularity,
+                                        linear_allocator *out_allocator);
+
+/**
+ * @brief Gets the number of bytes currently backed by memory. For allocators
+ * not created with linear_allocator_create_virtual, this is the total size.
+ *
+ * @param allocator A pointer to the allocator struct.
+ */
+KAPI u64 linear_allocator_committed(linear_allocator *allocator);
+
 /**
  * @brief Destroys the linear allocator struct. Does not own memory, and does
- * not destroy memory.
+ * not destroy memory. Virtual allocators release their reserved range.
  *
  * @param allocator A pointer to the allocator struct.
  */
@@ -46,8 +70,25 @@ KAPI void *linear_allocator_allocate(linear_allocator *allocator, u64 size,
                                      u64 alignment);
 
 /**
- * @brief Resets the linear_allocator struct and zeros out memory.
+ * @brief Resets the linear_allocator struct and zeros out memory. Virtual
+ * allocators decommit everything past the first commit instead.
  *
  * @param allocator A pointer to the allocator struct.
  */
 KAPI void linear_allocator_free_all(linear_allocator *allocator);
+
+/**
+ * @brief Resets the linear_allocator struct without touching memory, so the
+ * next allocations hand back whatever was left there.
+ *
+ * @param allocator A pointer to the allocator struct.
+ */
+KAPI void linear_allocator_reset(linear_allocator *allocator);
+
+/**
+ * @brief Gets the number of bytes allocated, including alignment padding,
+ * since the last reset.
+ *
+ * @param allocator A pointer to the allocator struct.
+ */
+KAPI u64 linear_allocator_allocated(linear_allocator *allocator);
@@ -0,0 +1,174 @@
+#include "memory/slab_allocator.h"
+
+#include "core/logger.h"
+#include "core/utils.h"
+
+typedef struct slab_block {
+    struct slab_block *next;
+} slab_block;
+
+// Sits at the start of every page taken from the backing allocator.
+typedef struct slab_page {
+    struct slab_page *next;
+} slab_page;
+
+typedef struct internal_state {
+    dynamic_allocator *backing;
+    slab_block *free_lists[SLAB_ALLOCATOR_CLASS_COUNT];
+    slab_page *pages;
+    u64 page_count;
+} internal_state;
+
+u32 slab_allocator_class_index(u64 size) {
+    if (size <= SLAB_ALLOCATOR_MIN_SIZE) {
+        return 0;
+    }
+    // ceil(log2(size)) - log2(SLAB_ALLOCATOR_MIN_SIZE)
+    return (u32)(64 - kclz_u64(size - 1)) - 4;
+}
+
+u64 slab_allocator_class_size(u32 index) {
+    return (u64)SLAB_ALLOCATOR_MIN_SIZE << index;
+}
+
+static b8 slab_refill(internal_state *state, u32 index) {
+    void *raw =
+        dynamic_allocator_allocate(state->backing, SLAB_ALLOCATOR_PAGE_SIZE);
+    if (!raw) {
+        return false;
+    }
+
+    slab_page *page = raw;
+    page->next = state->pages;
+    state->pages = page;
+    state->page_count++;
+
+    // Carve the rest of the page into blocks, 16 byte aligned.
+    u64 block_size = slab_allocator_class_size(index);
+    u64 start = ((u64)raw + sizeof(slab_page) + 15) & ~(u64)15;
+    u64 end = (u64)raw + SLAB_ALLOCATOR_PAGE_SIZE;
+
+    slab_block *head = state->free_lists[index];
+    for (u64 addr = start; addr + block_size <= end; addr += block_size) {
+        slab_block *block = (slab_block *)addr;
+        block->next = head;
+        head = block;
+    }
+    state->free_lists[index] = head;
+
+    return true;
+}
+
+b8 slab_allocator_create(dynamic_allocator *backing, u64 *memory_requirement,
+                         void *memory, slab_allocator *out_allocator) {
+    if (!memory_requirement) {
+        KERROR(
+            "slab_allocator_create - memory_requirement not passed through.");
+        return false;
+    }
+
+    *memory_requirement = sizeof(internal_state);
+
+    if (!memory) {
+        return true;
+    }
+
+    if (!backing || !out_allocator) {
+        KERROR("slab_allocator_create - requires backing and out_allocator.");
+        return false;
+    }
+
+    out_allocator->memory = memory;
+
+    internal_state *state = (internal_state *)out_allocator->memory;
+    state->backing = backing;
+    for (u32 i = 0; i < SLAB_ALLOCATOR_CLASS_COUNT; i++) {
+        state->free_lists[i] = 0;
+    }
+    state->pages = 0;
+    state->page_count = 0;
+
+    return true;
+}
+
+b8 slab_allocator_destroy(slab_allocator *allocator) {
+    if (!allocator || !allocator->memory) {
+        KERROR("slab_allocator_destroy - Passed in null allocator.");
+        return false;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+
+    slab_page *page = state->pages;
+    while (page) {
+        slab_page *next = page->next;
+        dynamic_allocator_free(state->backing, page, SLAB_ALLOCATOR_PAGE_SIZE);
+        page = next;
+    }
+
+    for (u32 i = 0; i < SLAB_ALLOCATOR_CLASS_COUNT; i++) {
+        state->free_lists[i] = 0;
+    }
+    state->pages = 0;
+    state->page_count = 0;
+    allocator->memory = 0;
+    return true;
+}
+
+void *slab_allocator_allocate(slab_allocator *allocator, u64 size) {
+    if (!allocator || !allocator->memory) {
+        KERROR("slab_allocator_allocate - Passed in null allocator.");
+        return 0;
+    }
+
+    if (size > SLAB_ALLOCATOR_MAX_SIZE) {
+        KERROR("slab_allocator_allocate - size %lluB is above the largest size "
+               "class (%uB).",
+               size, SLAB_ALLOCATOR_MAX_SIZE);
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    u32 index = slab_allocator_class_index(size);
+
+    if (!state->free_lists[index] && !slab_refill(state, index)) {
+        KERROR("slab_allocator_allocate - backing allocator is out of space.");
+        return 0;
+    }
+
+    slab_block *block = state->free_lists[index];
+    state->free_lists[index] = block->next;
+    return block;
+}
+
+b8 slab_allocator_free(slab_allocator *allocator, void *block, u64 size) {
+    if (!allocator || !allocator->memory || !block) {
+        KERROR("slab_allocator_free - Passed in null allocator or block.");
+        return false;
+    }
+
+    if (size > SLAB_ALLOCATOR_MAX_SIZE) {
+        KERROR("slab_allocator_free - size %lluB is above the largest size "
+               "class (%uB).",
+               size, SLAB_ALLOCATOR_MAX_SIZE);
+        return false;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    u32 index = slab_allocator_class_index(size);
+
+    slab_block *freed = block;
+    freed->next = state->free_lists[index];
+    state->free_lists[index] = freed;
+    return true;
+}
+
+u64 slab_allocator_page_count(slab_allocator *allocator) {
+    if (!allocator || !allocator->memory) {
+        KERROR("slab_allocator_page_count - Passed in null allocator.");
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    return state->page_count;
+}
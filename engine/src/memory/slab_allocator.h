@@ -0,0 +1,100 @@
+/**
+ * @file slab_allocator.h
+ * @brief Contains a segregated size-class slab allocator, used in front of the
+ * dynamic allocator for small blocks.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+#include "memory/dynamic_allocator.h"
+
+/** @brief The smallest size class, in bytes. */
+#define SLAB_ALLOCATOR_MIN_SIZE 16
+/** @brief The largest size class, in bytes. Larger blocks are not handled. */
+#define SLAB_ALLOCATOR_MAX_SIZE 4096
+/** @brief Number of power-of-two size classes from min to max. */
+#define SLAB_ALLOCATOR_CLASS_COUNT 9
+/** @brief Size of each page carved into blocks, taken from the backing. */
+#define SLAB_ALLOCATOR_PAGE_SIZE (64 * 1024)
+
+/**
+ * @brief The slab allocator struct. Each size class keeps an intrusive free
+ * list of blocks, refilled a page at a time from the backing allocator, so
+ * allocate and free are O(1).
+ */
+typedef struct slab_allocator {
+    /** @brief The internal state of the allocator. */
+    void *memory;
+} slab_allocator;
+
+/**
+ * @brief Creates a slab allocator. Should be called twice; once to get the
+ * memory requirement, twice to create the struct.
+ *
+ * @param backing The dynamic allocator pages are taken from. Must outlive the
+ * slab allocator.
+ * @param memory_requirement A pointer to the amount of memory needed for the
+ * struct.
+ * @param memory A pointer to the memory for the allocator.
+ * @param out_allocator A pointer to hold the allocator.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 slab_allocator_create(dynamic_allocator *backing,
+                              u64 *memory_requirement, void *memory,
+                              slab_allocator *out_allocator);
+
+/**
+ * @brief Destroys a slab allocator, returning all pages to the backing
+ * allocator.
+ *
+ * @param allocator A pointer to the allocator to destroy.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 slab_allocator_destroy(slab_allocator *allocator);
+
+/**
+ * @brief Allocates a block from the size class fitting size. Blocks are 16 byte
+ * aligned.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param size The size to allocate, at most SLAB_ALLOCATOR_MAX_SIZE.
+ * @return The block of memory if successful; otherwise Null.
+ */
+KAPI void *slab_allocator_allocate(slab_allocator *allocator, u64 size);
+
+/**
+ * @brief Returns a block to its size class.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param block The block to free.
+ * @param size The size the block was allocated with.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 slab_allocator_free(slab_allocator *allocator, void *block, u64 size);
+
+/**
+ * @brief Gets the index of the size class that serves blocks of size.
+ *
+ * @param size The size, at most SLAB_ALLOCATOR_MAX_SIZE.
+ * @return The class index, less than SLAB_ALLOCATOR_CLASS_COUNT.
+ */
+KAPI u32 slab_allocator_class_index(u64 size);
+
+/**
+ * @brief Gets the block size of a size class.
+ *
+ * @param index The class index.
+ * @return The size of every block in the class.
+ */
+KAPI u64 slab_allocator_class_size(u32 index);
+
+/**
+ * @brief Gets the number of pages taken from the backing allocator.
+ *
+ * @param allocator A pointer to the allocator struct.
+ */
+KAPI u64 slab_allocator_page_count(slab_allocator *allocator);
@@ -0,0 +1,405 @@
+#include "memory/tlsf_allocator.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "core/utils.h"
+
+// Second level lists per first level range: 2^5 = 32.
+#define TLSF_SL_LOG2 5
+#define TLSF_SL_COUNT (1 << TLSF_SL_LOG2)
+#define TLSF_ALIGN_LOG2 4
+// Below this size the first level is 0 and the second level is linear in
+// steps of TLSF_ALLOCATOR_ALIGNMENT.
+#define TLSF_FL_SHIFT (TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_SMALL_BLOCK_SIZE (1ULL << TLSF_FL_SHIFT)
+// Blocks up to 2^40 bytes (1 TiB).
+#define TLSF_FL_MAX_LOG2 39
+#define TLSF_FL_COUNT (TLSF_FL_MAX_LOG2 - TLSF_FL_SHIFT + 2)
+#define TLSF_MAX_BLOCK_SIZE (1ULL << (TLSF_FL_MAX_LOG2 + 1))
+
+#define TLSF_BLOCK_FREE 1ULL
+#define TLSF_SIZE_MASK (~(u64)(TLSF_ALLOCATOR_ALIGNMENT - 1))
+
+typedef struct tlsf_block {
+    // Payload size, with TLSF_BLOCK_FREE packed into the low bit.
+    u64 size;
+    struct tlsf_block *prev_phys;
+    // Only valid while the block is free. Overlaps the payload.
+    struct tlsf_block *next_free;
+    struct tlsf_block *prev_free;
+} tlsf_block;
+
+#define TLSF_HEADER_SIZE (sizeof(u64) + sizeof(tlsf_block *))
+#define TLSF_MIN_BLOCK_SIZE (sizeof(tlsf_block) - TLSF_HEADER_SIZE)
+
+typedef struct internal_state {
+    u64 total_size;
+    u64 free_space;
+    u32 fl_bitmap;
+    u32 sl_bitmap[TLSF_FL_COUNT];
+    tlsf_block *blocks[TLSF_FL_COUNT][TLSF_SL_COUNT];
+    tlsf_block *first;
+    // Zero sized, always used block past the end of the pool. Stops merges.
+    tlsf_block *sentinel;
+} internal_state;
+
+static u64 align_up(u64 value) {
+    return (value + TLSF_ALLOCATOR_ALIGNMENT - 1) & TLSF_SIZE_MASK;
+}
+
+static u64 block_size(const tlsf_block *block) {
+    return block->size & TLSF_SIZE_MASK;
+}
+
+static b8 block_is_free(const tlsf_block *block) {
+    return (block->size & TLSF_BLOCK_FREE) != 0;
+}
+
+static void block_set_size(tlsf_block *block, u64 size) {
+    block->size = size | (block->size & TLSF_BLOCK_FREE);
+}
+
+static tlsf_block *block_next(const tlsf_block *block) {
+    return (tlsf_block *)((u8 *)block + TLSF_HEADER_SIZE + block_size(block));
+}
+
+static u32 floor_log2(u64 value) { return 63 - (u32)kclz_u64(value); }
+
+static void mapping_insert(u64 size, u32 *fl, u32 *sl) {
+    if (size < TLSF_SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = (u32)(size >> TLSF_ALIGN_LOG2);
+    } else {
+        u32 f = floor_log2(size);
+        *sl = (u32)(size >> (f - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+        *fl = f - (TLSF_FL_SHIFT - 1);
+    }
+}
+
+// Rounds size up to the next list boundary, so any block in the resulting
+// list is large enough.
+static void mapping_search(u64 size, u32 *fl, u32 *sl) {
+    if (size >= TLSF_SMALL_BLOCK_SIZE) {
+        size += (1ULL << (floor_log2(size) - TLSF_SL_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static tlsf_block *find_suitable(internal_state *state, u32 *fl, u32 *sl) {
+    u32 sl_map = state->sl_bitmap[*fl] & (~0U << *sl);
+    if (!sl_map) {
+        // Nothing in this first level range; take the next non-empty one.
+        if (*fl + 1 >= TLSF_FL_COUNT) {
+            return 0;
+        }
+        u32 fl_map = state->fl_bitmap & (~0U << (*fl + 1));
+        if (!fl_map) {
+            return 0;
+        }
+        *fl = (u32)kctz_u64(fl_map);
+        sl_map = state->sl_bitmap[*fl];
+    }
+    *sl = (u32)kctz_u64(sl_map);
+    return state->blocks[*fl][*sl];
+}
+
+static void insert_free(internal_state *state, tlsf_block *block) {
+    u32 fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+
+    tlsf_block *head = state->blocks[fl][sl];
+    block->next_free = head;
+    block->prev_free = 0;
+    if (head) {
+        head->prev_free = block;
+    }
+    state->blocks[fl][sl] = block;
+    state->fl_bitmap |= 1U << fl;
+    state->sl_bitmap[fl] |= 1U << sl;
+
+    block->size |= TLSF_BLOCK_FREE;
+    state->free_space += block_size(block);
+}
+
+static void remove_free(internal_state *state, tlsf_block *block) {
+    u32 fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    }
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+    if (state->blocks[fl][sl] == block) {
+        state->blocks[fl][sl] = block->next_free;
+        if (!block->next_free) {
+            state->sl_bitmap[fl] &= ~(1U << sl);
+            if (!state->sl_bitmap[fl]) {
+                state->fl_bitmap &= ~(1U << fl);
+            }
+        }
+    }
+
+    block->size &= ~TLSF_BLOCK_FREE;
+    state->free_space -= block_size(block);
+}
+
+// Merges a block with any free neighbours and puts it on the free lists.
+static void block_release(internal_state *state, tlsf_block *block) {
+    tlsf_block *prev = block->prev_phys;
+    if (prev && block_is_free(prev)) {
+        remove_free(state, prev);
+        block_set_size(prev,
+                       block_size(prev) + TLSF_HEADER_SIZE + block_size(block));
+        block = prev;
+        block_next(block)->prev_phys = block;
+    }
+
+    tlsf_block *next = block_next(block);
+    if (block_is_free(next)) {
+        remove_free(state, next);
+        block_set_size(block,
+                       block_size(block) + TLSF_HEADER_SIZE + block_size(next));
+        block_next(block)->prev_phys = block;
+    }
+
+    insert_free(state, block);
+}
+
+// Splits off the end of a used block past size, if it can hold a block of its
+// own, and puts it on the free lists.
+static void block_trim(internal_state *state, tlsf_block *block, u64 size) {
+    if (block_size(block) < size + TLSF_HEADER_SIZE + TLSF_MIN_BLOCK_SIZE) {
+        return;
+    }
+
+    tlsf_block *remaining =
+        (tlsf_block *)((u8 *)block + TLSF_HEADER_SIZE + size);
+    remaining->size = block_size(block) - size - TLSF_HEADER_SIZE;
+    remaining->prev_phys = block;
+    block_next(remaining)->prev_phys = remaining;
+    block_set_size(block, size);
+    block_release(state, remaining);
+}
+
+b8 tlsf_allocator_create(u64 total_size, u64 *memory_requirement,
+                         void *memory, tlsf_allocator *out_allocator) {
+    if (total_size < TLSF_MIN_BLOCK_SIZE ||
+        total_size >= TLSF_MAX_BLOCK_SIZE) {
+        KERROR("tlsf_allocator_create - total_size must be between %lluB and "
+               "%lluB.",
+               (u64)TLSF_MIN_BLOCK_SIZE, TLSF_MAX_BLOCK_SIZE);
+        return false;
+    }
+
+    if (!memory_requirement) {
+        KERROR(
+            "tlsf_allocator_create - memory_requirement not passed through.");
+        return false;
+    }
+
+    // State, alignment slack, first block header, pool, sentinel header.
+    *memory_requirement = sizeof(internal_state) + TLSF_ALLOCATOR_ALIGNMENT -
+                          1 + TLSF_HEADER_SIZE + align_up(total_size) +
+                          TLSF_HEADER_SIZE;
+
+    if (!memory) {
+        return true;
+    }
+
+    if (!out_allocator) {
+        KERROR("tlsf_allocator_create - out_allocator not passed through.");
+        return false;
+    }
+
+    out_allocator->memory = memory;
+    internal_state *state = (internal_state *)memory;
+    kzero_memory(state, sizeof(internal_state));
+    state->total_size = align_up(total_size);
+
+    // The header is 16 bytes, so aligning the header aligns the payload.
+    u64 pool = align_up((u64)memory + sizeof(internal_state));
+    state->first = (tlsf_block *)pool;
+    state->first->size = state->total_size;
+    state->first->prev_phys = 0;
+
+    state->sentinel = block_next(state->first);
+    state->sentinel->size = 0;
+    state->sentinel->prev_phys = state->first;
+
+    insert_free(state, state->first);
+    return true;
+}
+
+b8 tlsf_allocator_destroy(tlsf_allocator *allocator) {
+    if (!allocator || !allocator->memory) {
+        KWARN("tlsf_allocator_destroy - Passed in null allocator.");
+        return false;
+    }
+
+    kzero_memory(allocator->memory, sizeof(internal_state));
+    allocator->memory = 0;
+    return true;
+}
+
+void *tlsf_allocator_allocate(tlsf_allocator *allocator, u64 size) {
+    if (!allocator || !allocator->memory || !size) {
+        KERROR("tlsf_allocator_allocate - Requires a valid allocator and "
+               "size.");
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+
+    u64 adjusted = size < TLSF_MIN_BLOCK_SIZE ? TLSF_MIN_BLOCK_SIZE : size;
+    adjusted = align_up(adjusted);
+
+    tlsf_block *block = 0;
+    if (adjusted < TLSF_MAX_BLOCK_SIZE) {
+        u32 fl, sl;
+        mapping_search(adjusted, &fl, &sl);
+        if (fl < TLSF_FL_COUNT) {
+            block = find_suitable(state, &fl, &sl);
+        }
+    }
+
+    if (!block) {
+        KERROR("tlsf_allocator_allocate - No blocks of memory large enough to "
+               "allocate from.");
+        KERROR("Requested size: %llu, total space available: %llu", size,
+               state->free_space);
+        return 0;
+    }
+
+    remove_free(state, block);
+    block_trim(state, block, adjusted);
+
+    return (u8 *)block + TLSF_HEADER_SIZE;
+}
+
+b8 tlsf_allocator_free(tlsf_allocator *allocator, void *block) {
+    if (!allocator || !allocator->memory || !block) {
+        KERROR("tlsf_allocator_free - Requires a valid allocator and block.");
+        return false;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+
+    if ((u8 *)block < (u8 *)state->first + TLSF_HEADER_SIZE ||
+        (u8 *)block >= (u8 *)state->sentinel) {
+        KERROR("tlsf_allocator_free - Block is not owned by this allocator.");
+        return false;
+    }
+
+    tlsf_block *freed = (tlsf_block *)((u8 *)block - TLSF_HEADER_SIZE);
+    if (block_is_free(freed)) {
+        KERROR("tlsf_allocator_free - Block is already free.");
+        return false;
+    }
+
+    block_release(state, freed);
+    return true;
+}
+
+b8 tlsf_allocator_try_extend(tlsf_allocator *allocator, void *block,
+                             u64 new_size) {
+    if (!allocator || !allocator->memory || !block) {
+        KERROR("tlsf_allocator_try_extend - Requires a valid allocator and "
+               "block.");
+        return false;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    tlsf_block *extended = (tlsf_block *)((u8 *)block - TLSF_HEADER_SIZE);
+    u64 adjusted = align_up(new_size);
+    if (block_size(extended) >= adjusted) {
+        return true;
+    }
+
+    tlsf_block *next = block_next(extended);
+    if (!block_is_free(next) ||
+        block_size(extended) + TLSF_HEADER_SIZE + block_size(next) <
+            adjusted) {
+        return false;
+    }
+
+    remove_free(state, next);
+    block_set_size(extended, block_size(extended) + TLSF_HEADER_SIZE +
+                                 block_size(next));
+    block_next(extended)->prev_phys = extended;
+    block_trim(state, extended, adjusted);
+    return true;
+}
+
+b8 tlsf_allocator_grow(tlsf_allocator *allocator, u64 new_total_size) {
+    if (!allocator || !allocator->memory) {
+        KERROR("tlsf_allocator_grow - Passed in null allocator.");
+        return false;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    u64 new_total = align_up(new_total_size);
+    u64 min_total = state->total_size + TLSF_HEADER_SIZE + TLSF_MIN_BLOCK_SIZE;
+    if (new_total >= TLSF_MAX_BLOCK_SIZE || new_total < min_total) {
+        KERROR("tlsf_allocator_grow - Cannot grow from %lluB to %lluB.",
+               state->total_size, new_total_size);
+        return false;
+    }
+
+    // The old sentinel becomes the header of a new block covering the added
+    // space, and a new sentinel goes at the new end.
+    tlsf_block *added = state->sentinel;
+    added->size = new_total - state->total_size - TLSF_HEADER_SIZE;
+
+    state->sentinel = block_next(added);
+    state->sentinel->size = 0;
+    state->sentinel->prev_phys = added;
+    state->total_size = new_total;
+
+    // The header reused from the sentinel is handed back once merged.
+    block_release(state, added);
+    return true;
+}
+
+u64 tlsf_allocator_block_size(void *block) {
+    if (!block) {
+        return 0;
+    }
+    return block_size((tlsf_block *)((u8 *)block - TLSF_HEADER_SIZE));
+}
+
+u64 tlsf_allocator_largest_free_block(tlsf_allocator *allocator) {
+    if (!allocator || !allocator->memory) {
+        KERROR("tlsf_allocator_largest_free_block - Passed in null allocator.");
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    if (!state->fl_bitmap) {
+        return 0;
+    }
+
+    // The highest non-empty list holds the largest blocks, but only bounds
+    // their size, so walk it.
+    u32 fl = floor_log2(state->fl_bitmap);
+    u32 sl = floor_log2(state->sl_bitmap[fl]);
+    u64 largest = 0;
+    for (tlsf_block *block = state->blocks[fl][sl]; block;
+         block = block->next_free) {
+        if (block_size(block) > largest) {
+            largest = block_size(block);
+        }
+    }
+    return largest;
+}
+
+u64 tlsf_allocator_free_space(tlsf_allocator *allocator) {
+    if (!allocator || !allocator->memory) {
+        KERROR("tlsf_allocator_free_space - Passed in null allocator.");
+        return 0;
+    }
+
+    internal_state *state = (internal_state *)allocator->memory;
+    return state->free_space;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file tlsf_allocator.h
+ * @brief Contains a two-level segregated fit (TLSF) allocator. Used as one of
+ * the dynamic allocator strategies.
+ * @version 1.0
+ * @date 2026-10-16
+ */
+
+#pragma once
+
+#include "defines.h"
+
+/** @brief Alignment, and size granularity, of every TLSF block. */
+#define TLSF_ALLOCATOR_ALIGNMENT 16
+
+/**
+ * @brief The TLSF allocator struct. Free blocks are kept in size-segregated
+ * lists indexed by a first-level (power of two) and second-level (linear
+ * subdivision) bitmap, so allocate and free are O(1). Neighbouring free blocks
+ * are merged immediately on free.
+ */
+typedef struct tlsf_allocator {
+    /** @brief The internal state, followed by the managed pool. */
+    void *memory;
+} tlsf_allocator;
+
+/**
+ * @brief Creates a TLSF allocator. Should be called twice; once to get the
+ * memory requirement, twice to create the struct.
+ *
+ * @param total_size The number of bytes available for allocations before any
+ * block overhead. Every block carries a small header, so the sum of allocation
+ * sizes that fit is slightly less than this.
+ * @param memory_requirement A pointer to the amount of memory needed.
+ * @param memory A pointer to the memory for the allocator, or 0.
+ * @param out_allocator A pointer to hold the allocator.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 tlsf_allocator_create(u64 total_size, u64 *memory_requirement,
+                              void *memory, tlsf_allocator *out_allocator);
+
+/**
+ * @brief Destroys a TLSF allocator. Does not free the memory block.
+ *
+ * @param allocator A pointer to the allocator to destroy.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 tlsf_allocator_destroy(tlsf_allocator *allocator);
+
+/**
+ * @brief Allocates a block of at least size bytes, aligned to
+ * TLSF_ALLOCATOR_ALIGNMENT.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param size The size to allocate.
+ * @return The block of memory if successful; otherwise Null.
+ */
+KAPI void *tlsf_allocator_allocate(tlsf_allocator *allocator, u64 size);
+
+/**
+ * @brief Frees a block allocated by the allocator, merging it with free
+ * neighbours.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param block The block to free.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 tlsf_allocator_free(tlsf_allocator *allocator, void *block);
+
+/**
+ * @brief Attempts to grow an allocated block in place, by taking space from
+ * the free block that physically follows it.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param block The block to grow.
+ * @param new_size The size the block must hold.
+ * @return True if the block now holds new_size bytes; otherwise False, and the
+ * block is unchanged.
+ */
+KAPI b8 tlsf_allocator_try_extend(tlsf_allocator *allocator, void *block,
+                                  u64 new_size);
+
+/**
+ * @brief Grows the pool in place to new_total_size. The memory after the
+ * current pool must already be usable, up to the memory requirement for
+ * new_total_size, i.e. the caller reserved for the larger size and committed
+ * the difference.
+ *
+ * @param allocator A pointer to the allocator struct.
+ * @param new_total_size The new total size. Must exceed the current total
+ * size by at least 32 bytes.
+ * @return True if successful; otherwise False.
+ */
+KAPI b8 tlsf_allocator_grow(tlsf_allocator *allocator, u64 new_total_size);
+
+/**
+ * @brief Gets the size usable by the caller of an allocated block.
+ *
+ * @param block A block returned by tlsf_allocator_allocate.
+ * @return The usable size in bytes.
+ */
+KAPI u64 tlsf_allocator_block_size(void *block);
+
+/**
+ * @brief Gets the total number of free bytes, excluding block headers.
+ *
+ * @param allocator A pointer to the allocator struct.
+ */
+KAPI u64 tlsf_allocator_free_space(tlsf_allocator *allocator);
+
+/**
+ * @brief Gets the size of the largest free block, excluding its header.
+ *
+ * @param allocator A pointer to the allocator struct.
+ */
+KAPI u64 tlsf_allocator_largest_free_block(tlsf_allocator *allocator);
@@ -16,6 +16,17 @@ b8 platform_pump_messages(platform_state *plat_state);
 void *platform_allocate(u64 size, b8 aligned);
 void platform_free(void *block, b8 aligned);
 void *platform_zero_memory(void *block, u64 size);
+
+/** @brief The huge page size used when committing in huge page units. */
+#define PLATFORM_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Virtual memory. Reserved address space has no backing until committed.
+// Addresses and sizes passed to commit/decommit must be page aligned.
+u64 platform_memory_page_size();
+void *platform_memory_reserve(u64 size);
+b8 platform_memory_commit(void *address, u64 size, b8 huge_pages);
+void platform_memory_decommit(void *address, u64 size);
+void platform_memory_release(void *address, u64 size);
 void *platform_copy_memory(void *dest, const void *source, u64 size);
 void *platform_set_memory(void *dest, i32 value, u64 size);
 
@@ -25,3 +36,19 @@ void platform_console_write_error(const char *message, u8 colour);
 f64 platform_get_absolute_time();
 
 void platform_sleep(u64 ms);
+
+/** @brief Gets the number of logical processors available to the process. */
+KAPI u32 platform_get_processor_count();
+
+/**
+ * @brief The cache line size assumed when laying out data at compile time, to
+ * keep data written by different threads on separate lines. At least the
+ * size reported by platform_get_cache_line_size on supported processors.
+ */
+#define PLATFORM_CACHE_LINE_SIZE 64
+
+/**
+ * @brief Gets the size of a level 1 data cache line in bytes, or
+ * PLATFORM_CACHE_LINE_SIZE if the platform does not report it.
+ */
+KAPI u32 platform_get_cache_line_size();
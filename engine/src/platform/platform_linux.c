@@ -1,3 +1,8 @@
+// Before any system header, for pthread_setaffinity_np.
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "platform/platform_linux.h"
 #include "renderer/vulkan/vulkan_platform.h"
 
@@ -5,19 +10,45 @@
 
 #include "platform.h"
 
+#include <core/kcondition.h>
+#include <core/kfiber.h>
+#include <core/kfutex.h>
+#include <core/kmutex.h>
+#include <core/ksemaphore.h>
+#include <core/kthread.h>
 #include <core/logger.h>
 #include <defines.h>
 #include <platform/platform_linux_wayland.h>
 #include <platform/platform_linux_x11.h>
 
+#include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <time.h>
 
+#include <pthread.h>
+#include <sched.h>
+#include <linux/futex.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h> // sysconf
+
 #include <X11/keysym.h>
 
+// Fibers switch with a hand-written routine on x86-64, which only saves the
+// callee-saved registers. Elsewhere they fall back to ucontext, whose
+// switches also save the signal mask with a system call.
+#if defined(__x86_64__)
+#define LINUX_FIBER_ASM 1
+#else
+#define LINUX_FIBER_ASM 0
+#include <ucontext.h>
+#endif
+
 #if _POSIX_X_SOURCE < 199309L
 #include <unistd.h> // usleep
 #endif              // SLEEP
@@ -82,6 +113,42 @@ void *platform_set_memory(void *dest, i32 value, u64 size) {
     return memset(dest, value, size);
 }
 
+u64 platform_memory_page_size() { return (u64)sysconf(_SC_PAGESIZE); }
+
+void *platform_memory_reserve(u64 size) {
+    void *address = mmap(0, size, PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (address == MAP_FAILED) {
+        KERROR("platform_memory_reserve - mmap of %lluB failed.", size);
+        return 0;
+    }
+    return address;
+}
+
+b8 platform_memory_commit(void *address, u64 size, b8 huge_pages) {
+    if (mprotect(address, size, PROT_READ | PROT_WRITE) != 0) {
+        KERROR("platform_memory_commit - mprotect of %lluB failed.", size);
+        return false;
+    }
+#if defined(MADV_HUGEPAGE)
+    if (huge_pages) {
+        // Only a hint; transparent huge pages may be disabled.
+        madvise(address, size, MADV_HUGEPAGE);
+    }
+#endif
+    return true;
+}
+
+void platform_memory_decommit(void *address, u64 size) {
+    // Drops the pages so the next commit sees zeroes, then revokes access.
+    madvise(address, size, MADV_DONTNEED);
+    mprotect(address, size, PROT_NONE);
+}
+
+void platform_memory_release(void *address, u64 size) {
+    munmap(address, size);
+}
+
 void platform_console_write(const char *message, u8 colour) {
     // FATAL,ERROR,WARN,INFO,DEBUG,TRACE
     const char *colour_strings[] = {"0;41", "1;31", "1;33",
@@ -116,6 +183,427 @@ void platform_sleep(u64 ms) {
 #endif
 }
 
+u32 platform_get_processor_count() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+}
+
+u32 platform_get_cache_line_size() {
+    // Reported by glibc from CPUID or sysfs; 0 where it is unknown.
+    long size = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+    return size > 0 ? (u32)size : PLATFORM_CACHE_LINE_SIZE;
+}
+
+typedef struct linux_thread_start {
+    pfn_thread_start function;
+    void *params;
+} linux_thread_start;
+
+static void *linux_thread_entry(void *data) {
+    linux_thread_start start = *(linux_thread_start *)data;
+    platform_free(data, false);
+    return (void *)(u64)start.function(start.params);
+}
+
+b8 kthread_create(pfn_thread_start start_function_ptr, void *params,
+                  b8 auto_detach, kthread *out_thread) {
+    if (!start_function_ptr || !out_thread) {
+        KERROR("kthread_create - Requires start_function_ptr and out_thread.");
+        return false;
+    }
+
+    linux_thread_start *start =
+        platform_allocate(sizeof(linux_thread_start), false);
+    start->function = start_function_ptr;
+    start->params = params;
+
+    pthread_t handle;
+    i32 result = pthread_create(&handle, 0, linux_thread_entry, start);
+    if (result != 0) {
+        KERROR("kthread_create - pthread_create failed with error %i.", result);
+        platform_free(start, false);
+        return false;
+    }
+
+    out_thread->thread_id = (u64)handle;
+    if (auto_detach) {
+        pthread_detach(handle);
+        out_thread->internal_data = 0;
+    } else {
+        out_thread->internal_data =
+            platform_allocate(sizeof(pthread_t), false);
+        *(pthread_t *)out_thread->internal_data = handle;
+    }
+    return true;
+}
+
+void kthread_destroy(kthread *thread) {
+    if (thread && thread->internal_data) {
+        platform_free(thread->internal_data, false);
+        thread->internal_data = 0;
+        thread->thread_id = 0;
+    }
+}
+
+b8 kthread_wait(kthread *thread) {
+    if (!thread || !thread->internal_data) {
+        KERROR("kthread_wait - Thread is detached or was not created.");
+        return false;
+    }
+
+    i32 result = pthread_join(*(pthread_t *)thread->internal_data, 0);
+    kthread_destroy(thread);
+    return result == 0;
+}
+
+u64 kthread_current_id() { return (u64)pthread_self(); }
+
+void kthread_yield() { sched_yield(); }
+
+b8 kthread_set_affinity(kthread *thread, u32 processor_index) {
+    if (!thread || !thread->internal_data) {
+        KERROR("kthread_set_affinity - Thread is detached or was not "
+               "created.");
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(processor_index, &set);
+    i32 result = pthread_setaffinity_np(*(pthread_t *)thread->internal_data,
+                                        sizeof(cpu_set_t), &set);
+    if (result != 0) {
+        KWARN("kthread_set_affinity - failed with error %i.", result);
+        return false;
+    }
+    return true;
+}
+
+b8 kmutex_create(kmutex *out_mutex) {
+    if (!out_mutex) {
+        KERROR("kmutex_create - Requires out_mutex.");
+        return false;
+    }
+
+    pthread_mutex_t *mutex = platform_allocate(sizeof(pthread_mutex_t), false);
+    if (pthread_mutex_init(mutex, 0) != 0) {
+        KERROR("kmutex_create - pthread_mutex_init failed.");
+        platform_free(mutex, false);
+        return false;
+    }
+    out_mutex->internal_data = mutex;
+    return true;
+}
+
+void kmutex_destroy(kmutex *mutex) {
+    if (mutex && mutex->internal_data) {
+        pthread_mutex_destroy(mutex->internal_data);
+        platform_free(mutex->internal_data, false);
+        mutex->internal_data = 0;
+    }
+}
+
+b8 kmutex_lock(kmutex *mutex) {
+    if (!mutex || !mutex->internal_data) {
+        return false;
+    }
+    return pthread_mutex_lock(mutex->internal_data) == 0;
+}
+
+b8 kmutex_unlock(kmutex *mutex) {
+    if (!mutex || !mutex->internal_data) {
+        return false;
+    }
+    return pthread_mutex_unlock(mutex->internal_data) == 0;
+}
+
+b8 ksemaphore_create(u32 initial_count, ksemaphore *out_semaphore) {
+    if (!out_semaphore) {
+        KERROR("ksemaphore_create - Requires out_semaphore.");
+        return false;
+    }
+
+    sem_t *semaphore = platform_allocate(sizeof(sem_t), false);
+    if (sem_init(semaphore, 0, initial_count) != 0) {
+        KERROR("ksemaphore_create - sem_init failed.");
+        platform_free(semaphore, false);
+        return false;
+    }
+    out_semaphore->internal_data = semaphore;
+    return true;
+}
+
+void ksemaphore_destroy(ksemaphore *semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        sem_destroy(semaphore->internal_data);
+        platform_free(semaphore->internal_data, false);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore *semaphore, u32 count) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    for (u32 i = 0; i < count; ++i) {
+        if (sem_post(semaphore->internal_data) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+b8 ksemaphore_wait(ksemaphore *semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    // Retry when a signal handler interrupts the wait.
+    while (sem_wait(semaphore->internal_data) != 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+b8 kcondition_create(kcondition *out_condition) {
+    if (!out_condition) {
+        KERROR("kcondition_create - Requires out_condition.");
+        return false;
+    }
+
+    pthread_cond_t *condition =
+        platform_allocate(sizeof(pthread_cond_t), false);
+    if (pthread_cond_init(condition, 0) != 0) {
+        KERROR("kcondition_create - pthread_cond_init failed.");
+        platform_free(condition, false);
+        return false;
+    }
+    out_condition->internal_data = condition;
+    return true;
+}
+
+void kcondition_destroy(kcondition *condition) {
+    if (condition && condition->internal_data) {
+        pthread_cond_destroy(condition->internal_data);
+        platform_free(condition->internal_data, false);
+        condition->internal_data = 0;
+    }
+}
+
+b8 kcondition_wait(kcondition *condition, kmutex *mutex) {
+    if (!condition || !condition->internal_data || !mutex ||
+        !mutex->internal_data) {
+        return false;
+    }
+    return pthread_cond_wait(condition->internal_data,
+                             mutex->internal_data) == 0;
+}
+
+b8 kcondition_signal(kcondition *condition) {
+    if (!condition || !condition->internal_data) {
+        return false;
+    }
+    return pthread_cond_signal(condition->internal_data) == 0;
+}
+
+b8 kcondition_broadcast(kcondition *condition) {
+    if (!condition || !condition->internal_data) {
+        return false;
+    }
+    return pthread_cond_broadcast(condition->internal_data) == 0;
+}
+
+b8 kfutex_wait(u32 *address, u32 expected, u32 timeout_ms) {
+    struct timespec timeout;
+    struct timespec *timeout_ptr = 0;
+    if (timeout_ms != KFUTEX_WAIT_FOREVER) {
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = (timeout_ms % 1000) * 1000 * 1000;
+        timeout_ptr = &timeout;
+    }
+    // The futexes are never shared between processes, so the private
+    // operations skip the kernel's shared-mapping lookup.
+    long result = syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected,
+                          timeout_ptr, 0, 0);
+    return result == 0 || errno != ETIMEDOUT;
+}
+
+void kfutex_wake(u32 *address, u32 count) {
+    i32 wake_count = count >= INT_MAX ? INT_MAX : (i32)count;
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, wake_count, 0, 0, 0);
+}
+
+typedef struct linux_fiber {
+#if LINUX_FIBER_ASM
+    void *stack_pointer;
+#else
+    ucontext_t context;
+#endif
+    /** @brief The reserved stack range, guard page first, or 0 for a
+     * converted thread. */
+    void *stack;
+    u64 stack_size;
+    pfn_fiber_start function;
+    void *params;
+} linux_fiber;
+
+#if LINUX_FIBER_ASM
+// Pushes the callee-saved registers and the SSE/x87 control words, saves the
+// stack pointer to *from_stack_pointer, then pops the same from
+// to_stack_pointer and returns into the fiber that was saved there.
+void linux_fiber_swap(void **from_stack_pointer, void *to_stack_pointer);
+// Where a new fiber's first swap returns to. Calls the start function held in
+// r12 with the parameter held in r13.
+void linux_fiber_trampoline();
+
+__asm__(".text\n"
+        ".globl linux_fiber_swap\n"
+        ".hidden linux_fiber_swap\n"
+        ".type linux_fiber_swap, @function\n"
+        ".p2align 4\n"
+        "linux_fiber_swap:\n"
+        "    pushq %rbp\n"
+        "    pushq %rbx\n"
+        "    pushq %r12\n"
+        "    pushq %r13\n"
+        "    pushq %r14\n"
+        "    pushq %r15\n"
+        "    subq $8, %rsp\n"
+        "    stmxcsr (%rsp)\n"
+        "    fnstcw 4(%rsp)\n"
+        "    movq %rsp, (%rdi)\n"
+        "    movq %rsi, %rsp\n"
+        "    ldmxcsr (%rsp)\n"
+        "    fldcw 4(%rsp)\n"
+        "    addq $8, %rsp\n"
+        "    popq %r15\n"
+        "    popq %r14\n"
+        "    popq %r13\n"
+        "    popq %r12\n"
+        "    popq %rbx\n"
+        "    popq %rbp\n"
+        "    ret\n"
+        ".size linux_fiber_swap, .-linux_fiber_swap\n"
+        ".globl linux_fiber_trampoline\n"
+        ".hidden linux_fiber_trampoline\n"
+        ".type linux_fiber_trampoline, @function\n"
+        ".p2align 4\n"
+        "linux_fiber_trampoline:\n"
+        "    movq %r13, %rdi\n"
+        "    callq *%r12\n"
+        "    ud2\n"
+        ".size linux_fiber_trampoline, .-linux_fiber_trampoline\n");
+
+// Lays out a stack the way linux_fiber_swap leaves one, so the first switch
+// to it returns into linux_fiber_trampoline.
+static void linux_fiber_prepare(linux_fiber *fiber, u8 *stack_top) {
+    u32 mxcsr = 0;
+    u16 fpu_control = 0;
+    __asm__ volatile("stmxcsr %0" : "=m"(mxcsr));
+    __asm__ volatile("fnstcw %0" : "=m"(fpu_control));
+
+    // The return slot sits so the trampoline runs with a 16-byte aligned
+    // stack, as a call expects.
+    u64 *slot = (u64 *)(stack_top - 24);
+    slot[0] = (u64)linux_fiber_trampoline;
+    slot[-1] = 0;                       // rbp
+    slot[-2] = 0;                       // rbx
+    slot[-3] = (u64)fiber->function;    // r12
+    slot[-4] = (u64)fiber->params;      // r13
+    slot[-5] = 0;                       // r14
+    slot[-6] = 0;                       // r15
+    slot[-7] = (u64)mxcsr | ((u64)fpu_control << 32);
+    fiber->stack_pointer = &slot[-7];
+}
+#else
+// makecontext passes int arguments, so the fiber pointer is split in two.
+static void linux_fiber_entry(u32 high, u32 low) {
+    linux_fiber *fiber = (linux_fiber *)(((u64)high << 32) | low);
+    fiber->function(fiber->params);
+}
+
+static void linux_fiber_prepare(linux_fiber *fiber, u8 *stack_top) {
+    u64 page_size = platform_memory_page_size();
+    getcontext(&fiber->context);
+    fiber->context.uc_stack.ss_sp = (u8 *)fiber->stack + page_size;
+    fiber->context.uc_stack.ss_size = fiber->stack_size - page_size;
+    fiber->context.uc_link = 0;
+    u64 address = (u64)fiber;
+    makecontext(&fiber->context, (void (*)())linux_fiber_entry, 2,
+                (u32)(address >> 32), (u32)address);
+}
+#endif
+
+b8 kfiber_create(u64 stack_size, pfn_fiber_start start_function_ptr,
+                 void *params, kfiber *out_fiber) {
+    if (!start_function_ptr || !out_fiber || stack_size == 0) {
+        KERROR("kfiber_create - Requires start_function_ptr, out_fiber and a "
+               "positive stack_size.");
+        return false;
+    }
+
+    // The lowest page stays inaccessible, so an overflow faults.
+    u64 page_size = platform_memory_page_size();
+    stack_size = (stack_size + page_size - 1) & ~(page_size - 1);
+    u64 reserved_size = stack_size + page_size;
+    u8 *stack = platform_memory_reserve(reserved_size);
+    if (!stack) {
+        return false;
+    }
+    if (!platform_memory_commit(stack + page_size, stack_size, false)) {
+        platform_memory_release(stack, reserved_size);
+        return false;
+    }
+
+    linux_fiber *fiber = platform_allocate(sizeof(linux_fiber), false);
+    platform_zero_memory(fiber, sizeof(linux_fiber));
+    fiber->stack = stack;
+    fiber->stack_size = reserved_size;
+    fiber->function = start_function_ptr;
+    fiber->params = params;
+    linux_fiber_prepare(fiber, stack + reserved_size);
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void kfiber_destroy(kfiber *fiber) {
+    if (fiber && fiber->internal_data) {
+        linux_fiber *internal = fiber->internal_data;
+        if (internal->stack) {
+            platform_memory_release(internal->stack, internal->stack_size);
+        }
+        platform_free(internal, false);
+        fiber->internal_data = 0;
+    }
+}
+
+b8 kfiber_convert_thread(kfiber *out_fiber) {
+    if (!out_fiber) {
+        KERROR("kfiber_convert_thread - Requires out_fiber.");
+        return false;
+    }
+
+    // The thread's own stack is used; the context is filled in by the first
+    // switch away from it.
+    linux_fiber *fiber = platform_allocate(sizeof(linux_fiber), false);
+    platform_zero_memory(fiber, sizeof(linux_fiber));
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void kfiber_revert_thread(kfiber *fiber) { kfiber_destroy(fiber); }
+
+void kfiber_switch(kfiber *from, kfiber *to) {
+    linux_fiber *from_fiber = from->internal_data;
+    linux_fiber *to_fiber = to->internal_data;
+#if LINUX_FIBER_ASM
+    linux_fiber_swap(&from_fiber->stack_pointer, to_fiber->stack_pointer);
+#else
+    swapcontext(&from_fiber->context, &to_fiber->context);
+#endif
+}
+
 void platform_get_required_extension_names(const char ***names_darray) {
     if (wayland_display) {
         platform_get_required_extension_names_wayland(names_darray);
@@ -5,6 +5,12 @@
 
 #include "core/event.h"
 #include "core/input.h"
+#include "core/kcondition.h"
+#include "core/kfiber.h"
+#include "core/kfutex.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kthread.h"
 #include "core/logger.h"
 
 #include "containers/darray.h"
@@ -14,6 +20,9 @@
 #include <windows.h>
 #include <windowsx.h>
 
+// WaitOnAddress and WakeByAddress*, for kfutex.
+#pragma comment(lib, "Synchronization.lib")
+
 // For surface creation
 #include "renderer/vulkan/vulkan_types.inl"
 #include <vulkan/vulkan.h>
@@ -144,6 +153,39 @@ void *platform_set_memory(void *dest, i32 value, u64 size) {
     return memset(dest, value, size);
 }
 
+u64 platform_memory_page_size() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+void *platform_memory_reserve(u64 size) {
+    void *address = VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+    if (!address) {
+        KERROR("platform_memory_reserve - VirtualAlloc of %lluB failed.",
+               size);
+    }
+    return address;
+}
+
+b8 platform_memory_commit(void *address, u64 size, b8 huge_pages) {
+    // Large pages need a privilege and must be allocated up front on
+    // Windows, so huge_pages is ignored here.
+    if (!VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE)) {
+        KERROR("platform_memory_commit - VirtualAlloc of %lluB failed.", size);
+        return false;
+    }
+    return true;
+}
+
+void platform_memory_decommit(void *address, u64 size) {
+    VirtualFree(address, size, MEM_DECOMMIT);
+}
+
+void platform_memory_release(void *address, u64 size) {
+    VirtualFree(address, 0, MEM_RELEASE);
+}
+
 void platform_console_write(const char *message, u8 colour) {
     HANDLE console_handle = GetStdHandle(STD_OUTPUT_HANDLE);
     static u8 levels[6] = {64, 4, 6, 2, 1, 8};
@@ -173,6 +215,327 @@ f64 platform_get_absolute_time() {
 
 void platform_sleep(u64 ms) { Sleep(ms); }
 
+u32 platform_get_processor_count() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+}
+
+u32 platform_get_cache_line_size() {
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION info[256];
+    DWORD size = sizeof(info);
+    if (GetLogicalProcessorInformation(info, &size)) {
+        u32 count = size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
+        for (u32 i = 0; i < count; ++i) {
+            if (info[i].Relationship == RelationCache &&
+                info[i].Cache.Level == 1 &&
+                info[i].Cache.Type != CacheInstruction) {
+                return info[i].Cache.LineSize;
+            }
+        }
+    }
+    return PLATFORM_CACHE_LINE_SIZE;
+}
+
+typedef struct win32_thread_start {
+    pfn_thread_start function;
+    void *params;
+} win32_thread_start;
+
+static DWORD WINAPI win32_thread_entry(LPVOID data) {
+    win32_thread_start start = *(win32_thread_start *)data;
+    platform_free(data, false);
+    return start.function(start.params);
+}
+
+b8 kthread_create(pfn_thread_start start_function_ptr, void *params,
+                  b8 auto_detach, kthread *out_thread) {
+    if (!start_function_ptr || !out_thread) {
+        KERROR("kthread_create - Requires start_function_ptr and out_thread.");
+        return false;
+    }
+
+    win32_thread_start *start =
+        platform_allocate(sizeof(win32_thread_start), false);
+    start->function = start_function_ptr;
+    start->params = params;
+
+    DWORD thread_id = 0;
+    HANDLE handle =
+        CreateThread(0, 0, win32_thread_entry, start, 0, &thread_id);
+    if (!handle) {
+        KERROR("kthread_create - CreateThread failed.");
+        platform_free(start, false);
+        return false;
+    }
+
+    out_thread->thread_id = thread_id;
+    if (auto_detach) {
+        CloseHandle(handle);
+        out_thread->internal_data = 0;
+    } else {
+        out_thread->internal_data = handle;
+    }
+    return true;
+}
+
+void kthread_destroy(kthread *thread) {
+    if (thread && thread->internal_data) {
+        CloseHandle((HANDLE)thread->internal_data);
+        thread->internal_data = 0;
+        thread->thread_id = 0;
+    }
+}
+
+b8 kthread_wait(kthread *thread) {
+    if (!thread || !thread->internal_data) {
+        KERROR("kthread_wait - Thread is detached or was not created.");
+        return false;
+    }
+
+    DWORD result =
+        WaitForSingleObject((HANDLE)thread->internal_data, INFINITE);
+    kthread_destroy(thread);
+    return result == WAIT_OBJECT_0;
+}
+
+u64 kthread_current_id() { return (u64)GetCurrentThreadId(); }
+
+void kthread_yield() { SwitchToThread(); }
+
+b8 kthread_set_affinity(kthread *thread, u32 processor_index) {
+    if (!thread || !thread->internal_data) {
+        KERROR("kthread_set_affinity - Thread is detached or was not "
+               "created.");
+        return false;
+    }
+
+    if (!SetThreadAffinityMask((HANDLE)thread->internal_data,
+                               (DWORD_PTR)1 << processor_index)) {
+        KWARN("kthread_set_affinity - SetThreadAffinityMask failed.");
+        return false;
+    }
+    return true;
+}
+
+b8 kmutex_create(kmutex *out_mutex) {
+    if (!out_mutex) {
+        KERROR("kmutex_create - Requires out_mutex.");
+        return false;
+    }
+
+    CRITICAL_SECTION *section =
+        platform_allocate(sizeof(CRITICAL_SECTION), false);
+    InitializeCriticalSection(section);
+    out_mutex->internal_data = section;
+    return true;
+}
+
+void kmutex_destroy(kmutex *mutex) {
+    if (mutex && mutex->internal_data) {
+        DeleteCriticalSection(mutex->internal_data);
+        platform_free(mutex->internal_data, false);
+        mutex->internal_data = 0;
+    }
+}
+
+b8 kmutex_lock(kmutex *mutex) {
+    if (!mutex || !mutex->internal_data) {
+        return false;
+    }
+    EnterCriticalSection(mutex->internal_data);
+    return true;
+}
+
+b8 kmutex_unlock(kmutex *mutex) {
+    if (!mutex || !mutex->internal_data) {
+        return false;
+    }
+    LeaveCriticalSection(mutex->internal_data);
+    return true;
+}
+
+b8 ksemaphore_create(u32 initial_count, ksemaphore *out_semaphore) {
+    if (!out_semaphore) {
+        KERROR("ksemaphore_create - Requires out_semaphore.");
+        return false;
+    }
+
+    HANDLE handle = CreateSemaphoreA(0, initial_count, 0x7FFFFFFF, 0);
+    if (!handle) {
+        KERROR("ksemaphore_create - CreateSemaphore failed.");
+        return false;
+    }
+    out_semaphore->internal_data = handle;
+    return true;
+}
+
+void ksemaphore_destroy(ksemaphore *semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        CloseHandle((HANDLE)semaphore->internal_data);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore *semaphore, u32 count) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+    return ReleaseSemaphore((HANDLE)semaphore->internal_data, count, 0) != 0;
+}
+
+b8 ksemaphore_wait(ksemaphore *semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    return WaitForSingleObject((HANDLE)semaphore->internal_data, INFINITE) ==
+           WAIT_OBJECT_0;
+}
+
+b8 kcondition_create(kcondition *out_condition) {
+    if (!out_condition) {
+        KERROR("kcondition_create - Requires out_condition.");
+        return false;
+    }
+
+    CONDITION_VARIABLE *condition =
+        platform_allocate(sizeof(CONDITION_VARIABLE), false);
+    InitializeConditionVariable(condition);
+    out_condition->internal_data = condition;
+    return true;
+}
+
+void kcondition_destroy(kcondition *condition) {
+    // Condition variables hold no resources of their own.
+    if (condition && condition->internal_data) {
+        platform_free(condition->internal_data, false);
+        condition->internal_data = 0;
+    }
+}
+
+b8 kcondition_wait(kcondition *condition, kmutex *mutex) {
+    if (!condition || !condition->internal_data || !mutex ||
+        !mutex->internal_data) {
+        return false;
+    }
+    return SleepConditionVariableCS(condition->internal_data,
+                                    mutex->internal_data, INFINITE) != 0;
+}
+
+b8 kcondition_signal(kcondition *condition) {
+    if (!condition || !condition->internal_data) {
+        return false;
+    }
+    WakeConditionVariable(condition->internal_data);
+    return true;
+}
+
+b8 kcondition_broadcast(kcondition *condition) {
+    if (!condition || !condition->internal_data) {
+        return false;
+    }
+    WakeAllConditionVariable(condition->internal_data);
+    return true;
+}
+
+b8 kfutex_wait(u32 *address, u32 expected, u32 timeout_ms) {
+    DWORD timeout = timeout_ms == KFUTEX_WAIT_FOREVER ? INFINITE : timeout_ms;
+    if (WaitOnAddress(address, &expected, sizeof(u32), timeout)) {
+        return true;
+    }
+    return GetLastError() != ERROR_TIMEOUT;
+}
+
+void kfutex_wake(u32 *address, u32 count) {
+    if (count == INVALID_ID) {
+        WakeByAddressAll(address);
+        return;
+    }
+    for (u32 i = 0; i < count; ++i) {
+        WakeByAddressSingle(address);
+    }
+}
+
+typedef struct win32_fiber {
+    LPVOID handle;
+    pfn_fiber_start function;
+    void *params;
+    /** @brief True for a thread converted with ConvertThreadToFiber. */
+    b8 converted;
+} win32_fiber;
+
+static VOID WINAPI win32_fiber_entry(LPVOID data) {
+    win32_fiber *fiber = data;
+    fiber->function(fiber->params);
+}
+
+b8 kfiber_create(u64 stack_size, pfn_fiber_start start_function_ptr,
+                 void *params, kfiber *out_fiber) {
+    if (!start_function_ptr || !out_fiber || stack_size == 0) {
+        KERROR("kfiber_create - Requires start_function_ptr, out_fiber and a "
+               "positive stack_size.");
+        return false;
+    }
+
+    win32_fiber *fiber = platform_allocate(sizeof(win32_fiber), false);
+    fiber->function = start_function_ptr;
+    fiber->params = params;
+    fiber->converted = false;
+    fiber->handle = CreateFiber(stack_size, win32_fiber_entry, fiber);
+    if (!fiber->handle) {
+        KERROR("kfiber_create - CreateFiber failed.");
+        platform_free(fiber, false);
+        return false;
+    }
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void kfiber_destroy(kfiber *fiber) {
+    if (fiber && fiber->internal_data) {
+        win32_fiber *internal = fiber->internal_data;
+        if (!internal->converted) {
+            DeleteFiber(internal->handle);
+        }
+        platform_free(internal, false);
+        fiber->internal_data = 0;
+    }
+}
+
+b8 kfiber_convert_thread(kfiber *out_fiber) {
+    if (!out_fiber) {
+        KERROR("kfiber_convert_thread - Requires out_fiber.");
+        return false;
+    }
+
+    win32_fiber *fiber = platform_allocate(sizeof(win32_fiber), false);
+    fiber->function = 0;
+    fiber->params = 0;
+    fiber->converted = true;
+    fiber->handle = ConvertThreadToFiber(0);
+    if (!fiber->handle) {
+        KERROR("kfiber_convert_thread - ConvertThreadToFiber failed.");
+        platform_free(fiber, false);
+        return false;
+    }
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void kfiber_revert_thread(kfiber *fiber) {
+    if (fiber && fiber->internal_data) {
+        ConvertFiberToThread();
+        kfiber_destroy(fiber);
+    }
+}
+
+void kfiber_switch(kfiber *from, kfiber *to) {
+    SwitchToFiber(((win32_fiber *)to->internal_data)->handle);
+}
+
 void platform_get_required_extension_names(const char ***names_darray) {
     darray_push(*names_darray, &"VK_KHR_win32_surface");
 }
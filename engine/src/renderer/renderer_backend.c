@@ -18,6 +18,8 @@ b8 renderer_backend_create(renderer_backend_type type,
         out_renderer_backend->initialize = vulkan_renderer_backend_initialize;
         out_renderer_backend->shutdown = vulkan_renderer_backend_shutdown;
 
+        out_renderer_backend->wait_for_frame =
+            vulkan_renderer_backend_wait_for_frame;
         out_renderer_backend->begin_frame = vulkan_renderer_backend_begin_frame;
         out_renderer_backend->end_frame = vulkan_renderer_backend_end_frame;
 
@@ -55,6 +57,7 @@ void renderer_backend_destroy(struct renderer_backend *renderer_backend) {
     renderer_backend->initialize = 0;
     renderer_backend->shutdown = 0;
 
+    renderer_backend->wait_for_frame = 0;
     renderer_backend->begin_frame = 0;
     renderer_backend->end_frame = 0;
 
@@ -93,6 +93,11 @@ void renderer_on_resize(u16 width, u16 height) {
     }
 }
 
+b8 renderer_wait_for_frame(u8 *out_frame_index) {
+    return state_ptr->backend.wait_for_frame(&state_ptr->backend,
+                                             out_frame_index);
+}
+
 b8 renderer_draw_frame(render_packet *packet) {
     if (!state_ptr->backend.begin_frame(&state_ptr->backend,
                                          packet->delta_time)) {
@@ -160,6 +165,10 @@ b8 renderer_draw_frame(render_packet *packet) {
     return true;
 }
 
+u8 renderer_max_frames_in_flight() {
+    return state_ptr ? state_ptr->backend.max_frames_in_flight : 0;
+}
+
 void renderer_set_view(mat4 view) { state_ptr->view = view; }
 
 void renderer_create_texture(const u8 *pixels, struct texture *texture) {
@@ -12,8 +12,15 @@ void renderer_shutdown(void *state);
 
 void renderer_on_resize(u16 width, u16 height);
 
+// Waits until the GPU is done with the frame slot the next frame will use.
+// Memory tied to that slot can be reused once this returns.
+b8 renderer_wait_for_frame(u8 *out_frame_index);
+
 b8 renderer_draw_frame(render_packet *packet);
 
+// Number of frames the backend may have in flight, or 0 before initialize.
+u8 renderer_max_frames_in_flight();
+
 void renderer_create_texture(const u8 *pixels, struct texture *texture);
 void renderer_destroy_texture(struct texture *texture);
 
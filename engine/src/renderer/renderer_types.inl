@@ -24,6 +24,9 @@ typedef enum builtin_renderpass {
 typedef struct renderer_backend {
     struct platform_state *plat_state;
     u64 frame_number;
+    // Frames the backend may have queued before waiting on the GPU. Set by
+    // the backend during initialize.
+    u8 max_frames_in_flight;
 
     b8 (*initialize)(struct renderer_backend *backend,
                      const char *application_name,
@@ -32,6 +35,10 @@ typedef struct renderer_backend {
 
     void (*resized)(struct renderer_backend *backend, u16 width, u16 height);
 
+    // Blocks until the GPU has finished the last frame submitted in the slot
+    // the next frame will use, and gives that slot's index.
+    b8 (*wait_for_frame)(struct renderer_backend *backend,
+                         u8 *out_frame_index);
     b8 (*begin_frame)(struct renderer_backend *backend, f32 delta_time);
     b8 (*end_frame)(struct renderer_backend *backend, f32 delta_time);
 
@@ -224,6 +224,7 @@ b8 vulkan_renderer_backend_initialize(renderer_backend *backend,
     // Swapchain
     vulkan_swapchain_create(&context, context.framebuffer_width,
                             context.framebuffer_height, &context.swapchain);
+    backend->max_frames_in_flight = context.swapchain.max_frames_in_flight;
 
     // World renderpass
     vulkan_renderpass_create(
@@ -293,10 +294,15 @@ b8 vulkan_renderer_backend_initialize(renderer_backend *backend,
 
     create_buffers(&context);
 
-    // Mark all geometries invalid
-    for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; i++) {
-        context.geometries[i].id = INVALID_ID;
-    }
+    // Geometry slots
+    context.geometry_memory_requirement = 0;
+    slotmap_create(sizeof(vulkan_geometry_data), VULKAN_MAX_GEOMETRY_COUNT,
+                   &context.geometry_memory_requirement, 0, 0);
+    context.geometry_block =
+        kallocate(context.geometry_memory_requirement, MEMORY_TAG_RENDERER);
+    slotmap_create(sizeof(vulkan_geometry_data), VULKAN_MAX_GEOMETRY_COUNT,
+                   &context.geometry_memory_requirement,
+                   context.geometry_block, &context.geometries);
 
     KINFO("Vulkan renderer initialized successfully!");
     return true;
@@ -309,6 +315,12 @@ void vulkan_renderer_backend_shutdown(renderer_backend *backend) {
     vulkan_buffer_destroy(&context, &context.object_vertex_buffer);
     vulkan_buffer_destroy(&context, &context.object_index_buffer);
 
+    slotmap_destroy(&context.geometries);
+    kfree(context.geometry_block, context.geometry_memory_requirement,
+          MEMORY_TAG_RENDERER);
+    context.geometry_block = 0;
+    context.geometry_memory_requirement = 0;
+
     vulkan_material_shader_destroy(&context, &context.material_shader);
     vulkan_ui_shader_destroy(&context, &context.ui_shader);
 
@@ -399,6 +411,23 @@ void vulkan_renderer_backend_on_resized(renderer_backend *backend, u16 width,
           context.framebuffer_size_generation);
 }
 
+b8 vulkan_renderer_backend_wait_for_frame(renderer_backend *backend,
+                                          u8 *out_frame_index) {
+    // current_frame only advances on present, so a skipped frame reuses the
+    // same slot. begin_frame waits on the same fence again, at no cost.
+    VkResult result = vkWaitForFences(
+        context.device.logical_device, 1,
+        &context.in_flight_fences[context.current_frame], true, UINT64_MAX);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vulkan_renderer_backend_wait_for_frame - in flight fence wait "
+               "failure! error: '%s'.",
+               vulkan_result_string(result, true));
+        return false;
+    }
+    *out_frame_index = (u8)context.current_frame;
+    return true;
+}
+
 b8 vulkan_renderer_backend_begin_frame(renderer_backend *backend,
                                        f32 delta_time) {
     context.frame_delta_time = delta_time;
@@ -1057,7 +1086,14 @@ b8 vulkan_renderer_create_geometry(geometry *geometry, u32 vertex_size,
 
     vulkan_geometry_data *internal_data = 0;
     if (is_reupload) {
-        internal_data = &context.geometries[geometry->internal_id];
+        internal_data =
+            slotmap_get_at(&context.geometries, geometry->internal_id);
+        if (!internal_data) {
+            KERROR("vulkan_renderer_create_geometry - geometry internal_id %u "
+                   "is not a live geometry; cannot reupload.",
+                   geometry->internal_id);
+            return false;
+        }
 
         // Take a copy of the old range
         old_range.index_buffer_offset = internal_data->index_buffer_offset;
@@ -1067,13 +1103,12 @@ b8 vulkan_renderer_create_geometry(geometry *geometry, u32 vertex_size,
         old_range.vertex_buffer_offset = internal_data->vertex_buffer_offset;
         old_range.vertex_buffer_offset = internal_data->vertex_buffer_offset;
     } else {
-        for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; i++) {
-            if (context.geometries[i].id == INVALID_ID) {
-                geometry->internal_id = i;
-                context.geometries[i].id = i;
-                internal_data = &context.geometries[i];
-                break;
-            }
+        slotmap_handle handle;
+        internal_data = slotmap_insert(&context.geometries, &handle);
+        if (internal_data) {
+            geometry->internal_id = slotmap_handle_index(handle);
+            internal_data->id = geometry->internal_id;
+            internal_data->generation = INVALID_ID;
         }
     }
 
@@ -1152,7 +1187,10 @@ void vulkan_renderer_destroy_geometry(geometry *geometry) {
 
     vkDeviceWaitIdle(context.device.logical_device);
     vulkan_geometry_data *internal_data =
-        &context.geometries[geometry->internal_id];
+        slotmap_get_at(&context.geometries, geometry->internal_id);
+    if (!internal_data) {
+        return;
+    }
 
     // Free vertex data
     u32 total_vertex_size =
@@ -1164,13 +1202,13 @@ void vulkan_renderer_destroy_geometry(geometry *geometry) {
     if (internal_data->index_element_size > 0) {
         u32 total_index_size =
             internal_data->index_element_size * internal_data->index_count;
-        free_data_range(&context.object_vertex_buffer,
-                        internal_data->vertex_buffer_offset, total_index_size);
+        free_data_range(&context.object_index_buffer,
+                        internal_data->index_buffer_offset, total_index_size);
     }
 
-    kzero_memory(internal_data, sizeof(vulkan_geometry_data));
-    internal_data->id = INVALID_ID;
-    internal_data->generation = INVALID_ID;
+    slotmap_remove(&context.geometries,
+                   slotmap_handle_at(&context.geometries,
+                                     geometry->internal_id));
 }
 
 void vulkan_renderer_draw_geometry(renderer_backend *backend,
@@ -1181,7 +1219,7 @@ void vulkan_renderer_draw_geometry(renderer_backend *backend,
     }
 
     vulkan_geometry_data *buffer_data =
-        &context.geometries[data.geometry->internal_id];
+        slotmap_get_at(&context.geometries, data.geometry->internal_id);
     vulkan_command_buffer *command_buffer =
         &context.graphics_command_buffers[context.image_index];
 
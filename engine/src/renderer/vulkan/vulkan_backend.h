@@ -10,6 +10,8 @@ void vulkan_renderer_backend_shutdown(renderer_backend *backend);
 
 void vulkan_renderer_backend_on_resized(renderer_backend *backend, u16 width,
                                         u16 height);
+b8 vulkan_renderer_backend_wait_for_frame(renderer_backend *backend,
+                                          u8 *out_frame_index);
 b8 vulkan_renderer_backend_begin_frame(renderer_backend *backend,
                                        f32 delta_time);
 b8 vulkan_renderer_backend_end_frame(renderer_backend *backend, f32 delta_time);
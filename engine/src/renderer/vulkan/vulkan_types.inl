@@ -1,6 +1,7 @@
 #pragma once
 
 #include "containers/freelist.h"
+#include "containers/slotmap.h"
 #include "defines.h"
 
 #include "core/asserts.h"
@@ -348,8 +349,10 @@ typedef struct vulkan_context {
     vulkan_material_shader material_shader;
     vulkan_ui_shader ui_shader;
 
-    // TODO: Make dynamic
-    vulkan_geometry_data geometries[VULKAN_MAX_GEOMETRY_COUNT];
+    // Uploaded geometries, indexed by geometry internal_id
+    u64 geometry_memory_requirement;
+    void *geometry_block;
+    slotmap geometries;
 
     // One per frame
     VkFramebuffer world_framebuffers[3];
@@ -39,7 +39,9 @@ b8 binary_loader_load(struct resource_loader *self, const char *name,
     }
 
     // TODO: should use an allocator
-    u8 *resource_data = kallocate(sizeof(u8) * file_size, MEMORY_TAG_ARRAY);
+    // Every byte up to read_size is written by the read.
+    u8 *resource_data =
+        kallocate_uninit(sizeof(u8) * file_size, MEMORY_TAG_ARRAY);
     u64 read_size = 0;
     if (!filesystem_read_all_bytes(&file, resource_data, &read_size)) {
         KERROR("Unable to binary read file '%s'.", full_file_path);
@@ -21,7 +21,9 @@ b8 resource_unload(struct resource_loader *self, resource *resource,
     }
 
     if (resource->data) {
-        kfree(resource->data, resource->data_size, tag);
+        // data_size is what the loader read, which can be less than what it
+        // allocated, so free by the block header instead.
+        kfree_unsized(resource->data);
         resource->data = 0;
         resource->data_size = 0;
         resource->loader_id = INVALID_ID;
@@ -39,7 +39,9 @@ b8 text_loader_load(struct resource_loader *self, const char *name,
     }
 
     // TODO: should use an allocator
-    char *resource_data = kallocate(sizeof(u8) * file_size, MEMORY_TAG_ARRAY);
+    // Every byte up to read_size is written by the read.
+    char *resource_data =
+        kallocate_uninit(sizeof(u8) * file_size, MEMORY_TAG_ARRAY);
     u64 read_size = 0;
     if (!filesystem_read_all_text(&file, resource_data, &read_size)) {
         KERROR("Unable to text read file '%s'.", full_file_path);
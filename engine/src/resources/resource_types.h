@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/string_intern.h"
 #include "math/math_types.h"
 
 typedef enum resource_type {
@@ -35,7 +36,7 @@ typedef struct texture {
     u8 channel_count;
     b8 has_transparency;
     u32 generation;
-    char name[TEXTURE_NAME_MAX_LENGTH];
+    string_id name;
     void *internal_data;
 } texture;
 
@@ -69,7 +70,7 @@ typedef struct material {
     u32 generation;
     u32 internal_id;
     material_type type;
-    char name[MATERIAL_NAME_MAX_LENGTH];
+    string_id name;
     vec4 diffuse_colour;
     texture_map diffuse_map;
 } material;
@@ -80,6 +81,6 @@ typedef struct geometry {
     u32 id;
     u32 generation;
     u32 internal_id;
-    char name[GEOMETRY_NAME_MAX_LENGTH];
+    string_id name;
     material *material;
 } geometry;
@@ -1,8 +1,10 @@
 #include "systems/geometry_system.h"
 
+#include "containers/slotmap.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "core/logger.h"
+#include "core/string_intern.h"
 
 #include "defines.h"
 #include "systems/material_system.h"
@@ -21,8 +23,8 @@ typedef struct geometry_system_state {
     geometry default_3d_geometry;
     geometry default_2d_geometry;
 
-    // Array of geometries.
-    geometry_reference *registered_geometries;
+    // Geometry references, indexed by geometry id.
+    slotmap registered_geometries;
 } geometry_system_state;
 
 static geometry_system_state *state_ptr = 0;
@@ -41,9 +43,10 @@ b8 geometry_system_initialize(u64 *memory_requirement, void *state,
     }
 
     u64 struct_requirement = sizeof(geometry_system_state);
-    u64 array_requirement =
-        sizeof(geometry_reference) * config.max_geometry_count;
-    *memory_requirement = struct_requirement + array_requirement;
+    u64 slotmap_requirement = 0;
+    slotmap_create(sizeof(geometry_reference), config.max_geometry_count,
+                   &slotmap_requirement, 0, 0);
+    *memory_requirement = struct_requirement + slotmap_requirement;
 
     if (!state) {
         return true;
@@ -52,18 +55,12 @@ b8 geometry_system_initialize(u64 *memory_requirement, void *state,
     state_ptr = state;
     state_ptr->config = config;
 
-    // The array block is after the state. Already allocated, so just set the
-    // pointer.
-    void *array_block = state + struct_requirement;
-    state_ptr->registered_geometries = array_block;
-
-    // Invalidate all geometries
-    u32 count = state_ptr->config.max_geometry_count;
-    for (u32 i = 0; i < count; i++) {
-        state_ptr->registered_geometries[i].geometry.id = INVALID_ID;
-        state_ptr->registered_geometries[i].geometry.internal_id = INVALID_ID;
-        state_ptr->registered_geometries[i].geometry.generation = INVALID_ID;
-    }
+    // The slotmap block is after the state. Already allocated, so just hand it
+    // over.
+    void *slotmap_block = state + struct_requirement;
+    slotmap_create(sizeof(geometry_reference), config.max_geometry_count,
+                   &slotmap_requirement, slotmap_block,
+                   &state_ptr->registered_geometries);
 
     if (!create_default_geometries()) {
         KFATAL("Failed to create default geometries. Application cannot "
@@ -79,39 +76,41 @@ void geometry_system_shutdown(void *state) {
 }
 
 geometry *geometry_system_acquire_by_id(u32 id) {
-    if (id == INVALID_ID ||
-        state_ptr->registered_geometries[id].geometry.id == INVALID_ID) {
+    geometry_reference *ref =
+        slotmap_get_at(&state_ptr->registered_geometries, id);
+    if (!ref || ref->geometry.id == INVALID_ID) {
         KERROR("geometry_system_acquire_by_id cannot load invalid geometry id "
                ": '%d'. Returning nullptr.",
                id);
         return 0;
     }
 
-    state_ptr->registered_geometries[id].reference_count++;
-    return &state_ptr->registered_geometries[id].geometry;
+    ref->reference_count++;
+    return &ref->geometry;
 }
 
 geometry *geometry_system_acquire_from_config(geometry_config config,
                                               b8 auto_release) {
-    geometry *geo = 0;
-    for (u32 i = 0; i < state_ptr->config.max_geometry_count; i++) {
-        if (state_ptr->registered_geometries[i].geometry.id == INVALID_ID) {
-            state_ptr->registered_geometries[i].reference_count = 1;
-            state_ptr->registered_geometries[i].auto_release = auto_release;
-            geo = &state_ptr->registered_geometries[i].geometry;
-            geo->id = i;
-            break;
-        }
-    }
-
-    if (!geo) {
+    slotmap_handle handle;
+    geometry_reference *ref =
+        slotmap_insert(&state_ptr->registered_geometries, &handle);
+    if (!ref) {
         KERROR("Unable to obtain free slot for geometry, adjust config. "
                "Retuning nullptr.");
         return 0;
     }
 
+    ref->reference_count = 1;
+    ref->auto_release = auto_release;
+    geometry *geo = &ref->geometry;
+    geo->id = slotmap_handle_index(handle);
+    geo->internal_id = INVALID_ID;
+    geo->generation = INVALID_ID;
+    geo->name = string_intern(config.name);
+
     if (!create_geometry(config, geo)) {
         KERROR("Failed to create geometry, returning nullptr.");
+        slotmap_remove(&state_ptr->registered_geometries, handle);
         return 0;
     }
 
@@ -131,16 +130,18 @@ void geometry_system_release(geometry *geometry) {
     }
 
     u32 id = geometry->id;
-    geometry_reference *ref = &state_ptr->registered_geometries[id];
-    if (ref->geometry.id == id) {
+    geometry_reference *ref =
+        slotmap_get_at(&state_ptr->registered_geometries, id);
+    if (ref && ref->geometry.id == id) {
         if (ref->reference_count > 0) {
             ref->reference_count--;
         }
 
         if (ref->reference_count < 1 && ref->auto_release) {
             destroy_geometry(&ref->geometry);
-            ref->reference_count = 0;
-            ref->auto_release = false;
+            slotmap_remove(&state_ptr->registered_geometries,
+                           slotmap_handle_at(&state_ptr->registered_geometries,
+                                             id));
         }
     } else {
         KFATAL("Geometry id mismatch, this should never happen.");
@@ -171,8 +172,6 @@ b8 create_geometry(geometry_config config, geometry *geo) {
     if (!renderer_create_geometry(geo, config.vertex_size, config.vertex_count,
                                   config.vertices, config.index_size,
                                   config.index_count, config.indices)) {
-        state_ptr->registered_geometries[geo->id].reference_count = 0;
-        state_ptr->registered_geometries[geo->id].auto_release = false;
         geo->id = INVALID_ID;
         geo->generation = INVALID_ID;
         geo->internal_id = INVALID_ID;
@@ -196,10 +195,10 @@ void destroy_geometry(geometry *geo) {
     geo->generation = INVALID_ID;
     geo->internal_id = INVALID_ID;
 
-    string_empty(geo->name);
+    geo->name = STRING_ID_EMPTY;
 
     // Release material
-    if (geo->material && string_length(geo->material->name) > 0) {
+    if (geo->material && geo->material->name != STRING_ID_EMPTY) {
         material_system_release(geo->material->name);
         geo->material = 0;
     }
@@ -242,6 +241,7 @@ b8 create_default_geometries() {
         return false;
     }
 
+    state_ptr->default_3d_geometry.name = string_intern(DEFAULT_GEOMETRY_NAME);
     state_ptr->default_3d_geometry.material = material_system_get_default();
 
     // Default 2d geometry
@@ -279,6 +279,7 @@ b8 create_default_geometries() {
         return false;
     }
 
+    state_ptr->default_2d_geometry.name = string_intern(DEFAULT_GEOMETRY_NAME);
     state_ptr->default_2d_geometry.material = material_system_get_default();
 
     return true;
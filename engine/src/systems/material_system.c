@@ -8,9 +8,11 @@
 
 #include "core/kstring.h"
 #include "core/logger.h"
+#include "core/string_intern.h"
 #include "math/kmath.h"
 
-#include "containers/hashtable.h"
+#include "containers/btree_map.h"
+#include "containers/slotmap.h"
 
 #include "renderer/renderer_frontend.h"
 
@@ -22,16 +24,16 @@ typedef struct material_system_state {
 
     material default_material;
 
-    // Array of registered materials
-    material *registered_materials;
+    // Registered materials, indexed by material id
+    slotmap registered_materials;
 
-    // Hashtable for material lookups
-    hashtable registered_material_table;
+    // Material references, keyed by interned name
+    btree_map registered_material_table;
 } material_system_state;
 
 typedef struct material_reference {
     u64 reference_count;
-    u32 handle;
+    slotmap_handle handle;
     b8 auto_release;
 } material_reference;
 
@@ -50,14 +52,13 @@ b8 material_system_initialize(u64 *memory_requirement, void *state,
         return false;
     }
 
-    // Block of memory will contain state structure, material array and
-    // hashtable
+    // Block of memory will contain state structure and material slotmap. The
+    // reference map owns its own memory so it can grow.
     u64 struct_requirement = sizeof(material_system_state);
-    u64 array_requirement = sizeof(material) * config.max_material_count;
-    u64 hashtable_requirement =
-        sizeof(material_reference) * config.max_material_count;
-    *memory_requirement =
-        struct_requirement + array_requirement + hashtable_requirement;
+    u64 slotmap_requirement = 0;
+    slotmap_create(sizeof(material), config.max_material_count,
+                   &slotmap_requirement, 0, 0);
+    *memory_requirement = struct_requirement + slotmap_requirement;
 
     if (!state) {
         return true;
@@ -66,30 +67,17 @@ b8 material_system_initialize(u64 *memory_requirement, void *state,
     state_ptr = state;
     state_ptr->config = config;
 
-    // The array block is after the state. Already allocated, so just set the
-    // pointer.
-    void *array_block = state + struct_requirement;
-    state_ptr->registered_materials = array_block;
-
-    // Hashtable block is after array block
-    void *hashtable_block = array_block + array_requirement;
-    hashtable_create(sizeof(material_reference), config.max_material_count,
-                     hashtable_block, false,
-                     &state_ptr->registered_material_table);
-
-    // Fill the hash table with invalid references to use as a default
-    material_reference invalid_ref;
-    invalid_ref.auto_release = false;
-    invalid_ref.handle = INVALID_ID;
-    invalid_ref.reference_count = 0;
-    hashtable_fill(&state_ptr->registered_material_table, &invalid_ref);
-
-    // Invalidate all materials in material array
-    u32 count = state_ptr->config.max_material_count;
-    for (u32 i = 0; i < count; i++) {
-        state_ptr->registered_materials[i].id = INVALID_ID;
-        state_ptr->registered_materials[i].generation = INVALID_ID;
-        state_ptr->registered_materials[i].internal_id = INVALID_ID;
+    // The slotmap block is after the state. Already allocated, so just hand it
+    // over.
+    void *slotmap_block = state + struct_requirement;
+    slotmap_create(sizeof(material), config.max_material_count,
+                   &slotmap_requirement, slotmap_block,
+                   &state_ptr->registered_materials);
+
+    if (!btree_map_create(sizeof(material_reference),
+                          &state_ptr->registered_material_table)) {
+        KFATAL("material_system_initialize - failed to create reference map.");
+        return false;
     }
 
     // Create default material
@@ -108,14 +96,18 @@ void material_system_shutdown(void *state) {
     }
 
     // Destroy all loaded materials
-    for (u32 i = 0; i < state_ptr->config.max_material_count; i++) {
-        material *t = &state_ptr->registered_materials[i];
+    slotmap *materials = &state_ptr->registered_materials;
+    const u32 *indices = slotmap_dense_indices(materials);
+    for (u32 i = 0; i < materials->count; i++) {
+        material *t = slotmap_get_at(materials, indices[i]);
         if (t->generation == INVALID_ID) {
             continue;
         }
         destroy_material(t);
     }
     destroy_material(&state_ptr->default_material);
+    btree_map_destroy(&state_ptr->registered_material_table);
+    slotmap_destroy(materials);
     state_ptr = 0;
 }
 
@@ -146,11 +138,6 @@ material *material_system_acquire(const char *name) {
 }
 
 material *material_system_acquire_from_config(material_config config) {
-    // Return default material
-    if (strings_equali(config.name, DEFAULT_MATERIAL_NAME)) {
-        return &state_ptr->default_material;
-    }
-
     if (!state_ptr) {
         KERROR(
             "material_system_acquire failed to acquire material '%s'. System "
@@ -159,108 +146,118 @@ material *material_system_acquire_from_config(material_config config) {
         return 0;
     }
 
-    material_reference material_reference;
-
-    if (!hashtable_get(&state_ptr->registered_material_table, config.name,
-                       &material_reference)) {
-        KERROR("material_system_acquire failed to acquire material '%s'. Null "
-               "pointer will be returned.",
+    string_id name_id = string_intern(config.name);
+    if (name_id == INVALID_ID) {
+        KERROR("material_system_acquire failed to intern material name '%s'. "
+               "Null pointer will be returned.",
                config.name);
         return 0;
     }
 
-    if (material_reference.reference_count == 0) {
-        material_reference.auto_release = config.auto_release;
+    // Return default material
+    if (name_id == state_ptr->default_material.name) {
+        return &state_ptr->default_material;
     }
-    material_reference.reference_count++;
-
-    if (material_reference.handle == INVALID_ID) {
-        // Find a free index
-        u32 count = state_ptr->config.max_material_count;
-        material *material = 0;
-        for (u32 i = 0; i < count; i++) {
-            if (state_ptr->registered_materials[i].id != INVALID_ID) {
-                continue;
-            }
-            material_reference.handle = i;
-            material = &state_ptr->registered_materials[i];
-            break;
+
+    material_reference *ref =
+        btree_map_get(&state_ptr->registered_material_table, name_id);
+    if (!ref) {
+        material_reference new_ref;
+        new_ref.reference_count = 0;
+        new_ref.handle = SLOTMAP_INVALID_HANDLE;
+        new_ref.auto_release = config.auto_release;
+        if (!btree_map_insert(&state_ptr->registered_material_table, name_id,
+                              &new_ref)) {
+            KERROR("material_system_acquire failed to acquire material '%s'. "
+                   "Null pointer will be returned.",
+                   config.name);
+            return 0;
         }
+        ref = btree_map_get(&state_ptr->registered_material_table, name_id);
+    }
 
-        if (!material || material_reference.handle == INVALID_ID) {
+    if (ref->handle == SLOTMAP_INVALID_HANDLE) {
+        slotmap_handle handle;
+        material *material =
+            slotmap_insert(&state_ptr->registered_materials, &handle);
+        if (!material) {
             KFATAL("material_system_acquire - Texture system cannot hold "
                    "anymore materials. Adjust configuration to allow more.");
             return 0;
         }
 
+        // Loading acquires textures, which does not touch this map, so ref
+        // stays valid.
         if (!load_material(config, material)) {
             KERROR("Failed to load material '%s'.", config.name);
+            slotmap_remove(&state_ptr->registered_materials, handle);
+            if (ref->reference_count == 0) {
+                btree_map_erase(&state_ptr->registered_material_table,
+                                name_id);
+            }
             return 0;
         }
 
-        material->id = material_reference.handle;
+        material->id = slotmap_handle_index(handle);
+        ref->handle = handle;
     } else {
         KTRACE("Material '%s' already exists, ref count has been increased to "
                "'%i'.",
-               config.name, material_reference.reference_count);
+               config.name, ref->reference_count + 1);
     }
 
-    // Update the entry
-    hashtable_set(&state_ptr->registered_material_table, config.name,
-                  &material_reference);
-    return &state_ptr->registered_materials[material_reference.handle];
-}
-
-void material_system_release(const char *name) {
-    if (strings_equali(name, DEFAULT_MATERIAL_NAME)) {
-        KWARN("material_system_release called for default material.");
-        return;
+    if (ref->reference_count == 0) {
+        ref->auto_release = config.auto_release;
     }
+    ref->reference_count++;
+
+    return slotmap_get(&state_ptr->registered_materials, ref->handle);
+}
 
+void material_system_release(string_id name) {
     if (!state_ptr) {
         KERROR(
             "material_system_release failed to acquire material '%s'. System "
             "should be initialized when using this function.",
-            name);
+            string_intern_get(name));
         return;
     }
 
-    // This should hopefully never get called...
-    material_reference ref;
-    if (!hashtable_get(&state_ptr->registered_material_table, name, &ref)) {
-        KERROR("material_system_release failed to release material '%s'.",
-               name);
+    if (name == state_ptr->default_material.name) {
+        KWARN("material_system_release called for default material.");
         return;
     }
 
-    if (ref.reference_count == 0) {
+    material_reference *ref =
+        btree_map_get(&state_ptr->registered_material_table, name);
+    if (!ref || ref->reference_count == 0) {
         KWARN("material_system_release tried to release non-existant material "
               "'%s'.",
-              name);
+              string_intern_get(name));
         return;
     }
 
-    ref.reference_count--;
+    ref->reference_count--;
 
-    if (ref.reference_count == 0 && ref.auto_release) {
-        material *material = &state_ptr->registered_materials[ref.handle];
+    if (ref->reference_count == 0 && ref->auto_release) {
+        slotmap_handle handle = ref->handle;
+        material *material =
+            slotmap_get(&state_ptr->registered_materials, handle);
 
+        // Drop the entry first; destroying releases textures and clears the
+        // name. The next acquire starts a new reference.
+        btree_map_erase(&state_ptr->registered_material_table, name);
         destroy_material(material);
-
-        // Reset the reference
-        ref.handle = INVALID_ID;
-        ref.auto_release = false;
+        slotmap_remove(&state_ptr->registered_materials, handle);
         KTRACE("Released material '%s'. Texture is now unloaded as "
                "reference_count = 0 and auto_release = true.",
-               name);
+               string_intern_get(name));
     } else {
         KTRACE(
             "Released material '%s'. reference_count = %i, auto_release = %s.",
-            name, ref.reference_count, ref.auto_release ? "true" : "false");
+            string_intern_get(name), ref->reference_count,
+            ref->auto_release ? "true" : "false");
     }
-
-    // Update the entry
-    hashtable_set(&state_ptr->registered_material_table, name, &ref);
 }
 
 material *material_system_get_default() {
@@ -276,7 +273,7 @@ material *material_system_get_default() {
 b8 load_material(material_config config, material *mat) {
     kzero_memory(mat, sizeof(material));
 
-    string_ncopy(mat->name, config.name, MATERIAL_NAME_MAX_LENGTH);
+    mat->name = string_intern(config.name);
 
     // Type
     mat->type = config.type;
@@ -291,7 +288,7 @@ b8 load_material(material_config config, material *mat) {
         if (!mat->diffuse_map.texture) {
             KWARN(
                 "Unable to load texture '%s' for material '%s', using default",
-                config.diffuse_map_name, mat->name);
+                config.diffuse_map_name, config.name);
             mat->diffuse_map.texture = texture_system_get_default_texture();
         }
     } else {
@@ -301,7 +298,7 @@ b8 load_material(material_config config, material *mat) {
 
     if (!renderer_create_material(mat)) {
         KERROR("Failed to acquire renderer resources for material '%s'.",
-               mat->name);
+               config.name);
         return false;
     }
 
@@ -309,7 +306,7 @@ b8 load_material(material_config config, material *mat) {
 }
 
 void destroy_material(material *mat) {
-    KTRACE("Destroying material '%s'...", mat->name);
+    KTRACE("Destroying material '%s'...", string_intern_get(mat->name));
 
     // Release texture references
     if (mat->diffuse_map.texture) {
@@ -330,8 +327,7 @@ b8 create_default_material() {
     kzero_memory(&state_ptr->default_material, sizeof(material));
     state_ptr->default_material.id = INVALID_ID;
     state_ptr->default_material.generation = INVALID_ID;
-    string_ncopy(state_ptr->default_material.name, DEFAULT_MATERIAL_NAME,
-                 MATERIAL_NAME_MAX_LENGTH);
+    state_ptr->default_material.name = string_intern(DEFAULT_MATERIAL_NAME);
     state_ptr->default_material.diffuse_colour = vec4_one();
     state_ptr->default_material.diffuse_map.use = TEXTURE_USE_MAP_DIFFUSE;
     state_ptr->default_material.diffuse_map.texture =
@@ -16,6 +16,7 @@ void material_system_shutdown(void *state);
 
 material *material_system_acquire(const char *name);
 material *material_system_acquire_from_config(material_config config);
-void material_system_release(const char *name);
+// Takes the interned name, usually material->name.
+void material_system_release(string_id name);
 
 material *material_system_get_default();
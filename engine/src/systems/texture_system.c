@@ -1,9 +1,11 @@
 #include "systems/texture_system.h"
 
-#include "containers/hashtable.h"
+#include "containers/btree_map.h"
+#include "containers/slotmap.h"
+#include "core/event.h"
 #include "core/kmemory.h"
-#include "core/kstring.h"
 #include "core/logger.h"
+#include "core/string_intern.h"
 
 #include "defines.h"
 #include "renderer/renderer_frontend.h"
@@ -15,16 +17,16 @@ typedef struct texture_system_state {
     texture_system_config config;
     texture default_texture;
 
-    // Array of registered textures
-    texture *registered_textures;
+    // Registered textures, indexed by texture id
+    slotmap registered_textures;
 
-    // Hashtable for texture lookups
-    hashtable registered_texture_table;
+    // Texture references, keyed by interned name
+    btree_map registered_texture_table;
 } texture_system_state;
 
 typedef struct texture_reference {
     u64 reference_count;
-    u32 handle;
+    slotmap_handle handle;
     b8 auto_release;
 } texture_reference;
 
@@ -34,6 +36,8 @@ b8 create_default_textures(texture_system_state *state_ptr);
 void destroy_default_textures(texture_system_state *state_ptr);
 b8 load_texture(const char *texture_name, texture *t);
 void destroy_texture(texture *texture);
+b8 texture_system_on_memory_pressure(u16 code, void *sender,
+                                     void *listener_inst, event_context data);
 
 b8 texture_system_initialize(u64 *memory_requirement, void *state,
                              texture_system_config config) {
@@ -43,13 +47,13 @@ b8 texture_system_initialize(u64 *memory_requirement, void *state,
         return false;
     }
 
-    // Block of memory will contain state structure, texture array and hashtable
+    // Block of memory will contain state structure and texture slotmap. The
+    // reference map owns its own memory so it can grow.
     u64 struct_requirement = sizeof(texture_system_state);
-    u64 array_requirement = sizeof(texture) * config.max_texture_count;
-    u64 hashtable_requirement =
-        sizeof(texture_reference) * config.max_texture_count;
-    *memory_requirement =
-        struct_requirement + array_requirement + hashtable_requirement;
+    u64 slotmap_requirement = 0;
+    slotmap_create(sizeof(texture), config.max_texture_count,
+                   &slotmap_requirement, 0, 0);
+    *memory_requirement = struct_requirement + slotmap_requirement;
 
     if (!state) {
         return true;
@@ -58,34 +62,25 @@ b8 texture_system_initialize(u64 *memory_requirement, void *state,
     state_ptr = state;
     state_ptr->config = config;
 
-    // The array block is after the state. Already allocated, so just set the
-    // pointer.
-    void *array_block = state + struct_requirement;
-    state_ptr->registered_textures = array_block;
-
-    // Hashtable block is after array block
-    void *hashtable_block = array_block + array_requirement;
-    hashtable_create(sizeof(texture_reference), config.max_texture_count,
-                     hashtable_block, false,
-                     &state_ptr->registered_texture_table);
-
-    // Fill the hash table with invalid references to use as a default
-    texture_reference invalid_ref;
-    invalid_ref.auto_release = false;
-    invalid_ref.handle = INVALID_ID;
-    invalid_ref.reference_count = 0;
-    hashtable_fill(&state_ptr->registered_texture_table, &invalid_ref);
-
-    // Invalidate all textures in texture array
-    u32 count = state_ptr->config.max_texture_count;
-    for (u32 i = 0; i < count; i++) {
-        state_ptr->registered_textures[i].id = INVALID_ID;
-        state_ptr->registered_textures[i].generation = INVALID_ID;
+    // The slotmap block is after the state. Already allocated, so just hand it
+    // over.
+    void *slotmap_block = state + struct_requirement;
+    slotmap_create(sizeof(texture), config.max_texture_count,
+                   &slotmap_requirement, slotmap_block,
+                   &state_ptr->registered_textures);
+
+    if (!btree_map_create(sizeof(texture_reference),
+                          &state_ptr->registered_texture_table)) {
+        KFATAL("texture_system_initialize - failed to create reference map.");
+        return false;
     }
 
     // Create default textures
     create_default_textures(state_ptr);
 
+    event_register(EVENT_CODE_MEMORY_PRESSURE, state_ptr,
+                   texture_system_on_memory_pressure);
+
     return true;
 }
 
@@ -94,9 +89,14 @@ void texture_system_shutdown(void *state) {
         return;
     }
 
+    event_unregister(EVENT_CODE_MEMORY_PRESSURE, state_ptr,
+                     texture_system_on_memory_pressure);
+
     // Destroy all loaded textures
-    for (u32 i = 0; i < state_ptr->config.max_texture_count; i++) {
-        texture *t = &state_ptr->registered_textures[i];
+    slotmap *textures = &state_ptr->registered_textures;
+    const u32 *indices = slotmap_dense_indices(textures);
+    for (u32 i = 0; i < textures->count; i++) {
+        texture *t = slotmap_get_at(textures, indices[i]);
         if (t->generation == INVALID_ID) {
             continue;
         }
@@ -105,17 +105,13 @@ void texture_system_shutdown(void *state) {
 
     destroy_default_textures(state_ptr);
 
+    btree_map_destroy(&state_ptr->registered_texture_table);
+    slotmap_destroy(textures);
+
     state_ptr = 0;
 }
 
 texture *texture_system_acquire(const char *name, b8 auto_release) {
-    // Return default texture, warn against using this for default textures
-    if (strings_equali(name, DEFAULT_TEXTURE_NAME)) {
-        KWARN("texture_system_acquire called for default texture. Use "
-              "texture_system_get_default_texture for texture '%s'",
-              DEFAULT_TEXTURE_NAME);
-    }
-
     if (!state_ptr) {
         KERROR("texture_system_acquire failed to acquire texture '%s'. System "
                "should be initialized before using this function.",
@@ -123,112 +119,120 @@ texture *texture_system_acquire(const char *name, b8 auto_release) {
         return 0;
     }
 
-    // This should hopefully never get called...
-    texture_reference texture_reference;
-    if (!hashtable_get(&state_ptr->registered_texture_table, name,
-                       &texture_reference)) {
-        KERROR("texture_system_acquire failed to acquire texture '%s'. Null "
-               "pointer will be returned.",
+    string_id name_id = string_intern(name);
+    if (name_id == INVALID_ID) {
+        KERROR("texture_system_acquire failed to intern texture name '%s'. "
+               "Null pointer will be returned.",
                name);
         return 0;
     }
 
-    if (texture_reference.reference_count == 0) {
-        texture_reference.auto_release = auto_release;
+    // Return default texture, warn against using this for default textures
+    if (name_id == state_ptr->default_texture.name) {
+        KWARN("texture_system_acquire called for default texture. Use "
+              "texture_system_get_default_texture for texture '%s'",
+              DEFAULT_TEXTURE_NAME);
     }
-    texture_reference.reference_count++;
-
-    if (texture_reference.handle == INVALID_ID) {
-        // find a free index
-        u32 count = state_ptr->config.max_texture_count;
-        texture *texture = 0;
-        for (u32 i = 0; i < count; i++) {
-            if (state_ptr->registered_textures[i].id != INVALID_ID) {
-                continue;
-            }
-            texture_reference.handle = i;
-            texture = &state_ptr->registered_textures[i];
-            break;
+
+    texture_reference *ref =
+        btree_map_get(&state_ptr->registered_texture_table, name_id);
+    if (!ref) {
+        texture_reference new_ref;
+        new_ref.reference_count = 0;
+        new_ref.handle = SLOTMAP_INVALID_HANDLE;
+        new_ref.auto_release = auto_release;
+        if (!btree_map_insert(&state_ptr->registered_texture_table, name_id,
+                              &new_ref)) {
+            KERROR("texture_system_acquire failed to acquire texture '%s'. "
+                   "Null pointer will be returned.",
+                   name);
+            return 0;
         }
+        ref = btree_map_get(&state_ptr->registered_texture_table, name_id);
+    }
 
-        if (!texture || texture_reference.handle == INVALID_ID) {
+    if (ref->handle == SLOTMAP_INVALID_HANDLE) {
+        slotmap_handle handle;
+        texture *texture =
+            slotmap_insert(&state_ptr->registered_textures, &handle);
+        if (!texture) {
             KFATAL("texture_system_acquire - Texture system cannot hold "
                    "anymore textures. Adjust configuration to allow more.");
             return 0;
         }
+        texture->id = INVALID_ID;
+        texture->generation = INVALID_ID;
 
+        // Memory pressure events, which release textures, only fire from
+        // memory_system_end_frame, so loading leaves this map and ref alone.
         if (!load_texture(name, texture)) {
             KERROR("Failed to load texture '%s'.", name);
+            slotmap_remove(&state_ptr->registered_textures, handle);
+            if (ref->reference_count == 0) {
+                btree_map_erase(&state_ptr->registered_texture_table,
+                                name_id);
+            }
             return 0;
         }
 
-        texture->id = texture_reference.handle;
-
+        texture->id = slotmap_handle_index(handle);
+        ref->handle = handle;
     } else {
         KTRACE("Texture '%s' already exists, ref count has been increased to "
                "'%i'.",
-               name, texture_reference.reference_count);
+               name, ref->reference_count + 1);
     }
 
-    // Update the entry
-    hashtable_set(&state_ptr->registered_texture_table, name,
-                  &texture_reference);
-    return &state_ptr->registered_textures[texture_reference.handle];
-}
-
-void texture_system_release(const char *name) {
-    if (strings_equali(name, DEFAULT_TEXTURE_NAME)) {
-        KWARN("texture_system_release called for default texture.");
-        return;
+    if (ref->reference_count == 0) {
+        ref->auto_release = auto_release;
     }
+    ref->reference_count++;
+
+    return slotmap_get(&state_ptr->registered_textures, ref->handle);
+}
 
+void texture_system_release(string_id name) {
     if (!state_ptr) {
         KERROR("texture_system_release failed to acquire texture '%s'. System "
                "should be initialized when using this function.",
-               name);
+               string_intern_get(name));
         return;
     }
 
-    // This should hopefully never get called...
-    texture_reference ref;
-    if (!hashtable_get(&state_ptr->registered_texture_table, name, &ref)) {
-        KERROR("texture_system_release failed to release texture '%s'.", name);
+    if (name == state_ptr->default_texture.name) {
+        KWARN("texture_system_release called for default texture.");
         return;
     }
 
-    if (ref.reference_count == 0) {
+    texture_reference *ref =
+        btree_map_get(&state_ptr->registered_texture_table, name);
+    if (!ref || ref->reference_count == 0) {
         KWARN("texture_system_release tried to release non-existant texture "
               "'%s'.",
-              name);
+              string_intern_get(name));
         return;
     }
 
-    // A lot of the time, name will be passed in from texture.name
-    char name_copy[TEXTURE_NAME_MAX_LENGTH];
-    string_ncopy(name_copy, name, TEXTURE_NAME_MAX_LENGTH);
+    ref->reference_count--;
 
-    ref.reference_count--;
-
-    if (ref.reference_count == 0 && ref.auto_release) {
-        texture *texture = &state_ptr->registered_textures[ref.handle];
+    if (ref->reference_count == 0 && ref->auto_release) {
+        slotmap_handle handle = ref->handle;
+        texture *texture = slotmap_get(&state_ptr->registered_textures, handle);
 
         destroy_texture(texture);
+        slotmap_remove(&state_ptr->registered_textures, handle);
 
-        // Reset the reference
-        ref.handle = INVALID_ID;
-        ref.auto_release = false;
+        // Drop the entry, the next acquire starts a new reference
+        btree_map_erase(&state_ptr->registered_texture_table, name);
         KTRACE("Released texture '%s'. Texture is now unloaded as "
                "reference_count = 0 and auto_release = true.",
-               name_copy);
+               string_intern_get(name));
     } else {
         KTRACE(
             "Released texture '%s'. reference_count = %i, auto_release = %s.",
-            name_copy, ref.reference_count,
-            ref.auto_release ? "true" : "false");
+            string_intern_get(name), ref->reference_count,
+            ref->auto_release ? "true" : "false");
     }
-
-    // Update the entry
-    hashtable_set(&state_ptr->registered_texture_table, name_copy, &ref);
 }
 
 texture *texture_system_get_default_texture() {
@@ -272,8 +276,7 @@ b8 create_default_textures(texture_system_state *state_ptr) {
         }
     }
 
-    string_ncopy(state_ptr->default_texture.name, DEFAULT_TEXTURE_NAME,
-                 TEXTURE_NAME_MAX_LENGTH);
+    state_ptr->default_texture.name = string_intern(DEFAULT_TEXTURE_NAME);
     state_ptr->default_texture.width = tex_dimension;
     state_ptr->default_texture.height = tex_dimension;
     state_ptr->default_texture.channel_count = 4;
@@ -323,8 +326,8 @@ b8 load_texture(const char *texture_name, texture *t) {
         }
     }
 
-    // Take a copy of the name
-    string_ncopy(temp_texture.name, texture_name, TEXTURE_NAME_MAX_LENGTH);
+    // Names are interned, so this is only an id
+    temp_texture.name = string_intern(texture_name);
     temp_texture.generation = INVALID_ID;
     temp_texture.has_transparency = has_transparency;
 
@@ -354,8 +357,51 @@ b8 load_texture(const char *texture_name, texture *t) {
 void destroy_texture(texture *tex) {
     renderer_destroy_texture(tex);
 
-    kzero_memory(tex->name, sizeof(char) * TEXTURE_NAME_MAX_LENGTH);
     kzero_memory(tex, sizeof(texture));
     tex->id = INVALID_ID;
     tex->generation = INVALID_ID;
 }
+
+u32 texture_system_evict_unused() {
+    if (!state_ptr) {
+        return 0;
+    }
+
+    // Walk backwards, removing swaps the last live texture into place.
+    slotmap *textures = &state_ptr->registered_textures;
+    const u32 *indices = slotmap_dense_indices(textures);
+    u32 evicted = 0;
+    for (u32 i = textures->count; i > 0; i--) {
+        texture *t = slotmap_get_at(textures, indices[i - 1]);
+
+        texture_reference *ref =
+            btree_map_get(&state_ptr->registered_texture_table, t->name);
+        if (!ref || ref->reference_count != 0) {
+            continue;
+        }
+
+        // destroy_texture clears the name, so drop the entry first.
+        slotmap_handle handle = ref->handle;
+        btree_map_erase(&state_ptr->registered_texture_table, t->name);
+        destroy_texture(t);
+        slotmap_remove(textures, handle);
+        evicted++;
+    }
+
+    if (evicted) {
+        KINFO("texture_system_evict_unused - evicted %u unreferenced "
+              "texture(s).",
+              evicted);
+    }
+    return evicted;
+}
+
+b8 texture_system_on_memory_pressure(u16 code, void *sender,
+                                     void *listener_inst, event_context data) {
+    memory_tag tag = data.data.u32[0];
+    if (tag == MEMORY_TAG_TEXTURE || tag == MEMORY_TAG_RENDERER) {
+        texture_system_evict_unused();
+    }
+    // Other caches may be able to free memory too.
+    return false;
+}
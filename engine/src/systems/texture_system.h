@@ -13,6 +13,12 @@ b8 texture_system_initialize(u64 *memory_requirement, void *state,
 void texture_system_shutdown(void *state);
 
 texture *texture_system_acquire(const char *name, b8 auto_release);
-void texture_system_release(const char *name);
+// Takes the interned name, usually texture->name.
+void texture_system_release(string_id name);
 
 texture *texture_system_get_default_texture();
+
+// Unloads every texture with no references left, including ones acquired
+// without auto_release. Called on EVENT_CODE_MEMORY_PRESSURE for the texture
+// and renderer tags. Returns the number unloaded.
+u32 texture_system_evict_unused();
@@ -12,6 +12,10 @@ b8 create_game(game *out_game) {
     out_game->app_config.start_height = 720;
     out_game->app_config.name = "Kohi Engine Testbed";
 
+    // Textures get a chance to evict before hitting their ceiling.
+    memory_tag_budget texture_budget = {MEBIBYTES(192), MEBIBYTES(256)};
+    out_game->app_config.memory_budgets[MEMORY_TAG_TEXTURE] = texture_budget;
+
     out_game->initialize = game_initialize;
     out_game->update = game_update;
     out_game->render = game_render;
@@ -3,8 +3,10 @@
 #include <core/event.h>
 #include <core/input.h>
 #include <core/kmemory.h>
+#include <core/kstring.h>
 #include <core/logger.h>
 #include <math/kmath.h>
+#include <platform/filesystem.h>
 
 // should not be available outside the engine
 #include <renderer/renderer_frontend.h>
@@ -58,6 +60,24 @@ b8 game_update(game *game_inst, f32 delta_time) {
     if (input_is_key_up('M') && input_was_key_down('M')) {
         KDEBUG("Allocations: %llu (%llu this frame).", alloc_count,
                alloc_count - previous_alloc_count);
+        char *report =
+            get_memory_allocation_report(ALLOCATION_TRACKER_SORT_FRAME_CHURN,
+                                         10);
+        KDEBUG("%s", report);
+        kfree(report, string_length(report) + 1, MEMORY_TAG_STRING);
+    }
+
+    if (input_is_key_up('N') && input_was_key_down('N')) {
+        char *json = get_memory_allocation_json();
+        file_handle file;
+        if (filesystem_open("memory_snapshot.json", FILE_MODE_WRITE, false,
+                            &file)) {
+            u64 written = 0;
+            filesystem_write(&file, string_length(json), json, &written);
+            filesystem_close(&file);
+            KDEBUG("Wrote memory_snapshot.json.");
+        }
+        kfree(json, string_length(json) + 1, MEMORY_TAG_STRING);
     }
 
     // TODO: temp
@@ -0,0 +1,271 @@
+#include "btree_map_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/clock.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+
+#include <containers/btree_map.h>
+#include <containers/hashtable.h>
+#include <defines.h>
+
+#define BTREE_MAP_TEST_COUNT 10000
+#define BTREE_MAP_BENCH_COUNT 65536
+#define BTREE_MAP_BENCH_NAME_LENGTH 16
+
+typedef struct btree_map_test_value {
+    u64 key;
+    u32 payload;
+} btree_map_test_value;
+
+// Visits 0..count - 1 in a scattered order; 7919 is prime, so coprime with
+// the counts used here.
+static u64 btree_map_test_scatter(u64 i, u64 count) {
+    return (i * 7919) % count;
+}
+
+u8 btree_map_should_insert_get_and_erase() {
+    u8 failed = false;
+
+    btree_map map;
+    expect_to_be_true(btree_map_create(sizeof(btree_map_test_value), &map));
+    expect_should_be(0, map.count);
+    expect_should_be(0, btree_map_get(&map, 5));
+
+    btree_map_test_value value = {5, 50};
+    expect_to_be_true(btree_map_insert(&map, 5, &value));
+    expect_should_be(1, map.count);
+    btree_map_test_value *got = btree_map_get(&map, 5);
+    expect_should_not_be(0, got);
+    expect_should_be(50, got->payload);
+
+    // Inserting an existing key replaces its value.
+    value.payload = 51;
+    expect_to_be_true(btree_map_insert(&map, 5, &value));
+    expect_should_be(1, map.count);
+    got = btree_map_get(&map, 5);
+    expect_should_be(51, got->payload);
+
+    expect_to_be_false(btree_map_erase(&map, 6));
+    expect_to_be_true(btree_map_erase(&map, 5));
+    expect_to_be_false(btree_map_erase(&map, 5));
+    expect_should_be(0, map.count);
+    expect_should_be(0, btree_map_get(&map, 5));
+
+    btree_map_destroy(&map);
+
+    return failed ? false : true;
+}
+
+u8 btree_map_should_stay_ordered_through_splits_and_merges() {
+    u8 failed = false;
+
+    btree_map map;
+    btree_map_create(sizeof(btree_map_test_value), &map);
+
+    for (u64 i = 0; i < BTREE_MAP_TEST_COUNT; i++) {
+        u64 key = btree_map_test_scatter(i, BTREE_MAP_TEST_COUNT) * 2;
+        btree_map_test_value value = {key, (u32)i};
+        expect_to_be_true(btree_map_insert(&map, key, &value));
+    }
+    expect_should_be(BTREE_MAP_TEST_COUNT, map.count);
+
+    // Walks every key in order.
+    u64 expected = 0;
+    btree_map_iterator it = btree_map_begin(&map);
+    for (; btree_map_iterator_valid(&it); btree_map_iterator_next(&it)) {
+        expect_should_be(expected, btree_map_iterator_key(&it));
+        btree_map_test_value *value = btree_map_iterator_value(&it);
+        expect_should_be(expected, value->key);
+        expected += 2;
+    }
+    expect_should_be(BTREE_MAP_TEST_COUNT * 2, expected);
+
+    // Erasing every other key, scattered, rebalances without losing any.
+    for (u64 i = 0; i < BTREE_MAP_TEST_COUNT; i++) {
+        u64 key = btree_map_test_scatter(i, BTREE_MAP_TEST_COUNT) * 2;
+        if (key % 4 == 0) {
+            expect_to_be_true(btree_map_erase(&map, key));
+        }
+    }
+    expect_should_be(BTREE_MAP_TEST_COUNT / 2, map.count);
+    for (u64 key = 0; key < BTREE_MAP_TEST_COUNT * 2; key += 2) {
+        btree_map_test_value *value = btree_map_get(&map, key);
+        if (key % 4 == 0) {
+            expect_should_be(0, value);
+        } else {
+            expect_should_not_be(0, value);
+            expect_should_be(key, value->key);
+        }
+    }
+
+    expected = 2;
+    it = btree_map_begin(&map);
+    for (; btree_map_iterator_valid(&it); btree_map_iterator_next(&it)) {
+        expect_should_be(expected, btree_map_iterator_key(&it));
+        expected += 4;
+    }
+
+    // Empty it completely, then refill it the same way from the freed nodes.
+    for (u64 key = 2; key < BTREE_MAP_TEST_COUNT * 2; key += 4) {
+        expect_to_be_true(btree_map_erase(&map, key));
+    }
+    expect_should_be(0, map.count);
+    it = btree_map_begin(&map);
+    expect_to_be_false(btree_map_iterator_valid(&it));
+
+    void *pages = map.pages;
+    for (u64 i = 0; i < BTREE_MAP_TEST_COUNT; i++) {
+        u64 key = btree_map_test_scatter(i, BTREE_MAP_TEST_COUNT) * 2;
+        btree_map_test_value value = {key, (u32)i};
+        btree_map_insert(&map, key, &value);
+    }
+    expect_should_be(BTREE_MAP_TEST_COUNT, map.count);
+    expect_should_be(pages, map.pages);
+
+    btree_map_destroy(&map);
+
+    return failed ? false : true;
+}
+
+u8 btree_map_should_find_lower_bound() {
+    u8 failed = false;
+
+    btree_map map;
+    btree_map_create(sizeof(u32), &map);
+
+    btree_map_iterator it = btree_map_lower_bound(&map, 0);
+    expect_to_be_false(btree_map_iterator_valid(&it));
+
+    // Keys 10, 20, ... 10000.
+    for (u32 i = 1; i <= 1000; i++) {
+        btree_map_insert(&map, i * 10, &i);
+    }
+
+    it = btree_map_lower_bound(&map, 0);
+    expect_to_be_true(btree_map_iterator_valid(&it));
+    expect_should_be(10, btree_map_iterator_key(&it));
+
+    it = btree_map_lower_bound(&map, 500);
+    expect_should_be(500, btree_map_iterator_key(&it));
+    expect_should_be(50, *(u32 *)btree_map_iterator_value(&it));
+
+    it = btree_map_lower_bound(&map, 501);
+    expect_should_be(510, btree_map_iterator_key(&it));
+
+    it = btree_map_lower_bound(&map, 10001);
+    expect_to_be_false(btree_map_iterator_valid(&it));
+
+    // A range query: every key in [2005, 2105).
+    u32 found = 0;
+    it = btree_map_lower_bound(&map, 2005);
+    for (; btree_map_iterator_valid(&it) && btree_map_iterator_key(&it) < 2105;
+         btree_map_iterator_next(&it)) {
+        found++;
+    }
+    expect_should_be(10, found);
+
+    btree_map_destroy(&map);
+
+    return failed ? false : true;
+}
+
+u8 btree_map_benchmark_lookup() {
+    u8 failed = false;
+
+    u64 count = BTREE_MAP_BENCH_COUNT;
+    char *names = kallocate(count * BTREE_MAP_BENCH_NAME_LENGTH,
+                            MEMORY_TAG_ARRAY);
+    for (u64 i = 0; i < count; i++) {
+        string_format(names + i * BTREE_MAP_BENCH_NAME_LENGTH, "key_%llu", i);
+    }
+
+    btree_map map;
+    btree_map_create(sizeof(u64), &map);
+    hashtable table;
+    hashtable_create(sizeof(u64), count, false, &table);
+
+    clock timer;
+    clock_start(&timer);
+    for (u64 i = 0; i < count; i++) {
+        u64 key = btree_map_test_scatter(i, count);
+        btree_map_insert(&map, key, &key);
+    }
+    clock_update(&timer);
+    f64 btree_insert = timer.elapsed;
+
+    clock_start(&timer);
+    for (u64 i = 0; i < count; i++) {
+        u64 key = btree_map_test_scatter(i, count);
+        hashtable_set(&table, names + key * BTREE_MAP_BENCH_NAME_LENGTH, &key);
+    }
+    clock_update(&timer);
+    f64 table_insert = timer.elapsed;
+
+    // Look everything up in a different scattered order than it went in.
+    u64 btree_sum = 0;
+    clock_start(&timer);
+    for (u64 i = 0; i < count; i++) {
+        u64 key = (i * 40503) % count;
+        u64 *value = btree_map_get(&map, key);
+        btree_sum += value ? *value : 0;
+    }
+    clock_update(&timer);
+    f64 btree_lookup = timer.elapsed;
+
+    u64 table_sum = 0;
+    clock_start(&timer);
+    for (u64 i = 0; i < count; i++) {
+        u64 key = (i * 40503) % count;
+        u64 value = 0;
+        hashtable_get(&table, names + key * BTREE_MAP_BENCH_NAME_LENGTH,
+                      &value);
+        table_sum += value;
+    }
+    clock_update(&timer);
+    f64 table_lookup = timer.elapsed;
+
+    u64 expected_sum = count * (count - 1) / 2;
+    expect_should_be(expected_sum, btree_sum);
+    expect_should_be(expected_sum, table_sum);
+
+    // Ordered iteration, which the hashtable cannot do.
+    u64 iterated = 0;
+    clock_start(&timer);
+    btree_map_iterator it = btree_map_begin(&map);
+    for (; btree_map_iterator_valid(&it); btree_map_iterator_next(&it)) {
+        iterated += *(u64 *)btree_map_iterator_value(&it);
+    }
+    clock_update(&timer);
+    expect_should_be(expected_sum, iterated);
+
+    KINFO("B-tree map vs hashtable at %llu entries (ns per op) - insert: "
+          "%.0f vs %.0f, lookup: %.0f vs %.0f. B-tree in-order walk: %.1f.",
+          count, btree_insert * 1e9 / count, table_insert * 1e9 / count,
+          btree_lookup * 1e9 / count, table_lookup * 1e9 / count,
+          timer.elapsed * 1e9 / count);
+
+    hashtable_destroy(&table);
+    btree_map_destroy(&map);
+    kfree(names, count * BTREE_MAP_BENCH_NAME_LENGTH, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+void btree_map_register_tests() {
+    test_manager_register_test(
+        btree_map_should_insert_get_and_erase,
+        "B-tree map should insert, replace, get and erase entries.");
+    test_manager_register_test(
+        btree_map_should_stay_ordered_through_splits_and_merges,
+        "B-tree map should keep keys ordered through splits and merges.");
+    test_manager_register_test(
+        btree_map_should_find_lower_bound,
+        "B-tree map lower_bound should find the first key not less than the "
+        "given one.");
+    test_manager_register_test(
+        btree_map_benchmark_lookup,
+        "B-tree map point lookup benchmark against the hashtable.");
+}
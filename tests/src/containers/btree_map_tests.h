@@ -0,0 +1,3 @@
+#pragma once
+
+void btree_map_register_tests();
@@ -0,0 +1,210 @@
+#include "darray_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/darray.h>
+#include <core/clock.h>
+#include <core/logger.h>
+#include <defines.h>
+
+#define DARRAY_BENCH_COUNT (1024 * 1024)
+
+u8 darray_should_push_and_pop_across_growth() {
+    u8 failed = false;
+
+    u32 *array = darray_create(u32);
+    expect_should_be(0, darray_length(array));
+    expect_should_be(DARRAY_DEFAULT_CAPACITY, darray_capacity(array));
+    expect_should_be(sizeof(u32), darray_stride(array));
+
+    for (u32 i = 0; i < 1000; i++) {
+        darray_push(array, i);
+    }
+    expect_should_be(1000, darray_length(array));
+    expect_to_be_true((darray_capacity(array) >= 1000));
+    for (u32 i = 0; i < 1000; i++) {
+        expect_should_be(i, array[i]);
+    }
+
+    u32 value = 0;
+    darray_pop(array, &value);
+    expect_should_be(999, value);
+    expect_should_be(999, darray_length(array));
+
+    darray_destroy(array);
+
+    return failed ? false : true;
+}
+
+u8 darray_should_follow_growth_policy() {
+    u8 failed = false;
+
+    darray_growth_policy defaults = darray_get_growth_policy();
+    expect_should_be(DARRAY_DEFAULT_GROWTH_PERCENT, defaults.growth_percent);
+    expect_should_be(DARRAY_DEFAULT_MIN_CAPACITY, defaults.min_capacity);
+
+    // A full array of capacity 1 grows straight to the minimum, then doubles.
+    u64 *array = darray_reserve(u64, 1);
+    darray_push(array, (u64)0);
+    darray_push(array, (u64)1);
+    expect_should_be(8, darray_capacity(array));
+    for (u64 i = 2; i < 9; i++) {
+        darray_push(array, i);
+    }
+    expect_should_be(16, darray_capacity(array));
+    darray_destroy(array);
+
+    darray_growth_policy policy = {150, 4};
+    darray_set_growth_policy(policy);
+    array = darray_reserve(u64, 1);
+    darray_push(array, (u64)0);
+    darray_push(array, (u64)1);
+    expect_should_be(4, darray_capacity(array));
+    for (u64 i = 2; i < 5; i++) {
+        darray_push(array, i);
+    }
+    expect_should_be(6, darray_capacity(array));
+    for (u64 i = 0; i < 5; i++) {
+        expect_should_be(i, array[i]);
+    }
+    darray_destroy(array);
+
+    // Growth below 110% is clamped, so arrays always grow.
+    policy.growth_percent = 100;
+    darray_set_growth_policy(policy);
+    expect_should_be(110, darray_get_growth_policy().growth_percent);
+
+    darray_set_growth_policy(defaults);
+
+    return failed ? false : true;
+}
+
+u8 darray_should_push_n_and_reserve() {
+    u8 failed = false;
+
+    u32 values[100];
+    for (u32 i = 0; i < 100; i++) {
+        values[i] = i * 3;
+    }
+
+    u32 *array = darray_create(u32);
+    darray_push(array, (u32)7);
+    // Grows once, to exactly what is needed.
+    darray_push_n(array, values, 100);
+    expect_should_be(101, darray_length(array));
+    expect_should_be(101, darray_capacity(array));
+    expect_should_be(7, array[0]);
+    expect_should_be(0, array[1]);
+    expect_should_be(297, array[100]);
+
+    darray_reserve_on(array, 50);
+    u64 capacity = darray_capacity(array);
+    expect_to_be_true((capacity >= 151));
+    expect_should_be(101, darray_length(array));
+    expect_should_be(297, array[100]);
+
+    // Already room, so nothing changes.
+    darray_reserve_on(array, 10);
+    expect_should_be(capacity, darray_capacity(array));
+
+    darray_destroy(array);
+
+    return failed ? false : true;
+}
+
+u8 darray_should_stay_unchanged_when_growth_fails() {
+    u8 failed = false;
+
+    u64 *array = darray_create(u64);
+    for (u64 i = 0; i < 4; i++) {
+        darray_push(array, i);
+    }
+    u64 capacity = darray_capacity(array);
+
+    // Far more than the memory system can hand out. The values are never
+    // read, since nothing is copied when the array cannot grow.
+    KDEBUG("Note: The following errors are intentionally caused by this "
+           "test.");
+    u64 too_many = (u64)1 << 40;
+    darray_push_n(array, array, too_many);
+    expect_should_be(4, darray_length(array));
+    expect_should_be(capacity, darray_capacity(array));
+    for (u64 i = 0; i < 4; i++) {
+        expect_should_be(i, array[i]);
+    }
+
+    darray_destroy(array);
+
+    return failed ? false : true;
+}
+
+// Pushes DARRAY_BENCH_COUNT values one at a time, counting how often growth
+// had to move the array rather than extend it in place.
+static u64 darray_bench_push(f64 *out_seconds, u64 *out_moves) {
+    u64 *array = darray_create(u64);
+    u64 moves = 0;
+    clock timer;
+    clock_start(&timer);
+    for (u64 i = 0; i < DARRAY_BENCH_COUNT; i++) {
+        u64 *before = array;
+        darray_push(array, i);
+        if (array != before) {
+            moves++;
+        }
+    }
+    clock_update(&timer);
+
+    u64 sum = 0;
+    for (u64 i = 0; i < darray_length(array); i++) {
+        sum += array[i];
+    }
+    darray_destroy(array);
+
+    *out_seconds = timer.elapsed;
+    *out_moves = moves;
+    return sum;
+}
+
+u8 darray_benchmark_growth() {
+    u8 failed = false;
+
+    darray_growth_policy defaults = darray_get_growth_policy();
+    u32 percents[] = {200, 150, 125};
+    u64 expected_sum = (u64)DARRAY_BENCH_COUNT * (DARRAY_BENCH_COUNT - 1) / 2;
+
+    for (u32 i = 0; i < 3; i++) {
+        darray_growth_policy policy = defaults;
+        policy.growth_percent = percents[i];
+        darray_set_growth_policy(policy);
+
+        f64 seconds = 0;
+        u64 moves = 0;
+        expect_should_be(expected_sum, darray_bench_push(&seconds, &moves));
+        KINFO("Darray push of %u u64s at %u%% growth: %.2f ms, %.1f ns per "
+              "push, %llu of the growths moved the array.",
+              DARRAY_BENCH_COUNT, percents[i], seconds * 1e3,
+              seconds * 1e9 / DARRAY_BENCH_COUNT, moves);
+    }
+
+    darray_set_growth_policy(defaults);
+
+    return failed ? false : true;
+}
+
+void darray_register_tests() {
+    test_manager_register_test(
+        darray_should_push_and_pop_across_growth,
+        "Darray should keep its elements as it grows.");
+    test_manager_register_test(
+        darray_should_follow_growth_policy,
+        "Darray should grow by the configured factor and minimum capacity.");
+    test_manager_register_test(
+        darray_should_push_n_and_reserve,
+        "Darray should push many elements and reserve space at once.");
+    test_manager_register_test(
+        darray_should_stay_unchanged_when_growth_fails,
+        "Darray should keep its contents when it cannot grow.");
+    test_manager_register_test(darray_benchmark_growth,
+                               "Darray growth benchmark.");
+}
@@ -3,12 +3,15 @@
 
 #include "../expect.h"
 #include "../test_manager.h"
+#include "core/clock.h"
 #include "core/kmemory.h"
 #include "core/logger.h"
 
 #include <containers/freelist.h>
 #include <defines.h>
 
+#include <stdlib.h>
+
 u8 freelist_should_create_and_destroy() {
     u8 failed = false;
 
@@ -405,6 +408,226 @@ u8 freelist_should_resize_and_allocate_new_space() {
     return failed ? false : true;
 }
 
+u8 freelist_should_size_node_pool_to_ranges() {
+    u8 failed = false;
+
+    // The node pool no longer scales with every byte tracked.
+    u64 memory_requirement = 0;
+    freelist_create(GIBIBYTES(1), &memory_requirement, 0, 0);
+    expect_to_be_true((memory_requirement < MEBIBYTES(4)));
+
+    u64 small_requirement = 0;
+    freelist_create(1024, &small_requirement, 0, 0);
+    u64 larger_requirement = 0;
+    freelist_create_with_capacity(1024, FREELIST_MIN_ENTRIES * 2,
+                                  &larger_requirement, 0, 0);
+    expect_to_be_true((larger_requirement > small_requirement));
+
+    return failed ? false : true;
+}
+
+u8 freelist_should_track_ranges_past_4gib() {
+    u8 failed = false;
+
+    // Only offsets are tracked, so no backing memory is needed.
+    freelist list;
+    u64 gib = GIBIBYTES(1);
+    u64 total_size = 8 * gib;
+    u64 memory_requirement = 0;
+    freelist_create(total_size, &memory_requirement, 0, 0);
+    void *memory = kallocate(memory_requirement, MEMORY_TAG_ARRAY);
+    freelist_create(total_size, &memory_requirement, memory, &list);
+
+    u64 offset1 = 0, offset2 = 0;
+    expect_to_be_true(freelist_allocate_block(&list, 5 * gib, &offset1));
+    expect_to_be_true(freelist_allocate_block(&list, 2 * gib, &offset2));
+    expect_should_be(0, offset1);
+    expect_should_be(5 * gib, offset2);
+    expect_should_be(gib, freelist_free_space(&list));
+
+    expect_to_be_true(freelist_free_block(&list, 5 * gib, offset1));
+    expect_should_be(5 * gib, freelist_largest_free_block(&list));
+    expect_to_be_true(freelist_free_block(&list, 2 * gib, offset2));
+    expect_should_be(total_size, freelist_largest_free_block(&list));
+
+    freelist_destroy(&list);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+u8 freelist_should_fail_free_when_out_of_nodes() {
+    u8 failed = false;
+
+    freelist list;
+    u64 total_size = 1024;
+    u64 memory_requirement = 0;
+    freelist_create_with_capacity(total_size, 2, &memory_requirement, 0, 0);
+    void *memory = kallocate(memory_requirement, MEMORY_TAG_ARRAY);
+    freelist_create_with_capacity(total_size, 2, &memory_requirement, memory,
+                                  &list);
+
+    u64 offsets[4];
+    for (u32 i = 0; i < 4; i++) {
+        expect_to_be_true(freelist_allocate_block(&list, 100, &offsets[i]));
+    }
+
+    // Two ranges: [0, 100) and the tail.
+    expect_to_be_true(freelist_free_block(&list, 100, offsets[0]));
+
+    KDEBUG("Note: The following errors are intentionally caused by this "
+           "test.");
+    // A third range needs a third node.
+    expect_to_be_false(freelist_free_block(&list, 100, offsets[2]));
+
+    // Frees that merge with an existing range need no node.
+    expect_to_be_true(freelist_free_block(&list, 100, offsets[1]));
+    expect_to_be_true(freelist_free_block(&list, 100, offsets[2]));
+    expect_to_be_true(freelist_free_block(&list, 100, offsets[3]));
+    expect_should_be(total_size, freelist_free_space(&list));
+    expect_should_be(total_size, freelist_largest_free_block(&list));
+
+    freelist_destroy(&list);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+u8 freelist_should_allocate_best_fit() {
+    u8 failed = false;
+
+    freelist list;
+    u64 total_size = 1024;
+    u64 memory_requirement = 0;
+    freelist_create(total_size, &memory_requirement, 0, 0);
+    void *memory = kallocate(memory_requirement, MEMORY_TAG_ARRAY);
+    freelist_create(total_size, &memory_requirement, memory, &list);
+
+    // Leave a 300 byte hole, then a 100 byte hole.
+    u64 sizes[4] = {300, 100, 100, 100};
+    u64 offsets[4];
+    for (u32 i = 0; i < 4; i++) {
+        b8 result = freelist_allocate_block(&list, sizes[i], &offsets[i]);
+        expect_to_be_true(result);
+    }
+    expect_to_be_true(freelist_free_block(&list, sizes[0], offsets[0]));
+    expect_to_be_true(freelist_free_block(&list, sizes[2], offsets[2]));
+
+    // The smallest range that fits is used, not the first.
+    u64 offset = 0;
+    expect_to_be_true(freelist_allocate_block(&list, 100, &offset));
+    expect_should_be(offsets[2], offset);
+    expect_to_be_true(freelist_allocate_block(&list, 200, &offset));
+    expect_should_be(offsets[0], offset);
+
+    freelist_destroy(&list);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+// Small xorshift so runs see the same sequence.
+static u32 freelist_bench_next(u32 *seed) {
+    u32 x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+static int freelist_bench_compare(const void *a, const void *b) {
+    f64 x = *(const f64 *)a;
+    f64 y = *(const f64 *)b;
+    return (x > y) - (x < y);
+}
+
+static void freelist_bench_report(const char *name, f64 *samples, u64 count) {
+    qsort(samples, count, sizeof(f64), freelist_bench_compare);
+    KINFO("Freelist %s latency (ns) over %llu ops - p50: %.0f, p90: %.0f, "
+          "p99: %.0f, p99.9: %.0f, max: %.0f.",
+          name, count, samples[count / 2] * 1e9,
+          samples[count * 90 / 100] * 1e9, samples[count * 99 / 100] * 1e9,
+          samples[count * 999 / 1000] * 1e9, samples[count - 1] * 1e9);
+}
+
+#define FREELIST_BENCH_LIVE_BLOCKS 100000
+#define FREELIST_BENCH_MAX_SIZE 4096
+
+// Grows to FREELIST_BENCH_LIVE_BLOCKS live blocks, replaces a random one per
+// op for as many ops again, then frees everything. Each op is timed on its
+// own, so the clock's overhead is included in every sample.
+u8 freelist_benchmark_latency() {
+    u8 failed = false;
+
+    u64 live = FREELIST_BENCH_LIVE_BLOCKS;
+    freelist list;
+    u64 total_size = live * FREELIST_BENCH_MAX_SIZE * 2;
+    u64 memory_requirement = 0;
+    freelist_create_with_capacity(total_size, live * 2, &memory_requirement, 0,
+                                  0);
+    void *memory = kallocate(memory_requirement, MEMORY_TAG_ARRAY);
+    freelist_create_with_capacity(total_size, live * 2, &memory_requirement,
+                                  memory, &list);
+
+    u64 *offsets = kallocate(sizeof(u64) * live, MEMORY_TAG_ARRAY);
+    u64 *sizes = kallocate(sizeof(u64) * live, MEMORY_TAG_ARRAY);
+    f64 *allocate_samples = kallocate(sizeof(f64) * live * 2, MEMORY_TAG_ARRAY);
+    f64 *free_samples = kallocate(sizeof(f64) * live * 2, MEMORY_TAG_ARRAY);
+    u64 allocate_count = 0;
+    u64 free_count = 0;
+    u32 seed = 0x9E3779B9;
+    b8 ok = true;
+    clock timer;
+
+    for (u64 i = 0; i < live && ok; i++) {
+        sizes[i] = 16 + (freelist_bench_next(&seed) % FREELIST_BENCH_MAX_SIZE);
+        clock_start(&timer);
+        ok = freelist_allocate_block(&list, sizes[i], &offsets[i]);
+        clock_update(&timer);
+        allocate_samples[allocate_count++] = timer.elapsed;
+    }
+
+    for (u64 i = 0; i < live && ok; i++) {
+        u32 slot = freelist_bench_next(&seed) % live;
+        clock_start(&timer);
+        ok = freelist_free_block(&list, sizes[slot], offsets[slot]);
+        clock_update(&timer);
+        free_samples[free_count++] = timer.elapsed;
+
+        sizes[slot] =
+            16 + (freelist_bench_next(&seed) % FREELIST_BENCH_MAX_SIZE);
+        clock_start(&timer);
+        ok = ok && freelist_allocate_block(&list, sizes[slot], &offsets[slot]);
+        clock_update(&timer);
+        allocate_samples[allocate_count++] = timer.elapsed;
+    }
+
+    for (u64 i = 0; i < live && ok; i++) {
+        clock_start(&timer);
+        ok = freelist_free_block(&list, sizes[i], offsets[i]);
+        clock_update(&timer);
+        free_samples[free_count++] = timer.elapsed;
+    }
+    expect_to_be_true(ok);
+
+    // Everything merged back into one range.
+    expect_should_be(total_size, freelist_free_space(&list));
+    expect_should_be(total_size, freelist_largest_free_block(&list));
+
+    freelist_bench_report("allocate", allocate_samples, allocate_count);
+    freelist_bench_report("free", free_samples, free_count);
+
+    kfree(free_samples, sizeof(f64) * live * 2, MEMORY_TAG_ARRAY);
+    kfree(allocate_samples, sizeof(f64) * live * 2, MEMORY_TAG_ARRAY);
+    kfree(sizes, sizeof(u64) * live, MEMORY_TAG_ARRAY);
+    kfree(offsets, sizeof(u64) * live, MEMORY_TAG_ARRAY);
+    freelist_destroy(&list);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
 void freelist_register_tests() {
     test_manager_register_test(
         freelist_should_create_and_destroy,
@@ -447,4 +670,24 @@ void freelist_register_tests() {
     test_manager_register_test(
         freelist_should_resize_and_allocate_new_space,
         "Freelist should allow allocation in new space after resize.");
+
+    test_manager_register_test(
+        freelist_should_size_node_pool_to_ranges,
+        "Freelist node pool should be sized to free ranges, not bytes.");
+
+    test_manager_register_test(
+        freelist_should_track_ranges_past_4gib,
+        "Freelist should track ranges past 4GiB.");
+
+    test_manager_register_test(
+        freelist_should_fail_free_when_out_of_nodes,
+        "Freelist should fail frees that need more nodes than it has.");
+
+    test_manager_register_test(
+        freelist_should_allocate_best_fit,
+        "Freelist should allocate from the smallest range that fits.");
+
+    test_manager_register_test(freelist_benchmark_latency,
+                               "Freelist allocate and free latency benchmark "
+                               "at 100k live blocks.");
 }
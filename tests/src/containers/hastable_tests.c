@@ -5,6 +5,7 @@
 #include "../test_manager.h"
 
 #include <containers/hashtable.h>
+#include <core/kstring.h>
 #include <defines.h>
 
 u8 hashtable_should_create_and_destroy() {
@@ -13,9 +14,7 @@ u8 hashtable_should_create_and_destroy() {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
-
-    hashtable_create(element_size, element_count, memory, false, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(u64), table.element_size);
@@ -36,9 +35,7 @@ u8 hashtable_should_set_and_get_successfully() {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
-
-    hashtable_create(element_size, element_count, memory, false, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(u64), table.element_size);
@@ -71,9 +68,7 @@ u8 hashtable_should_set_and_get_ptr_successfully() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct *);
     u64 element_count = 3;
-    u64 memory[3];
-
-    hashtable_create(element_size, element_count, memory, true, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(ht_test_struct *), table.element_size);
@@ -108,9 +103,7 @@ u8 hashtable_should_set_and_get_nonexistant() {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
-
-    hashtable_create(element_size, element_count, memory, false, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(u64), table.element_size);
@@ -137,9 +130,7 @@ u8 hashtable_should_set_and_get_ptr_nonexistant() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct *);
     u64 element_count = 3;
-    u64 memory[3];
-
-    hashtable_create(element_size, element_count, memory, true, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(ht_test_struct *), table.element_size);
@@ -173,9 +164,7 @@ u8 hashtable_should_set_and_unset_ptr() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct *);
     u64 element_count = 3;
-    u64 memory[3];
-
-    hashtable_create(element_size, element_count, memory, true, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(ht_test_struct *), table.element_size);
@@ -220,9 +209,7 @@ u8 try_call_non_ptr_on_ptr_table() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct *);
     u64 element_count = 3;
-    u64 memory[3];
-
-    hashtable_create(element_size, element_count, memory, true, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(ht_test_struct *), table.element_size);
@@ -256,9 +243,7 @@ u8 try_call_ptr_on_non_ptr_table() {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
-
-    hashtable_create(element_size, element_count, memory, false, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(u64), table.element_size);
@@ -291,9 +276,7 @@ u8 hashtable_should_set_get_and_update_ptr_successfully() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct *);
     u64 element_count = 3;
-    u64 memory[3];
-
-    hashtable_create(element_size, element_count, memory, true, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(ht_test_struct *), table.element_size);
@@ -333,6 +316,118 @@ u8 hashtable_should_set_get_and_update_ptr_successfully() {
     return failed ? false : true;
 }
 
+u8 hashtable_should_keep_many_entries_and_grow() {
+    u8 failed = false;
+
+    hashtable table;
+    u64 element_size = sizeof(u64);
+    u64 element_count = 3;
+
+    hashtable_create(element_size, element_count, false, &table);
+    u32 initial_capacity = table.capacity;
+
+    // Far more entries than slots, so names must collide and the table grow.
+    char name[32];
+    for (u64 i = 0; i < 1000; i++) {
+        string_format(name, "texture_%llu", i);
+        u64 value = i * 3;
+        b8 result = hashtable_set(&table, name, &value);
+        expect_to_be_true(result);
+    }
+
+    expect_should_be(1000, table.count);
+    expect_to_be_true((table.capacity > initial_capacity));
+
+    for (u64 i = 0; i < 1000; i++) {
+        string_format(name, "texture_%llu", i);
+        u64 value = 0;
+        b8 result = hashtable_get(&table, name, &value);
+        expect_to_be_true(result);
+        expect_should_be(i * 3, value);
+    }
+
+    hashtable_destroy(&table);
+
+    expect_should_be(0, table.memory);
+
+    return failed ? false : true;
+}
+
+u8 hashtable_should_remove_entries() {
+    u8 failed = false;
+
+    hashtable table;
+    u64 element_size = sizeof(u64);
+    u64 element_count = 64;
+
+    hashtable_create(element_size, element_count, false, &table);
+
+    char name[32];
+    for (u64 i = 0; i < 64; i++) {
+        string_format(name, "material_%llu", i);
+        hashtable_set(&table, name, &i);
+    }
+
+    // Remove every other entry, the rest should survive the backward shifts.
+    for (u64 i = 0; i < 64; i += 2) {
+        string_format(name, "material_%llu", i);
+        b8 result = hashtable_remove(&table, name);
+        expect_to_be_true(result);
+    }
+
+    expect_should_be(32, table.count);
+
+    for (u64 i = 0; i < 64; i++) {
+        string_format(name, "material_%llu", i);
+        u64 value = 99;
+        b8 result = hashtable_get(&table, name, &value);
+        if (i % 2) {
+            expect_to_be_true(result);
+            expect_should_be(i, value);
+        } else {
+            expect_to_be_false(result);
+            expect_should_be(0, value);
+        }
+    }
+
+    b8 result = hashtable_remove(&table, "material_0");
+    expect_to_be_false(result);
+
+    hashtable_destroy(&table);
+
+    return failed ? false : true;
+}
+
+u8 hashtable_should_get_default_after_fill() {
+    u8 failed = false;
+
+    hashtable table;
+    u64 element_size = sizeof(u64);
+    u64 element_count = 3;
+
+    hashtable_create(element_size, element_count, false, &table);
+
+    u64 invalid = INVALID_ID;
+    hashtable_fill(&table, &invalid);
+
+    u64 testval1 = 23;
+    hashtable_set(&table, "test1", &testval1);
+
+    u64 get_testval1 = 0;
+    b8 result = hashtable_get(&table, "test1", &get_testval1);
+    expect_to_be_true(result);
+    expect_should_be(testval1, get_testval1);
+
+    u64 get_testval2 = 0;
+    result = hashtable_get(&table, "test2", &get_testval2);
+    expect_to_be_true(result);
+    expect_should_be(invalid, get_testval2);
+
+    hashtable_destroy(&table);
+
+    return failed ? false : true;
+}
+
 void hashtable_register_tests() {
     test_manager_register_test(
         hashtable_should_create_and_destroy,
@@ -361,4 +456,12 @@ void hashtable_register_tests() {
         hashtable_should_set_get_and_update_ptr_successfully,
         "Hashtable should set, get, update, and get pointer again "
         "successfully.");
+    test_manager_register_test(
+        hashtable_should_keep_many_entries_and_grow,
+        "Hashtable should keep colliding entries and grow past capacity.");
+    test_manager_register_test(hashtable_should_remove_entries,
+                               "Hashtable should remove entries successfully.");
+    test_manager_register_test(
+        hashtable_should_get_default_after_fill,
+        "Hashtable should return the fill value for missing entries.");
 }
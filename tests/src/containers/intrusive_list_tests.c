@@ -0,0 +1,132 @@
+#include "intrusive_list_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/intrusive_list.h>
+#include <defines.h>
+
+typedef struct intrusive_list_test_item {
+    u32 id;
+    intrusive_list_node node;
+} intrusive_list_test_item;
+
+static u32 intrusive_list_test_id(intrusive_list_node *node) {
+    return intrusive_list_entry(node, intrusive_list_test_item, node)->id;
+}
+
+u8 intrusive_list_should_push_remove_and_move() {
+    u8 failed = false;
+
+    intrusive_list_test_item items[5] = {0};
+    intrusive_list list;
+    intrusive_list_init(&list);
+    expect_to_be_true(intrusive_list_empty(&list));
+    expect_should_be(0, (u64)intrusive_list_head(&list));
+    expect_should_be(0, (u64)intrusive_list_pop_tail(&list));
+
+    for (u32 i = 0; i < 5; i++) {
+        items[i].id = i;
+        expect_to_be_false(intrusive_list_linked(&items[i].node));
+        intrusive_list_push_tail(&list, &items[i].node);
+        expect_to_be_true(intrusive_list_linked(&items[i].node));
+    }
+    expect_should_be(5, list.length);
+
+    // 0 1 2 3 4 walks in order, and entry recovers the item.
+    u32 expected = 0;
+    intrusive_list_for_each(&list, node) {
+        intrusive_list_test_item *item =
+            intrusive_list_entry(node, intrusive_list_test_item, node);
+        expect_should_be((u64)&items[expected], (u64)item);
+        expected++;
+    }
+    expect_should_be(5, expected);
+
+    // 3 0 1 4 2 through remove, push_head, move_to_head and move_to_tail.
+    intrusive_list_remove(&list, &items[3].node);
+    expect_to_be_false(intrusive_list_linked(&items[3].node));
+    intrusive_list_push_head(&list, &items[3].node);
+    intrusive_list_move_to_tail(&list, &items[2].node);
+    expect_should_be(4, intrusive_list_test_id(
+                            intrusive_list_prev(&list, &items[2].node)));
+    expect_should_be(0, (u64)intrusive_list_next(&list, &items[2].node));
+    expect_should_be(0, (u64)intrusive_list_prev(&list, &items[3].node));
+
+    u32 order[] = {3, 0, 1, 4, 2};
+    u32 index = 0;
+    intrusive_list_for_each(&list, node) {
+        expect_should_be(order[index], intrusive_list_test_id(node));
+        index++;
+    }
+
+    // An LRU touch moves the used entry to the head; evict from the tail.
+    intrusive_list_move_to_head(&list, &items[4].node);
+    expect_should_be(4, intrusive_list_test_id(intrusive_list_head(&list)));
+    expect_should_be(2, intrusive_list_test_id(intrusive_list_pop_tail(&list)));
+    expect_should_be(1, intrusive_list_test_id(intrusive_list_pop_tail(&list)));
+    expect_should_be(3, list.length);
+
+    intrusive_list_insert_before(&list, &items[3].node, &items[1].node);
+    expect_should_be(1, intrusive_list_test_id(
+                            intrusive_list_next(&list, &items[4].node)));
+    expect_should_be(4, list.length);
+
+    intrusive_list_clear(&list);
+    expect_to_be_true(intrusive_list_empty(&list));
+    expect_should_be(0, list.length);
+    for (u32 i = 0; i < 5; i++) {
+        expect_to_be_false(intrusive_list_linked(&items[i].node));
+    }
+
+    return failed ? false : true;
+}
+
+u8 intrusive_list_should_splice() {
+    u8 failed = false;
+
+    intrusive_list_test_item items[6] = {0};
+    intrusive_list a;
+    intrusive_list b;
+    intrusive_list_init(&a);
+    intrusive_list_init(&b);
+
+    // Splicing an empty list changes nothing.
+    intrusive_list_splice_tail(&a, &b);
+    expect_to_be_true(intrusive_list_empty(&a));
+
+    for (u32 i = 0; i < 6; i++) {
+        items[i].id = i;
+        intrusive_list_push_tail(i < 2 ? &a : &b, &items[i].node);
+    }
+
+    intrusive_list_splice_tail(&a, &b);
+    expect_should_be(6, a.length);
+    expect_should_be(0, b.length);
+    expect_to_be_true(intrusive_list_empty(&b));
+
+    u32 expected = 0;
+    intrusive_list_for_each(&a, node) {
+        expect_should_be(expected, intrusive_list_test_id(node));
+        expected++;
+    }
+    expect_should_be(6, expected);
+
+    // Both ends are linked back to the root.
+    expect_should_be(5, intrusive_list_test_id(intrusive_list_tail(&a)));
+    expect_should_be(4, intrusive_list_test_id(
+                            intrusive_list_prev(&a, intrusive_list_tail(&a))));
+    expect_should_be(5, intrusive_list_test_id(intrusive_list_pop_tail(&a)));
+    expect_should_be(0, intrusive_list_test_id(intrusive_list_pop_head(&a)));
+    expect_should_be(4, a.length);
+
+    return failed ? false : true;
+}
+
+void intrusive_list_register_tests() {
+    test_manager_register_test(
+        intrusive_list_should_push_remove_and_move,
+        "Intrusive list should push, remove and move embedded nodes.");
+    test_manager_register_test(intrusive_list_should_splice,
+                               "Intrusive list should splice lists.");
+}
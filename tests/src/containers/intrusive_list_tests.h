@@ -0,0 +1,3 @@
+#pragma once
+
+void intrusive_list_register_tests();
@@ -0,0 +1,301 @@
+#include "pool_list_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/clock.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#include <containers/intrusive_list.h>
+#include <containers/linkedlist.h>
+#include <containers/pool_list.h>
+#include <defines.h>
+
+#define POOL_LIST_BENCH_COUNT 65536
+#define POOL_LIST_BENCH_ROUNDS 20
+
+static void *pool_list_test_create(u64 element_size, u32 capacity,
+                                   pool_list *list, u64 *out_size) {
+    pool_list_create(element_size, capacity, out_size, 0, 0);
+    void *memory = kallocate(*out_size, MEMORY_TAG_ARRAY);
+    pool_list_create(element_size, capacity, out_size, memory, list);
+    return memory;
+}
+
+u8 pool_list_should_push_pop_and_remove() {
+    u8 failed = false;
+
+    u64 size = 0;
+    pool_list_create(sizeof(u64), 4, &size, 0, 0);
+    expect_should_be(4 * (sizeof(pool_list_links) + sizeof(u64)), size);
+
+    pool_list list;
+    void *memory = pool_list_test_create(sizeof(u64), 4, &list, &size);
+    expect_should_be(0, pool_list_length(&list));
+    expect_should_be(INVALID_ID, pool_list_head(&list));
+    expect_to_be_false(pool_list_pop_head(&list, 0));
+
+    // Nodes are taken from the front of the pool.
+    u64 values[] = {10, 20, 30, 40};
+    expect_should_be(0, pool_list_push_tail(&list, &values[1]));
+    expect_should_be(1, pool_list_push_head(&list, &values[0]));
+    expect_should_be(2, pool_list_push_tail(&list, &values[3]));
+    expect_should_be(3, pool_list_insert_after(&list, 0, &values[2]));
+    expect_should_be(INVALID_ID, pool_list_push_tail(&list, &values[0]));
+    expect_should_be(4, pool_list_length(&list));
+
+    // 10 20 30 40, forwards and backwards.
+    u32 index = 0;
+    for (u32 node = pool_list_head(&list); node != INVALID_ID;
+         node = pool_list_next(&list, node)) {
+        expect_should_be(values[index], *(u64 *)pool_list_get(&list, node));
+        index++;
+    }
+    expect_should_be(4, index);
+    for (u32 node = pool_list_tail(&list); node != INVALID_ID;
+         node = pool_list_prev(&list, node)) {
+        index--;
+        expect_should_be(values[index], *(u64 *)pool_list_get(&list, node));
+    }
+
+    // Removing twice, or a node outside the pool, is rejected.
+    expect_to_be_true(pool_list_remove(&list, 3));
+    expect_to_be_false(pool_list_remove(&list, 3));
+    expect_to_be_false(pool_list_remove(&list, 4));
+    expect_to_be_false(pool_list_move_to_head(&list, 3));
+    expect_should_be(3, pool_list_length(&list));
+
+    // The freed node is reused, zeroed when no value is given.
+    expect_should_be(3, pool_list_push_head(&list, 0));
+    expect_should_be(0, *(u64 *)pool_list_get(&list, 3));
+
+    u64 popped = 0;
+    expect_to_be_true(pool_list_pop_head(&list, &popped));
+    expect_should_be(0, popped);
+    expect_to_be_true(pool_list_pop_tail(&list, &popped));
+    expect_should_be(40, popped);
+    expect_to_be_true(pool_list_pop_tail(&list, &popped));
+    expect_should_be(20, popped);
+    expect_to_be_true(pool_list_pop_tail(&list, &popped));
+    expect_should_be(10, popped);
+    expect_to_be_false(pool_list_pop_tail(&list, &popped));
+    expect_should_be(INVALID_ID, pool_list_head(&list));
+    expect_should_be(INVALID_ID, pool_list_tail(&list));
+
+    pool_list_destroy(&list);
+    expect_should_be(0, list.memory);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+u8 pool_list_should_move_and_reset() {
+    u8 failed = false;
+
+    u64 size = 0;
+    pool_list list;
+    void *memory = pool_list_test_create(sizeof(u32), 8, &list, &size);
+
+    for (u32 i = 0; i < 8; i++) {
+        expect_should_be(i, pool_list_push_tail(&list, &i));
+    }
+
+    // Use as an LRU: touch 5, 0 and 7, then evict the least recent.
+    expect_to_be_true(pool_list_move_to_head(&list, 5));
+    expect_to_be_true(pool_list_move_to_head(&list, 0));
+    expect_to_be_true(pool_list_move_to_head(&list, 7));
+    expect_to_be_true(pool_list_move_to_head(&list, 7));
+    expect_to_be_true(pool_list_move_to_tail(&list, 1));
+
+    u32 order[] = {7, 0, 5, 2, 3, 4, 6, 1};
+    u32 index = 0;
+    for (u32 node = pool_list_head(&list); node != INVALID_ID;
+         node = pool_list_next(&list, node)) {
+        expect_should_be(order[index], *(u32 *)pool_list_get(&list, node));
+        index++;
+    }
+    expect_should_be(8, index);
+
+    u32 evicted = 0;
+    expect_to_be_true(pool_list_pop_tail(&list, &evicted));
+    expect_should_be(1, evicted);
+
+    pool_list_reset(&list);
+    expect_should_be(0, pool_list_length(&list));
+    for (u32 i = 0; i < 8; i++) {
+        expect_should_be(i, pool_list_push_head(&list, 0));
+    }
+
+    pool_list_destroy(&list);
+    kfree(memory, size, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+// A cache entry of one cache line, as a resource LRU would hold. The pooled
+// list keeps its links beside the value, so its values leave them out.
+typedef struct pool_list_bench_entry {
+    u64 key;
+    u8 payload[40];
+    intrusive_list_node node;
+} pool_list_bench_entry;
+
+typedef struct pool_list_bench_value {
+    u64 key;
+    u8 payload[48];
+} pool_list_bench_value;
+
+static u64 pool_list_bench_walk_void(linkedlist *list) {
+    u64 sum = 0;
+    for (u32 r = 0; r < POOL_LIST_BENCH_ROUNDS; r++) {
+        linkedlist_iterator it;
+        b8 valid = linkedlist_iterator_begin(list, &it);
+        for (; valid; valid = linkedlist_iterator_next(&it)) {
+            sum += ((pool_list_bench_entry *)linkedlist_iterator_get(&it))->key;
+        }
+    }
+    return sum;
+}
+
+static u64 pool_list_bench_walk_intrusive(intrusive_list *list) {
+    u64 sum = 0;
+    for (u32 r = 0; r < POOL_LIST_BENCH_ROUNDS; r++) {
+        intrusive_list_for_each(list, node) {
+            sum += intrusive_list_entry(node, pool_list_bench_entry, node)->key;
+        }
+    }
+    return sum;
+}
+
+static u64 pool_list_bench_walk_pooled(pool_list *list) {
+    u64 sum = 0;
+    for (u32 r = 0; r < POOL_LIST_BENCH_ROUNDS; r++) {
+        for (u32 node = pool_list_head(list); node != INVALID_ID;
+             node = pool_list_next(list, node)) {
+            sum += ((pool_list_bench_value *)pool_list_get(list, node))->key;
+        }
+    }
+    return sum;
+}
+
+u8 pool_list_benchmark_walk() {
+    u8 failed = false;
+
+    const u32 count = POOL_LIST_BENCH_COUNT;
+    u64 entries_size = sizeof(pool_list_bench_entry) * count;
+    pool_list_bench_entry *entries =
+        kallocate_aligned(entries_size, 64, MEMORY_TAG_ARRAY);
+
+    u64 linkedlist_size = 0;
+    linkedlist_create(count, &linkedlist_size, 0, 0);
+    void *linkedlist_memory = kallocate(linkedlist_size, MEMORY_TAG_ARRAY);
+    linkedlist void_list;
+    linkedlist_create(count, &linkedlist_size, linkedlist_memory, &void_list);
+
+    intrusive_list embedded;
+    intrusive_list_init(&embedded);
+
+    u64 pool_size = 0;
+    pool_list pooled;
+    void *pool_memory = pool_list_test_create(sizeof(pool_list_bench_value),
+                                              count, &pooled, &pool_size);
+
+    for (u32 i = 0; i < count; i++) {
+        entries[i].key = i;
+        linkedlist_push_tail(&void_list, &entries[i]);
+        intrusive_list_push_tail(&embedded, &entries[i].node);
+        pool_list_bench_value value = {.key = i};
+        pool_list_push_tail(&pooled, &value);
+    }
+
+    // A shuffled touch order; the pooled list's node indices match the
+    // entries, as both were filled in order.
+    u32 *touches = kallocate(sizeof(u32) * count, MEMORY_TAG_ARRAY);
+    u32 random = 2463534242u;
+    for (u32 i = 0; i < count; i++) {
+        touches[i] = i;
+    }
+    for (u32 i = count - 1; i > 0; i--) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        u32 j = random % (i + 1);
+        u32 swap = touches[i];
+        touches[i] = touches[j];
+        touches[j] = swap;
+    }
+
+    u64 expected_sum = (u64)count * (count - 1) / 2 * POOL_LIST_BENCH_ROUNDS;
+    clock timer;
+
+    // Freshly built, every list walks memory in order.
+    clock_start(&timer);
+    expect_should_be(expected_sum, pool_list_bench_walk_void(&void_list));
+    clock_update(&timer);
+    f64 void_walk = timer.elapsed;
+
+    clock_start(&timer);
+    expect_should_be(expected_sum, pool_list_bench_walk_intrusive(&embedded));
+    clock_update(&timer);
+    f64 fresh_embedded_walk = timer.elapsed;
+
+    clock_start(&timer);
+    expect_should_be(expected_sum, pool_list_bench_walk_pooled(&pooled));
+    clock_update(&timer);
+    f64 fresh_pooled_walk = timer.elapsed;
+
+    // Touch every entry in shuffled order, as an LRU does when entries are
+    // used. The void* list cannot move a node without an O(n) search.
+    clock_start(&timer);
+    for (u32 i = 0; i < count; i++) {
+        intrusive_list_move_to_head(&embedded, &entries[touches[i]].node);
+    }
+    clock_update(&timer);
+    f64 embedded_touch = timer.elapsed;
+
+    clock_start(&timer);
+    for (u32 i = 0; i < count; i++) {
+        pool_list_move_to_head(&pooled, touches[i]);
+    }
+    clock_update(&timer);
+    f64 pooled_touch = timer.elapsed;
+
+    clock_start(&timer);
+    expect_should_be(expected_sum, pool_list_bench_walk_intrusive(&embedded));
+    clock_update(&timer);
+    f64 churned_embedded_walk = timer.elapsed;
+
+    clock_start(&timer);
+    expect_should_be(expected_sum, pool_list_bench_walk_pooled(&pooled));
+    clock_update(&timer);
+    f64 churned_pooled_walk = timer.elapsed;
+
+    f64 per_node = 1e9 / ((f64)count * POOL_LIST_BENCH_ROUNDS);
+    KINFO("List walk over %u entries (ns per node) - in order: void* %.2f, "
+          "intrusive %.2f, pooled %.2f; after LRU churn: intrusive %.2f, "
+          "pooled %.2f. LRU touch: intrusive %.1f, pooled %.1f.",
+          count, void_walk * per_node, fresh_embedded_walk * per_node,
+          fresh_pooled_walk * per_node, churned_embedded_walk * per_node,
+          churned_pooled_walk * per_node, embedded_touch * 1e9 / count,
+          pooled_touch * 1e9 / count);
+
+    kfree(touches, sizeof(u32) * count, MEMORY_TAG_ARRAY);
+    pool_list_destroy(&pooled);
+    kfree(pool_memory, pool_size, MEMORY_TAG_ARRAY);
+    linkedlist_destroy(&void_list);
+    kfree(linkedlist_memory, linkedlist_size, MEMORY_TAG_ARRAY);
+    kfree_aligned(entries, entries_size, 64, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+void pool_list_register_tests() {
+    test_manager_register_test(
+        pool_list_should_push_pop_and_remove,
+        "Pool list should push, pop and remove nodes by index.");
+    test_manager_register_test(pool_list_should_move_and_reset,
+                               "Pool list should move nodes and reset.");
+    test_manager_register_test(pool_list_benchmark_walk,
+                               "Pool list vs intrusive vs void* list walk "
+                               "benchmark.");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void pool_list_register_tests();
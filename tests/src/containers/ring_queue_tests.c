@@ -0,0 +1,324 @@
+#include "ring_queue_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/clock.h"
+#include "core/kmemory.h"
+#include "core/kthread.h"
+#include "core/logger.h"
+
+#include <containers/ring_queue.h>
+#include <defines.h>
+
+typedef struct ring_queue_test_value {
+    u32 producer;
+    u32 sequence;
+    u64 payload;
+} ring_queue_test_value;
+
+static const ring_queue_type ring_queue_test_types[] = {
+    RING_QUEUE_TYPE_SINGLE_THREADED, RING_QUEUE_TYPE_SPSC,
+    RING_QUEUE_TYPE_MPMC};
+#define RING_QUEUE_TEST_TYPE_COUNT 3
+
+u8 ring_queue_should_create_and_destroy() {
+    u8 failed = false;
+
+    for (u32 t = 0; t < RING_QUEUE_TEST_TYPE_COUNT; t++) {
+        ring_queue queue;
+        expect_to_be_true(ring_queue_create(ring_queue_test_types[t],
+                                            sizeof(u32), 100, &queue));
+        expect_should_not_be(0, queue.state);
+        // Rounded up to a power of 2.
+        expect_should_be(128, queue.capacity);
+        expect_should_be(0, ring_queue_count(&queue));
+
+        ring_queue_destroy(&queue);
+        expect_should_be(0, queue.state);
+    }
+
+    ring_queue queue;
+    expect_to_be_false(
+        ring_queue_create(RING_QUEUE_TYPE_SPSC, sizeof(u32), 0, &queue));
+
+    return failed ? false : true;
+}
+
+u8 ring_queue_should_be_fifo_and_wrap() {
+    u8 failed = false;
+
+    for (u32 t = 0; t < RING_QUEUE_TEST_TYPE_COUNT; t++) {
+        ring_queue queue;
+        ring_queue_create(ring_queue_test_types[t],
+                          sizeof(ring_queue_test_value), 8, &queue);
+
+        ring_queue_test_value out;
+        expect_to_be_false(ring_queue_dequeue(&queue, &out));
+
+        // Several laps, so indices wrap the slots many times.
+        u32 next_in = 0;
+        u32 next_out = 0;
+        for (u32 lap = 0; lap < 10; lap++) {
+            for (u32 i = 0; i < 5; i++) {
+                ring_queue_test_value value = {0, next_in, next_in * 3ull};
+                expect_to_be_true(ring_queue_enqueue(&queue, &value));
+                next_in++;
+            }
+            expect_should_be(5, ring_queue_count(&queue));
+            for (u32 i = 0; i < 5; i++) {
+                expect_to_be_true(ring_queue_dequeue(&queue, &out));
+                expect_should_be(next_out, out.sequence);
+                expect_should_be(next_out * 3ull, out.payload);
+                next_out++;
+            }
+        }
+        expect_should_be(0, ring_queue_count(&queue));
+
+        ring_queue_destroy(&queue);
+    }
+
+    return failed ? false : true;
+}
+
+u8 ring_queue_should_fail_when_full() {
+    u8 failed = false;
+
+    for (u32 t = 0; t < RING_QUEUE_TEST_TYPE_COUNT; t++) {
+        ring_queue queue;
+        ring_queue_create(ring_queue_test_types[t], sizeof(u64), 4, &queue);
+
+        for (u64 i = 0; i < 4; i++) {
+            expect_to_be_true(ring_queue_enqueue(&queue, &i));
+        }
+        u64 extra = 99;
+        expect_to_be_false(ring_queue_enqueue(&queue, &extra));
+        expect_should_be(4, ring_queue_count(&queue));
+
+        // Taking one makes room for one.
+        u64 out = 0;
+        expect_to_be_true(ring_queue_dequeue(&queue, &out));
+        expect_should_be(0, out);
+        expect_to_be_true(ring_queue_enqueue(&queue, &extra));
+        expect_to_be_false(ring_queue_enqueue(&queue, &extra));
+
+        for (u64 i = 1; i < 4; i++) {
+            expect_to_be_true(ring_queue_dequeue(&queue, &out));
+            expect_should_be(i, out);
+        }
+        expect_to_be_true(ring_queue_dequeue(&queue, &out));
+        expect_should_be(99, out);
+        expect_to_be_false(ring_queue_dequeue(&queue, &out));
+
+        ring_queue_destroy(&queue);
+    }
+
+    return failed ? false : true;
+}
+
+#define RING_QUEUE_MAX_THREADS 4
+
+typedef struct ring_queue_thread_context {
+    ring_queue *queue;
+    u32 id;
+    // Values to produce, or to consume.
+    u32 count;
+    // Consumers: the next sequence expected from each producer.
+    u32 next[RING_QUEUE_MAX_THREADS];
+    u64 payload_sum;
+    b8 ok;
+} ring_queue_thread_context;
+
+static u32 ring_queue_producer(void *params) {
+    ring_queue_thread_context *ctx = params;
+    for (u32 i = 0; i < ctx->count; i++) {
+        ring_queue_test_value value = {ctx->id, i, i};
+        while (!ring_queue_enqueue(ctx->queue, &value)) {
+        }
+    }
+    return 0;
+}
+
+static u32 ring_queue_consumer(void *params) {
+    ring_queue_thread_context *ctx = params;
+    for (u32 i = 0; i < ctx->count; i++) {
+        ring_queue_test_value value;
+        while (!ring_queue_dequeue(ctx->queue, &value)) {
+        }
+        // Values from one producer arrive in the order it sent them.
+        if (value.producer >= RING_QUEUE_MAX_THREADS ||
+            value.sequence < ctx->next[value.producer]) {
+            ctx->ok = false;
+        } else {
+            ctx->next[value.producer] = value.sequence + 1;
+        }
+        ctx->payload_sum += value.payload;
+    }
+    return 0;
+}
+
+// Runs producers and consumers over one queue, each producer sending
+// per_producer values. Returns the elapsed time.
+static f64 ring_queue_run_threads(ring_queue *queue, u32 producers,
+                                  u32 consumers, u32 per_producer, b8 *ok) {
+    kthread threads[RING_QUEUE_MAX_THREADS * 2];
+    ring_queue_thread_context contexts[RING_QUEUE_MAX_THREADS * 2];
+    kzero_memory(contexts, sizeof(contexts));
+
+    u32 total = producers * per_producer;
+    u32 thread_count = producers + consumers;
+    for (u32 i = 0; i < thread_count; i++) {
+        contexts[i].queue = queue;
+        contexts[i].ok = true;
+        if (i < producers) {
+            contexts[i].id = i;
+            contexts[i].count = per_producer;
+        } else {
+            // Spread the values across consumers, the first taking the rest.
+            u32 c = i - producers;
+            contexts[i].count =
+                total / consumers + (c == 0 ? total % consumers : 0);
+        }
+    }
+
+    clock timer;
+    clock_start(&timer);
+    for (u32 i = 0; i < thread_count; i++) {
+        pfn_thread_start start =
+            i < producers ? ring_queue_producer : ring_queue_consumer;
+        if (!kthread_create(start, &contexts[i], false, &threads[i])) {
+            // Cannot unblock the others safely; give up on the run.
+            KFATAL("ring_queue_run_threads - failed to create thread.");
+            *ok = false;
+            return 0;
+        }
+    }
+    for (u32 i = 0; i < thread_count; i++) {
+        kthread_wait(&threads[i]);
+    }
+    clock_update(&timer);
+
+    // Every value arrives exactly once.
+    u64 payload_sum = 0;
+    for (u32 i = producers; i < thread_count; i++) {
+        if (!contexts[i].ok) {
+            *ok = false;
+        }
+        payload_sum += contexts[i].payload_sum;
+    }
+    u64 expected = (u64)producers * per_producer * (per_producer - 1) / 2;
+    if (payload_sum != expected || ring_queue_count(queue) != 0) {
+        *ok = false;
+    }
+
+    return timer.elapsed;
+}
+
+u8 ring_queue_should_pass_values_between_two_threads() {
+    u8 failed = false;
+
+    ring_queue queue;
+    ring_queue_create(RING_QUEUE_TYPE_SPSC, sizeof(ring_queue_test_value), 256,
+                      &queue);
+    b8 ok = true;
+    ring_queue_run_threads(&queue, 1, 1, 50000, &ok);
+    expect_to_be_true(ok);
+    ring_queue_destroy(&queue);
+
+    return failed ? false : true;
+}
+
+u8 ring_queue_should_pass_values_between_many_threads() {
+    u8 failed = false;
+
+    ring_queue queue;
+    ring_queue_create(RING_QUEUE_TYPE_MPMC, sizeof(ring_queue_test_value), 256,
+                      &queue);
+    b8 ok = true;
+    ring_queue_run_threads(&queue, 3, 2, 10000, &ok);
+    expect_to_be_true(ok);
+    ring_queue_destroy(&queue);
+
+    return failed ? false : true;
+}
+
+#define RING_QUEUE_BENCH_VALUES 1000000
+// Threads spin while the queue is full or empty, so on few cores the
+// threaded runs are dominated by scheduling; keep them short.
+#define RING_QUEUE_BENCH_THREADED_VALUES 200000
+
+u8 ring_queue_benchmark_throughput() {
+    u8 failed = false;
+
+    static const char *names[] = {"single-threaded", "SPSC", "MPMC"};
+    for (u32 t = 0; t < RING_QUEUE_TEST_TYPE_COUNT; t++) {
+        ring_queue queue;
+        ring_queue_create(ring_queue_test_types[t],
+                          sizeof(ring_queue_test_value), 1024, &queue);
+
+        // Uncontended: batches of enqueues then dequeues on this thread.
+        clock timer;
+        clock_start(&timer);
+        ring_queue_test_value value = {0, 0, 0};
+        for (u32 i = 0; i < RING_QUEUE_BENCH_VALUES; i += 512) {
+            for (u32 j = 0; j < 512; j++) {
+                ring_queue_enqueue(&queue, &value);
+            }
+            for (u32 j = 0; j < 512; j++) {
+                ring_queue_dequeue(&queue, &value);
+            }
+        }
+        clock_update(&timer);
+        KINFO("Ring queue %s uncontended throughput: %.1f M values/s.",
+              names[t], RING_QUEUE_BENCH_VALUES / timer.elapsed / 1e6);
+
+        ring_queue_destroy(&queue);
+    }
+
+    // Across threads.
+    u32 values = RING_QUEUE_BENCH_THREADED_VALUES;
+    b8 ok = true;
+    ring_queue queue;
+    ring_queue_create(RING_QUEUE_TYPE_SPSC, sizeof(ring_queue_test_value),
+                      1024, &queue);
+    f64 elapsed = ring_queue_run_threads(&queue, 1, 1, values, &ok);
+    KINFO("Ring queue SPSC 1 producer, 1 consumer: %.1f M values/s.",
+          values / elapsed / 1e6);
+    ring_queue_destroy(&queue);
+
+    ring_queue_create(RING_QUEUE_TYPE_MPMC, sizeof(ring_queue_test_value),
+                      1024, &queue);
+    elapsed = ring_queue_run_threads(&queue, 1, 1, values, &ok);
+    KINFO("Ring queue MPMC 1 producer, 1 consumer: %.1f M values/s.",
+          values / elapsed / 1e6);
+    elapsed = ring_queue_run_threads(&queue, 2, 2, values / 2, &ok);
+    KINFO("Ring queue MPMC 2 producers, 2 consumers: %.1f M values/s.",
+          values / elapsed / 1e6);
+    ring_queue_destroy(&queue);
+    expect_to_be_true(ok);
+
+    return failed ? false : true;
+}
+
+void ring_queue_register_tests() {
+    test_manager_register_test(ring_queue_should_create_and_destroy,
+                               "Ring queue should create and destroy.");
+
+    test_manager_register_test(
+        ring_queue_should_be_fifo_and_wrap,
+        "Ring queue should be first in, first out across wraps.");
+
+    test_manager_register_test(
+        ring_queue_should_fail_when_full,
+        "Ring queue should fail to enqueue when full and dequeue when empty.");
+
+    test_manager_register_test(
+        ring_queue_should_pass_values_between_two_threads,
+        "SPSC ring queue should pass every value between two threads.");
+
+    test_manager_register_test(
+        ring_queue_should_pass_values_between_many_threads,
+        "MPMC ring queue should pass every value between many threads.");
+
+    test_manager_register_test(ring_queue_benchmark_throughput,
+                               "Ring queue throughput benchmark.");
+}
@@ -0,0 +1,242 @@
+#include "slotmap_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/clock.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#include <containers/slotmap.h>
+#include <defines.h>
+
+typedef struct slotmap_test_value {
+    u64 key;
+    u32 payload;
+} slotmap_test_value;
+
+static void *slotmap_test_create(u32 capacity, slotmap *out_map,
+                                 u64 *out_requirement) {
+    slotmap_create(sizeof(slotmap_test_value), capacity, out_requirement, 0,
+                   0);
+    void *memory = kallocate(*out_requirement, MEMORY_TAG_ARRAY);
+    slotmap_create(sizeof(slotmap_test_value), capacity, out_requirement,
+                   memory, out_map);
+    return memory;
+}
+
+u8 slotmap_should_insert_and_get() {
+    u8 failed = false;
+
+    slotmap map;
+    u64 memory_requirement = 0;
+    void *memory = slotmap_test_create(8, &map, &memory_requirement);
+    expect_should_be(8, map.capacity);
+    expect_should_be(0, map.count);
+
+    slotmap_handle handles[3];
+    for (u32 i = 0; i < 3; i++) {
+        slotmap_test_value *value = slotmap_insert(&map, &handles[i]);
+        expect_should_not_be(0, value);
+        // Slots are handed out lowest first.
+        expect_should_be(i, slotmap_handle_index(handles[i]));
+        expect_should_be(0, value->key);
+        value->key = 100 + i;
+    }
+    expect_should_be(3, map.count);
+
+    for (u32 i = 0; i < 3; i++) {
+        slotmap_test_value *value = slotmap_get(&map, handles[i]);
+        expect_should_not_be(0, value);
+        expect_should_be(100 + i, value->key);
+        expect_should_be(value, slotmap_get_at(&map, i));
+        expect_should_be(handles[i], slotmap_handle_at(&map, i));
+    }
+
+    expect_should_be(0, slotmap_get(&map, SLOTMAP_INVALID_HANDLE));
+    expect_should_be(0, slotmap_get_at(&map, 3));
+    expect_should_be(SLOTMAP_INVALID_HANDLE, slotmap_handle_at(&map, 3));
+
+    slotmap_destroy(&map);
+    expect_should_be(0, map.memory);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+u8 slotmap_should_reject_stale_handles() {
+    u8 failed = false;
+
+    slotmap map;
+    u64 memory_requirement = 0;
+    void *memory = slotmap_test_create(4, &map, &memory_requirement);
+
+    slotmap_handle first;
+    slotmap_test_value *value = slotmap_insert(&map, &first);
+    value->key = 1;
+
+    expect_to_be_true(slotmap_remove(&map, first));
+    expect_should_be(0, map.count);
+    expect_should_be(0, slotmap_get(&map, first));
+    expect_to_be_false(slotmap_remove(&map, first));
+
+    // The slot is reused with a new generation, and zeroed.
+    slotmap_handle second;
+    value = slotmap_insert(&map, &second);
+    expect_should_be(slotmap_handle_index(first),
+                     slotmap_handle_index(second));
+    expect_should_not_be(first, second);
+    expect_should_be(0, value->key);
+    expect_should_be(0, slotmap_get(&map, first));
+    expect_should_be(value, slotmap_get(&map, second));
+
+    slotmap_destroy(&map);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+u8 slotmap_should_fail_when_full() {
+    u8 failed = false;
+
+    slotmap map;
+    u64 memory_requirement = 0;
+    void *memory = slotmap_test_create(4, &map, &memory_requirement);
+
+    slotmap_handle handle;
+    for (u32 i = 0; i < 4; i++) {
+        expect_should_not_be(0, slotmap_insert(&map, &handle));
+    }
+    expect_should_be(0, slotmap_insert(&map, &handle));
+    expect_should_be(SLOTMAP_INVALID_HANDLE, handle);
+
+    // Freeing any slot makes room again.
+    expect_to_be_true(slotmap_remove(&map, slotmap_handle_at(&map, 2)));
+    expect_should_not_be(0, slotmap_insert(&map, &handle));
+    expect_should_be(2, slotmap_handle_index(handle));
+
+    slotmap_destroy(&map);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+u8 slotmap_should_iterate_live_values() {
+    u8 failed = false;
+
+    slotmap map;
+    u64 memory_requirement = 0;
+    void *memory = slotmap_test_create(16, &map, &memory_requirement);
+
+    slotmap_handle handles[16];
+    for (u32 i = 0; i < 16; i++) {
+        slotmap_test_value *value = slotmap_insert(&map, &handles[i]);
+        value->key = i;
+    }
+
+    // Remove every odd key.
+    for (u32 i = 1; i < 16; i += 2) {
+        expect_to_be_true(slotmap_remove(&map, handles[i]));
+    }
+    expect_should_be(8, map.count);
+
+    const u32 *dense = slotmap_dense_indices(&map);
+    u64 key_sum = 0;
+    for (u32 i = 0; i < map.count; i++) {
+        slotmap_test_value *value = slotmap_get_at(&map, dense[i]);
+        expect_should_not_be(0, value);
+        expect_should_be(0, value->key % 2);
+        key_sum += value->key;
+    }
+    expect_should_be(0 + 2 + 4 + 6 + 8 + 10 + 12 + 14, key_sum);
+
+    // Removing while iterating backwards visits everything once.
+    u32 visited = 0;
+    for (u32 i = map.count; i > 0; i--) {
+        expect_to_be_true(
+            slotmap_remove(&map, slotmap_handle_at(&map, dense[i - 1])));
+        visited++;
+    }
+    expect_should_be(8, visited);
+    expect_should_be(0, map.count);
+
+    slotmap_destroy(&map);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+#define SLOTMAP_BENCH_CAPACITY 65536
+#define SLOTMAP_BENCH_WINDOW 1000
+
+// Fills a 65536 slot map, churns it, and compares the cost of the first
+// inserts with the last ones, which the resource systems used to pay for with
+// a linear scan.
+u8 slotmap_benchmark_insert() {
+    u8 failed = false;
+
+    u32 capacity = SLOTMAP_BENCH_CAPACITY;
+    slotmap map;
+    u64 memory_requirement = 0;
+    void *memory = slotmap_test_create(capacity, &map, &memory_requirement);
+    slotmap_handle *handles =
+        kallocate(sizeof(slotmap_handle) * capacity, MEMORY_TAG_ARRAY);
+
+    clock timer;
+    f64 first = 0;
+    f64 last = 0;
+    b8 ok = true;
+    for (u32 i = 0; i < capacity && ok; i++) {
+        clock_start(&timer);
+        ok = slotmap_insert(&map, &handles[i]) != 0;
+        clock_update(&timer);
+        if (i < SLOTMAP_BENCH_WINDOW) {
+            first += timer.elapsed;
+        } else if (i >= capacity - SLOTMAP_BENCH_WINDOW) {
+            last += timer.elapsed;
+        }
+    }
+    expect_to_be_true(ok);
+    expect_should_be(capacity, map.count);
+
+    // Churn through every slot once more, in a scattered order.
+    clock_start(&timer);
+    for (u32 i = 0; i < capacity && ok; i++) {
+        u32 index = (i * 40503u) % capacity;
+        ok = slotmap_remove(&map, handles[index]) &&
+             slotmap_insert(&map, &handles[index]);
+    }
+    clock_update(&timer);
+    expect_to_be_true(ok);
+    expect_should_be(capacity, map.count);
+
+    KINFO("Slotmap insert average (ns) - first %u: %.0f, last %u: %.0f. "
+          "Remove + insert churn average: %.0f.",
+          SLOTMAP_BENCH_WINDOW, first * 1e9 / SLOTMAP_BENCH_WINDOW,
+          SLOTMAP_BENCH_WINDOW, last * 1e9 / SLOTMAP_BENCH_WINDOW,
+          timer.elapsed * 1e9 / capacity);
+
+    kfree(handles, sizeof(slotmap_handle) * capacity, MEMORY_TAG_ARRAY);
+    slotmap_destroy(&map);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+void slotmap_register_tests() {
+    test_manager_register_test(slotmap_should_insert_and_get,
+                               "Slotmap should insert and get values.");
+
+    test_manager_register_test(
+        slotmap_should_reject_stale_handles,
+        "Slotmap should reject handles to removed values.");
+
+    test_manager_register_test(slotmap_should_fail_when_full,
+                               "Slotmap should fail to insert when full.");
+
+    test_manager_register_test(
+        slotmap_should_iterate_live_values,
+        "Slotmap should iterate only live values through dense indices.");
+
+    test_manager_register_test(slotmap_benchmark_insert,
+                               "Slotmap insert benchmark at 65536 slots.");
+}
@@ -0,0 +1,234 @@
+#include "soa_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/clock.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#include <containers/soa.h>
+#include <defines.h>
+#include <math/math_types.h>
+
+#define SOA_TEST_COLUMNS(X) X(u32, id) X(mat4, model) X(u8, flags)
+SOA_DEFINE(soa_test, SOA_TEST_COLUMNS)
+
+u8 soa_should_push_grow_and_swap_remove() {
+    u8 failed = false;
+
+    soa_test soa;
+    expect_to_be_true(soa_test_create(&soa, 0));
+    expect_should_be(0, soa_test_count(&soa));
+    expect_should_be(SOA_MIN_CAPACITY, soa.header.capacity);
+
+    // Every column starts on its own aligned boundary in the one block.
+    expect_should_be(0, (u64)soa.id % SOA_COLUMN_ALIGNMENT);
+    expect_should_be(0, (u64)soa.model % SOA_COLUMN_ALIGNMENT);
+    expect_should_be(0, (u64)soa.flags % SOA_COLUMN_ALIGNMENT);
+    expect_should_be(soa.header.block, soa.id);
+    expect_to_be_true(((u8 *)soa.flags < (u8 *)soa.header.block +
+                                             soa.header.block_size));
+
+    // Push past the initial capacity, filling every column.
+    for (u32 i = 0; i < 100; i++) {
+        u64 index = soa_test_push(&soa);
+        expect_should_be(i, index);
+        expect_should_be(0, soa.id[index]);
+        expect_should_be(0, soa.flags[index]);
+        soa.id[index] = i;
+        soa.model[index].data[12] = (f32)i;
+        soa.flags[index] = (u8)(i * 3);
+    }
+    expect_should_be(100, soa_test_count(&soa));
+    expect_to_be_true((soa.header.capacity >= 100));
+    expect_should_be(0, (u64)soa.model % SOA_COLUMN_ALIGNMENT);
+    for (u32 i = 0; i < 100; i++) {
+        expect_should_be(i, soa.id[i]);
+        expect_should_be((f32)i, soa.model[i].data[12]);
+        expect_should_be((u8)(i * 3), soa.flags[i]);
+    }
+
+    // The last row moves into the removed one, in every column.
+    expect_to_be_true(soa_test_swap_remove(&soa, 10));
+    expect_should_be(99, soa_test_count(&soa));
+    expect_should_be(99, soa.id[10]);
+    expect_should_be(99.0f, soa.model[10].data[12]);
+    expect_should_be((u8)(99 * 3), soa.flags[10]);
+
+    expect_to_be_true(soa_test_swap_remove(&soa, 98));
+    expect_should_be(98, soa_test_count(&soa));
+    expect_to_be_false(soa_test_swap_remove(&soa, 98));
+
+    soa_test_destroy(&soa);
+    expect_should_be(0, soa.header.block);
+    expect_should_be(0, soa.model);
+
+    return failed ? false : true;
+}
+
+u8 soa_should_reserve() {
+    u8 failed = false;
+
+    soa_test soa;
+    soa_test_create(&soa, 4);
+    u64 index = soa_test_push(&soa);
+    soa.id[index] = 42;
+
+    expect_to_be_true(soa_test_reserve(&soa, 1000));
+    expect_should_be(1000, soa.header.capacity);
+    expect_should_be(1, soa_test_count(&soa));
+    expect_should_be(42, soa.id[0]);
+
+    // Never shrinks.
+    expect_to_be_true(soa_test_reserve(&soa, 10));
+    expect_should_be(1000, soa.header.capacity);
+
+    soa_test_destroy(&soa);
+
+    return failed ? false : true;
+}
+
+#define SOA_BENCH_OBJECTS (64 * 1024)
+#define SOA_BENCH_ROUNDS 32
+
+// Per-object data laid out the way it is iterated today: one struct per
+// object, every field pulled into cache whether a pass needs it or not.
+typedef struct soa_bench_object {
+    mat4 model;
+    vec3 position;
+    f32 radius;
+    vec3 velocity;
+    b8 visible;
+    void *geometry;
+} soa_bench_object;
+
+// The same data as columns, with vectors split per component so the hot
+// loops run over plain f32 arrays.
+#define SOA_BENCH_COLUMNS(X)                                                   \
+    X(f32, position_x)                                                         \
+    X(f32, position_y)                                                         \
+    X(f32, position_z)                                                         \
+    X(f32, velocity_x)                                                         \
+    X(f32, velocity_y)                                                         \
+    X(f32, velocity_z)                                                         \
+    X(f32, radius)                                                             \
+    X(b8, visible)                                                             \
+    X(mat4, model)                                                             \
+    X(void *, geometry)
+SOA_DEFINE(soa_bench_objects, SOA_BENCH_COLUMNS)
+
+// A slab of the world along x, standing in for a view frustum.
+#define SOA_BENCH_CULL_MIN -250.0f
+#define SOA_BENCH_CULL_MAX 250.0f
+
+static f32 soa_bench_value(u64 i, u64 scale) {
+    return (f32)((i * 2654435761u) % (scale * 2)) - (f32)scale;
+}
+
+u8 soa_benchmark_transform_and_cull() {
+    u8 failed = false;
+
+    u64 count = SOA_BENCH_OBJECTS;
+    u64 aos_size = sizeof(soa_bench_object) * count;
+    soa_bench_object *aos = kallocate_aligned(aos_size, 64, MEMORY_TAG_ARRAY);
+    soa_bench_objects soa;
+    soa_bench_objects_create(&soa, count);
+
+    for (u64 i = 0; i < count; i++) {
+        u64 index = soa_bench_objects_push(&soa);
+        soa.position_x[index] = aos[i].position.x = soa_bench_value(i, 500);
+        soa.position_y[index] = aos[i].position.y = soa_bench_value(i + 1, 500);
+        soa.position_z[index] = aos[i].position.z = soa_bench_value(i + 2, 500);
+        soa.velocity_x[index] = aos[i].velocity.x = soa_bench_value(i, 5);
+        soa.velocity_y[index] = aos[i].velocity.y = soa_bench_value(i + 1, 5);
+        soa.velocity_z[index] = aos[i].velocity.z = soa_bench_value(i + 2, 5);
+        soa.radius[index] = aos[i].radius = 1.0f + (f32)(i % 8);
+    }
+
+    const f32 dt = 1.0f / 60.0f;
+    clock timer;
+
+    clock_start(&timer);
+    for (u32 r = 0; r < SOA_BENCH_ROUNDS; r++) {
+        for (u64 i = 0; i < count; i++) {
+            aos[i].position.x += aos[i].velocity.x * dt;
+            aos[i].position.y += aos[i].velocity.y * dt;
+            aos[i].position.z += aos[i].velocity.z * dt;
+        }
+    }
+    clock_update(&timer);
+    f64 aos_transform = timer.elapsed;
+
+    clock_start(&timer);
+    for (u32 r = 0; r < SOA_BENCH_ROUNDS; r++) {
+        f32 *restrict px = soa.position_x;
+        f32 *restrict py = soa.position_y;
+        f32 *restrict pz = soa.position_z;
+        const f32 *restrict vx = soa.velocity_x;
+        const f32 *restrict vy = soa.velocity_y;
+        const f32 *restrict vz = soa.velocity_z;
+        for (u64 i = 0; i < count; i++) {
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            pz[i] += vz[i] * dt;
+        }
+    }
+    clock_update(&timer);
+    f64 soa_transform = timer.elapsed;
+
+    u64 aos_visible = 0;
+    clock_start(&timer);
+    for (u32 r = 0; r < SOA_BENCH_ROUNDS; r++) {
+        for (u64 i = 0; i < count; i++) {
+            f32 x = aos[i].position.x;
+            f32 radius = aos[i].radius;
+            aos[i].visible = x + radius >= SOA_BENCH_CULL_MIN &&
+                             x - radius <= SOA_BENCH_CULL_MAX;
+            aos_visible += aos[i].visible;
+        }
+    }
+    clock_update(&timer);
+    f64 aos_cull = timer.elapsed;
+
+    u64 soa_visible = 0;
+    clock_start(&timer);
+    for (u32 r = 0; r < SOA_BENCH_ROUNDS; r++) {
+        const f32 *restrict px = soa.position_x;
+        const f32 *restrict radii = soa.radius;
+        b8 *restrict visible = soa.visible;
+        for (u64 i = 0; i < count; i++) {
+            visible[i] = px[i] + radii[i] >= SOA_BENCH_CULL_MIN &&
+                         px[i] - radii[i] <= SOA_BENCH_CULL_MAX;
+            soa_visible += visible[i];
+        }
+    }
+    clock_update(&timer);
+    f64 soa_cull = timer.elapsed;
+
+    // Both layouts did the same work.
+    expect_should_be(aos_visible, soa_visible);
+    expect_should_be(aos[count - 1].position.x, soa.position_x[count - 1]);
+
+    u64 updates = count * SOA_BENCH_ROUNDS;
+    KINFO("SoA vs AoS over %llu objects of %llu bytes (ns per object) - "
+          "transform: %.2f vs %.2f, cull: %.2f vs %.2f.",
+          count, (u64)sizeof(soa_bench_object), soa_transform * 1e9 / updates,
+          aos_transform * 1e9 / updates, soa_cull * 1e9 / updates,
+          aos_cull * 1e9 / updates);
+
+    soa_bench_objects_destroy(&soa);
+    kfree_aligned(aos, aos_size, 64, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+void soa_register_tests() {
+    test_manager_register_test(
+        soa_should_push_grow_and_swap_remove,
+        "SoA container should push, grow and swap-remove across columns.");
+    test_manager_register_test(soa_should_reserve,
+                               "SoA container should reserve capacity.");
+    test_manager_register_test(
+        soa_benchmark_transform_and_cull,
+        "SoA vs AoS transform and culling benchmark.");
+}
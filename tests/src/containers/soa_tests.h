@@ -0,0 +1,3 @@
+#pragma once
+
+void soa_register_tests();
@@ -0,0 +1,544 @@
+#include "job_system_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "containers/ring_queue.h"
+#include "core/clock.h"
+#include "core/job_system.h"
+#include "core/katomic.h"
+#include "core/kfiber.h"
+#include "core/kmemory.h"
+#include "core/kthread.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+#include <defines.h>
+
+#define JOB_SYSTEM_TEST_JOBS 1000
+#define JOB_SYSTEM_BENCH_JOBS 2048
+#define JOB_SYSTEM_BENCH_ITERATIONS 20000
+#define JOB_SYSTEM_FIBER_STACK_SIZE (64 * 1024)
+// Simulated I/O requests in flight at once, and how long each takes.
+#define JOB_SYSTEM_IO_MAX_REQUESTS 256
+#define JOB_SYSTEM_IO_LATENCY_MS 2
+#define JOB_SYSTEM_IO_BENCH_JOBS 64
+
+static void *job_system_test_start(u32 worker_count, u32 max_queued_jobs,
+                                   u32 fiber_count, u64 *out_requirement) {
+    job_system_config config;
+    config.worker_count = worker_count;
+    config.max_queued_jobs = max_queued_jobs;
+    config.pin_workers = false;
+    config.fiber_count = fiber_count;
+    config.fiber_stack_size = JOB_SYSTEM_FIBER_STACK_SIZE;
+    job_system_initialize(out_requirement, 0, config);
+    void *state = kallocate_aligned(*out_requirement, 64, MEMORY_TAG_JOB);
+    if (!job_system_initialize(out_requirement, state, config)) {
+        kfree_aligned(state, *out_requirement, 64, MEMORY_TAG_JOB);
+        return 0;
+    }
+    return state;
+}
+
+static void job_system_test_end(void *state, u64 requirement) {
+    job_system_shutdown(state);
+    kfree_aligned(state, requirement, 64, MEMORY_TAG_JOB);
+}
+
+typedef struct job_system_test_totals {
+    u64 sum;
+    // A bit per thread index that ran a job.
+    u64 threads;
+} job_system_test_totals;
+
+typedef struct job_system_test_params {
+    job_system_test_totals *totals;
+    u64 value;
+} job_system_test_params;
+
+static void job_system_test_add(void *params) {
+    job_system_test_params *p = params;
+    katomic_fetch_add(&p->totals->sum, p->value, KATOMIC_RELAXED);
+    katomic_fetch_or(&p->totals->threads,
+                     1ull << (job_system_thread_index() % 64),
+                     KATOMIC_RELAXED);
+}
+
+// Splits a range in half until it is small, running the halves as jobs and
+// waiting on them from inside a job.
+typedef struct job_system_test_range {
+    job_system_test_totals *totals;
+    u64 begin;
+    u64 end;
+} job_system_test_range;
+
+static void job_system_test_sum_range(void *params) {
+    job_system_test_range *range = params;
+    if (range->end - range->begin <= 16) {
+        u64 sum = 0;
+        for (u64 i = range->begin; i < range->end; ++i) {
+            sum += i;
+        }
+        katomic_fetch_add(&range->totals->sum, sum, KATOMIC_RELAXED);
+        return;
+    }
+
+    u64 middle = range->begin + (range->end - range->begin) / 2;
+    job_system_test_range halves[2] = {
+        {range->totals, range->begin, middle},
+        {range->totals, middle, range->end}};
+    job jobs[2] = {{job_system_test_sum_range, &halves[0]},
+                   {job_system_test_sum_range, &halves[1]}};
+    job_counter counter = {0};
+    job_run(jobs, 2, JOB_PRIORITY_NORMAL, &counter);
+    job_wait(&counter);
+}
+
+u8 job_system_should_run_jobs_and_wait() {
+    u8 failed = false;
+
+    u64 requirement = 0;
+    void *state = job_system_test_start(3, 256, 0, &requirement);
+    expect_to_be_true((state != 0));
+    expect_should_be(4, job_system_thread_count());
+    expect_should_be(0, job_system_thread_index());
+
+    job_system_test_totals totals = {0};
+    job_system_test_params params[JOB_SYSTEM_TEST_JOBS];
+    job jobs[JOB_SYSTEM_TEST_JOBS];
+    for (u32 i = 0; i < JOB_SYSTEM_TEST_JOBS; ++i) {
+        params[i].totals = &totals;
+        params[i].value = i + 1;
+        jobs[i].entry = job_system_test_add;
+        jobs[i].params = &params[i];
+    }
+
+    // More jobs than fit in the deque; the rest run as they are queued.
+    job_counter counter = {0};
+    job_run(jobs, JOB_SYSTEM_TEST_JOBS, JOB_PRIORITY_NORMAL, &counter);
+    job_wait(&counter);
+    expect_should_be(0, counter.value);
+    expect_should_be(JOB_SYSTEM_TEST_JOBS * (JOB_SYSTEM_TEST_JOBS + 1) / 2,
+                     totals.sum);
+    expect_to_be_true(((totals.threads & ~0xFull) == 0));
+
+    // Nested fork-join, waiting inside jobs.
+    totals.sum = 0;
+    job_system_test_range range = {&totals, 0, 10000};
+    job root = {job_system_test_sum_range, &range};
+    job_run(&root, 1, JOB_PRIORITY_HIGH, &counter);
+    job_wait(&counter);
+    expect_should_be(10000ull * 9999 / 2, totals.sum);
+
+    job_system_test_end(state, requirement);
+    expect_should_be(0, job_system_thread_count());
+
+    return failed ? false : true;
+}
+
+typedef struct job_system_test_order {
+    u32 log[8];
+    u32 count;
+} job_system_test_order;
+
+typedef struct job_system_test_order_params {
+    job_system_test_order *order;
+    u32 id;
+} job_system_test_order_params;
+
+static void job_system_test_record(void *params) {
+    job_system_test_order_params *p = params;
+    p->order->log[p->order->count++] = p->id;
+}
+
+u8 job_system_should_run_by_priority_and_when_full() {
+    u8 failed = false;
+
+    // No workers, so the waiting thread runs everything, in priority order.
+    u64 requirement = 0;
+    void *state = job_system_test_start(0, 2, 0, &requirement);
+    expect_should_be(1, job_system_thread_count());
+
+    job_system_test_order order = {0};
+    job_system_test_order_params params[6];
+    job jobs[6];
+    for (u32 i = 0; i < 6; ++i) {
+        params[i].order = &order;
+        params[i].id = i;
+        jobs[i].entry = job_system_test_record;
+        jobs[i].params = &params[i];
+    }
+
+    job_counter counter = {0};
+    job_run(&jobs[0], 1, JOB_PRIORITY_LOW, &counter);
+    job_run(&jobs[1], 1, JOB_PRIORITY_NORMAL, &counter);
+    job_run(&jobs[2], 1, JOB_PRIORITY_HIGH, &counter);
+    expect_should_be(3, counter.value);
+    expect_should_be(0, order.count);
+
+    // The normal deque holds 2, so only job 3 fits; 4 and 5 run at once.
+    job_run(&jobs[3], 3, JOB_PRIORITY_NORMAL, &counter);
+    expect_should_be(4, counter.value);
+    expect_should_be(2, order.count);
+    expect_should_be(4, order.log[0]);
+    expect_should_be(5, order.log[1]);
+
+    job_wait(&counter);
+    expect_should_be(6, order.count);
+    // High, then both normal jobs in any order, then low.
+    expect_should_be(2, order.log[2]);
+    expect_should_be(0, order.log[5]);
+    u32 normal_ids = (1u << order.log[3]) | (1u << order.log[4]);
+    u32 expected_ids = (1u << 1) | (1u << 3);
+    expect_should_be(expected_ids, normal_ids);
+
+    job_system_test_end(state, requirement);
+
+    // Before initialization, jobs run at once.
+    order.count = 0;
+    job_run(jobs, 2, JOB_PRIORITY_NORMAL, &counter);
+    expect_should_be(0, counter.value);
+    expect_should_be(2, order.count);
+
+    return failed ? false : true;
+}
+
+typedef struct job_system_bench_params {
+    u64 seed;
+    u64 result;
+} job_system_bench_params;
+
+static void job_system_bench_work(void *params) {
+    job_system_bench_params *p = params;
+    u64 x = p->seed;
+    for (u32 i = 0; i < JOB_SYSTEM_BENCH_ITERATIONS; ++i) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        x ^= x >> 29;
+    }
+    p->result = x;
+}
+
+u8 job_system_benchmark_scaling() {
+    u8 failed = false;
+
+    u32 processor_count = platform_get_processor_count();
+    u64 params_size = sizeof(job_system_bench_params) * JOB_SYSTEM_BENCH_JOBS;
+    job_system_bench_params *params = kallocate(params_size, MEMORY_TAG_JOB);
+    job *jobs = kallocate(sizeof(job) * JOB_SYSTEM_BENCH_JOBS, MEMORY_TAG_JOB);
+    for (u32 i = 0; i < JOB_SYSTEM_BENCH_JOBS; ++i) {
+        params[i].seed = i;
+        jobs[i].entry = job_system_bench_work;
+        jobs[i].params = &params[i];
+    }
+
+    f64 single_thread = 0;
+    for (u32 threads = 1; threads <= processor_count; ++threads) {
+        u64 requirement = 0;
+        void *state = job_system_test_start(threads - 1, JOB_SYSTEM_BENCH_JOBS,
+                                            0, &requirement);
+
+        clock timer;
+        clock_start(&timer);
+        job_counter counter = {0};
+        job_run(jobs, JOB_SYSTEM_BENCH_JOBS, JOB_PRIORITY_NORMAL, &counter);
+        job_wait(&counter);
+        clock_update(&timer);
+        expect_should_be(0, counter.value);
+
+        if (threads == 1) {
+            single_thread = timer.elapsed;
+        }
+        KINFO("Job system scaling - %u threads: %.2f ms for %u jobs, %.2fx "
+              "the single thread rate.",
+              threads, timer.elapsed * 1000.0, JOB_SYSTEM_BENCH_JOBS,
+              single_thread / timer.elapsed);
+
+        job_system_test_end(state, requirement);
+    }
+
+    // Every job ran exactly once with its own seed.
+    job_system_bench_params check = {.seed = 7};
+    job_system_bench_work(&check);
+    expect_should_be(check.result, params[7].result);
+
+    kfree(jobs, sizeof(job) * JOB_SYSTEM_BENCH_JOBS, MEMORY_TAG_JOB);
+    kfree(params, params_size, MEMORY_TAG_JOB);
+
+    return failed ? false : true;
+}
+
+typedef struct job_system_test_ping_pong {
+    kfiber main;
+    kfiber fiber;
+    u32 count;
+} job_system_test_ping_pong;
+
+static void job_system_test_ping(void *params) {
+    job_system_test_ping_pong *p = params;
+    for (;;) {
+        p->count++;
+        kfiber_switch(&p->fiber, &p->main);
+    }
+}
+
+u8 kfiber_should_switch_back_and_forth() {
+    u8 failed = false;
+
+    job_system_test_ping_pong p = {0};
+    expect_to_be_true(kfiber_convert_thread(&p.main));
+    expect_to_be_true(kfiber_create(JOB_SYSTEM_FIBER_STACK_SIZE,
+                                    job_system_test_ping, &p, &p.fiber));
+    expect_should_be(0, p.count);
+    for (u32 i = 1; i <= 3; ++i) {
+        kfiber_switch(&p.main, &p.fiber);
+        expect_should_be(i, p.count);
+    }
+
+    kfiber_destroy(&p.fiber);
+    kfiber_revert_thread(&p.main);
+    expect_to_be_true((p.fiber.internal_data == 0));
+
+    return failed ? false : true;
+}
+
+// A device on its own thread that completes each request a fixed time after
+// it was made, standing in for a disk or network.
+typedef struct job_system_io_request {
+    job_counter *counter;
+    f64 due;
+} job_system_io_request;
+
+typedef struct job_system_io_device {
+    ring_queue requests;
+    kthread thread;
+    b8 running;
+    u32 completed;
+} job_system_io_device;
+
+static u32 job_system_io_device_main(void *params) {
+    job_system_io_device *device = params;
+    job_system_io_request pending[JOB_SYSTEM_IO_MAX_REQUESTS];
+    u32 pending_count = 0;
+    while (katomic_load(&device->running, KATOMIC_ACQUIRE) ||
+           pending_count > 0) {
+        while (pending_count < JOB_SYSTEM_IO_MAX_REQUESTS &&
+               ring_queue_dequeue(&device->requests,
+                                  &pending[pending_count])) {
+            pending_count++;
+        }
+
+        f64 now = platform_get_absolute_time();
+        for (u32 i = 0; i < pending_count;) {
+            if (pending[i].due <= now) {
+                katomic_fetch_add(&device->completed, 1, KATOMIC_RELAXED);
+                job_counter_add(pending[i].counter, -1);
+                pending[i] = pending[--pending_count];
+            } else {
+                ++i;
+            }
+        }
+        kthread_yield();
+    }
+    return 0;
+}
+
+static b8 job_system_io_device_start(job_system_io_device *device) {
+    kzero_memory(device, sizeof(job_system_io_device));
+    device->running = true;
+    return ring_queue_create(RING_QUEUE_TYPE_MPMC,
+                             sizeof(job_system_io_request),
+                             JOB_SYSTEM_IO_MAX_REQUESTS, &device->requests) &&
+           kthread_create(job_system_io_device_main, device, false,
+                          &device->thread);
+}
+
+static void job_system_io_device_stop(job_system_io_device *device) {
+    katomic_store(&device->running, false, KATOMIC_RELEASE);
+    kthread_wait(&device->thread);
+    ring_queue_destroy(&device->requests);
+}
+
+// Starts a request and waits for it: on a fiber the job is parked meanwhile.
+static void job_system_io_read(job_system_io_device *device) {
+    job_counter counter = {0};
+    job_counter_add(&counter, 1);
+    job_system_io_request request = {
+        &counter,
+        platform_get_absolute_time() + JOB_SYSTEM_IO_LATENCY_MS / 1000.0};
+    while (!ring_queue_enqueue(&device->requests, &request)) {
+        kthread_yield();
+    }
+    job_wait(&counter);
+}
+
+typedef struct job_system_io_params {
+    job_system_io_device *device;
+    u32 reads;
+    u64 *sum;
+} job_system_io_params;
+
+static void job_system_test_read_and_add(void *params) {
+    job_system_io_params *p = params;
+    for (u32 i = 0; i < p->reads; ++i) {
+        job_system_io_read(p->device);
+    }
+    katomic_fetch_add(p->sum, p->reads, KATOMIC_RELAXED);
+}
+
+u8 job_system_should_park_fibers_that_wait() {
+    u8 failed = false;
+
+    job_system_io_device device;
+    expect_to_be_true(job_system_io_device_start(&device));
+
+    // Fewer fibers than waiting jobs, so some also run on thread stacks.
+    u64 requirement = 0;
+    void *state = job_system_test_start(2, 256, 8, &requirement);
+    expect_to_be_true((state != 0));
+
+    // Jobs that wait on I/O, a few reads each.
+    u64 sum = 0;
+    job_system_io_params params = {&device, 3, &sum};
+    job jobs[32];
+    for (u32 i = 0; i < 32; ++i) {
+        jobs[i].entry = job_system_test_read_and_add;
+        jobs[i].params = &params;
+    }
+    job_counter counter = {0};
+    job_run(jobs, 32, JOB_PRIORITY_NORMAL, &counter);
+    job_wait(&counter);
+    expect_should_be(0, counter.value);
+    expect_should_be(32 * 3, sum);
+    expect_should_be(32 * 3, device.completed);
+
+    // Nested fork-join, with far more waits than fibers.
+    job_system_test_totals totals = {0};
+    job_system_test_range range = {&totals, 0, 10000};
+    job root = {job_system_test_sum_range, &range};
+    job_run(&root, 1, JOB_PRIORITY_HIGH, &counter);
+    job_wait(&counter);
+    expect_should_be(10000ull * 9999 / 2, totals.sum);
+
+    job_system_test_end(state, requirement);
+    job_system_io_device_stop(&device);
+
+    return failed ? false : true;
+}
+
+static void job_system_bench_blocking_read(void *params) {
+    platform_sleep(JOB_SYSTEM_IO_LATENCY_MS);
+}
+
+static void job_system_bench_fiber_read(void *params) {
+    job_system_io_read(params);
+}
+
+u8 job_system_benchmark_io_waits() {
+    u8 failed = false;
+
+    job_system_io_device device;
+    expect_to_be_true(job_system_io_device_start(&device));
+
+    job jobs[JOB_SYSTEM_IO_BENCH_JOBS];
+    f64 elapsed[2];
+    for (u32 use_fibers = 0; use_fibers < 2; ++use_fibers) {
+        for (u32 i = 0; i < JOB_SYSTEM_IO_BENCH_JOBS; ++i) {
+            jobs[i].entry = use_fibers ? job_system_bench_fiber_read
+                                       : job_system_bench_blocking_read;
+            jobs[i].params = &device;
+        }
+
+        u64 requirement = 0;
+        void *state = job_system_test_start(
+            JOB_SYSTEM_WORKER_COUNT_AUTO, JOB_SYSTEM_IO_BENCH_JOBS,
+            use_fibers ? JOB_SYSTEM_IO_BENCH_JOBS : 0, &requirement);
+
+        clock timer;
+        clock_start(&timer);
+        job_counter counter = {0};
+        job_run(jobs, JOB_SYSTEM_IO_BENCH_JOBS, JOB_PRIORITY_NORMAL, &counter);
+        job_wait(&counter);
+        clock_update(&timer);
+        elapsed[use_fibers] = timer.elapsed;
+        expect_should_be(0, counter.value);
+
+        job_system_test_end(state, requirement);
+    }
+    expect_should_be(JOB_SYSTEM_IO_BENCH_JOBS, device.completed);
+    job_system_io_device_stop(&device);
+
+    KINFO("Job system I/O waits - %u jobs each waiting %u ms on %u threads: "
+          "%.2f ms blocking the thread, %.2f ms parking the fiber (%.1fx).",
+          JOB_SYSTEM_IO_BENCH_JOBS, JOB_SYSTEM_IO_LATENCY_MS,
+          platform_get_processor_count(), elapsed[0] * 1000.0,
+          elapsed[1] * 1000.0, elapsed[0] / elapsed[1]);
+
+    return failed ? false : true;
+}
+
+static void job_system_test_allocate(void *params) {
+    job_system_test_totals *totals = params;
+    katomic_fetch_or(&totals->threads, 1ull << (job_system_thread_index() % 64),
+                     KATOMIC_RELAXED);
+    void *blocks[8];
+    for (u32 i = 0; i < 8; ++i) {
+        blocks[i] = kallocate(48, MEMORY_TAG_JOB);
+    }
+    // Long enough that the workers pick up jobs too.
+    platform_sleep(1);
+    for (u32 i = 0; i < 8; ++i) {
+        kfree(blocks[i], 48, MEMORY_TAG_JOB);
+    }
+}
+
+u8 job_system_should_return_worker_caches_on_shutdown() {
+    u8 failed = false;
+
+    memory_system_flush_thread_cache();
+    u64 baseline = get_memory_cached_block_count();
+
+    u64 requirement = 0;
+    void *state = job_system_test_start(3, 256, 4, &requirement);
+    expect_to_be_true((state != 0));
+
+    // Every thread that runs one of these keeps some small blocks cached.
+    job_system_test_totals totals = {0};
+    job jobs[64];
+    for (u32 i = 0; i < 64; ++i) {
+        jobs[i].entry = job_system_test_allocate;
+        jobs[i].params = &totals;
+    }
+    job_counter counter = {0};
+    job_run(jobs, 64, JOB_PRIORITY_NORMAL, &counter);
+    job_wait(&counter);
+    expect_should_be(0, counter.value);
+    expect_to_be_true(((totals.threads & ~1ull) != 0));
+
+    // Workers give theirs back as they exit; this thread has to ask.
+    job_system_test_end(state, requirement);
+    memory_system_flush_thread_cache();
+    expect_should_be(baseline, get_memory_cached_block_count());
+
+    return failed ? false : true;
+}
+
+void job_system_register_tests() {
+    test_manager_register_test(
+        job_system_should_run_jobs_and_wait,
+        "Job system should run jobs across workers and wait on counters.");
+    test_manager_register_test(
+        job_system_should_run_by_priority_and_when_full,
+        "Job system should run jobs by priority, and at once when full.");
+    test_manager_register_test(job_system_benchmark_scaling,
+                               "Job system scaling benchmark.");
+    test_manager_register_test(kfiber_should_switch_back_and_forth,
+                               "Fibers should switch back and forth.");
+    test_manager_register_test(
+        job_system_should_park_fibers_that_wait,
+        "Job system should park fibers that wait and resume them.");
+    test_manager_register_test(job_system_benchmark_io_waits,
+                               "Job system I/O wait benchmark.");
+    test_manager_register_test(
+        job_system_should_return_worker_caches_on_shutdown,
+        "Job system workers should return cached memory when they exit.");
+}
@@ -0,0 +1,208 @@
+#include "string_intern_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/clock.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "core/string_intern.h"
+
+#include <containers/btree_map.h>
+#include <containers/hashtable.h>
+#include <defines.h>
+#include <resources/resource_types.h>
+
+#define STRING_INTERN_BENCH_COUNT 4096
+#define STRING_INTERN_BENCH_ROUNDS 64
+#define STRING_INTERN_BENCH_NAME_LENGTH 64
+
+static void *string_intern_test_start(u32 max_string_count,
+                                      u64 *out_requirement) {
+    string_intern_config config;
+    config.max_string_count = max_string_count;
+    string_intern_initialize(out_requirement, 0, config);
+    void *state = kallocate(*out_requirement, MEMORY_TAG_ARRAY);
+    if (!string_intern_initialize(out_requirement, state, config)) {
+        kfree(state, *out_requirement, MEMORY_TAG_ARRAY);
+        return 0;
+    }
+    return state;
+}
+
+static void string_intern_test_end(void *state, u64 requirement) {
+    string_intern_shutdown(state);
+    kfree(state, requirement, MEMORY_TAG_ARRAY);
+}
+
+u8 string_intern_should_return_stable_ids() {
+    u8 failed = false;
+
+    u64 requirement = 0;
+    void *state = string_intern_test_start(64, &requirement);
+    expect_should_not_be(0, state);
+    expect_should_be(1, string_intern_count());
+
+    expect_should_be(STRING_ID_EMPTY, string_intern(""));
+    expect_should_be(STRING_ID_EMPTY, string_intern(0));
+    expect_to_be_true(strings_equal("", string_intern_get(STRING_ID_EMPTY)));
+
+    string_id cobblestone = string_intern("cobblestone");
+    string_id paving = string_intern("paving");
+    expect_should_not_be(INVALID_ID, cobblestone);
+    expect_should_not_be(STRING_ID_EMPTY, cobblestone);
+    expect_should_not_be(cobblestone, paving);
+    expect_should_be(3, string_intern_count());
+
+    // The same contents from a different buffer give the same id.
+    char buffer[32];
+    string_ncopy(buffer, "cobblestone", 32);
+    expect_should_be(cobblestone, string_intern(buffer));
+    expect_should_be(3, string_intern_count());
+
+    // Case sensitive, like the file names they come from.
+    expect_should_not_be(cobblestone, string_intern("Cobblestone"));
+
+    // The interned copy does not depend on the caller's buffer.
+    const char *stored = string_intern_get(cobblestone);
+    expect_should_not_be(buffer, stored);
+    string_empty(buffer);
+    expect_to_be_true(strings_equal("cobblestone", stored));
+    expect_should_be(hash_name("cobblestone"), string_intern_hash(cobblestone));
+
+    // find never interns.
+    expect_should_be(paving, string_intern_find("paving"));
+    expect_should_be(INVALID_ID, string_intern_find("grass"));
+    expect_should_be(4, string_intern_count());
+
+    // Unknown ids read as empty.
+    expect_to_be_true(strings_equal("", string_intern_get(INVALID_ID)));
+    expect_should_be(0, string_intern_hash(1000));
+
+    string_intern_test_end(state, requirement);
+
+    return failed ? false : true;
+}
+
+u8 string_intern_should_handle_full_table_and_long_strings() {
+    u8 failed = false;
+
+    u64 requirement = 0;
+    void *state = string_intern_test_start(4, &requirement);
+
+    // Longer than a block, so it gets one of its own.
+    u64 long_length = STRING_INTERN_BLOCK_SIZE + 100;
+    char *long_string = kallocate(long_length + 1, MEMORY_TAG_ARRAY);
+    kset_memory(long_string, 'k', long_length);
+    string_id long_id = string_intern(long_string);
+    expect_should_not_be(INVALID_ID, long_id);
+    expect_should_be(long_length, string_length(string_intern_get(long_id)));
+
+    expect_should_not_be(INVALID_ID, string_intern("a"));
+    expect_should_not_be(INVALID_ID, string_intern("b"));
+    expect_should_be(4, string_intern_count());
+
+    // Full; existing strings still resolve.
+    expect_should_be(INVALID_ID, string_intern("c"));
+    expect_should_be(long_id, string_intern(long_string));
+    string_id b = string_intern("b");
+    expect_to_be_true(strings_equal("b", string_intern_get(b)));
+
+    kfree(long_string, long_length + 1, MEMORY_TAG_ARRAY);
+    string_intern_test_end(state, requirement);
+
+    return failed ? false : true;
+}
+
+typedef struct string_intern_bench_reference {
+    u64 reference_count;
+    u64 handle;
+} string_intern_bench_reference;
+
+// Compares the reference lookup resource systems used to do, rehashing and
+// comparing the name each time, with a lookup by interned id.
+u8 string_intern_benchmark_lookup() {
+    u8 failed = false;
+
+    u64 requirement = 0;
+    void *state =
+        string_intern_test_start(STRING_INTERN_BENCH_COUNT + 1, &requirement);
+
+    u64 count = STRING_INTERN_BENCH_COUNT;
+    u64 names_size = count * STRING_INTERN_BENCH_NAME_LENGTH;
+    char *names = kallocate(names_size, MEMORY_TAG_ARRAY);
+    string_id *ids = kallocate(sizeof(string_id) * count, MEMORY_TAG_ARRAY);
+
+    hashtable table;
+    hashtable_create(sizeof(string_intern_bench_reference), count, false,
+                     &table);
+    btree_map map;
+    btree_map_create(sizeof(string_intern_bench_reference), &map);
+
+    for (u64 i = 0; i < count; i++) {
+        char *name = names + i * STRING_INTERN_BENCH_NAME_LENGTH;
+        string_format(name, "textures/environment/surface_%llu_diffuse", i);
+        ids[i] = string_intern(name);
+        string_intern_bench_reference ref = {i, i};
+        hashtable_set(&table, name, &ref);
+        btree_map_insert(&map, ids[i], &ref);
+    }
+
+    u64 by_name_sum = 0;
+    clock timer;
+    clock_start(&timer);
+    for (u32 r = 0; r < STRING_INTERN_BENCH_ROUNDS; r++) {
+        for (u64 i = 0; i < count; i++) {
+            u64 index = (i * 40503) % count;
+            string_intern_bench_reference ref;
+            hashtable_get(&table,
+                          names + index * STRING_INTERN_BENCH_NAME_LENGTH,
+                          &ref);
+            by_name_sum += ref.reference_count;
+        }
+    }
+    clock_update(&timer);
+    f64 by_name = timer.elapsed;
+
+    u64 by_id_sum = 0;
+    clock_start(&timer);
+    for (u32 r = 0; r < STRING_INTERN_BENCH_ROUNDS; r++) {
+        for (u64 i = 0; i < count; i++) {
+            u64 index = (i * 40503) % count;
+            string_intern_bench_reference *ref =
+                btree_map_get(&map, ids[index]);
+            by_id_sum += ref->reference_count;
+        }
+    }
+    clock_update(&timer);
+    f64 by_id = timer.elapsed;
+
+    expect_should_be(by_name_sum, by_id_sum);
+
+    u64 lookups = count * STRING_INTERN_BENCH_ROUNDS;
+    KINFO("Reference lookup at %llu names (ns per lookup) - by name: %.0f, by "
+          "interned id: %.0f. sizeof(texture): %llu, sizeof(material): %llu.",
+          count, by_name * 1e9 / lookups, by_id * 1e9 / lookups,
+          (u64)sizeof(texture), (u64)sizeof(material));
+
+    btree_map_destroy(&map);
+    hashtable_destroy(&table);
+    kfree(ids, sizeof(string_id) * count, MEMORY_TAG_ARRAY);
+    kfree(names, names_size, MEMORY_TAG_ARRAY);
+    string_intern_test_end(state, requirement);
+
+    return failed ? false : true;
+}
+
+void string_intern_register_tests() {
+    test_manager_register_test(
+        string_intern_should_return_stable_ids,
+        "String intern should return the same id for equal strings.");
+    test_manager_register_test(
+        string_intern_should_handle_full_table_and_long_strings,
+        "String intern should refuse new strings once full and store long "
+        "ones.");
+    test_manager_register_test(
+        string_intern_benchmark_lookup,
+        "String intern reference lookup benchmark, by name and by id.");
+}
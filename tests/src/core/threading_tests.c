@@ -0,0 +1,204 @@
+#include "threading_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/katomic.h"
+#include "core/kcondition.h"
+#include "core/kfutex.h"
+#include "core/kmutex.h"
+#include "core/kthread.h"
+#include "platform/platform.h"
+
+#include <defines.h>
+
+#define THREADING_TEST_THREADS 4
+#define THREADING_TEST_INCREMENTS 10000
+
+u8 threading_should_report_processors_and_cache_lines() {
+    u8 failed = false;
+
+    expect_to_be_true((platform_get_processor_count() >= 1));
+    u32 line = platform_get_cache_line_size();
+    expect_to_be_true((line >= 16 && line <= 256));
+    // Always a power of 2.
+    expect_should_be(0, (line & (line - 1)));
+
+    return failed ? false : true;
+}
+
+typedef struct threading_test_counter {
+    u64 value;
+    u32 flags;
+} threading_test_counter;
+
+static u32 threading_test_increment(void *params) {
+    threading_test_counter *counter = params;
+    for (u32 i = 0; i < THREADING_TEST_INCREMENTS; ++i) {
+        katomic_fetch_add(&counter->value, 1, KATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+u8 katomic_should_update_values_atomically() {
+    u8 failed = false;
+
+    threading_test_counter counter = {0};
+    expect_should_be(0, katomic_fetch_add(&counter.value, 5, KATOMIC_RELAXED));
+    expect_should_be(5, katomic_fetch_sub(&counter.value, 2, KATOMIC_RELAXED));
+    expect_should_be(3, katomic_exchange(&counter.value, 10, KATOMIC_ACQ_REL));
+    expect_should_be(10, katomic_load(&counter.value, KATOMIC_ACQUIRE));
+
+    // A failed exchange reports the value found.
+    u64 expected = 7;
+    expect_to_be_false(katomic_compare_exchange_strong(
+        &counter.value, &expected, 8, KATOMIC_SEQ_CST, KATOMIC_RELAXED));
+    expect_should_be(10, expected);
+    expect_to_be_true(katomic_compare_exchange_strong(
+        &counter.value, &expected, 8, KATOMIC_SEQ_CST, KATOMIC_RELAXED));
+    expect_should_be(8, counter.value);
+
+    expect_should_be(0, katomic_fetch_or(&counter.flags, 6, KATOMIC_RELAXED));
+    expect_should_be(6, katomic_fetch_and(&counter.flags, 3, KATOMIC_RELAXED));
+    expect_should_be(2, counter.flags);
+    katomic_thread_fence(KATOMIC_SEQ_CST);
+    katomic_spin_pause();
+
+    // No increments are lost across threads.
+    katomic_store(&counter.value, 0, KATOMIC_RELEASE);
+    kthread threads[THREADING_TEST_THREADS];
+    for (u32 i = 0; i < THREADING_TEST_THREADS; ++i) {
+        expect_to_be_true(kthread_create(threading_test_increment, &counter,
+                                         false, &threads[i]));
+    }
+    for (u32 i = 0; i < THREADING_TEST_THREADS; ++i) {
+        kthread_wait(&threads[i]);
+    }
+    expect_should_be(THREADING_TEST_THREADS * THREADING_TEST_INCREMENTS,
+                     counter.value);
+
+    return failed ? false : true;
+}
+
+typedef struct threading_test_mailbox {
+    kmutex mutex;
+    kcondition condition;
+    u32 sent;
+    u32 received;
+} threading_test_mailbox;
+
+// Receives each message the main thread sends, acknowledging it.
+static u32 threading_test_receive(void *params) {
+    threading_test_mailbox *mailbox = params;
+    kmutex_lock(&mailbox->mutex);
+    while (mailbox->received < 3) {
+        while (mailbox->sent == mailbox->received) {
+            kcondition_wait(&mailbox->condition, &mailbox->mutex);
+        }
+        mailbox->received++;
+        kcondition_broadcast(&mailbox->condition);
+    }
+    kmutex_unlock(&mailbox->mutex);
+    return 0;
+}
+
+u8 kcondition_should_hand_off_between_threads() {
+    u8 failed = false;
+
+    threading_test_mailbox mailbox = {0};
+    expect_to_be_true(kmutex_create(&mailbox.mutex));
+    expect_to_be_true(kcondition_create(&mailbox.condition));
+
+    kthread receiver;
+    expect_to_be_true(
+        kthread_create(threading_test_receive, &mailbox, false, &receiver));
+    kmutex_lock(&mailbox.mutex);
+    for (u32 i = 1; i <= 3; ++i) {
+        mailbox.sent = i;
+        kcondition_signal(&mailbox.condition);
+        while (mailbox.received != i) {
+            kcondition_wait(&mailbox.condition, &mailbox.mutex);
+        }
+    }
+    kmutex_unlock(&mailbox.mutex);
+    kthread_wait(&receiver);
+    expect_should_be(3, mailbox.received);
+
+    kcondition_destroy(&mailbox.condition);
+    kmutex_destroy(&mailbox.mutex);
+    expect_to_be_true((mailbox.condition.internal_data == 0));
+
+    return failed ? false : true;
+}
+
+typedef struct threading_test_gate {
+    kfutex_event open;
+    u32 passed;
+} threading_test_gate;
+
+static u32 threading_test_pass_gate(void *params) {
+    threading_test_gate *gate = params;
+    kfutex_event_wait(&gate->open, KFUTEX_WAIT_FOREVER);
+    katomic_fetch_add(&gate->passed, 1, KATOMIC_RELAXED);
+    return 0;
+}
+
+u8 kfutex_event_should_release_waiters() {
+    u8 failed = false;
+
+    // A value other than the expected one returns at once.
+    u32 word = 1;
+    expect_to_be_true(kfutex_wait(&word, 0, KFUTEX_WAIT_FOREVER));
+    expect_to_be_false(kfutex_wait(&word, 1, 1));
+    kfutex_wake(&word, 1);
+
+    threading_test_gate gate = {0};
+    expect_to_be_false(kfutex_event_is_set(&gate.open));
+    expect_to_be_false(kfutex_event_wait(&gate.open, 2));
+
+    kthread threads[THREADING_TEST_THREADS];
+    for (u32 i = 0; i < THREADING_TEST_THREADS; ++i) {
+        expect_to_be_true(kthread_create(threading_test_pass_gate, &gate,
+                                         false, &threads[i]));
+    }
+    // Let some of them reach the wait before the event is set.
+    platform_sleep(5);
+    expect_should_be(0, katomic_load(&gate.passed, KATOMIC_RELAXED));
+    kfutex_event_set(&gate.open);
+    for (u32 i = 0; i < THREADING_TEST_THREADS; ++i) {
+        kthread_wait(&threads[i]);
+    }
+    expect_should_be(THREADING_TEST_THREADS, gate.passed);
+
+    // Stays set until reset.
+    expect_to_be_true(kfutex_event_wait(&gate.open, 0));
+    kfutex_event_reset(&gate.open);
+    expect_to_be_false(kfutex_event_is_set(&gate.open));
+    expect_to_be_false(kfutex_event_wait(&gate.open, 0));
+
+    // A wait with a timeout gives up once it passes.
+    f64 start = platform_get_absolute_time();
+    expect_to_be_false(kfutex_event_wait(&gate.open, 5));
+    expect_to_be_true((platform_get_absolute_time() - start >= 0.004));
+
+    // Set before anyone waits, even a wait with no time limit returns at once.
+    kfutex_event early = {0};
+    kfutex_event_set(&early);
+    expect_to_be_true(kfutex_event_is_set(&early));
+    expect_to_be_true(kfutex_event_wait(&early, KFUTEX_WAIT_FOREVER));
+    expect_to_be_true(kfutex_event_wait(&early, 0));
+
+    return failed ? false : true;
+}
+
+void threading_register_tests() {
+    test_manager_register_test(
+        threading_should_report_processors_and_cache_lines,
+        "Platform should report processor count and cache line size.");
+    test_manager_register_test(katomic_should_update_values_atomically,
+                               "Atomics should update values atomically.");
+    test_manager_register_test(
+        kcondition_should_hand_off_between_threads,
+        "Condition variables should hand off between threads.");
+    test_manager_register_test(kfutex_event_should_release_waiters,
+                               "Futex events should release their waiters.");
+}
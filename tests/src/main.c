@@ -1,10 +1,26 @@
+#include "containers/btree_map_tests.h"
+#include "containers/darray_tests.h"
 #include "containers/freelist_tests.h"
+#include "containers/intrusive_list_tests.h"
 #include "containers/linkedlist_tests.h"
+#include "containers/pool_list_tests.h"
+#include "containers/ring_queue_tests.h"
+#include "containers/slotmap_tests.h"
+#include "containers/soa_tests.h"
+#include "core/job_system_tests.h"
+#include "core/string_intern_tests.h"
+#include "core/threading_tests.h"
 #include "core/kmemory.h"
+#include "memory/allocation_tracker_test.h"
 #include "memory/dynamic_allocator_test.h"
 #include "test_manager.h"
 
+#include "memory/frame_allocator_test.h"
+#include "memory/handle_allocator_test.h"
+#include "memory/kmemory_test.h"
 #include "memory/linear_allocator_test.h"
+#include "memory/slab_allocator_test.h"
+#include "memory/tlsf_allocator_test.h"
 #include "containers/hastable_tests.h"
 
 #include <core/logger.h>
@@ -13,6 +29,8 @@ int main() {
     // memory
     memory_system_configuration memory_system_config = {};
     memory_system_config.total_alloc_count = GIBIBYTES(1);
+    memory_system_config.allocator_strategy =
+        DYNAMIC_ALLOCATOR_STRATEGY_FREELIST;
     if (!memory_system_initialize(memory_system_config)) {
         KERROR("Failed to initialize memory system, shutting down.");
         return false;
@@ -26,6 +44,22 @@ int main() {
     freelist_register_tests();
     dynamic_allocator_register_tests();
     linkedlist_register_tests();
+    intrusive_list_register_tests();
+    pool_list_register_tests();
+    slotmap_register_tests();
+    ring_queue_register_tests();
+    darray_register_tests();
+    btree_map_register_tests();
+    string_intern_register_tests();
+    threading_register_tests();
+    job_system_register_tests();
+    soa_register_tests();
+    slab_allocator_register_tests();
+    tlsf_allocator_register_tests();
+    kmemory_register_tests();
+    frame_allocator_register_tests();
+    handle_allocator_register_tests();
+    allocation_tracker_register_tests();
 
     KDEBUG("Starting tests...");
 
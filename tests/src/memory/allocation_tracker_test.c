@@ -0,0 +1,224 @@
+#include "allocation_tracker_test.h"
+
+#include <memory/allocation_tracker.h>
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include <defines.h>
+
+#include <string.h>
+
+typedef struct tracker_test_context {
+    allocation_tracker tracker;
+    void *memory;
+    u64 memory_requirement;
+} tracker_test_context;
+
+static void tracker_test_setup(tracker_test_context *ctx, u32 max_sites) {
+    allocation_tracker_create(max_sites, &ctx->memory_requirement, 0, 0);
+    ctx->memory = kallocate(ctx->memory_requirement, MEMORY_TAG_ARRAY);
+    allocation_tracker_create(max_sites, &ctx->memory_requirement, ctx->memory,
+                              &ctx->tracker);
+}
+
+static void tracker_test_teardown(tracker_test_context *ctx) {
+    allocation_tracker_destroy(&ctx->tracker);
+    kfree(ctx->memory, ctx->memory_requirement, MEMORY_TAG_ARRAY);
+}
+
+u8 allocation_tracker_should_track_sites() {
+    u8 failed = false;
+
+    tracker_test_context ctx;
+    tracker_test_setup(&ctx, 16);
+
+    // Same text from a different pointer is the same site.
+    char file_copy[] = "a.c";
+    u32 a = allocation_tracker_record_allocation(&ctx.tracker, "a.c", 10, 100);
+    u32 a_again =
+        allocation_tracker_record_allocation(&ctx.tracker, file_copy, 10, 50);
+    u32 b = allocation_tracker_record_allocation(&ctx.tracker, "a.c", 11, 8);
+    expect_should_be(a, a_again);
+    expect_should_not_be(a, b);
+    expect_should_not_be(ALLOCATION_TRACKER_OVERFLOW_SITE, a);
+    expect_should_be(3, allocation_tracker_site_count(&ctx.tracker));
+
+    allocation_tracker_record_free(&ctx.tracker, a, 100);
+
+    allocation_site_stats stats;
+    expect_to_be_true(allocation_tracker_get_site(&ctx.tracker, a, &stats));
+    expect_should_be(10, stats.line);
+    expect_should_be(1, stats.live_count);
+    expect_should_be(50, stats.live_bytes);
+    expect_should_be(150, stats.peak_live_bytes);
+    expect_should_be(2, stats.total_count);
+    expect_should_be(150, stats.total_bytes);
+    // Frame counters only show up once the frame closes.
+    expect_should_be(0, stats.frame_allocations);
+
+    allocation_tracker_end_frame(&ctx.tracker);
+    allocation_tracker_get_site(&ctx.tracker, a, &stats);
+    expect_should_be(2, stats.frame_allocations);
+    expect_should_be(1, stats.frame_frees);
+
+    allocation_tracker_end_frame(&ctx.tracker);
+    allocation_tracker_get_site(&ctx.tracker, a, &stats);
+    expect_should_be(0, stats.frame_allocations);
+    expect_should_be(1, stats.live_count);
+
+    u64 histogram[ALLOCATION_TRACKER_HISTOGRAM_BUCKETS];
+    allocation_tracker_get_histogram(&ctx.tracker, histogram);
+    expect_should_be(1, histogram[3]); // 8
+    expect_should_be(1, histogram[5]); // 50
+    expect_should_be(1, histogram[6]); // 100
+
+    tracker_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 allocation_tracker_should_overflow_into_shared_site() {
+    u8 failed = false;
+
+    tracker_test_context ctx;
+    tracker_test_setup(&ctx, 2);
+
+    allocation_tracker_record_allocation(&ctx.tracker, "a.c", 1, 16);
+    allocation_tracker_record_allocation(&ctx.tracker, "a.c", 2, 16);
+    u32 third =
+        allocation_tracker_record_allocation(&ctx.tracker, "a.c", 3, 16);
+    expect_should_be(ALLOCATION_TRACKER_OVERFLOW_SITE, third);
+
+    allocation_site_stats stats;
+    allocation_tracker_get_site(&ctx.tracker, third, &stats);
+    expect_should_be(1, stats.live_count);
+
+    allocation_tracker_record_free(&ctx.tracker, third, 16);
+    allocation_tracker_get_site(&ctx.tracker, third, &stats);
+    expect_should_be(0, stats.live_count);
+
+    tracker_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 allocation_tracker_should_sort_and_report() {
+    u8 failed = false;
+
+    tracker_test_context ctx;
+    tracker_test_setup(&ctx, 16);
+
+    // Line n allocates n times in the frame; line 9 holds the most bytes.
+    for (u32 line = 1; line <= 5; line++) {
+        for (u32 i = 0; i < line; i++) {
+            allocation_tracker_record_allocation(&ctx.tracker, "hot.c", line,
+                                                 32);
+        }
+    }
+    allocation_tracker_record_allocation(&ctx.tracker, "big.c", 9, 1 << 20);
+    allocation_tracker_end_frame(&ctx.tracker);
+
+    u32 top[3];
+    u32 count = allocation_tracker_top_sites(
+        &ctx.tracker, ALLOCATION_TRACKER_SORT_FRAME_CHURN, 3, top);
+    expect_should_be(3, count);
+    allocation_site_stats stats;
+    u32 expected_lines[] = {5, 4, 3};
+    for (u32 i = 0; i < 3; i++) {
+        allocation_tracker_get_site(&ctx.tracker, top[i], &stats);
+        expect_should_be(expected_lines[i], stats.line);
+    }
+
+    count = allocation_tracker_top_sites(
+        &ctx.tracker, ALLOCATION_TRACKER_SORT_LIVE_BYTES, 1, top);
+    expect_should_be(1, count);
+    allocation_tracker_get_site(&ctx.tracker, top[0], &stats);
+    expect_should_be(9, stats.line);
+
+    char report[2048];
+    u64 length = allocation_tracker_report(
+        &ctx.tracker, ALLOCATION_TRACKER_SORT_FRAME_CHURN, 3, report,
+        sizeof(report));
+    expect_should_be(string_length(report), length);
+    expect_should_not_be(0, strstr(report, "hot.c:5"));
+    expect_should_be(0, strstr(report, "hot.c:1 "));
+
+    // A small buffer is cut short but stays terminated.
+    char small[16];
+    length = allocation_tracker_report(
+        &ctx.tracker, ALLOCATION_TRACKER_SORT_FRAME_CHURN, 3, small,
+        sizeof(small));
+    expect_should_be(15, length);
+    expect_should_be(15, string_length(small));
+
+    tracker_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 allocation_tracker_should_write_json() {
+    u8 failed = false;
+
+    tracker_test_context ctx;
+    tracker_test_setup(&ctx, 16);
+
+    allocation_tracker_record_allocation(&ctx.tracker, "dir\\\"x\".c", 7, 64);
+
+    u64 size = allocation_tracker_json_size(&ctx.tracker);
+    char *json = kallocate(size, MEMORY_TAG_STRING);
+    u64 length = allocation_tracker_json(&ctx.tracker, json, size);
+    expect_to_be_true((length > 0 && length < size));
+    expect_should_be('{', json[0]);
+    expect_should_be('}', json[length - 1]);
+    expect_should_not_be(0, strstr(json, "\"file\":\"dir\\\\\\\"x\\\".c\""));
+    expect_should_not_be(0, strstr(json, "\"line\":7,\"live_count\":1"));
+
+    kfree(json, size, MEMORY_TAG_STRING);
+    tracker_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+#if KMEMORY_TRACK_ALLOCATIONS
+u8 allocation_tracker_should_record_memory_system_sites() {
+    u8 failed = false;
+
+    void *block = kallocate(1234, MEMORY_TAG_ARRAY);
+    memory_system_end_frame();
+
+    char *report =
+        get_memory_allocation_report(ALLOCATION_TRACKER_SORT_FRAME_CHURN, 64);
+    expect_should_not_be(0, strstr(report, __FILE__));
+    kfree(report, string_length(report) + 1, MEMORY_TAG_STRING);
+
+    char *json = get_memory_allocation_json();
+    expect_should_not_be(0, strstr(json, __FILE__));
+    kfree(json, string_length(json) + 1, MEMORY_TAG_STRING);
+
+    kfree(block, 1234, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+#endif
+
+void allocation_tracker_register_tests() {
+    test_manager_register_test(
+        allocation_tracker_should_track_sites,
+        "Allocation tracker should track live, total and per-frame counts.");
+    test_manager_register_test(
+        allocation_tracker_should_overflow_into_shared_site,
+        "Allocation tracker should count extra sites together when full.");
+    test_manager_register_test(
+        allocation_tracker_should_sort_and_report,
+        "Allocation tracker should sort sites and write a report.");
+    test_manager_register_test(allocation_tracker_should_write_json,
+                               "Allocation tracker should write escaped JSON.");
+#if KMEMORY_TRACK_ALLOCATIONS
+    test_manager_register_test(
+        allocation_tracker_should_record_memory_system_sites,
+        "Memory system should report kallocate call sites.");
+#endif
+}
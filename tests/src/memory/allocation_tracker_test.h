@@ -0,0 +1,3 @@
+#pragma once
+
+void allocation_tracker_register_tests();
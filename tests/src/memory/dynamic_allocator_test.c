@@ -268,6 +268,92 @@ u8 dynamic_allocator_should_not_overwrite_allocated_data() {
     return failed ? false : true;
 }
 
+u8 dynamic_allocator_should_try_extend() {
+    u8 failed = false;
+
+    dynamic_allocator_strategy strategies[] = {
+        DYNAMIC_ALLOCATOR_STRATEGY_FREELIST, DYNAMIC_ALLOCATOR_STRATEGY_TLSF};
+    u64 total_size = 4096;
+
+    for (u32 s = 0; s < 2; s++) {
+        dynamic_allocator allocator;
+        u64 memory_requirement = 0;
+        dynamic_allocator_create_with_strategy(strategies[s], total_size,
+                                               &memory_requirement, 0, 0);
+        void *memory = kallocate(memory_requirement, MEMORY_TAG_ARRAY);
+        dynamic_allocator_create_with_strategy(
+            strategies[s], total_size, &memory_requirement, memory, &allocator);
+
+        u8 *a = dynamic_allocator_allocate(&allocator, 256);
+        void *b = dynamic_allocator_allocate(&allocator, 256);
+        void *c = dynamic_allocator_allocate(&allocator, 256);
+        expect_should_not_be(0, a);
+        expect_should_not_be(0, b);
+        expect_should_not_be(0, c);
+        kset_memory(a, 0xCD, 256);
+
+        // b sits directly after a, so a cannot grow yet.
+        expect_to_be_false(
+            dynamic_allocator_try_extend(&allocator, a, 256, 384));
+
+        // Once b is freed, a grows into its space without moving.
+        dynamic_allocator_free(&allocator, b, 256);
+        expect_to_be_true(
+            dynamic_allocator_try_extend(&allocator, a, 256, 384));
+        expect_should_be(0xCD, a[255]);
+        kset_memory(a, 0xCD, 384);
+
+        // Growing past c is still refused.
+        expect_to_be_false(
+            dynamic_allocator_try_extend(&allocator, a, 384, 1024));
+
+        dynamic_allocator_free(&allocator, a, 384);
+        dynamic_allocator_free(&allocator, c, 256);
+        expect_should_be(total_size, dynamic_allocator_free_space(&allocator));
+
+        dynamic_allocator_destroy(&allocator);
+        kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+    }
+
+    return failed ? false : true;
+}
+
+u8 kallocate_aligned_should_reject_bad_alignment() {
+    u8 failed = false;
+
+    u64 before = get_memory_alloc_count();
+    KDEBUG("Note: The following errors are intentionally caused by this "
+           "test.");
+    expect_should_be(0, kallocate_aligned(64, 0, MEMORY_TAG_ARRAY));
+    expect_should_be(0, kallocate_aligned(64, 24, MEMORY_TAG_ARRAY));
+    expect_should_be(before, get_memory_alloc_count());
+
+    return failed ? false : true;
+}
+
+u8 kallocate_aligned_should_align_and_track_usage() {
+    u8 failed = false;
+
+    u64 before = get_memory_alloc_count();
+    void *small = kallocate_aligned(sizeof(f32) * 4, 16, MEMORY_TAG_ARRAY);
+    void *large = kallocate_aligned(64 * 1024, 64, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, small);
+    expect_should_not_be(0, large);
+    expect_should_be(0, (u64)small % 16);
+    expect_should_be(0, (u64)large % 64);
+    expect_should_be(before + 2, get_memory_alloc_count());
+
+    // Blocks come back zeroed, like kallocate
+    u8 *bytes = large;
+    expect_should_be(0, bytes[0]);
+    expect_should_be(0, bytes[64 * 1024 - 1]);
+
+    kfree_aligned(small, sizeof(f32) * 4, 16, MEMORY_TAG_ARRAY);
+    kfree_aligned(large, 64 * 1024, 64, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
 void dynamic_allocator_register_tests() {
     test_manager_register_test(
         dynamic_allocator_should_create_and_destroy,
@@ -298,4 +384,17 @@ void dynamic_allocator_register_tests() {
         dynamic_allocator_should_not_overwrite_allocated_data,
         "Dynamic allocator should preserve data of existing blocks when "
         "allocating new ones.");
+
+    test_manager_register_test(
+        dynamic_allocator_should_try_extend,
+        "Dynamic allocator should grow blocks in place into free space only "
+        "with either strategy.");
+
+    test_manager_register_test(
+        kallocate_aligned_should_align_and_track_usage,
+        "kallocate_aligned should return aligned, zeroed, tracked blocks.");
+
+    test_manager_register_test(
+        kallocate_aligned_should_reject_bad_alignment,
+        "kallocate_aligned should reject non power of 2 alignments.");
 }
@@ -0,0 +1,144 @@
+#include "frame_allocator_test.h"
+
+#include <memory/frame_allocator.h>
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include <defines.h>
+
+typedef struct frame_test_context {
+    frame_allocator allocator;
+    void *memory;
+    u64 memory_requirement;
+} frame_test_context;
+
+static b8 frame_test_setup(frame_test_context *ctx, u64 frame_size,
+                           u8 frame_count) {
+    if (!frame_allocator_create(frame_size, frame_count,
+                                &ctx->memory_requirement, 0, 0)) {
+        return false;
+    }
+    ctx->memory = kallocate(ctx->memory_requirement, MEMORY_TAG_ARRAY);
+    return frame_allocator_create(frame_size, frame_count,
+                                  &ctx->memory_requirement, ctx->memory,
+                                  &ctx->allocator);
+}
+
+static void frame_test_teardown(frame_test_context *ctx) {
+    frame_allocator_destroy(&ctx->allocator);
+    kfree(ctx->memory, ctx->memory_requirement, MEMORY_TAG_ARRAY);
+}
+
+u8 frame_allocator_should_create_and_destroy() {
+    u8 failed = false;
+
+    frame_test_context ctx;
+    expect_to_be_true(frame_test_setup(&ctx, 1024, 2));
+    expect_should_not_be(0, ctx.allocator.memory);
+
+    frame_allocator_stats stats;
+    frame_allocator_get_stats(&ctx.allocator, &stats);
+    expect_should_be(1024, stats.capacity);
+    expect_should_be(0, stats.used);
+    expect_should_be(0, stats.high_water);
+
+    frame_test_teardown(&ctx);
+    expect_should_be(0, ctx.allocator.memory);
+
+    KDEBUG("Note: The following errors are intentionally caused by this "
+           "test.");
+    u64 requirement = 0;
+    expect_to_be_false(frame_allocator_create(1024, 0, &requirement, 0, 0));
+    expect_to_be_false(frame_allocator_create(
+        1024, FRAME_ALLOCATOR_MAX_FRAMES + 1, &requirement, 0, 0));
+
+    return failed ? false : true;
+}
+
+u8 frame_allocator_should_keep_data_for_frames_in_flight() {
+    u8 failed = false;
+
+    frame_test_context ctx;
+    u8 frame_count = 3;
+    expect_to_be_true(frame_test_setup(&ctx, 1024, frame_count));
+
+    // Each frame writes its number into its own block.
+    u32 *blocks[3];
+    for (u8 i = 0; i < frame_count; i++) {
+        if (i > 0) {
+            frame_allocator_begin_frame(&ctx.allocator, i);
+        }
+        blocks[i] = frame_allocator_allocate(&ctx.allocator, sizeof(u32), 4);
+        expect_should_not_be(0, blocks[i]);
+        *blocks[i] = 100 + i;
+    }
+
+    // Every frame still in flight is untouched.
+    for (u8 i = 0; i < frame_count; i++) {
+        expect_should_be(100 + i, *blocks[i]);
+    }
+
+    // Wrapping around reuses the oldest frame's buffer from the start.
+    frame_allocator_begin_frame(&ctx.allocator, 0);
+    u32 *reused = frame_allocator_allocate(&ctx.allocator, sizeof(u32), 4);
+    expect_should_be(blocks[0], reused);
+    expect_should_be(101, *blocks[1]);
+    expect_should_be(102, *blocks[2]);
+
+    // A frame the renderer skipped keeps its slot, so the same buffer is
+    // reset again and the others are left alone.
+    frame_allocator_begin_frame(&ctx.allocator, 0);
+    reused = frame_allocator_allocate(&ctx.allocator, sizeof(u32), 4);
+    expect_should_be(blocks[0], reused);
+    expect_should_be(101, *blocks[1]);
+    expect_should_be(102, *blocks[2]);
+
+    frame_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 frame_allocator_should_track_high_water_and_failures() {
+    u8 failed = false;
+
+    frame_test_context ctx;
+    expect_to_be_true(frame_test_setup(&ctx, 1024, 2));
+
+    expect_should_not_be(0, frame_allocator_allocate(&ctx.allocator, 600, 8));
+    frame_allocator_begin_frame(&ctx.allocator, 1);
+    expect_should_not_be(0, frame_allocator_allocate(&ctx.allocator, 100, 8));
+
+    frame_allocator_stats stats;
+    frame_allocator_get_stats(&ctx.allocator, &stats);
+    expect_should_be(100, stats.used);
+    expect_should_be(600, stats.last_frame_used);
+    expect_should_be(600, stats.high_water);
+
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(0, frame_allocator_allocate(&ctx.allocator, 1000, 8));
+    frame_allocator_begin_frame(&ctx.allocator, 0);
+
+    frame_allocator_get_stats(&ctx.allocator, &stats);
+    expect_should_be(0, stats.used);
+    expect_should_be(100, stats.last_frame_used);
+    expect_should_be(600, stats.high_water);
+    expect_should_be(1, stats.failed_count);
+
+    frame_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+void frame_allocator_register_tests() {
+    test_manager_register_test(
+        frame_allocator_should_create_and_destroy,
+        "Frame allocator should create and destroy successfully.");
+    test_manager_register_test(
+        frame_allocator_should_keep_data_for_frames_in_flight,
+        "Frame allocator should keep data until its buffer comes around.");
+    test_manager_register_test(
+        frame_allocator_should_track_high_water_and_failures,
+        "Frame allocator should track high-water marks and failures.");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void frame_allocator_register_tests();
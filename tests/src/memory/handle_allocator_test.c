@@ -0,0 +1,198 @@
+#include "handle_allocator_test.h"
+
+#include <memory/dynamic_allocator.h>
+#include <memory/handle_allocator.h>
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include <defines.h>
+
+typedef struct handle_test_context {
+    dynamic_allocator backing;
+    void *backing_memory;
+    u64 backing_requirement;
+    handle_allocator allocator;
+    void *memory;
+    u64 memory_requirement;
+} handle_test_context;
+
+static void handle_test_setup(handle_test_context *ctx, u64 backing_size,
+                              u32 max_handle_count) {
+    dynamic_allocator_create(backing_size, &ctx->backing_requirement, 0, 0);
+    ctx->backing_memory = kallocate(ctx->backing_requirement, MEMORY_TAG_ARRAY);
+    dynamic_allocator_create(backing_size, &ctx->backing_requirement,
+                             ctx->backing_memory, &ctx->backing);
+
+    handle_allocator_create(&ctx->backing, max_handle_count,
+                            &ctx->memory_requirement, 0, 0);
+    ctx->memory = kallocate(ctx->memory_requirement, MEMORY_TAG_ARRAY);
+    handle_allocator_create(&ctx->backing, max_handle_count,
+                            &ctx->memory_requirement, ctx->memory,
+                            &ctx->allocator);
+}
+
+static void handle_test_teardown(handle_test_context *ctx) {
+    handle_allocator_destroy(&ctx->allocator);
+    kfree(ctx->memory, ctx->memory_requirement, MEMORY_TAG_ARRAY);
+    dynamic_allocator_destroy(&ctx->backing);
+    kfree(ctx->backing_memory, ctx->backing_requirement, MEMORY_TAG_ARRAY);
+}
+
+u8 handle_allocator_should_allocate_and_free() {
+    u8 failed = false;
+
+    handle_test_context ctx;
+    u64 backing_size = 64 * 1024;
+    handle_test_setup(&ctx, backing_size, 16);
+
+    u32 handle = handle_allocator_allocate(&ctx.allocator, 100);
+    expect_should_not_be(INVALID_ID, handle);
+    u8 *block = handle_allocator_get(&ctx.allocator, handle);
+    expect_should_not_be(0, block);
+    expect_should_be(0, (u64)block % HANDLE_ALLOCATOR_ALIGNMENT);
+    expect_should_be(100, handle_allocator_size(&ctx.allocator, handle));
+    expect_should_be(0, block[99]);
+
+    expect_to_be_true(handle_allocator_free(&ctx.allocator, handle));
+    expect_should_be(0, handle_allocator_get(&ctx.allocator, handle));
+    expect_should_be(backing_size,
+                     dynamic_allocator_free_space(&ctx.backing));
+
+    // The entry is reused, but the old handle stays dead.
+    u32 reused = handle_allocator_allocate(&ctx.allocator, 100);
+    expect_should_not_be(INVALID_ID, reused);
+    expect_should_not_be(handle, reused);
+    expect_should_be(0, handle_allocator_get(&ctx.allocator, handle));
+    expect_should_not_be(0, handle_allocator_get(&ctx.allocator, reused));
+
+    KDEBUG("Note: The following errors are intentionally caused by this "
+           "test.");
+    expect_to_be_false(handle_allocator_free(&ctx.allocator, handle));
+    expect_to_be_false(handle_allocator_free(&ctx.allocator, INVALID_ID));
+    expect_to_be_true(handle_allocator_free(&ctx.allocator, reused));
+
+    handle_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 handle_allocator_should_run_out_of_handles() {
+    u8 failed = false;
+
+    handle_test_context ctx;
+    handle_test_setup(&ctx, 64 * 1024, 4);
+
+    u32 handles[4];
+    for (u32 i = 0; i < 4; i++) {
+        handles[i] = handle_allocator_allocate(&ctx.allocator, 16);
+        expect_should_not_be(INVALID_ID, handles[i]);
+    }
+
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(INVALID_ID, handle_allocator_allocate(&ctx.allocator, 16));
+
+    expect_to_be_true(handle_allocator_free(&ctx.allocator, handles[2]));
+    handles[2] = handle_allocator_allocate(&ctx.allocator, 16);
+    expect_should_not_be(INVALID_ID, handles[2]);
+
+    // Destroy returns the live blocks.
+    handle_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 handle_allocator_should_compact_into_holes() {
+    u8 failed = false;
+
+    handle_test_context ctx;
+    u64 backing_size = 40000;
+    handle_test_setup(&ctx, backing_size, 16);
+
+    u64 block_size = 4096;
+    u32 handles[8];
+    for (u32 i = 0; i < 8; i++) {
+        handles[i] = handle_allocator_allocate(&ctx.allocator, block_size);
+        expect_should_not_be(INVALID_ID, handles[i]);
+        kset_memory(handle_allocator_get(&ctx.allocator, handles[i]),
+                    (i32)i + 1, block_size);
+    }
+
+    // Punch holes, leaving free space split into pieces.
+    for (u32 i = 1; i < 8; i += 2) {
+        expect_to_be_true(handle_allocator_free(&ctx.allocator, handles[i]));
+    }
+    u64 free_space = dynamic_allocator_free_space(&ctx.backing);
+    u64 largest = dynamic_allocator_largest_free_block(&ctx.backing);
+    expect_to_be_true((largest < free_space));
+
+    // A small budget only moves part of the way.
+    u64 moved = handle_allocator_compact(&ctx.allocator, block_size);
+    expect_should_be(block_size, moved);
+
+    u64 total_moved = moved;
+    while ((moved = handle_allocator_compact(&ctx.allocator, 64 * 1024))) {
+        total_moved += moved;
+    }
+    // Best fit fills the hole that matches exactly, not the lowest one, so one
+    // block takes two moves to settle.
+    expect_should_be(block_size * 4, total_moved);
+
+    // Free space is now a single block, and the data came along.
+    expect_should_be(free_space, dynamic_allocator_free_space(&ctx.backing));
+    expect_should_be(free_space,
+                     dynamic_allocator_largest_free_block(&ctx.backing));
+    for (u32 i = 0; i < 8; i += 2) {
+        u8 *block = handle_allocator_get(&ctx.allocator, handles[i]);
+        expect_should_not_be(0, block);
+        expect_should_be(i + 1, block[0]);
+        expect_should_be(i + 1, block[block_size - 1]);
+    }
+
+    handle_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 handle_allocator_should_back_memory_system_handles() {
+    u8 failed = false;
+
+    u64 alloc_count = get_memory_alloc_count();
+    u32 handle = kallocate_handle(64 * 1024, MEMORY_TAG_ARRAY);
+    expect_should_not_be(INVALID_ID, handle);
+    expect_should_be(alloc_count + 1, get_memory_alloc_count());
+
+    u8 *block = khandle_get(handle);
+    expect_should_not_be(0, block);
+    block[0] = 0x7F;
+
+    memory_system_compact(MEBIBYTES(1));
+    block = khandle_get(handle);
+    expect_should_be(0x7F, block[0]);
+
+    f32 contiguity = get_memory_free_contiguity();
+    expect_to_be_true((contiguity > 0.0f && contiguity <= 1.0f));
+
+    u64 mismatches = get_memory_free_mismatch_count();
+    kfree_handle(handle, MEMORY_TAG_ARRAY);
+    expect_should_be(0, khandle_get(handle));
+    expect_should_be(mismatches, get_memory_free_mismatch_count());
+
+    return failed ? false : true;
+}
+
+void handle_allocator_register_tests() {
+    test_manager_register_test(
+        handle_allocator_should_allocate_and_free,
+        "Handle allocator should allocate, resolve and reject stale handles.");
+    test_manager_register_test(
+        handle_allocator_should_run_out_of_handles,
+        "Handle allocator should fail cleanly when out of handles.");
+    test_manager_register_test(
+        handle_allocator_should_compact_into_holes,
+        "Handle allocator should compact blocks into lower free space.");
+    test_manager_register_test(
+        handle_allocator_should_back_memory_system_handles,
+        "Memory system handles should survive compaction.");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void handle_allocator_register_tests();
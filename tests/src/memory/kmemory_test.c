@@ -0,0 +1,517 @@
+#include "kmemory_test.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/clock.h"
+#include "core/event.h"
+#include "core/kmemory.h"
+#include "core/kthread.h"
+#include "core/logger.h"
+#include <defines.h>
+
+#if defined(KPLATFORM_LINUX)
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+u8 kmemory_should_free_without_size() {
+    u8 failed = false;
+
+    u64 sizes[] = {1, 24, 4000, 4096, 100 * 1024};
+    void *blocks[5];
+    for (u32 i = 0; i < 5; i++) {
+        blocks[i] = kallocate(sizes[i], MEMORY_TAG_ARRAY);
+        expect_should_not_be(0, blocks[i]);
+        expect_should_be(sizes[i], kallocation_size(blocks[i]));
+    }
+
+    u64 mismatches = get_memory_free_mismatch_count();
+    for (u32 i = 0; i < 5; i++) {
+        kfree_unsized(blocks[i]);
+    }
+    expect_should_be(mismatches, get_memory_free_mismatch_count());
+
+    // Freed space is handed straight back out
+    void *again = kallocate(100 * 1024, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, again);
+    kfree_unsized(again);
+
+    return failed ? false : true;
+}
+
+u8 kmemory_should_free_aligned_without_size() {
+    u8 failed = false;
+
+    void *block = kallocate_aligned(256, 64, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, block);
+    expect_should_be(0, (u64)block % 64);
+    expect_should_be(256, kallocation_size(block));
+
+    u64 mismatches = get_memory_free_mismatch_count();
+    kfree_unsized(block);
+    expect_should_be(mismatches, get_memory_free_mismatch_count());
+
+    return failed ? false : true;
+}
+
+u8 kmemory_should_reallocate() {
+    u8 failed = false;
+
+    // A null block is a fresh allocation.
+    u64 size = 64 * 1024;
+    u8 *block = kreallocate(0, 0, size, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, block);
+    expect_should_be(size, kallocation_size(block));
+    for (u64 i = 0; i < size; i++) {
+        block[i] = (u8)i;
+    }
+
+    // Growing keeps the contents, whether or not the block moved.
+    u64 mismatches = get_memory_free_mismatch_count();
+    u8 *grown = kreallocate(block, size, size * 2, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, grown);
+    expect_should_be(size * 2, kallocation_size(grown));
+    expect_should_be(0, grown[0]);
+    expect_should_be(255, grown[255]);
+    expect_should_be((u8)(size - 1), grown[size - 1]);
+
+    // Small blocks move between slab size classes.
+    u8 *shrunk = kreallocate(grown, size * 2, 24, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, shrunk);
+    expect_should_be(24, kallocation_size(shrunk));
+    expect_should_be(23, shrunk[23]);
+
+    kfree(shrunk, 24, MEMORY_TAG_ARRAY);
+    expect_should_be(mismatches, get_memory_free_mismatch_count());
+
+    return failed ? false : true;
+}
+
+u8 kmemory_should_detect_mismatched_and_double_free() {
+    u8 failed = false;
+
+    u64 mismatches = get_memory_free_mismatch_count();
+
+    KDEBUG("Note: The following errors are intentionally caused by this "
+           "test.");
+
+    // The wrong size is reported, but the block is still freed correctly
+    void *block = kallocate(128, MEMORY_TAG_ARRAY);
+    kfree(block, 64, MEMORY_TAG_ARRAY);
+#if KMEMORY_VERIFY_FREES
+    expect_should_be(mismatches + 1, get_memory_free_mismatch_count());
+    mismatches++;
+#endif
+
+    block = kallocate(128, MEMORY_TAG_ARRAY);
+    kfree(block, 128, MEMORY_TAG_DICT);
+#if KMEMORY_VERIFY_FREES
+    expect_should_be(mismatches + 1, get_memory_free_mismatch_count());
+    mismatches++;
+#endif
+
+    // Double frees are caught by the header in every build
+    block = kallocate(5000, MEMORY_TAG_ARRAY);
+    kfree_unsized(block);
+    kfree_unsized(block);
+    expect_should_be(mismatches + 1, get_memory_free_mismatch_count());
+
+    return failed ? false : true;
+}
+
+u8 kmemory_should_count_zeroed_bytes_per_frame() {
+    u8 failed = false;
+
+    // Close whatever frame earlier tests left open
+    memory_system_end_frame();
+
+    void *zeroed = kallocate(1000, MEMORY_TAG_ARRAY);
+    void *uninit = kallocate_uninit(5000, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, uninit);
+    expect_should_be(5000, kallocation_size(uninit));
+    kzero_memory(uninit, 24);
+
+    memory_system_end_frame();
+    expect_should_be(1024, get_memory_zeroed_bytes_last_frame());
+
+    kfree(zeroed, 1000, MEMORY_TAG_ARRAY);
+    kfree(uninit, 5000, MEMORY_TAG_ARRAY);
+
+    memory_system_end_frame();
+    expect_should_be(0, get_memory_zeroed_bytes_last_frame());
+
+    return failed ? false : true;
+}
+
+#define KMEMORY_THREAD_LIVE_BLOCKS 256
+#define KMEMORY_THREAD_OPERATIONS 200000
+#define KMEMORY_MAX_THREADS 8
+
+typedef struct kmemory_thread_context {
+    u32 id;
+    u32 seed;
+    u32 operations;
+    b8 ok;
+} kmemory_thread_context;
+
+static u32 kmemory_next(u32 *seed) {
+    u32 x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+// Replaces a random live block per operation. Each block is stamped with its
+// slot so any cross-thread overlap shows up as a corrupted stamp.
+static u32 kmemory_thread_worker(void *params) {
+    kmemory_thread_context *ctx = params;
+    void *blocks[KMEMORY_THREAD_LIVE_BLOCKS] = {0};
+    u64 sizes[KMEMORY_THREAD_LIVE_BLOCKS] = {0};
+
+    for (u32 i = 0; i < ctx->operations; i++) {
+        u32 slot = kmemory_next(&ctx->seed) % KMEMORY_THREAD_LIVE_BLOCKS;
+        if (blocks[slot]) {
+            u32 *stamp = blocks[slot];
+            if (*stamp != (ctx->id << 16 | slot)) {
+                ctx->ok = false;
+            }
+            kfree(blocks[slot], sizes[slot], MEMORY_TAG_ARRAY);
+        }
+
+        // Mostly small blocks, with the occasional large one
+        u32 roll = kmemory_next(&ctx->seed);
+        sizes[slot] = (roll % 64) ? 8 + roll % 512 : 8192 + roll % 8192;
+        blocks[slot] = kallocate(sizes[slot], MEMORY_TAG_ARRAY);
+        if (!blocks[slot]) {
+            ctx->ok = false;
+            break;
+        }
+        *(u32 *)blocks[slot] = ctx->id << 16 | slot;
+    }
+
+    for (u32 i = 0; i < KMEMORY_THREAD_LIVE_BLOCKS; i++) {
+        if (blocks[i]) {
+            kfree(blocks[i], sizes[i], MEMORY_TAG_ARRAY);
+        }
+    }
+    memory_system_flush_thread_cache();
+    return 0;
+}
+
+static f64 kmemory_run_threads(u32 thread_count, u32 operations, b8 *ok) {
+    kthread threads[KMEMORY_MAX_THREADS];
+    kmemory_thread_context contexts[KMEMORY_MAX_THREADS];
+
+    clock timer;
+    clock_start(&timer);
+
+    for (u32 i = 0; i < thread_count; i++) {
+        contexts[i].id = i;
+        contexts[i].seed = 0x9E3779B9 + i * 7919;
+        contexts[i].operations = operations;
+        contexts[i].ok = true;
+        if (!kthread_create(kmemory_thread_worker, &contexts[i], false,
+                            &threads[i])) {
+            *ok = false;
+            thread_count = i;
+            break;
+        }
+    }
+    for (u32 i = 0; i < thread_count; i++) {
+        kthread_wait(&threads[i]);
+        if (!contexts[i].ok) {
+            *ok = false;
+        }
+    }
+
+    clock_update(&timer);
+    f64 elapsed = timer.elapsed;
+    clock_stop(&timer);
+    return elapsed;
+}
+
+u8 kmemory_should_allocate_from_many_threads() {
+    u8 failed = false;
+
+    u64 mismatches = get_memory_free_mismatch_count();
+    b8 ok = true;
+    kmemory_run_threads(4, 20000, &ok);
+    expect_to_be_true(ok);
+    expect_should_be(mismatches, get_memory_free_mismatch_count());
+
+    return failed ? false : true;
+}
+
+u8 kmemory_benchmark_thread_scaling() {
+    u8 failed = false;
+
+    u32 thread_counts[] = {1, 2, 4, 8};
+    f64 single_rate = 0;
+    for (u32 i = 0; i < 4; i++) {
+        b8 ok = true;
+        f64 seconds = kmemory_run_threads(
+            thread_counts[i], KMEMORY_THREAD_OPERATIONS, &ok);
+        expect_to_be_true(ok);
+
+        f64 rate = (thread_counts[i] * (f64)KMEMORY_THREAD_OPERATIONS) /
+                   seconds;
+        if (i == 0) {
+            single_rate = rate;
+        }
+        KINFO("kallocate/kfree pairs per second with %u thread(s): %.0f "
+              "(%.2fx).",
+              thread_counts[i], rate, rate / single_rate);
+    }
+
+    return failed ? false : true;
+}
+
+typedef struct budget_test_listener {
+    u32 pressure_count;
+    memory_tag last_tag;
+    u64 last_usage;
+} budget_test_listener;
+
+static b8 budget_test_on_pressure(u16 code, void *sender, void *listener_inst,
+                                  event_context data) {
+    budget_test_listener *listener = listener_inst;
+    listener->pressure_count++;
+    listener->last_tag = data.data.u32[0];
+    listener->last_usage = data.data.u64[1];
+    return true;
+}
+
+u8 kmemory_should_enforce_tag_budgets() {
+    u8 failed = false;
+
+    u64 event_memory_requirement = 0;
+    event_initialize(&event_memory_requirement, 0);
+    void *event_state = kallocate(event_memory_requirement, MEMORY_TAG_ARRAY);
+    event_initialize(&event_memory_requirement, event_state);
+    budget_test_listener listener = {};
+    event_register(EVENT_CODE_MEMORY_PRESSURE, &listener,
+                   budget_test_on_pressure);
+
+    u64 kib = 1024;
+    u64 baseline = get_memory_tag_usage(MEMORY_TAG_GAME);
+    memory_tag_budget budget = {baseline + 64 * kib, baseline + 128 * kib};
+    memory_system_set_tag_budget(MEMORY_TAG_GAME, budget);
+
+    void *first = kallocate(48 * kib, MEMORY_TAG_GAME);
+    expect_should_not_be(0, first);
+    expect_should_be(0, listener.pressure_count);
+
+    // Crossing the soft limit fires once, at the end of the frame.
+    void *second = kallocate(32 * kib, MEMORY_TAG_GAME);
+    expect_should_not_be(0, second);
+    expect_should_be(0, listener.pressure_count);
+    memory_system_end_frame();
+    expect_should_be(1, listener.pressure_count);
+    expect_should_be(MEMORY_TAG_GAME, listener.last_tag);
+    expect_should_be(baseline + 80 * kib, listener.last_usage);
+    void *third = kallocate(8 * kib, MEMORY_TAG_GAME);
+    memory_system_end_frame();
+    expect_should_be(1, listener.pressure_count);
+
+    u64 usage = get_memory_tag_usage(MEMORY_TAG_GAME);
+    expect_should_be(baseline + 88 * kib, usage);
+
+    // Other tags are unaffected.
+    void *other = kallocate(256 * kib, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, other);
+    kfree(other, 256 * kib, MEMORY_TAG_ARRAY);
+
+    // Dropping back under the soft limit re-arms the event.
+    kfree(third, 8 * kib, MEMORY_TAG_GAME);
+    kfree(second, 32 * kib, MEMORY_TAG_GAME);
+    second = kallocate(32 * kib, MEMORY_TAG_GAME);
+    memory_system_end_frame();
+    expect_should_be(2, listener.pressure_count);
+
+    kfree(second, 32 * kib, MEMORY_TAG_GAME);
+    kfree(first, 48 * kib, MEMORY_TAG_GAME);
+    memory_tag_budget none = {};
+    memory_system_set_tag_budget(MEMORY_TAG_GAME, none);
+
+    event_unregister(EVENT_CODE_MEMORY_PRESSURE, &listener,
+                     budget_test_on_pressure);
+    event_shutdown(event_state);
+    kfree(event_state, event_memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+#if defined(KPLATFORM_LINUX)
+u8 kmemory_should_stop_at_hard_limit() {
+    u8 failed = false;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Runs in the child. Should never get to exit.
+        u64 baseline = get_memory_tag_usage(MEMORY_TAG_GAME);
+        memory_tag_budget budget = {0, baseline + 16 * 1024};
+        memory_system_set_tag_budget(MEMORY_TAG_GAME, budget);
+        KDEBUG("Note: The following error is intentionally caused by this "
+               "test.");
+        kallocate(64 * 1024, MEMORY_TAG_GAME);
+        _exit(0);
+    }
+    expect_to_be_true((pid > 0));
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    expect_to_be_true(WIFSIGNALED(status));
+
+    return failed ? false : true;
+}
+#endif
+
+#if KMEMORY_GUARD_ALLOCATIONS && defined(KPLATFORM_LINUX)
+// Restarts the memory system in guard mode. Only called in a forked child, so
+// the test runner's memory system is left alone.
+static b8 guard_restart_memory_system(dynamic_allocator_strategy strategy) {
+    memory_system_shutdown();
+    memory_system_configuration config = {};
+    config.total_alloc_count = MEBIBYTES(64);
+    config.allocator_strategy = strategy;
+    config.guard_allocations = true;
+    return memory_system_initialize(config);
+}
+
+// Runs in the child. Exits 0 if every check passed.
+static void guard_check_canaries() {
+    if (!guard_restart_memory_system(DYNAMIC_ALLOCATOR_STRATEGY_TLSF)) {
+        _exit(1);
+    }
+    u8 failed = false;
+
+    // Large blocks live between guard pages, but behave as normal.
+    u8 *large = kallocate(100 * 1024, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, large);
+    large[100 * 1024 - 1] = 1;
+    expect_should_be(100 * 1024, kallocation_size(large));
+    u8 *aligned = kallocate_aligned(10000, 256, MEMORY_TAG_ARRAY);
+    expect_should_be(0, (u64)aligned % 256);
+    kfree_aligned(aligned, 10000, 256, MEMORY_TAG_ARRAY);
+    kfree(large, 100 * 1024, MEMORY_TAG_ARRAY);
+    expect_should_be(0, get_memory_overrun_count());
+
+    // Every guard-mode block is 16 byte aligned, even from the freelist
+    // strategy, which does not align blocks itself.
+    if (!guard_restart_memory_system(DYNAMIC_ALLOCATOR_STRATEGY_FREELIST)) {
+        _exit(1);
+    }
+    u64 sizes[] = {1, 3, 24, 100, 5000, 70000};
+    void *blocks[6];
+    for (u32 i = 0; i < 6; i++) {
+        blocks[i] = kallocate(sizes[i], MEMORY_TAG_ARRAY);
+        expect_should_be(0, (u64)blocks[i] % 16);
+    }
+    for (u32 i = 0; i < 6; i++) {
+        kfree(blocks[i], sizes[i], MEMORY_TAG_ARRAY);
+    }
+    expect_should_be(0, get_memory_overrun_count());
+
+    // Small blocks are checked on free.
+    KDEBUG("Note: The following errors are intentionally caused by this "
+           "test.");
+    u8 *small = kallocate(24, MEMORY_TAG_ARRAY);
+    small[24] = 0xAB;
+    kfree(small, 24, MEMORY_TAG_ARRAY);
+    expect_should_be(1, get_memory_overrun_count());
+
+    memory_system_shutdown();
+    _exit(failed ? 1 : 0);
+}
+
+// Runs in the child. Should never get to exit.
+static void guard_overrun_large_block() {
+    if (!guard_restart_memory_system(DYNAMIC_ALLOCATOR_STRATEGY_TLSF)) {
+        _exit(1);
+    }
+    volatile u8 *block = kallocate(10000, MEMORY_TAG_ARRAY);
+    for (u64 i = 0; i < 10000 + 4096; i++) {
+        block[i] = 1;
+    }
+    _exit(0);
+}
+
+u8 kmemory_guard_should_check_canaries() {
+    u8 failed = false;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        guard_check_canaries();
+    }
+    expect_to_be_true((pid > 0));
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    expect_to_be_true(WIFEXITED(status));
+    expect_should_be(0, WEXITSTATUS(status));
+
+    return failed ? false : true;
+}
+
+u8 kmemory_guard_should_fault_on_overrun() {
+    u8 failed = false;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        guard_overrun_large_block();
+    }
+    expect_to_be_true((pid > 0));
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    expect_to_be_true(WIFSIGNALED(status));
+    expect_should_be(SIGSEGV, WTERMSIG(status));
+
+    return failed ? false : true;
+}
+#endif
+
+void kmemory_register_tests() {
+    test_manager_register_test(kmemory_should_free_without_size,
+                               "kfree_unsized should free using the block "
+                               "header.");
+    test_manager_register_test(
+        kmemory_should_free_aligned_without_size,
+        "kfree_unsized should free aligned blocks using the block header.");
+    test_manager_register_test(
+        kmemory_should_reallocate,
+        "kreallocate should grow and shrink blocks, keeping their contents.");
+    test_manager_register_test(
+        kmemory_should_detect_mismatched_and_double_free,
+        "Memory system should detect mismatched and double frees.");
+    test_manager_register_test(
+        kmemory_should_count_zeroed_bytes_per_frame,
+        "Memory system should count bytes zeroed per frame, skipping "
+        "kallocate_uninit.");
+    test_manager_register_test(
+        kmemory_should_allocate_from_many_threads,
+        "Memory system should allocate and free from many threads.");
+    test_manager_register_test(
+        kmemory_should_enforce_tag_budgets,
+        "Memory system should fire pressure events per tag at the end of the "
+        "frame.");
+#if defined(KPLATFORM_LINUX)
+    test_manager_register_test(
+        kmemory_should_stop_at_hard_limit,
+        "Memory system should stop the program at a tag's hard limit.");
+#endif
+    test_manager_register_test(kmemory_benchmark_thread_scaling,
+                               "Memory system multi-threaded allocation "
+                               "benchmark.");
+#if KMEMORY_GUARD_ALLOCATIONS && defined(KPLATFORM_LINUX)
+    test_manager_register_test(
+        kmemory_guard_should_check_canaries,
+        "Memory system guard mode should catch overruns of small blocks.");
+    test_manager_register_test(
+        kmemory_guard_should_fault_on_overrun,
+        "Memory system guard mode should fault on overruns of large blocks.");
+#endif
+}
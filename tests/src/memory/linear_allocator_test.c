@@ -219,6 +219,82 @@ u8 linear_allocator_should_preserve_data() {
     return failed ? false : true;
 }
 
+u8 linear_allocator_virtual_should_commit_on_demand() {
+    u8 failed = false;
+
+    linear_allocator allocator;
+    u64 reserve_size = 1024ULL * 1024 * 1024; // 1 GiB, mostly never touched
+    expect_to_be_true(
+        linear_allocator_create_virtual(reserve_size, 0, &allocator));
+    expect_should_not_be(0, allocator.memory);
+
+    u64 initial = linear_allocator_committed(&allocator);
+    expect_to_be_true((initial < reserve_size));
+
+    // Allocate well past the first commit and write every byte.
+    u64 size = 4 * 1024 * 1024;
+    u8 *block = linear_allocator_allocate(&allocator, size, 16);
+    expect_should_not_be(0, block);
+    kset_memory(block, 0xCD, size);
+    expect_should_be(0xCD, block[size - 1]);
+
+    u64 committed = linear_allocator_committed(&allocator);
+    expect_to_be_true((committed >= size));
+    expect_to_be_true((committed < reserve_size));
+
+    linear_allocator_destroy(&allocator);
+    expect_should_be(0, allocator.memory);
+
+    return failed ? false : true;
+}
+
+u8 linear_allocator_virtual_should_decommit_on_free_all() {
+    u8 failed = false;
+
+    linear_allocator allocator;
+    expect_to_be_true(
+        linear_allocator_create_virtual(64 * 1024 * 1024, 0, &allocator));
+    u64 initial = linear_allocator_committed(&allocator);
+
+    u8 *block = linear_allocator_allocate(&allocator, 1024 * 1024, 16);
+    expect_should_not_be(0, block);
+    kset_memory(block, 0xAB, 1024 * 1024);
+    expect_to_be_true((linear_allocator_committed(&allocator) > initial));
+
+    linear_allocator_free_all(&allocator);
+    expect_should_be(initial, linear_allocator_committed(&allocator));
+
+    // Reused memory reads back as zero, like the non-virtual allocator.
+    u8 *again = linear_allocator_allocate(&allocator, 1024 * 1024, 16);
+    expect_should_be(block, again);
+    expect_should_be(0, again[0]);
+    expect_should_be(0, again[1024 * 1024 - 1]);
+
+    linear_allocator_destroy(&allocator);
+
+    return failed ? false : true;
+}
+
+u8 linear_allocator_virtual_should_fail_past_reserve() {
+    u8 failed = false;
+
+    linear_allocator allocator;
+    u64 reserve_size = 64 * 1024;
+    expect_to_be_true(
+        linear_allocator_create_virtual(reserve_size, 0, &allocator));
+
+    KDEBUG("The following error is intentionally caused by this test.");
+    void *block = linear_allocator_allocate(&allocator, reserve_size + 1, 1);
+    expect_should_be(0, block);
+
+    block = linear_allocator_allocate(&allocator, reserve_size, 1);
+    expect_should_not_be(0, block);
+
+    linear_allocator_destroy(&allocator);
+
+    return failed ? false : true;
+}
+
 void linear_allocator_register_tests() {
     test_manager_register_test(
         linear_allocator_should_create_and_destroy,
@@ -243,4 +319,16 @@ void linear_allocator_register_tests() {
     test_manager_register_test(
         linear_allocator_should_preserve_data,
         "Linear allocator should preserve data integrity across allocations.");
+
+    test_manager_register_test(
+        linear_allocator_virtual_should_commit_on_demand,
+        "Virtual linear allocator should commit memory as it is used.");
+
+    test_manager_register_test(
+        linear_allocator_virtual_should_decommit_on_free_all,
+        "Virtual linear allocator should decommit and zero on free_all.");
+
+    test_manager_register_test(
+        linear_allocator_virtual_should_fail_past_reserve,
+        "Virtual linear allocator should return 0 past its reserve.");
 }
@@ -0,0 +1,247 @@
+#include "slab_allocator_test.h"
+
+#include <memory/dynamic_allocator.h>
+#include <memory/slab_allocator.h>
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/clock.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include <defines.h>
+
+typedef struct slab_test_context {
+    dynamic_allocator backing;
+    void *backing_memory;
+    u64 backing_requirement;
+    slab_allocator allocator;
+    void *allocator_memory;
+    u64 allocator_requirement;
+} slab_test_context;
+
+static void slab_test_setup(slab_test_context *ctx, u64 total_size) {
+    dynamic_allocator_create(total_size, &ctx->backing_requirement, 0, 0);
+    ctx->backing_memory = kallocate(ctx->backing_requirement, MEMORY_TAG_ARRAY);
+    dynamic_allocator_create(total_size, &ctx->backing_requirement,
+                             ctx->backing_memory, &ctx->backing);
+
+    slab_allocator_create(&ctx->backing, &ctx->allocator_requirement, 0, 0);
+    ctx->allocator_memory =
+        kallocate(ctx->allocator_requirement, MEMORY_TAG_ARRAY);
+    slab_allocator_create(&ctx->backing, &ctx->allocator_requirement,
+                          ctx->allocator_memory, &ctx->allocator);
+}
+
+static void slab_test_teardown(slab_test_context *ctx) {
+    slab_allocator_destroy(&ctx->allocator);
+    kfree(ctx->allocator_memory, ctx->allocator_requirement, MEMORY_TAG_ARRAY);
+    dynamic_allocator_destroy(&ctx->backing);
+    kfree(ctx->backing_memory, ctx->backing_requirement, MEMORY_TAG_ARRAY);
+}
+
+u8 slab_allocator_should_create_and_destroy() {
+    u8 failed = false;
+
+    slab_test_context ctx;
+    u64 total_size = 1024 * 1024;
+    slab_test_setup(&ctx, total_size);
+
+    expect_should_not_be(0, ctx.allocator.memory);
+    expect_should_be(0, slab_allocator_page_count(&ctx.allocator));
+
+    void *block = slab_allocator_allocate(&ctx.allocator, 24);
+    expect_should_not_be(0, block);
+    expect_should_be(1, slab_allocator_page_count(&ctx.allocator));
+
+    // Destroy should hand every page back to the backing allocator
+    slab_allocator_destroy(&ctx.allocator);
+    expect_should_be(0, ctx.allocator.memory);
+    expect_should_be(total_size, dynamic_allocator_free_space(&ctx.backing));
+
+    kfree(ctx.allocator_memory, ctx.allocator_requirement, MEMORY_TAG_ARRAY);
+    dynamic_allocator_destroy(&ctx.backing);
+    kfree(ctx.backing_memory, ctx.backing_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+u8 slab_allocator_should_allocate_aligned_distinct_blocks() {
+    u8 failed = false;
+
+    slab_test_context ctx;
+    slab_test_setup(&ctx, 1024 * 1024);
+
+    u64 sizes[] = {1, 16, 17, 100, 256, 1000, 2048, 4096};
+    void *blocks[8];
+    for (u32 i = 0; i < 8; i++) {
+        blocks[i] = slab_allocator_allocate(&ctx.allocator, sizes[i]);
+        expect_should_not_be(0, blocks[i]);
+        expect_should_be(0, (u64)blocks[i] % 16);
+        // Write the whole requested range to catch overlaps below
+        kset_memory(blocks[i], (i32)i + 1, sizes[i]);
+    }
+
+    for (u32 i = 0; i < 8; i++) {
+        u8 *bytes = blocks[i];
+        for (u64 j = 0; j < sizes[i]; j++) {
+            if (bytes[j] != i + 1) {
+                KERROR("--> Block %u was overwritten at byte %llu.", i, j);
+                failed = true;
+                break;
+            }
+        }
+    }
+
+    for (u32 i = 0; i < 8; i++) {
+        b8 result = slab_allocator_free(&ctx.allocator, blocks[i], sizes[i]);
+        expect_to_be_true(result);
+    }
+
+    slab_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 slab_allocator_should_reuse_freed_block() {
+    u8 failed = false;
+
+    slab_test_context ctx;
+    slab_test_setup(&ctx, 1024 * 1024);
+
+    void *block1 = slab_allocator_allocate(&ctx.allocator, 64);
+    void *block2 = slab_allocator_allocate(&ctx.allocator, 64);
+    expect_should_not_be(block1, block2);
+
+    slab_allocator_free(&ctx.allocator, block1, 64);
+
+    // Same size class, the most recently freed block comes back first
+    void *block3 = slab_allocator_allocate(&ctx.allocator, 50);
+    expect_should_be(block1, block3);
+    expect_should_be(1, slab_allocator_page_count(&ctx.allocator));
+
+    slab_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 slab_allocator_should_reject_oversized_allocation() {
+    u8 failed = false;
+
+    slab_test_context ctx;
+    slab_test_setup(&ctx, 1024 * 1024);
+
+    KDEBUG("The following error message is intentional.");
+
+    void *block =
+        slab_allocator_allocate(&ctx.allocator, SLAB_ALLOCATOR_MAX_SIZE + 1);
+    expect_should_be(0, block);
+    expect_should_be(0, slab_allocator_page_count(&ctx.allocator));
+
+    slab_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+// Small xorshift so both runs see the same size sequence.
+static u32 slab_bench_next(u32 *seed) {
+    u32 x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+#define SLAB_BENCH_LIVE_BLOCKS 1024
+#define SLAB_BENCH_OPERATIONS 100000
+
+// Keeps a window of live blocks and replaces a random one per operation, which
+// fragments the freelist the way long-running engine allocations do.
+static f64 slab_bench_run(slab_test_context *ctx, b8 use_slabs, b8 *ok) {
+    void *blocks[SLAB_BENCH_LIVE_BLOCKS] = {0};
+    u64 sizes[SLAB_BENCH_LIVE_BLOCKS] = {0};
+    u32 seed = 0x9E3779B9;
+
+    clock timer;
+    clock_start(&timer);
+
+    for (u32 i = 0; i < SLAB_BENCH_OPERATIONS; i++) {
+        u32 slot = slab_bench_next(&seed) % SLAB_BENCH_LIVE_BLOCKS;
+        if (blocks[slot]) {
+            if (use_slabs) {
+                slab_allocator_free(&ctx->allocator, blocks[slot], sizes[slot]);
+            } else {
+                dynamic_allocator_free(&ctx->backing, blocks[slot],
+                                       sizes[slot]);
+            }
+        }
+
+        u64 size =
+            16 + (slab_bench_next(&seed) % (SLAB_ALLOCATOR_MAX_SIZE - 15));
+        sizes[slot] = size;
+        blocks[slot] = use_slabs
+                           ? slab_allocator_allocate(&ctx->allocator, size)
+                           : dynamic_allocator_allocate(&ctx->backing, size);
+        if (!blocks[slot]) {
+            *ok = false;
+            break;
+        }
+    }
+
+    clock_update(&timer);
+    f64 elapsed = timer.elapsed;
+    clock_stop(&timer);
+
+    for (u32 i = 0; i < SLAB_BENCH_LIVE_BLOCKS; i++) {
+        if (!blocks[i]) {
+            continue;
+        }
+        if (use_slabs) {
+            slab_allocator_free(&ctx->allocator, blocks[i], sizes[i]);
+        } else {
+            dynamic_allocator_free(&ctx->backing, blocks[i], sizes[i]);
+        }
+    }
+
+    return elapsed;
+}
+
+u8 slab_allocator_benchmark_against_dynamic_allocator() {
+    u8 failed = false;
+
+    slab_test_context ctx;
+    slab_test_setup(&ctx, 16 * 1024 * 1024);
+
+    b8 ok = true;
+    f64 dynamic_seconds = slab_bench_run(&ctx, false, &ok);
+    expect_to_be_true(ok);
+    f64 slab_seconds = slab_bench_run(&ctx, true, &ok);
+    expect_to_be_true(ok);
+
+    f64 dynamic_rate = SLAB_BENCH_OPERATIONS / dynamic_seconds;
+    f64 slab_rate = SLAB_BENCH_OPERATIONS / slab_seconds;
+    KINFO("Allocations per second - dynamic allocator: %.0f, slab allocator: "
+          "%.0f (%.1fx).",
+          dynamic_rate, slab_rate, slab_rate / dynamic_rate);
+
+    slab_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+void slab_allocator_register_tests() {
+    test_manager_register_test(
+        slab_allocator_should_create_and_destroy,
+        "Slab allocator should create and destroy successfully.");
+    test_manager_register_test(
+        slab_allocator_should_allocate_aligned_distinct_blocks,
+        "Slab allocator should allocate aligned, non-overlapping blocks.");
+    test_manager_register_test(slab_allocator_should_reuse_freed_block,
+                               "Slab allocator should reuse freed blocks.");
+    test_manager_register_test(
+        slab_allocator_should_reject_oversized_allocation,
+        "Slab allocator should reject blocks above the largest size class.");
+    test_manager_register_test(
+        slab_allocator_benchmark_against_dynamic_allocator,
+        "Slab allocator benchmark against dynamic allocator.");
+}
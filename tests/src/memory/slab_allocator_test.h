@@ -0,0 +1,3 @@
+#pragma once
+
+void slab_allocator_register_tests();
@@ -0,0 +1,354 @@
+#include "tlsf_allocator_test.h"
+
+#include <memory/dynamic_allocator.h>
+#include <memory/tlsf_allocator.h>
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "core/clock.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include <defines.h>
+
+typedef struct tlsf_test_context {
+    tlsf_allocator allocator;
+    void *memory;
+    u64 memory_requirement;
+} tlsf_test_context;
+
+static void tlsf_test_setup(tlsf_test_context *ctx, u64 total_size) {
+    tlsf_allocator_create(total_size, &ctx->memory_requirement, 0, 0);
+    ctx->memory = kallocate(ctx->memory_requirement, MEMORY_TAG_ARRAY);
+    tlsf_allocator_create(total_size, &ctx->memory_requirement, ctx->memory,
+                          &ctx->allocator);
+}
+
+static void tlsf_test_teardown(tlsf_test_context *ctx) {
+    tlsf_allocator_destroy(&ctx->allocator);
+    kfree(ctx->memory, ctx->memory_requirement, MEMORY_TAG_ARRAY);
+}
+
+u8 tlsf_allocator_should_create_and_destroy() {
+    u8 failed = false;
+
+    tlsf_test_context ctx;
+    u64 total_size = 4096;
+    tlsf_test_setup(&ctx, total_size);
+
+    expect_should_not_be(0, ctx.allocator.memory);
+    expect_should_be(total_size, tlsf_allocator_free_space(&ctx.allocator));
+
+    tlsf_test_teardown(&ctx);
+    expect_should_be(0, ctx.allocator.memory);
+
+    return failed ? false : true;
+}
+
+u8 tlsf_allocator_should_allocate_aligned_blocks_and_free_to_full() {
+    u8 failed = false;
+
+    tlsf_test_context ctx;
+    u64 total_size = 64 * 1024;
+    tlsf_test_setup(&ctx, total_size);
+
+    u64 sizes[] = {1, 16, 17, 100, 511, 512, 1000, 4096};
+    void *blocks[8];
+    for (u32 i = 0; i < 8; i++) {
+        blocks[i] = tlsf_allocator_allocate(&ctx.allocator, sizes[i]);
+        expect_should_not_be(0, blocks[i]);
+        expect_should_be(0, (u64)blocks[i] % TLSF_ALLOCATOR_ALIGNMENT);
+        expect_to_be_true(
+            (tlsf_allocator_block_size(blocks[i]) >= sizes[i]));
+        // Write the whole requested range to catch overlaps below
+        kset_memory(blocks[i], (i32)i + 1, sizes[i]);
+    }
+    expect_to_be_true(
+        (tlsf_allocator_free_space(&ctx.allocator) < total_size));
+
+    for (u32 i = 0; i < 8; i++) {
+        u8 *bytes = blocks[i];
+        for (u64 j = 0; j < sizes[i]; j++) {
+            expect_should_be(i + 1, bytes[j]);
+        }
+    }
+
+    // Free out of order so merges with both neighbours are exercised
+    u32 order[] = {3, 1, 2, 7, 0, 5, 4, 6};
+    for (u32 i = 0; i < 8; i++) {
+        expect_to_be_true(
+            tlsf_allocator_free(&ctx.allocator, blocks[order[i]]));
+    }
+    expect_should_be(total_size, tlsf_allocator_free_space(&ctx.allocator));
+
+    tlsf_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 tlsf_allocator_should_coalesce_into_full_allocation() {
+    u8 failed = false;
+
+    tlsf_test_context ctx;
+    u64 total_size = 16 * 1024;
+    tlsf_test_setup(&ctx, total_size);
+
+    void *blocks[16];
+    for (u32 i = 0; i < 16; i++) {
+        blocks[i] = tlsf_allocator_allocate(&ctx.allocator, 512);
+        expect_should_not_be(0, blocks[i]);
+    }
+
+    // Free every other block first; no single hole can take the whole pool
+    for (u32 i = 0; i < 16; i += 2) {
+        tlsf_allocator_free(&ctx.allocator, blocks[i]);
+    }
+    for (u32 i = 1; i < 16; i += 2) {
+        tlsf_allocator_free(&ctx.allocator, blocks[i]);
+    }
+
+    // Everything merged back, so the whole pool is a single block again
+    void *whole = tlsf_allocator_allocate(&ctx.allocator, total_size);
+    expect_should_not_be(0, whole);
+    expect_should_be(0, tlsf_allocator_free_space(&ctx.allocator));
+    tlsf_allocator_free(&ctx.allocator, whole);
+    expect_should_be(total_size, tlsf_allocator_free_space(&ctx.allocator));
+
+    tlsf_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 tlsf_allocator_should_reuse_freed_block() {
+    u8 failed = false;
+
+    tlsf_test_context ctx;
+    tlsf_test_setup(&ctx, 64 * 1024);
+
+    void *first = tlsf_allocator_allocate(&ctx.allocator, 256);
+    void *guard = tlsf_allocator_allocate(&ctx.allocator, 256);
+    expect_should_not_be(0, first);
+    expect_should_not_be(0, guard);
+
+    tlsf_allocator_free(&ctx.allocator, first);
+    void *second = tlsf_allocator_allocate(&ctx.allocator, 256);
+    expect_should_be(first, second);
+
+    tlsf_allocator_free(&ctx.allocator, second);
+    tlsf_allocator_free(&ctx.allocator, guard);
+
+    tlsf_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 tlsf_allocator_should_reject_oversized_and_foreign_blocks() {
+    u8 failed = false;
+
+    tlsf_test_context ctx;
+    u64 total_size = 4096;
+    tlsf_test_setup(&ctx, total_size);
+
+    KDEBUG("Note: The following errors are intentionally caused by this "
+           "test.");
+    void *block = tlsf_allocator_allocate(&ctx.allocator, total_size + 16);
+    expect_should_be(0, block);
+
+    u64 foreign = 0;
+    expect_should_be(false, tlsf_allocator_free(&ctx.allocator, &foreign));
+
+    block = tlsf_allocator_allocate(&ctx.allocator, 64);
+    expect_to_be_true(tlsf_allocator_free(&ctx.allocator, block));
+    expect_should_be(false, tlsf_allocator_free(&ctx.allocator, block));
+    expect_should_be(total_size, tlsf_allocator_free_space(&ctx.allocator));
+
+    tlsf_test_teardown(&ctx);
+
+    return failed ? false : true;
+}
+
+u8 tlsf_allocator_should_back_dynamic_allocator() {
+    u8 failed = false;
+
+    dynamic_allocator allocator;
+    u64 memory_requirement = 0;
+    u64 total_size = 64 * 1024;
+    b8 result = dynamic_allocator_create_with_strategy(
+        DYNAMIC_ALLOCATOR_STRATEGY_TLSF, total_size, &memory_requirement, 0, 0);
+    expect_to_be_true(result);
+
+    void *memory = kallocate(memory_requirement, MEMORY_TAG_ARRAY);
+    result = dynamic_allocator_create_with_strategy(
+        DYNAMIC_ALLOCATOR_STRATEGY_TLSF, total_size, &memory_requirement,
+        memory, &allocator);
+    expect_to_be_true(result);
+    expect_should_be(total_size, dynamic_allocator_free_space(&allocator));
+
+    void *block = dynamic_allocator_allocate(&allocator, 1024);
+    expect_should_not_be(0, block);
+    expect_to_be_true(dynamic_allocator_owns_block(&allocator, block));
+    expect_to_be_true(
+        (dynamic_allocator_free_space(&allocator) < total_size));
+
+    expect_to_be_true(dynamic_allocator_free(&allocator, block, 1024));
+    expect_should_be(total_size, dynamic_allocator_free_space(&allocator));
+
+    dynamic_allocator_destroy(&allocator);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+u8 tlsf_allocator_should_grow_in_place() {
+    u8 failed = false;
+
+    // Memory sized for the grown pool, the allocator created over less of it.
+    u64 total_size = 4096;
+    u64 grown_size = 16 * 1024;
+    u64 memory_requirement = 0;
+    tlsf_allocator_create(grown_size, &memory_requirement, 0, 0);
+    void *memory = kallocate(memory_requirement, MEMORY_TAG_ARRAY);
+    tlsf_allocator allocator;
+    u64 small_requirement = 0;
+    tlsf_allocator_create(total_size, &small_requirement, 0, 0);
+    expect_to_be_true(tlsf_allocator_create(total_size, &small_requirement,
+                                            memory, &allocator));
+
+    void *first = tlsf_allocator_allocate(&allocator, 1024);
+    expect_should_not_be(0, first);
+    kset_memory(first, 0x5A, 1024);
+
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(0, tlsf_allocator_allocate(&allocator, 8192));
+
+    expect_to_be_true(tlsf_allocator_grow(&allocator, grown_size));
+    expect_to_be_false(tlsf_allocator_grow(&allocator, grown_size));
+
+    // The tail merges with the existing free block, so a block larger than
+    // the old pool now fits next to the surviving allocation.
+    void *second = tlsf_allocator_allocate(&allocator, 8192);
+    expect_should_not_be(0, second);
+    expect_should_be(0x5A, ((u8 *)first)[1023]);
+
+    expect_to_be_true(tlsf_allocator_free(&allocator, second));
+    expect_to_be_true(tlsf_allocator_free(&allocator, first));
+    expect_should_be(grown_size, tlsf_allocator_free_space(&allocator));
+    expect_should_not_be(0, tlsf_allocator_allocate(&allocator, grown_size));
+
+    tlsf_allocator_destroy(&allocator);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+
+    return failed ? false : true;
+}
+
+// Small xorshift so both runs see the same size sequence.
+static u32 tlsf_bench_next(u32 *seed) {
+    u32 x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+#define TLSF_BENCH_LIVE_BLOCKS 4096
+#define TLSF_BENCH_OPERATIONS 100000
+#define TLSF_BENCH_MAX_SIZE (16 * 1024)
+
+// Replaces a random live block per operation, so free space fragments while
+// the freelist strategy searches its trees and TLSF stays constant time.
+static f64 tlsf_bench_run(dynamic_allocator *allocator, b8 *ok) {
+    static void *blocks[TLSF_BENCH_LIVE_BLOCKS];
+    static u64 sizes[TLSF_BENCH_LIVE_BLOCKS];
+    kzero_memory(blocks, sizeof(blocks));
+    u32 seed = 0x9E3779B9;
+
+    clock timer;
+    clock_start(&timer);
+
+    for (u32 i = 0; i < TLSF_BENCH_OPERATIONS; i++) {
+        u32 slot = tlsf_bench_next(&seed) % TLSF_BENCH_LIVE_BLOCKS;
+        if (blocks[slot]) {
+            dynamic_allocator_free(allocator, blocks[slot], sizes[slot]);
+        }
+
+        sizes[slot] = 16 + (tlsf_bench_next(&seed) % TLSF_BENCH_MAX_SIZE);
+        blocks[slot] = dynamic_allocator_allocate(allocator, sizes[slot]);
+        if (!blocks[slot]) {
+            *ok = false;
+            break;
+        }
+    }
+
+    clock_update(&timer);
+    f64 elapsed = timer.elapsed;
+    clock_stop(&timer);
+
+    for (u32 i = 0; i < TLSF_BENCH_LIVE_BLOCKS; i++) {
+        if (blocks[i]) {
+            dynamic_allocator_free(allocator, blocks[i], sizes[i]);
+        }
+    }
+
+    return elapsed;
+}
+
+static f64 tlsf_bench_strategy(dynamic_allocator_strategy strategy, b8 *ok) {
+    dynamic_allocator allocator;
+    u64 memory_requirement = 0;
+    u64 total_size = 64 * 1024 * 1024;
+    dynamic_allocator_create_with_strategy(strategy, total_size,
+                                           &memory_requirement, 0, 0);
+    void *memory = kallocate(memory_requirement, MEMORY_TAG_ARRAY);
+    dynamic_allocator_create_with_strategy(strategy, total_size,
+                                           &memory_requirement, memory,
+                                           &allocator);
+
+    f64 elapsed = tlsf_bench_run(&allocator, ok);
+
+    dynamic_allocator_destroy(&allocator);
+    kfree(memory, memory_requirement, MEMORY_TAG_ARRAY);
+    return elapsed;
+}
+
+u8 tlsf_allocator_benchmark_against_freelist() {
+    u8 failed = false;
+
+    b8 ok = true;
+    f64 freelist_seconds =
+        tlsf_bench_strategy(DYNAMIC_ALLOCATOR_STRATEGY_FREELIST, &ok);
+    expect_to_be_true(ok);
+    f64 tlsf_seconds =
+        tlsf_bench_strategy(DYNAMIC_ALLOCATOR_STRATEGY_TLSF, &ok);
+    expect_to_be_true(ok);
+
+    f64 freelist_rate = TLSF_BENCH_OPERATIONS / freelist_seconds;
+    f64 tlsf_rate = TLSF_BENCH_OPERATIONS / tlsf_seconds;
+    KINFO("Allocations per second - freelist: %.0f, tlsf: %.0f (%.1fx).",
+          freelist_rate, tlsf_rate, tlsf_rate / freelist_rate);
+
+    return failed ? false : true;
+}
+
+void tlsf_allocator_register_tests() {
+    test_manager_register_test(
+        tlsf_allocator_should_create_and_destroy,
+        "TLSF allocator should create and destroy successfully.");
+    test_manager_register_test(
+        tlsf_allocator_should_allocate_aligned_blocks_and_free_to_full,
+        "TLSF allocator should allocate aligned blocks and free back to full.");
+    test_manager_register_test(
+        tlsf_allocator_should_coalesce_into_full_allocation,
+        "TLSF allocator should coalesce freed neighbours.");
+    test_manager_register_test(tlsf_allocator_should_reuse_freed_block,
+                               "TLSF allocator should reuse freed blocks.");
+    test_manager_register_test(
+        tlsf_allocator_should_reject_oversized_and_foreign_blocks,
+        "TLSF allocator should reject oversized, foreign and double frees.");
+    test_manager_register_test(
+        tlsf_allocator_should_back_dynamic_allocator,
+        "Dynamic allocator should work with the TLSF strategy.");
+    test_manager_register_test(tlsf_allocator_should_grow_in_place,
+                               "TLSF allocator should grow into added space.");
+    test_manager_register_test(tlsf_allocator_benchmark_against_freelist,
+                               "TLSF allocator benchmark against freelist.");
+}
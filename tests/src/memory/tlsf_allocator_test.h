@@ -0,0 +1,3 @@
+#pragma once
+
+void tlsf_allocator_register_tests();